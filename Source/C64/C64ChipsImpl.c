@@ -21,6 +21,26 @@
 #include "util/m6502dasm.h"
 #include "util/z80dasm.h"
 
+#include "C64ChipsImpl.h"
+
+
+static C64FetchTrap g_FetchTrap = NULL;
+static void* g_FetchTrapUserData = NULL;
+static uint16_t g_FetchTrapAddress = 0;
+
+void C64SetFetchTrap(uint16_t address, C64FetchTrap trap_func, void* user_data)
+{
+	g_FetchTrapAddress = address;
+	g_FetchTrap = trap_func;
+	g_FetchTrapUserData = user_data;
+}
+
+static inline uint64_t FetchTrapTick(c64_t* sys, uint64_t pins)
+{
+	if (g_FetchTrap != NULL && (pins & M6502_SYNC) && M6502_GET_ADDR(pins) == g_FetchTrapAddress)
+		pins = g_FetchTrap(sys, pins, g_FetchTrapUserData);
+	return pins;
+}
 
 uint32_t C64ExecEmu(c64_t* sys, uint32_t micro_seconds) 
 {
@@ -33,6 +53,7 @@ uint32_t C64ExecEmu(c64_t* sys, uint32_t micro_seconds)
 		for (uint32_t ticks = 0; ticks < num_ticks; ticks++) 
 		{
 			pins = _c64_tick(sys, pins);
+			pins = FetchTrapTick(sys, pins);
 		}
 	}
 	else 
@@ -41,6 +62,7 @@ uint32_t C64ExecEmu(c64_t* sys, uint32_t micro_seconds)
 		for (uint32_t ticks = 0; (ticks < num_ticks) && !(*sys->debug.stopped); ticks++) 
 		{
 			pins = _c64_tick(sys, pins);
+			pins = FetchTrapTick(sys, pins);
 			sys->debug.callback.func(sys->debug.callback.user_data, pins);
 		}
 	}
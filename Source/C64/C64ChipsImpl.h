@@ -3,4 +3,17 @@
 #include "chips/chips_common.h"
 #include "systems/c64.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// called when the CPU fetches the opcode at the trap address, returns new pins
+// data can be modified to change the opcode that gets executed
+typedef uint64_t(*C64FetchTrap)(c64_t* sys, uint64_t pins, void* user_data);
+
 uint32_t C64ExecEmu(c64_t* sys, uint32_t micro_seconds);
+void C64SetFetchTrap(uint16_t address, C64FetchTrap trap_func, void* user_data);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -21,6 +21,10 @@ void FC64Config::ReadFromJson(const nlohmann::json& jsonConfigFile)
 		bShowHCounter = jsonConfigFile["ShowHCounter"];
 	if (jsonConfigFile.contains("ShowVICOverlay"))
 		bShowVICOverlay = jsonConfigFile["ShowVICOverlay"];
+	if (jsonConfigFile.contains("FastLoad"))
+		bFastLoad = jsonConfigFile["FastLoad"];
+	if (jsonConfigFile.contains("WarpLoading"))
+		bWarpLoading = jsonConfigFile["WarpLoading"];
 
 	// fixup paths
 	if (TapesFolder.back() != '/')
@@ -42,6 +46,8 @@ void FC64Config::WriteToJson(nlohmann::json& jsonConfigFile) const
 	jsonConfigFile["CrtFolder"] = CrtFolder;
 	jsonConfigFile["ShowHCounter"] = bShowHCounter;
 	jsonConfigFile["ShowVICOverlay"] = bShowVICOverlay;
+	jsonConfigFile["FastLoad"] = bFastLoad;
+	jsonConfigFile["WarpLoading"] = bWarpLoading;
 }
 
 void FC64ProjectConfig::LoadFromJson(const nlohmann::json& jsonConfig)
@@ -17,6 +17,8 @@ struct FC64Config : public FGlobalConfig
 
 	bool		bShowHCounter = false;
 	bool		bShowVICOverlay = false;
+	bool		bFastLoad = true;		// load D64/T64 files by trapping the KERNAL LOAD routine
+	bool		bWarpLoading = true;	// run unthrottled while loading
 
 protected:
 
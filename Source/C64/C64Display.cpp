@@ -261,6 +261,7 @@ void FC64Display::DrawUI()
 			dl->AddLine(ImVec2(pos.x + (disp.screen.width * scale), pos.y + (scanlineY * scale)), ImVec2(pos.x + (disp.screen.width + 32) * scale, pos.y + (scanlineY * scale)), col);
 		}
 	}
+	debugger.GetScanlineTimeline().DrawBeamChart(ImVec2(pos.x + (disp.screen.width + 36) * scale, pos.y), 96 * scale, scale, topScreenScanLine, disp.screen.height);
 
 	// Draw an indicator to show which scanline is being drawn
 	if (config.bShowScanLineIndicator && CodeAnalysis->Debugger.IsStopped())
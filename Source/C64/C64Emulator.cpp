@@ -11,11 +11,16 @@
 
 #include "C64Config.h"
 #include <CodeAnalyser/CodeAnalysisJson.h>
+#include <CodeAnalyser/RomAnalysisImage.h>
 #include <CodeAnalyser/CodeAnalysisState.h>
 #include "CodeAnalyser/UI/CharacterMapViewer.h"
 #include <Debug/DebugLog.h>
 
 #include "FileLoaders/CRTFile.h"
+#include "C64ChipsImpl.h"
+#include <array>
+#include <chrono>
+#include <utility>
 
 
 const char* kGlobalConfigFilename = "GlobalConfig.json";
@@ -39,6 +44,20 @@ void DebugCB(void* user_data, uint64_t pins)
 	pC64Emu->OnCPUTick(pins);
 }
 
+// KERNAL LOAD routine, entered from $FFD5 via the ILOAD vector at $0330
+static const uint16_t kKernalLoadAddress = 0xF4A5;
+// KERNAL serial bus routines - used to detect the 1541 being busy
+static const uint16_t kKernalSerialStart = 0xED09;
+static const uint16_t kKernalSerialEnd = 0xEEBB;
+static const int kSerialBusWarpFrames = 50;
+static const int kFileLoadTimeoutFrames = 250;	// give up waiting on a load phase after 5 seconds of machine time
+
+static uint64_t KernalLoadTrapCB(c64_t* sys, uint64_t pins, void* user_data)
+{
+	FC64Emulator* pC64Emu = (FC64Emulator*)user_data;
+	return pC64Emu->KernalLoadTrap(pins);
+}
+
 class F6502MemDescGenerator : public FMemoryRegionDescGenerator
 {
 public:
@@ -123,6 +142,7 @@ bool FC64Emulator::Init(const FEmulatorLaunchConfig& launchConfig)
 	c64_init(&C64Emu, &desc);
 
 	Display.Init(&CodeAnalysis, this);
+	C64SetFetchTrap(kKernalLoadAddress, KernalLoadTrapCB, this);
 
 	LoadFont();
 
@@ -157,6 +177,8 @@ bool FC64Emulator::Init(const FEmulatorLaunchConfig& launchConfig)
 	CodeAnalysis.MapBank(BankIds.RAMBehindCharROM, 52, EBankAccess::Write);  // Map because VIC needs map address to be set - hack
 	CodeAnalysis.MapBank(BankIds.RAMBehindKernelROM, 56, EBankAccess::Write);
 
+	InitMemoryConfigs();
+
 	// Setup VIC Bank Mapping 16 * 4k pages
 	VICBankMapping[0x0] = BankIds.LowerRAM;
 	VICBankMapping[0x1] = BankIds.CharacterROM;
@@ -179,6 +201,7 @@ bool FC64Emulator::Init(const FEmulatorLaunchConfig& launchConfig)
 	AddGamesList("PRG File", GetC64GlobalConfig()->PrgFolder.c_str());
 	AddGamesList("Tape File", GetC64GlobalConfig()->TapesFolder.c_str());
 	AddGamesList("Crt File", GetC64GlobalConfig()->CrtFolder.c_str());
+	AddGamesList("Disk File", GetC64GlobalConfig()->DisksFolder.c_str());
 
 	// setup code analysis
 	CodeAnalysis.Init(this);
@@ -222,61 +245,62 @@ void FC64Emulator::SetupCodeAnalysisLabels()
 	// Add Stack??
 }
 
-void FC64Emulator::UpdateCodeAnalysisPages(uint8_t cpuPort)
+// Build the bank mappings for each CPU port value up front so port writes are cheap
+void FC64Emulator::InitMemoryConfigs(void)
 {
-	bBasicROMMapped = false;
-	bKernelROMMapped = false;
-	bCharacterROMMapped = false;
-	bIOMapped = false;
-
-	/* shortcut if HIRAM and LORAM is 0, everything is RAM */
-	if ((cpuPort & (C64_CPUPORT_HIRAM | C64_CPUPORT_LORAM)) == 0)
-	{
-		// Map in all RAM
-		CodeAnalysis.MapBank(BankIds.RAMBehindBasicROM, 40, EBankAccess::ReadWrite);          // RAM Under BASIC ROM - $A000-$BFFF - pages 40-47 - 8k
-		CodeAnalysis.MapBank(BankIds.RAMBehindCharROM, 52, EBankAccess::ReadWrite);           // RAM Under Char ROM - %D000 - $DFFF - page 52-55 - 4k
-		CodeAnalysis.MapBank(BankIds.RAMBehindKernelROM, 56, EBankAccess::ReadWrite);         // RAM Under Kernel ROM - $E000-$FFFF - pages 56-63 - 8k
-	}
-	else
+	for (uint8_t cpuPort = 0; cpuPort < 8; cpuPort++)
 	{
+		FCodeAnalysisMemoryConfig& config = MemoryConfigs[cpuPort];
+		config.Reset();
+
+		/* shortcut if HIRAM and LORAM is 0, everything is RAM */
+		if ((cpuPort & (C64_CPUPORT_HIRAM | C64_CPUPORT_LORAM)) == 0)
+		{
+			// Map in all RAM
+			config.MapBank(CodeAnalysis.GetBank(BankIds.RAMBehindBasicROM), 40, EBankAccess::ReadWrite);          // RAM Under BASIC ROM - $A000-$BFFF - pages 40-47 - 8k
+			config.MapBank(CodeAnalysis.GetBank(BankIds.RAMBehindCharROM), 52, EBankAccess::ReadWrite);           // RAM Under Char ROM - %D000 - $DFFF - page 52-55 - 4k
+			config.MapBank(CodeAnalysis.GetBank(BankIds.RAMBehindKernelROM), 56, EBankAccess::ReadWrite);         // RAM Under Kernel ROM - $E000-$FFFF - pages 56-63 - 8k
+			continue;
+		}
+
 		/* A000..BFFF is either RAM-behind-BASIC-ROM or RAM */
 		// both bits are set
 		if ((cpuPort & (C64_CPUPORT_HIRAM | C64_CPUPORT_LORAM)) == (C64_CPUPORT_HIRAM | C64_CPUPORT_LORAM))
-		{
-			CodeAnalysis.MapBank(BankIds.BasicROM, 40, EBankAccess::Read);       // BASIC ROM - $A000-$BFFF - pages 40-47 - 8k
-			bBasicROMMapped = true;
-		}
+			config.MapBank(CodeAnalysis.GetBank(BankIds.BasicROM), 40, EBankAccess::Read);       // BASIC ROM - $A000-$BFFF - pages 40-47 - 8k
 		else
-		{
-			CodeAnalysis.MapBank(BankIds.RAMBehindBasicROM, 40, EBankAccess::Read);       // RAM Under BASIC ROM - $A000-$BFFF - pages 40-47 - 8k
-		}
+			config.MapBank(CodeAnalysis.GetBank(BankIds.RAMBehindBasicROM), 40, EBankAccess::Read);       // RAM Under BASIC ROM - $A000-$BFFF - pages 40-47 - 8k
 
 		/* E000..FFFF is either RAM-behind-KERNAL-ROM or RAM */
 		if (cpuPort & C64_CPUPORT_HIRAM)
-		{
-			bKernelROMMapped = true;
-			CodeAnalysis.MapBank(BankIds.KernelROM, 56, EBankAccess::Read);      // Kernel ROM - $E000-$FFFF - pages 56-63 - 8k
-		}
+			config.MapBank(CodeAnalysis.GetBank(BankIds.KernelROM), 56, EBankAccess::Read);      // Kernel ROM - $E000-$FFFF - pages 56-63 - 8k
 		else
-		{
-			CodeAnalysis.MapBank(BankIds.RAMBehindKernelROM, 56, EBankAccess::Read);      // RAM Under Kernel ROM - $E000-$FFFF - pages 56-63 - 8k
-		}
+			config.MapBank(CodeAnalysis.GetBank(BankIds.RAMBehindKernelROM), 56, EBankAccess::Read);      // RAM Under Kernel ROM - $E000-$FFFF - pages 56-63 - 8k
 
 		/* D000..DFFF can be Char-ROM or I/O */
 		if (cpuPort & C64_CPUPORT_CHAREN)
 		{
-			bIOMapped = true;
-			CodeAnalysis.MapBank(BankIds.IOArea, 52, EBankAccess::ReadWrite);         // IO System - %D000 - $DFFF - page 52-55 - 4k
+			config.MapBank(CodeAnalysis.GetBank(BankIds.IOArea), 52, EBankAccess::ReadWrite);         // IO System - %D000 - $DFFF - page 52-55 - 4k
 		}
 		else
 		{
-			bCharacterROMMapped = true;
-			CodeAnalysis.MapBank(BankIds.CharacterROM, 52, EBankAccess::Read);       // Character ROM - %D000 - $DFFF - page 52-55 - 4k
-			CodeAnalysis.MapBank(BankIds.RAMBehindCharROM, 52, EBankAccess::Write);
+			config.MapBank(CodeAnalysis.GetBank(BankIds.CharacterROM), 52, EBankAccess::Read);       // Character ROM - %D000 - $DFFF - page 52-55 - 4k
+			config.MapBank(CodeAnalysis.GetBank(BankIds.RAMBehindCharROM), 52, EBankAccess::Write);
 		}
 	}
 }
 
+void FC64Emulator::UpdateCodeAnalysisPages(uint8_t cpuPort)
+{
+	const bool bAllRAM = (cpuPort & (C64_CPUPORT_HIRAM | C64_CPUPORT_LORAM)) == 0;
+
+	bBasicROMMapped = (cpuPort & (C64_CPUPORT_HIRAM | C64_CPUPORT_LORAM)) == (C64_CPUPORT_HIRAM | C64_CPUPORT_LORAM);
+	bKernelROMMapped = (cpuPort & C64_CPUPORT_HIRAM) != 0;
+	bIOMapped = bAllRAM == false && (cpuPort & C64_CPUPORT_CHAREN) != 0;
+	bCharacterROMMapped = bAllRAM == false && (cpuPort & C64_CPUPORT_CHAREN) == 0;
+
+	CodeAnalysis.ApplyMemoryConfig(MemoryConfigs[cpuPort & 7]);
+}
+
 // Note : can be passed nullptr on a reset
 bool FC64Emulator::LoadProject(FProjectConfig* pProjectConfig, bool bLoadGameData)
 {
@@ -353,7 +377,7 @@ bool FC64Emulator::LoadProject(FProjectConfig* pProjectConfig, bool bLoadGameDat
 	}
 
 	if (FileExists(kROMAnalysisFilename))
-		ImportAnalysisJson(CodeAnalysis, kROMAnalysisFilename);
+		ImportRomAnalysis(CodeAnalysis, kROMAnalysisFilename);
 
 
 	/*if (bLoadSnapshot)
@@ -422,17 +446,35 @@ bool FC64Emulator::LoadEmulatorFile(const FEmulatorFile* pSnapshot)
 		}
 	}
 	break;
-	// C64 disks aren't implmented yet :(
+	// disk & T64 images are loaded by trapping the KERNAL LOAD routine, disks go to the 1541 when fast load is off
 	case EEmuFileType::D64:
+		if (GetC64GlobalConfig()->bFastLoad == false)
+		{
+			chips_range_t diskData;
+			diskData.ptr = LoadBinaryFile(fileName.c_str(), diskData.size);
+			if (diskData.ptr != nullptr)
+			{
+				c1541_insert_disc(&C64Emu.c1541, diskData);
+				free(diskData.ptr);
+				LoadedFileType = EC64FileType::Disk;
+				return true;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		[[fallthrough]];
+	case EEmuFileType::T64:
 	{
-		chips_range_t diskData;
-		diskData.ptr = LoadBinaryFile(fileName.c_str(), diskData.size);
-		if (diskData.ptr != nullptr)
+		size_t imageSize = 0;
+		uint8_t* pImageData = (uint8_t*)LoadBinaryFile(fileName.c_str(), imageSize);
+		if (pImageData != nullptr)
 		{
-			c1541_insert_disc(&C64Emu.c1541, diskData);
-			free(diskData.ptr);
+			const bool bSuccess = pSnapshot->Type == EEmuFileType::D64 ? FileImage.LoadD64(pImageData, imageSize) : FileImage.LoadT64(pImageData, imageSize);
+			free(pImageData);
 			LoadedFileType = EC64FileType::Disk;
-			return true;
+			return bSuccess;
 		}
 		else
 		{
@@ -489,12 +531,12 @@ bool FC64Emulator::NewProjectFromEmulatorFile(const FEmulatorFile& emuFile)
 		if (emuFile.Type == EEmuFileType::CRT)	// cartridge can start instantly
 		{
 			LoadEmulatorFile(&emuFile);
-			FileLoadPhase = EFileLoadPhase::Run;
+			SetFileLoadPhase(EFileLoadPhase::Run);
 			CodeAnalysis.Debugger.Break();
 		}
 		else
 		{
-			FileLoadPhase = EFileLoadPhase::Reset;
+			SetFileLoadPhase(EFileLoadPhase::Reset);
 		}
 
 		return true;
@@ -615,6 +657,7 @@ void FC64Emulator::Shutdown()
 	pGlobalConfig->Save(kGlobalConfigFilename);
 
 	//ui_c64_discard(&C64UI);
+	C64SetFetchTrap(0, nullptr, nullptr);
 	c64_discard(&C64Emu);
 
 	FEmuBase::Shutdown();
@@ -698,6 +741,8 @@ void	FC64Emulator::OptionsMenuAdditions(void)
 	FC64Config* pC64Config = GetC64GlobalConfig();
 	ImGui::MenuItem("Show H Counter", 0, &pC64Config->bShowHCounter);
 	ImGui::MenuItem("Show VIC Overlay", 0, &pC64Config->bShowVICOverlay);
+	ImGui::MenuItem("Fast Load Disks/T64", 0, &pC64Config->bFastLoad);
+	ImGui::MenuItem("Warp Speed Loading", 0, &pC64Config->bWarpLoading);
 }
 
 void	FC64Emulator::WindowsMenuAdditions(void) 
@@ -705,6 +750,180 @@ void	FC64Emulator::WindowsMenuAdditions(void)
 }
 
 
+void FC64Emulator::ExecuteEmulation(uint32_t microSeconds)
+{
+	CodeAnalysis.OnFrameStart();
+	//StoreRegisters_6502(CodeAnalysis);
+
+	C64ExecEmu(&C64Emu, microSeconds);
+
+	CodeAnalysis.OnFrameEnd();
+}
+
+// Is the machine booting or waiting on the tape/drive
+// The file load phases after boot don't count - warp is driven by tape motor & serial bus activity
+bool FC64Emulator::IsLoading()
+{
+	switch (FileLoadPhase)
+	{
+	case EFileLoadPhase::Reset:
+	case EFileLoadPhase::BasicReady:
+	case EFileLoadPhase::Loaded:
+		return true;
+	default:
+		break;
+	}
+
+	if (LoadedFileType == EC64FileType::Tape && c64_is_tape_motor_on(&C64Emu))
+		return true;
+
+	return CodeAnalysis.CurrentFrameNo - LastSerialBusFrame < kSerialBusWarpFrames;
+}
+
+void FC64Emulator::SetFileLoadPhase(EFileLoadPhase phase)
+{
+	FileLoadPhase = phase;
+	FileLoadPhaseStartFrame = CodeAnalysis.CurrentFrameNo;
+}
+
+// don't wait forever on phases which rely on the machine getting somewhere
+void FC64Emulator::UpdateFileLoadTimeout()
+{
+	if (CodeAnalysis.CurrentFrameNo - FileLoadPhaseStartFrame < kFileLoadTimeoutFrames)
+		return;
+
+	switch (FileLoadPhase)
+	{
+	case EFileLoadPhase::Reset:
+		LOGWARNING("File load: machine didn't reach BASIC READY");
+		SetFileLoadPhase(EFileLoadPhase::Run);
+		break;
+	case EFileLoadPhase::FileLoading:
+		LOGWARNING("File load: KERNAL LOAD wasn't called");
+		SetFileLoadPhase(EFileLoadPhase::Run);
+		break;
+	case EFileLoadPhase::FileLoaded:
+		LOGINFO("File load: program didn't return to READY, assuming it autostarted");
+		SetFileLoadPhase(EFileLoadPhase::Run);
+		break;
+	default:
+		break;
+	}
+}
+
+// Run extra frames while loading, for a limited amount of real time so the UI stays responsive
+void FC64Emulator::ExecuteWarpLoading()
+{
+	if (GetC64GlobalConfig()->bWarpLoading == false)
+		return;
+
+	const auto startTime = std::chrono::steady_clock::now();
+	while (IsLoading() && CodeAnalysis.Debugger.IsStopped() == false)
+	{
+		if (std::chrono::steady_clock::now() - startTime > std::chrono::milliseconds(kWarpLoadingMilliSeconds))
+			break;
+		ExecuteEmulation(20000);
+	}
+}
+
+// put text in the KERNAL keyboard buffer - max 10 chars
+void FC64Emulator::TypeIntoKeyboardBuffer(const char* pText)
+{
+	const uint16_t kKeyboardBuffer = 0x0277;
+	const uint16_t kKeyboardBufferCount = 0xC6;
+	int noChars = 0;
+	while (pText[noChars] != 0 && noChars < 10)
+	{
+		WriteByte(kKeyboardBuffer + noChars, (uint8_t)pText[noChars]);
+		noChars++;
+	}
+	WriteByte(kKeyboardBufferCount, noChars);
+}
+
+// Called when the CPU fetches the opcode at the start of the KERNAL LOAD routine
+// Entry: A = 0 load/1 verify, $C3/$C4 = load address, $BA = device, $B9 = secondary address, $B7/$BB/$BC = file name
+// If we have the file, copy it into memory & replace the opcode with RTS so it returns to the caller
+uint64_t FC64Emulator::KernalLoadTrap(uint64_t pins)
+{
+	if (GetC64GlobalConfig()->bFastLoad == false || bKernelROMMapped == false)
+		return pins;
+
+	// not ours - let the normal load run
+	const uint8_t deviceNo = ReadByte(0xBA);
+	if (FileImage.IsDeviceHandled(deviceNo) == false)
+	{
+		if (FileLoadPhase == EFileLoadPhase::FileLoading)
+			SetFileLoadPhase(EFileLoadPhase::Run);
+		return pins;
+	}
+
+	m6502_t& cpu = C64Emu.cpu;
+	const bool bVerify = cpu.A != 0;
+
+	uint8_t fileName[256];
+	const int nameLength = ReadByte(0xB7);
+	const uint16_t namePtr = ReadWord(0xBB);
+	for (int i = 0; i < nameLength; i++)
+		fileName[i] = ReadByte(namePtr + i);
+
+	std::vector<uint8_t> dirListing;
+	const std::vector<uint8_t>* pPRGData = nullptr;
+	if (deviceNo == 8 && nameLength == 1 && fileName[0] == '$')
+	{
+		FileImage.GenerateDirectoryListing(dirListing);
+		pPRGData = &dirListing;
+	}
+	else
+	{
+		const FC64ImageFile* pFile = FileImage.FindFile(fileName, nameLength);
+		if (pFile != nullptr)
+			pPRGData = &pFile->Data;
+	}
+
+	bool bLoaded = false;
+	if (pPRGData == nullptr || pPRGData->size() < 2)
+	{
+		LOGWARNING("Fast Load: file '%.*s' not found", nameLength, (const char*)fileName);
+		cpu.A = 4;	// FILE NOT FOUND
+		cpu.P |= M6502_CF;
+	}
+	else
+	{
+		// secondary address 0 loads to the address passed in, otherwise use the file's address
+		const uint16_t fileAddress = (*pPRGData)[0] | ((*pPRGData)[1] << 8);
+		const uint16_t loadAddress = ReadByte(0xB9) == 0 ? ReadWord(0xC3) : fileAddress;
+		uint16_t address = loadAddress;
+		uint8_t status = 0;
+
+		for (size_t i = 2; i < pPRGData->size(); i++, address++)
+		{
+			const uint8_t val = (*pPRGData)[i];
+			if (bVerify == false)
+				WriteByte(address, val);
+			else if (ReadByte(address) != val)
+				status |= 0x10;	// verify error
+		}
+
+		// return end address in X/Y & $AE/$AF
+		WriteByte(0x90, status);
+		WriteByte(0xAE, address & 0xff);
+		WriteByte(0xAF, address >> 8);
+		cpu.X = address & 0xff;
+		cpu.Y = address >> 8;
+		cpu.P &= ~M6502_CF;
+
+		LOGINFO("Fast Load: '%.*s' $%04X-$%04X", nameLength, (const char*)fileName, loadAddress, address);
+		bLoaded = bVerify == false;
+	}
+
+	// nothing to RUN if the load failed
+	if (FileLoadPhase == EFileLoadPhase::FileLoading)
+		SetFileLoadPhase(bLoaded ? EFileLoadPhase::FileLoaded : EFileLoadPhase::Run);
+
+	M6502_SET_DATA(pins, 0x60);	// RTS
+	return pins;
+}
+
 void FC64Emulator::Tick()
 {
 	FEmuBase::Tick();
@@ -717,39 +936,46 @@ void FC64Emulator::Tick()
 	{
 		const float frameTime = (float)std::min(1000000.0f / ImGui::GetIO().Framerate, 32000.0f) * 1.0f;// speccyInstance.ExecSpeedScale;
 	
-		CodeAnalysis.OnFrameStart();
-		//StoreRegisters_6502(CodeAnalysis);
-
-		c64_exec(&C64Emu, (uint32_t)std::max(static_cast<uint32_t>(frameTime), uint32_t(1)));
-
-		CodeAnalysis.OnFrameEnd();
+		ExecuteEmulation((uint32_t)std::max(static_cast<uint32_t>(frameTime), uint32_t(1)));
+		ExecuteWarpLoading();
 	}
 	DrawDockingView();
 
+	UpdateFileLoadTimeout();
 	switch(FileLoadPhase)
 	{
 		case EFileLoadPhase::BasicReady:
 			LoadEmulatorFile(&EmulatorFileToLoad);
 			//GamesList.LoadGame(pCurrentGameConfig->Name.c_str());
-			FileLoadPhase = EFileLoadPhase::Loaded;
+			SetFileLoadPhase(EFileLoadPhase::Loaded);
 			break;
 		case EFileLoadPhase::Loaded:
 			switch(LoadedFileType)
 			{
 				case EC64FileType::PRG:
 					c64_basic_run(&C64Emu);
-					FileLoadPhase = EFileLoadPhase::Run;
+					SetFileLoadPhase(EFileLoadPhase::Run);
 					break;
 				case EC64FileType::Tape:
 					c64_basic_load(&C64Emu);
 					c64_tape_play(&C64Emu);
-					FileLoadPhase = EFileLoadPhase::TapePlaying;
+					SetFileLoadPhase(EFileLoadPhase::TapePlaying);
 					break;
-				default:
+				case EC64FileType::Disk:
+					// LOAD"*",8,1 - abbreviated so it fits in the keyboard buffer
+					TypeIntoKeyboardBuffer(FileImage.GetType() == EC64FileImageType::T64 ? "L\xCF\"*\",1,1\r" : "L\xCF\"*\",8,1\r");
+					SetFileLoadPhase(GetC64GlobalConfig()->bFastLoad ? EFileLoadPhase::FileLoading : EFileLoadPhase::Run);
+					break;
+				default:	// nothing loaded or nothing to start
+					SetFileLoadPhase(EFileLoadPhase::Run);
 					break;
 			}
 			
 			break;
+		case EFileLoadPhase::FileReady:
+			c64_basic_run(&C64Emu);
+			SetFileLoadPhase(EFileLoadPhase::Run);
+			break;
 
 		default:
 			break;
@@ -830,6 +1056,9 @@ void FC64Emulator::FixupAddressRefs()
 	FixupCharacterMapAddressRefs(CodeAnalysis);
 	FixupCharacterSetAddressRefs(CodeAnalysis);
 
+	// access tables are keyed on PC
+	IOAnalysis.FixupAddressRefs();
+
 	// Fixup viewers
 	pCharacterMapViewer->FixupAddressRefs();
 	pGraphicsViewer->FixupAddressRefs();
@@ -930,8 +1159,13 @@ int    FC64Emulator::OnCPUTrap(uint16_t pc, int ticks, uint64_t pins)
 	return 0;
 }
 
-uint64_t FC64Emulator::OnCPUTick(uint64_t pins)
+// Tick handler for a set of analysis features - see ETickFeature
+template<uint32_t kTickFeatures>
+uint64_t FC64Emulator::OnCPUTickWithFeatures(uint64_t pins)
 {
+	constexpr bool bAccessTracking = (kTickFeatures & ETickFeature::AccessTracking) != 0;
+	constexpr bool bIOAnalysis = (kTickFeatures & ETickFeature::IOAnalysis) != 0;
+
 	FCodeAnalysisState& state = CodeAnalysis;
 
 	const uint16_t pc = GetPC().Address;
@@ -953,18 +1187,18 @@ uint64_t FC64Emulator::OnCPUTick(uint64_t pins)
 	}
 
 	// trigger frame events on scanline pos
-	static uint16_t lastScanlinePos = 0;
 	const uint16_t scanlinePos = C64Emu.vic.rs.v_count;
-	if (scanlinePos != lastScanlinePos)
+	if (scanlinePos != LastScanlinePos)
 	{
+		if(scanlinePos == 0)	// start the frame before the scanline so it lands in the new frame
+			CodeAnalysis.OnMachineFrameStart();
+
 		CodeAnalysis.Debugger.OnScanlineStart(scanlinePos);
 
-		if(scanlinePos == 0)
-			CodeAnalysis.OnMachineFrameStart();
-		else if(scanlinePos == M6569_VTOTAL - 1)    // last scanline
+		if(scanlinePos == M6569_VTOTAL - 1)    // last scanline
 			CodeAnalysis.OnMachineFrameEnd();
 
-		lastScanlinePos = scanlinePos;
+		LastScanlinePos = scanlinePos;
 	}
 
 	const bool bReadingInstruction = addr == m6502_pc(&C64Emu.cpu) - 1;
@@ -973,12 +1207,13 @@ uint64_t FC64Emulator::OnCPUTick(uint64_t pins)
 	{
 		if (pins & M6502_RW)
 		{
-			if (state.bRegisterDataAccesses)
+			if constexpr (bAccessTracking)
 				RegisterDataRead(CodeAnalysis, pc, addr);   // this gives false positives on indirect addressing e.g. STA ($0a),y
 
 			if (bIOMapped && (addr >> 12) == 0xd)
 			{
-				IOAnalysis.RegisterIORead(addr, GetPC());
+				if constexpr (bIOAnalysis)
+					IOAnalysis.RegisterIORead(addr, GetPC());
 				uint8_t readVal = 0;
 				if (CartridgeManager.HandleIORead(addr, readVal))
 				{
@@ -988,26 +1223,30 @@ uint64_t FC64Emulator::OnCPUTick(uint64_t pins)
 		}
 		else
 		{
-			if (state.bRegisterDataAccesses)
+			if constexpr (bAccessTracking)
 			{
 				RegisterDataWrite(CodeAnalysis, pc, addr, val);
-			}
 
-			FAddressRef pcRef = state.AddressRefFromPhysicalAddress(pc);
-			FAddressRef addrRef = state.AddressRefFromPhysicalAddress(addr);
-			state.SetLastWriterForAddress(addr, pcRef);
+				FAddressRef pcRef = state.AddressRefFromPhysicalAddress(pc);
+				state.SetLastWriterForAddress(addr, pcRef);
+			}
 
 			if (bIOMapped && (addr >> 12) == 0xd)
 			{
-				IOAnalysis.RegisterIOWrite(addr, val, GetPC());
+				if constexpr (bIOAnalysis)
+					IOAnalysis.RegisterIOWrite(addr, val, GetPC());
 				IOMemBuffer[addr & 0xfff] = val;
 				
 				CartridgeManager.HandleIOWrite(addr,val);
 			}
 
-			FCodeInfo* pCodeWrittenTo = CodeAnalysis.GetCodeInfoForAddress(addrRef);
-			if (pCodeWrittenTo != nullptr && pCodeWrittenTo->bSelfModifyingCode == false)
-				pCodeWrittenTo->bSelfModifyingCode = true;
+			if constexpr (bAccessTracking)
+			{
+				FAddressRef addrRef = state.AddressRefFromPhysicalAddress(addr);
+				FCodeInfo* pCodeWrittenTo = CodeAnalysis.GetCodeInfoForAddress(addrRef);
+				if (pCodeWrittenTo != nullptr && pCodeWrittenTo->bSelfModifyingCode == false)
+					pCodeWrittenTo->bSelfModifyingCode = true;
+			}
 		}
 	}
 	else
@@ -1018,8 +1257,16 @@ uint64_t FC64Emulator::OnCPUTick(uint64_t pins)
 		if(FileLoadPhase == EFileLoadPhase::Reset)
 		{
 			if(pc == 0xE5CD)
-				FileLoadPhase = EFileLoadPhase::BasicReady;
+				SetFileLoadPhase(EFileLoadPhase::BasicReady);
 		}
+		else if (FileLoadPhase == EFileLoadPhase::FileLoaded)
+		{
+			if (pc == 0xE5CD)	// back at READY
+				SetFileLoadPhase(EFileLoadPhase::FileReady);
+		}
+
+		if (pc >= kKernalSerialStart && pc < kKernalSerialEnd && bKernelROMMapped)
+			LastSerialBusFrame = CodeAnalysis.CurrentFrameNo;
 	}
 
 	const bool bNeedMemUpdate = ((C64Emu.cpu_port ^ LastMemPort) & 7) != 0;
@@ -1030,7 +1277,23 @@ uint64_t FC64Emulator::OnCPUTick(uint64_t pins)
 		LastMemPort = C64Emu.cpu_port & 7;
 	}
 
-	CodeAnalysis.OnCPUTick(pins);
+	CodeAnalysis.OnCPUTick<kTickFeatures>(pins);
 
 	return pins;
 }
+
+// one tick handler for each feature combination
+typedef uint64_t (FC64Emulator::*FCPUTickHandler)(uint64_t pins);
+
+template<uint32_t... kFeatureSets>
+static constexpr std::array<FCPUTickHandler, sizeof...(kFeatureSets)> MakeCPUTickHandlers(std::integer_sequence<uint32_t, kFeatureSets...>)
+{
+	return { &FC64Emulator::OnCPUTickWithFeatures<kFeatureSets>... };
+}
+
+static constexpr auto g_CPUTickHandlers = MakeCPUTickHandlers(std::make_integer_sequence<uint32_t, ETickFeature::NoCombinations>());
+
+uint64_t FC64Emulator::OnCPUTick(uint64_t pins)
+{
+	return (this->*g_CPUTickHandlers[CodeAnalysis.GetTickFeatures()])(pins);
+}
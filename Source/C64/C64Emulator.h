@@ -31,6 +31,7 @@
 #include "IOAnalysis/C64IOAnalysis.h"
 #include "GraphicsViewer/C64GraphicsViewer.h"
 #include "FileLoaders/CRTFile.h"
+#include "FileLoaders/C64FileImage.h"
 
 enum class EC64Event
 {
@@ -66,7 +67,10 @@ enum class EFileLoadPhase
 	BasicReady,
 	Loaded,
 	Run,
-	TapePlaying
+	TapePlaying,
+	FileLoading,	// LOAD typed, waiting for the KERNAL trap to load the file
+	FileLoaded,		// trap has loaded the file, waiting for BASIC to get back to READY
+	FileReady,		// back at READY - type RUN
 };
 
 struct FC64BankIds
@@ -133,6 +137,7 @@ public:
 	void WriteByte(uint16_t address, uint8_t value) override
 	{
 		mem_wr(&C64Emu.mem_cpu, address, value);
+		CodeAnalysis.OnMemoryPoked(address);
 	}
 
 	FAddressRef GetPC() override
@@ -154,6 +159,7 @@ public:
 
 	c64_desc_t GenerateC64Desc(c64_joystick_type_t joy_type);
 	void SetupCodeAnalysisLabels(void);
+	void InitMemoryConfigs(void);
 	void UpdateCodeAnalysisPages(uint8_t cpuPort);
 	FAddressRef	GetVICMemoryAddress(uint16_t vicAddress) const	// VIC address is 14bit (16K range)
 	{
@@ -186,6 +192,8 @@ public:
 	void    OnBoot(void);
 	int     OnCPUTrap(uint16_t pc, int ticks, uint64_t pins);
 	uint64_t    OnCPUTick(uint64_t pins);
+	template<uint32_t kTickFeatures> uint64_t	OnCPUTickWithFeatures(uint64_t pins);
+	uint64_t	KernalLoadTrap(uint64_t pins);
 
 	c64_t*	GetEmu() {return &C64Emu;}
 	const FC64IOAnalysis&	GetC64IOAnalysis() { return IOAnalysis; }
@@ -195,11 +203,19 @@ public:
 
 	void	SetLoadedFileType(EC64FileType type) { LoadedFileType = type;}
 private:
+	void	ExecuteEmulation(uint32_t microSeconds);
+	void	ExecuteWarpLoading();
+	bool	IsLoading();
+	void	SetFileLoadPhase(EFileLoadPhase phase);
+	void	UpdateFileLoadTimeout();
+	void	TypeIntoKeyboardBuffer(const char* pText);
+
 	c64_t       C64Emu;
 	double      ExecTime;
 
 	EC64FileType	LoadedFileType = EC64FileType::None;
 	EFileLoadPhase	FileLoadPhase = EFileLoadPhase::Idle;
+	int				FileLoadPhaseStartFrame = 0;
 
 	const FGameInfo*	CurrentGame = nullptr;
 
@@ -209,9 +225,15 @@ private:
 
 	uint8_t             LastMemPort = 0x7;		// Default startup
 	uint16_t            PreviousPC = 0;
+	uint16_t            LastScanlinePos = 0;
 
 	FCartridgeManager	CartridgeManager;
 
+	// fast loading
+	FC64FileImage		FileImage;
+	int					LastSerialBusFrame = -1000;
+	static const int	kWarpLoadingMilliSeconds = 12;	// real time to spend on extra frames when loading
+
 	FC64IOAnalysis		IOAnalysis;
 	std::set<FAddressRef>	InterruptHandlers;
 
@@ -223,6 +245,7 @@ private:
 
 	FC64BankIds			BankIds;
 	uint16_t			VICBankMapping[16];
+	FCodeAnalysisMemoryConfig	MemoryConfigs[8];	// indexed by CPU port bits 0-2
 
 	FC64Emulator(const FC64Emulator&) = delete;				// Prevent copy-construction
 	FC64Emulator& operator=(const FC64Emulator&) = delete;	// Prevent assignment
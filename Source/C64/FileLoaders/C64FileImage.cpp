@@ -0,0 +1,263 @@
+#include "C64FileImage.h"
+
+#include <algorithm>
+#include <cstring>
+#include <Debug/DebugLog.h>
+
+// http://unusedino.de/ec64/technical/formats/d64.html
+// http://unusedino.de/ec64/technical/formats/t64.html
+
+static const int kD64SectorSize = 256;
+static const int kD64DirTrack = 18;
+static const uint8_t kPETSCIIPadding = 0xA0;
+
+static const char* kFileTypeNames[] = { "DEL", "SEQ", "PRG", "USR", "REL" };
+
+static int GetD64SectorsForTrack(int track)
+{
+	if (track <= 17)
+		return 21;
+	else if (track <= 24)
+		return 19;
+	else if (track <= 30)
+		return 18;
+	else
+		return 17;
+}
+
+static const uint8_t* GetD64Sector(const uint8_t* pData, size_t dataSize, int track, int sector)
+{
+	if (track < 1 || track > 40 || sector < 0 || sector >= GetD64SectorsForTrack(track))
+		return nullptr;
+
+	size_t offset = 0;
+	for (int t = 1; t < track; t++)
+		offset += GetD64SectorsForTrack(t) * kD64SectorSize;
+	offset += sector * kD64SectorSize;
+
+	if (offset + kD64SectorSize > dataSize)
+		return nullptr;
+	return pData + offset;
+}
+
+// get a name string from a padded buffer
+static std::string GetPaddedName(const uint8_t* pName, int maxLength, uint8_t padding)
+{
+	int length = 0;
+	while (length < maxLength && pName[length] != padding)
+		length++;
+	return std::string((const char*)pName, length);
+}
+
+void FC64FileImage::Clear()
+{
+	Type = EC64FileImageType::None;
+	ImageName.clear();
+	ImageId.clear();
+	FreeBlocks = 0;
+	Files.clear();
+}
+
+bool FC64FileImage::LoadD64(const uint8_t* pData, size_t dataSize)
+{
+	Clear();
+
+	const uint8_t* pBAM = GetD64Sector(pData, dataSize, kD64DirTrack, 0);
+	if (pBAM == nullptr)
+		return false;
+
+	ImageName = GetPaddedName(pBAM + 0x90, 16, kPETSCIIPadding);
+	ImageId = std::string((const char*)pBAM + 0xA2, 5);
+	for (int track = 1; track <= 35; track++)
+	{
+		if (track != kD64DirTrack)
+			FreeBlocks += pBAM[4 + (track - 1) * 4];
+	}
+
+	// walk the directory sector chain
+	const int kMaxSectors = 683;	// sectors on a 35 track disk - stops us getting stuck in loops
+	int dirTrack = pBAM[0];
+	int dirSector = pBAM[1];
+	for (int sectorCount = 0; dirTrack != 0 && sectorCount < kMaxSectors; sectorCount++)
+	{
+		const uint8_t* pDirSector = GetD64Sector(pData, dataSize, dirTrack, dirSector);
+		if (pDirSector == nullptr)
+			break;
+
+		for (int entryNo = 0; entryNo < 8; entryNo++)
+		{
+			const uint8_t* pEntry = pDirSector + entryNo * 32;
+			const uint8_t fileType = pEntry[2];
+			if ((fileType & 0x7) == 0)	// deleted/empty
+				continue;
+
+			FC64ImageFile file;
+			file.Name = GetPaddedName(pEntry + 5, 16, kPETSCIIPadding);
+			file.FileType = fileType;
+			file.NoBlocks = pEntry[30] | (pEntry[31] << 8);
+
+			// read the file's sector chain
+			int track = pEntry[3];
+			int sector = pEntry[4];
+			for (int fileSectors = 0; track != 0 && fileSectors < kMaxSectors; fileSectors++)
+			{
+				const uint8_t* pSector = GetD64Sector(pData, dataSize, track, sector);
+				if (pSector == nullptr)
+					break;
+				// last sector - sector byte is the index of the last used byte
+				const int lastByte = pSector[0] == 0 ? pSector[1] : kD64SectorSize - 1;
+				if (lastByte >= 2)
+					file.Data.insert(file.Data.end(), pSector + 2, pSector + lastByte + 1);
+				track = pSector[0];
+				sector = pSector[1];
+			}
+
+			Files.push_back(file);
+		}
+
+		dirTrack = pDirSector[0];
+		dirSector = pDirSector[1];
+	}
+
+	Type = EC64FileImageType::D64;
+	LOGINFO("D64: '%s' %d files", ImageName.c_str(), (int)Files.size());
+	return true;
+}
+
+bool FC64FileImage::LoadT64(const uint8_t* pData, size_t dataSize)
+{
+	Clear();
+
+	if (dataSize < 0x40 || memcmp(pData, "C64", 3) != 0)
+		return false;
+
+	const int maxEntries = pData[0x22] | (pData[0x23] << 8);
+	ImageName = GetPaddedName(pData + 0x28, 24, ' ');
+	ImageId = "T64  ";
+
+	for (int entryNo = 0; entryNo < maxEntries; entryNo++)
+	{
+		const size_t entryOffset = 0x40 + entryNo * 32;
+		if (entryOffset + 32 > dataSize)
+			break;
+
+		const uint8_t* pEntry = pData + entryOffset;
+		if (pEntry[0] != 1)	// not a normal tape file
+			continue;
+
+		const uint16_t startAddress = pEntry[2] | (pEntry[3] << 8);
+		const uint16_t endAddress = pEntry[4] | (pEntry[5] << 8);
+		const uint32_t dataOffset = pEntry[8] | (pEntry[9] << 8) | (pEntry[10] << 16) | (pEntry[11] << 24);
+		if (dataOffset >= dataSize)
+			continue;
+
+		// some T64 files have bad end addresses
+		size_t length = (uint16_t)(endAddress - startAddress);
+		if (length == 0 || dataOffset + length > dataSize)
+			length = dataSize - dataOffset;
+
+		FC64ImageFile file;
+		file.Name = GetPaddedName(pEntry + 16, 16, ' ');
+		file.FileType = 0x82;	// closed PRG
+		file.Data.push_back(startAddress & 0xff);
+		file.Data.push_back(startAddress >> 8);
+		file.Data.insert(file.Data.end(), pData + dataOffset, pData + dataOffset + length);
+		file.NoBlocks = (int)(length + 253) / 254;
+		Files.push_back(file);
+	}
+
+	Type = EC64FileImageType::T64;
+	LOGINFO("T64: '%s' %d files", ImageName.c_str(), (int)Files.size());
+	return Files.empty() == false;
+}
+
+bool FC64FileImage::IsDeviceHandled(uint8_t deviceNo) const
+{
+	switch (Type)
+	{
+	case EC64FileImageType::D64:
+		return deviceNo == 8;
+	case EC64FileImageType::T64:
+		return deviceNo == 1;
+	default:
+		return false;
+	}
+}
+
+static bool MatchFileName(const std::string& fileName, const uint8_t* pPattern, int patternLength)
+{
+	for (int i = 0; i < patternLength; i++)
+	{
+		if (pPattern[i] == '*')
+			return true;
+		if (i >= (int)fileName.size())
+			return false;
+		if (pPattern[i] != '?' && pPattern[i] != (uint8_t)fileName[i])
+			return false;
+	}
+	return patternLength == (int)fileName.size();
+}
+
+const FC64ImageFile* FC64FileImage::FindFile(const uint8_t* pName, int nameLength) const
+{
+	// strip drive prefix e.g. "0:NAME"
+	for (int i = 0; i < nameLength && i < 2; i++)
+	{
+		if (pName[i] == ':')
+		{
+			pName += i + 1;
+			nameLength -= i + 1;
+			break;
+		}
+	}
+
+	for (const FC64ImageFile& file : Files)
+	{
+		if ((file.FileType & 0x7) != 2)	// PRG files only
+			continue;
+		// tape loads with no name load the first file
+		if (nameLength == 0 || MatchFileName(file.Name, pName, nameLength))
+			return &file;
+	}
+
+	return nullptr;
+}
+
+// add a BASIC line to the listing, load address is $0401
+static void AddListingLine(std::vector<uint8_t>& prg, uint16_t lineNo, const std::string& text)
+{
+	const uint16_t nextLineAddress = (uint16_t)(0x0401 + (prg.size() - 2) + 4 + text.size() + 1);
+	prg.push_back(nextLineAddress & 0xff);
+	prg.push_back(nextLineAddress >> 8);
+	prg.push_back(lineNo & 0xff);
+	prg.push_back(lineNo >> 8);
+	prg.insert(prg.end(), text.begin(), text.end());
+	prg.push_back(0);
+}
+
+void FC64FileImage::GenerateDirectoryListing(std::vector<uint8_t>& outPRG) const
+{
+	outPRG.clear();
+	outPRG.push_back(0x01);
+	outPRG.push_back(0x04);
+
+	std::string header = "\x12\"" + ImageName;
+	header.resize(18, ' ');
+	header += "\" " + ImageId;
+	AddListingLine(outPRG, 0, header);
+
+	for (const FC64ImageFile& file : Files)
+	{
+		std::string line;
+		line.append(file.NoBlocks < 10 ? 3 : file.NoBlocks < 100 ? 2 : 1, ' ');
+		line += "\"" + file.Name + "\"";
+		line.resize(21, ' ');
+		line += (file.FileType & 0x80) ? ' ' : '*';
+		line += kFileTypeNames[std::min(file.FileType & 0x7, 4)];
+		AddListingLine(outPRG, (uint16_t)file.NoBlocks, line);
+	}
+
+	AddListingLine(outPRG, (uint16_t)FreeBlocks, "BLOCKS FREE.");
+	outPRG.push_back(0);
+	outPRG.push_back(0);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cinttypes>
+#include <string>
+#include <vector>
+
+enum class EC64FileImageType
+{
+	None,
+	D64,	// 1541 disk image
+	T64,	// tape archive
+};
+
+// A PRG file extracted from an image - the first 2 bytes are the load address
+struct FC64ImageFile
+{
+	std::string				Name;	// PETSCII, padding removed
+	std::vector<uint8_t>	Data;
+	uint8_t					FileType = 0;	// 1541 directory file type
+	int						NoBlocks = 0;
+
+	uint16_t	GetLoadAddress() const { return Data.size() >= 2 ? Data[0] | (Data[1] << 8) : 0; }
+};
+
+// Holds the files from a D64 or T64 image so they can be loaded by trapping the KERNAL LOAD routine
+class FC64FileImage
+{
+public:
+	bool	LoadD64(const uint8_t* pData, size_t dataSize);
+	bool	LoadT64(const uint8_t* pData, size_t dataSize);
+	void	Clear();
+
+	EC64FileImageType	GetType() const { return Type; }
+	bool	IsDeviceHandled(uint8_t deviceNo) const;
+
+	// find a file using 1541 name matching - supports '*' and '?' wildcards
+	const FC64ImageFile*	FindFile(const uint8_t* pName, int nameLength) const;
+	// generate a BASIC program of the directory listing for LOAD"$"
+	void	GenerateDirectoryListing(std::vector<uint8_t>& outPRG) const;
+
+	const std::vector<FC64ImageFile>&	GetFiles() const { return Files; }
+	const std::string&	GetImageName() const { return ImageName; }
+private:
+	EC64FileImageType			Type = EC64FileImageType::None;
+	std::string					ImageName;
+	std::string					ImageId;
+	int							FreeBlocks = 0;
+	std::vector<FC64ImageFile>	Files;
+};
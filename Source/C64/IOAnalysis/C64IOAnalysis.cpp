@@ -24,6 +24,14 @@ void	FC64IOAnalysis::Reset()
 	CIA2Analysis.Reset();
 }
 
+void	FC64IOAnalysis::FixupAddressRefs()
+{
+	VICAnalysis.FixupAddressRefs();
+	SIDAnalysis.FixupAddressRefs();
+	CIA1Analysis.FixupAddressRefs();
+	CIA2Analysis.FixupAddressRefs();
+}
+
 
 void	FC64IOAnalysis::RegisterIORead(uint16_t addr, FAddressRef pc)
 {
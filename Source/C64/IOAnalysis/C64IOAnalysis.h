@@ -15,6 +15,7 @@ class FC64IOAnalysis
 public:
 	void	Init(FC64Emulator* pEmulator);
 	void	Reset();
+	void	FixupAddressRefs();
 	void	RegisterIORead(uint16_t addr, FAddressRef pc);
 	void	RegisterIOWrite(uint16_t addr, uint8_t val, FAddressRef pc);
 
@@ -171,12 +171,27 @@ void FCIAAnalysis::Reset(void)
 		CIARegisters[i].Reset();
 }
 
+void FCIAAnalysis::FixupAddressRefs(void)
+{
+	for (int i = 0; i < kNoRegisters; i++)
+		CIARegisters[i].FixupAddressRefs(*pCodeAnalyser);
+}
+
+void	FCIAAnalysis::OnMachineFrameStart(void)
+{
+	if (bRecordWriteTimeline)
+	{
+		for (int i = 0; i < kNoRegisters; i++)
+			CIARegisters[i].OnMachineFrameStart();
+	}
+}
+
 void	FCIAAnalysis::OnRegisterRead(uint8_t reg, FAddressRef pc)
 {
 	c64_t* pC64 = pC64Emu->GetEmu();
 	const uint8_t val = M6526_GET_DATA(pC64->cia_1.pins);	// Not sure if this is correct
 	pCodeAnalyser->Debugger.RegisterEvent(ReadEventType, pc, reg, val, pC64->vic.rs.v_count);
-
+	CIARegisters[reg].OnRead(pc);
 }
 void	FCIAAnalysis::OnRegisterWrite(uint8_t reg, uint8_t val, FAddressRef pc)
 {
@@ -186,9 +201,7 @@ void	FCIAAnalysis::OnRegisterWrite(uint8_t reg, uint8_t val, FAddressRef pc)
 
 	pCodeAnalyser->Debugger.RegisterEvent(WriteEventType, pc, reg, val, pC64->vic.rs.v_count);
 
-	ciaRegister.Accesses[pc].WriteVals.insert(val);
-
-	ciaRegister.LastVal = val;
+	ciaRegister.OnWrite(val, pc, pC64->vic.rs.v_count, bRecordWriteTimeline);
 }
 
 void DrawPortState(const m6526_port_t& port, const char** portNames)
@@ -281,6 +294,7 @@ void	FCIAAnalysis::DrawDetailsUI(void)
 	ImGui::Text("Latch:\t %s", NumStr(pCIA->pb.inp));
 	SetNumberDisplayMode(numberMode);
 #endif
+	DrawWriteTimelineCheckbox();
 	if (ImGui::BeginChild("CIA Reg Select", ImVec2(ImGui::GetContentRegionAvail().x * 0.5f, 0), true))
 	{
 		SelectedRegister = DrawRegSelectList(*RegConfig, SelectedRegister);
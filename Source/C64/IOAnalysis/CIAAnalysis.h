@@ -13,6 +13,8 @@ class FCIAAnalysis : public FC64IODevice
 public:
 	void	Init(FC64Emulator* pEmulator);
 	void	Reset();
+	void	FixupAddressRefs(void) override;
+	void	OnMachineFrameStart(void) override;
 	void	OnRegisterRead(uint8_t reg, FAddressRef pc);
 	void	OnRegisterWrite(uint8_t reg, uint8_t val, FAddressRef pc);
 
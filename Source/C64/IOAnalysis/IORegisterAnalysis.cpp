@@ -5,6 +5,90 @@
 #include <CodeAnalyser/CodeAnalyser.h>
 #include <CodeAnalyser/UI/CodeAnalyserUI.h>
 
+static const uint32_t kInitialAccessTableSize = 8;
+
+// the timeline is recorded for all of a device's registers
+void FC64IODevice::DrawWriteTimelineCheckbox()
+{
+	ImGui::Checkbox("Record Write Timeline", &bRecordWriteTimeline);
+}
+
+void FC64IORegisterInfo::Reset()
+{
+	Accesses.assign(kInitialAccessTableSize, FC64IORegisterAccessInfo());
+	AccessTableSize = kInitialAccessTableSize;
+	NoAccessors = 0;
+	FrameWrites.clear();
+	LastFrameWrites.clear();
+	WriteVals.Clear();
+	ReadCount = 0;
+	WriteCount = 0;
+	LastVal = 0;
+}
+
+void FC64IORegisterInfo::OnMachineFrameStart()
+{
+	std::swap(FrameWrites, LastFrameWrites);
+	FrameWrites.clear();
+}
+
+// fixing up can change the PCs the table is hashed on so it gets rebuilt
+void FC64IORegisterInfo::FixupAddressRefs(const FCodeAnalysisState& state)
+{
+	std::vector<FC64IORegisterAccessInfo> oldAccesses;
+	oldAccesses.swap(Accesses);
+	Accesses.assign(AccessTableSize, FC64IORegisterAccessInfo());
+	NoAccessors = 0;
+	for (FC64IORegisterAccessInfo& oldAccess : oldAccesses)
+	{
+		if (oldAccess.PC.IsValid() == false)
+			continue;
+		FixupAddressRef(state, oldAccess.PC);
+		if (oldAccess.PC.IsValid() == false)
+			continue;
+
+		// two PCs can end up the same
+		FC64IORegisterAccessInfo& access = GetAccessInfo(oldAccess.PC);
+		access.ReadCount += oldAccess.ReadCount;
+		access.WriteCount += oldAccess.WriteCount;
+		access.WriteVals.Add(oldAccess.WriteVals);
+	}
+
+	for (FC64IORegisterWrite& write : FrameWrites)
+		FixupAddressRef(state, write.PC);
+	for (FC64IORegisterWrite& write : LastFrameWrites)
+		FixupAddressRef(state, write.PC);
+}
+
+FC64IORegisterAccessInfo& FC64IORegisterInfo::AddAccessInfo(FAddressRef pc, uint32_t slot)
+{
+	// grow when 3/4 full - only happens when a new piece of code touches the register
+	if ((NoAccessors + 1) * 4 > (int)AccessTableSize * 3)
+	{
+		std::vector<FC64IORegisterAccessInfo> oldAccesses;
+		oldAccesses.swap(Accesses);
+		AccessTableSize *= 2;
+		Accesses.assign(AccessTableSize, FC64IORegisterAccessInfo());
+		for (const FC64IORegisterAccessInfo& access : oldAccesses)
+		{
+			if (access.PC.IsValid() == false)
+				continue;
+			uint32_t newSlot = HashPC(access.PC) & (AccessTableSize - 1);
+			while (Accesses[newSlot].PC.IsValid())
+				newSlot = (newSlot + 1) & (AccessTableSize - 1);
+			Accesses[newSlot] = access;
+		}
+
+		slot = HashPC(pc) & (AccessTableSize - 1);
+		while (Accesses[slot].PC.IsValid())
+			slot = (slot + 1) & (AccessTableSize - 1);
+	}
+
+	NoAccessors++;
+	Accesses[slot].PC = pc;
+	return Accesses[slot];
+}
+
 void DrawRegValueHex(FC64IODevice* pDevice, uint8_t val)
 {
 	ImGui::Text("$%X", val);
@@ -33,27 +117,49 @@ int DrawRegSelectList(std::vector<FRegDisplayConfig>& regList, int selection)
 void DrawRegDetails(FC64IODevice* pDevice, FC64IORegisterInfo& reg, const FRegDisplayConfig& regConfig, FCodeAnalysisState* pCodeAnalysis)
 {
 	if (ImGui::Button("Clear"))
-	{
-		reg.LastVal = 0;
-		reg.Accesses.clear();
-	}
+		reg.Reset();
+
 	// move out into function?
 	ImGui::Text("Last Val:");
 	regConfig.UIDrawFunction(pDevice, reg.LastVal);
+	ImGui::Text("Reads: %d, Writes: %d", reg.ReadCount, reg.WriteCount);
+
+	if (pDevice->bRecordWriteTimeline && ImGui::CollapsingHeader("Last Frame Writes"))
+	{
+		for (const FC64IORegisterWrite& write : reg.LastFrameWrites)
+		{
+			ImGui::Text("Scanline %d:", write.Scanline);
+			ImGui::SameLine();
+			regConfig.UIDrawFunction(pDevice, write.Val);
+			ImGui::SameLine();
+			DrawCodeAddress(*pCodeAnalysis, pCodeAnalysis->GetFocussedViewState(), write.PC);
+		}
+	}
+
 	ImGui::Text("Accesses:");
 	for (auto& access : reg.Accesses)
 	{
+		if (access.PC.IsValid() == false)
+			continue;
+
+		ImGui::PushID(access.PC.Val);
 		ImGui::Separator();
-		ShowCodeAccessorActivity(*pCodeAnalysis, access.first);
+		ShowCodeAccessorActivity(*pCodeAnalysis, access.PC);
 
 		ImGui::Text("   ");
 		ImGui::SameLine();
-		DrawCodeAddress(*pCodeAnalysis, pCodeAnalysis->GetFocussedViewState(), access.first);
+		DrawCodeAddress(*pCodeAnalysis, pCodeAnalysis->GetFocussedViewState(), access.PC);
+		ImGui::SameLine();
+		ImGui::Text("R:%d W:%d", access.ReadCount, access.WriteCount);
 
-		if(ImGui::CollapsingHeader("Values"))
+		if(access.WriteCount > 0 && ImGui::CollapsingHeader("Values"))
 		{ 
-			for (auto& val : access.second.WriteVals)
-				regConfig.UIDrawFunction(pDevice, val);
+			for (int val = 0; val < 256; val++)
+			{
+				if (access.WriteVals.Contains((uint8_t)val))
+					regConfig.UIDrawFunction(pDevice, (uint8_t)val);
+			}
 		}
+		ImGui::PopID();
 	}
 }
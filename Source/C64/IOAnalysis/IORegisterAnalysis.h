@@ -4,8 +4,7 @@
 #include "CodeAnalyser/IOAnalyser.h"
 
 #include <cstdint>
-#include <unordered_map>
-#include <unordered_set>
+#include <cstring>
 #include <vector>
 
 class FCodeAnalysisState;
@@ -16,20 +15,95 @@ class FC64IODevice : public FIODevice
 public:
 	FC64Emulator* GetC64() { return pC64Emu;}
 
+	virtual void	FixupAddressRefs() {}
+
+	bool	bRecordWriteTimeline = false;	// keep each frame's register writes
 protected:
+	void	DrawWriteTimelineCheckbox();
+
 	FC64Emulator* pC64Emu = nullptr;
 };
 
+// 256 bit set of the values written
+struct FC64IOValueSet
+{
+	void	Clear() { memset(Bits, 0, sizeof(Bits)); }
+	void	Add(uint8_t val) { Bits[val >> 5] |= 1u << (val & 31); }
+	void	Add(const FC64IOValueSet& other) { for (int i = 0; i < 8; i++) Bits[i] |= other.Bits[i]; }
+	bool	Contains(uint8_t val) const { return (Bits[val >> 5] & (1u << (val & 31))) != 0; }
+
+	uint32_t	Bits[8] = { 0 };
+};
+
 struct FC64IORegisterAccessInfo
 {
-	std::unordered_set<uint8_t>	WriteVals;
+	FAddressRef		PC;	// invalid for an empty slot
+	uint32_t		ReadCount = 0;
+	uint32_t		WriteCount = 0;
+	FC64IOValueSet	WriteVals;
 };
 
+struct FC64IORegisterWrite
+{
+	uint16_t	Scanline;
+	uint8_t		Val;
+	FAddressRef	PC;
+};
+
+// Per register access info - accessors are kept in a small open addressed table so the hot path doesn't allocate
 struct FC64IORegisterInfo
 {
-	void Reset() { Accesses.clear(); LastVal = 0; }
-	std::unordered_map<FAddressRef, FC64IORegisterAccessInfo>	Accesses;
+	FC64IORegisterInfo() { Reset(); }
+	void	Reset();
+	void	OnMachineFrameStart();
+	void	FixupAddressRefs(const FCodeAnalysisState& state);
+	void	OnRead(FAddressRef pc) 
+	{ 
+		ReadCount++;
+		GetAccessInfo(pc).ReadCount++;
+	}
+	void	OnWrite(uint8_t val, FAddressRef pc, uint16_t scanline, bool bRecordTimeline)
+	{
+		WriteCount++;
+		WriteVals.Add(val);
+		FC64IORegisterAccessInfo& access = GetAccessInfo(pc);
+		access.WriteCount++;
+		access.WriteVals.Add(val);
+		if (bRecordTimeline)
+			FrameWrites.push_back({ scanline, val, pc });
+		LastVal = val;
+	}
+
+	FC64IORegisterAccessInfo&	GetAccessInfo(FAddressRef pc)
+	{
+		uint32_t slot = HashPC(pc) & (AccessTableSize - 1);
+		while (true)
+		{
+			FC64IORegisterAccessInfo& access = Accesses[slot];
+			if (access.PC == pc)
+				return access;
+			if (access.PC.IsValid() == false)
+				break;
+			slot = (slot + 1) & (AccessTableSize - 1);
+		}
+		return AddAccessInfo(pc, slot);
+	}
+	int		GetNoAccessors() const { return NoAccessors; }
+
+	std::vector<FC64IORegisterAccessInfo>	Accesses;	// open addressed on PC, check PC.IsValid() when iterating
+	std::vector<FC64IORegisterWrite>		FrameWrites;	// writes this frame when the timeline is on
+	std::vector<FC64IORegisterWrite>		LastFrameWrites;
+	FC64IOValueSet	WriteVals;
+	uint32_t		ReadCount = 0;
+	uint32_t		WriteCount = 0;
 	uint8_t			LastVal = 0;
+
+private:
+	static uint32_t	HashPC(FAddressRef pc) { return (pc.Val * 0x9E3779B1u) >> 16; }
+	FC64IORegisterAccessInfo&	AddAccessInfo(FAddressRef pc, uint32_t slot);
+
+	uint32_t		AccessTableSize = 0;
+	int				NoAccessors = 0;
 };
 
 struct FRegDisplayConfig
@@ -26,9 +26,24 @@ void FSIDAnalysis::Reset(void)
 		SIDRegisters[i].Reset();
 }
 
-void	FSIDAnalysis::OnRegisterRead(uint8_t reg, FAddressRef pc)
+void FSIDAnalysis::FixupAddressRefs(void)
 {
+	for (int i = 0; i < kNoRegisters; i++)
+		SIDRegisters[i].FixupAddressRefs(*pCodeAnalyser);
+}
 
+void	FSIDAnalysis::OnMachineFrameStart(void)
+{
+	if (bRecordWriteTimeline)
+	{
+		for (int i = 0; i < kNoRegisters; i++)
+			SIDRegisters[i].OnMachineFrameStart();
+	}
+}
+
+void	FSIDAnalysis::OnRegisterRead(uint8_t reg, FAddressRef pc)
+{
+	SIDRegisters[reg].OnRead(pc);
 }
 void	FSIDAnalysis::OnRegisterWrite(uint8_t reg, uint8_t val, FAddressRef pc)
 {
@@ -37,9 +52,7 @@ void	FSIDAnalysis::OnRegisterWrite(uint8_t reg, uint8_t val, FAddressRef pc)
 	const uint8_t regChange = sidRegister.LastVal ^ val;	// which bits have changed
 
 	pCodeAnalyser->Debugger.RegisterEvent((uint8_t)EC64Event::SIDRegisterWrite, pc, reg, val, pC64->vic.rs.v_count);
-	sidRegister.Accesses[pc].WriteVals.insert(val);
-
-	sidRegister.LastVal = val;
+	sidRegister.OnWrite(val, pc, pC64->vic.rs.v_count, bRecordWriteTimeline);
 }
 
 #include <imgui.h>
@@ -99,6 +112,7 @@ void SIDWriteEventShowValue(FCodeAnalysisState& state, const FEvent& event)
 
 void	FSIDAnalysis::DrawDetailsUI(void)
 {
+	DrawWriteTimelineCheckbox();
 	if (ImGui::BeginChild("SID Reg Select", ImVec2(ImGui::GetContentRegionAvail().x * 0.5f, 0), true))
 	{
 		SelectedRegister = DrawRegSelectList(g_SIDRegDrawInfo, SelectedRegister);
@@ -130,8 +130,20 @@ void FVICAnalysis::Reset(void)
 		VICRegisters[i].Reset();
 }
 
+void FVICAnalysis::FixupAddressRefs(void)
+{
+	for (int i = 0; i < kNoRegisters; i++)
+		VICRegisters[i].FixupAddressRefs(*pCodeAnalyser);
+}
+
 void FVICAnalysis::OnMachineFrameStart(void)
 {
+	if (bRecordWriteTimeline)
+	{
+		for (int i = 0; i < kNoRegisters; i++)
+			VICRegisters[i].OnMachineFrameStart();
+	}
+
 	FrameSprites.clear();
 
 	// add new sprites
@@ -243,7 +255,7 @@ EC64Event FVICAnalysis::GetVICEvent(uint8_t reg, uint8_t val, FAddressRef pc)
 
 void FVICAnalysis::OnRegisterRead(uint8_t reg, FAddressRef pc)
 {
-    
+	VICRegisters[reg].OnRead(pc);
 }
 
 void FVICAnalysis::OnRegisterWrite(uint8_t reg, uint8_t val, FAddressRef pc)
@@ -309,9 +321,7 @@ void FVICAnalysis::OnRegisterWrite(uint8_t reg, uint8_t val, FAddressRef pc)
     
 	// Events
 	pCodeAnalyser->Debugger.RegisterEvent((uint8_t)GetVICEvent(reg,val,pc),pc,reg,val, scanline);
-	vicRegister.Accesses[pc].WriteVals.insert(val);
-
-	vicRegister.LastVal = val;
+	vicRegister.OnWrite(val, pc, scanline, bRecordWriteTimeline);
 
 	// check for sprite register updates
 	if (reg <= (int)EVicRegister::Sprite7_Y)	// set sprite coordinate
@@ -589,6 +599,7 @@ void FVICAnalysis::DrawDetailsUI(void)
 
 void FVICAnalysis::DrawVICRegisterInfo(void)
 {
+	DrawWriteTimelineCheckbox();
 	if (ImGui::BeginChild("VIC Reg Select", ImVec2(ImGui::GetContentRegionAvail().x * 0.5f, 0), true))
 	{
 		for (int i = 0; i < (int)g_VICRegDrawInfo.size(); i++)
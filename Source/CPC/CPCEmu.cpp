@@ -1,4 +1,6 @@
 #include <cstdint>
+#include <array>
+#include <utility>
 
 #define SAVE_NEW_DIRS 1
 
@@ -17,6 +19,7 @@
 #include <CodeAnalyser/CodeAnalysisState.h>
 #include <CodeAnalyser/AssemblerExport.h>
 #include "CodeAnalyser/CodeAnalysisJson.h"
+#include "CodeAnalyser/RomAnalysisImage.h"
 #include "CPCGameConfig.h"
 #include "Debug/DebugLog.h"
 #include "CPCChipsImpl.h"
@@ -76,6 +79,7 @@ const uint8_t* FCPCEmu::GetMemPtr(uint16_t address) const
 void FCPCEmu::WriteByte(uint16_t address, uint8_t value)
 {
 	mem_wr(&CPCEmuState.mem, address, value);
+	CodeAnalysis.OnMemoryPoked(address);
 }
 
 FAddressRef FCPCEmu::GetPC(void) 
@@ -194,10 +198,14 @@ void	FCPCEmu::OnInstructionExecuted(int ticks, uint64_t pins)
 	PreviousPC = pc;
 }
 
-// Note - you can't read the cpu vars during tick
-// They are only written back at end of exec function
-uint64_t FCPCEmu::Z80Tick(int num, uint64_t pins)
+// Tick handler for a set of analysis features - see ETickFeature
+template<uint32_t kTickFeatures>
+uint64_t FCPCEmu::Z80TickWithFeatures(int num, uint64_t pins)
 {
+	constexpr bool bAccessTracking = (kTickFeatures & ETickFeature::AccessTracking) != 0;
+	constexpr bool bEventTrace = (kTickFeatures & ETickFeature::EventTrace) != 0;
+	constexpr bool bIOAnalysis = (kTickFeatures & ETickFeature::IOAnalysis) != 0;
+
 	FCodeAnalysisState& state = CodeAnalysis;
 	FDebugger& debugger = CodeAnalysis.Debugger;
 
@@ -209,20 +217,20 @@ uint64_t FCPCEmu::Z80Tick(int num, uint64_t pins)
 
 	const am40010_crt_t& crt = CPCEmuState.ga.crt;
 	const uint16_t scanlinePos = crt.v_pos;
-	static uint16_t lastScanlinePos = 0;
 
-	if (lastScanlinePos != scanlinePos)
+	if (LastScanlinePos != scanlinePos)
 	{
-		if (scanlinePos == 0)
+		if (scanlinePos == 0)	// start the frame before the scanline so it lands in the new frame
 		{
 			CodeAnalysis.OnMachineFrameStart();
 		}
+		debugger.OnScanlineStart(scanlinePos);
 		if (scanlinePos == 311)
 		{
 			CodeAnalysis.OnMachineFrameEnd();
 		}
 	}
-	lastScanlinePos = scanlinePos;
+	LastScanlinePos = scanlinePos;
 
 	/* memory and IO requests */
 	if (pins & Z80_MREQ)
@@ -237,22 +245,24 @@ uint64_t FCPCEmu::Z80Tick(int num, uint64_t pins)
 			}
 			else
 			{
-				if (state.bRegisterDataAccesses)
+				if constexpr (bAccessTracking)
 					RegisterDataRead(state, pc, addr);
 			}
 		}
 		else if (pins & Z80_WR) 
 		{
-			if (state.bRegisterDataAccesses)
-				RegisterDataWrite(state, pc, addr, value);
-			const FAddressRef addrRef = state.AddressRefFromPhysicalAddress(addr);
 			const FAddressRef pcAddrRef = state.AddressRefFromPhysicalAddress(pc);
-			state.SetLastWriterForAddress(addr, pcAddrRef);
+			if constexpr (bAccessTracking)
+			{
+				RegisterDataWrite(state, pc, addr, value);
+				state.SetLastWriterForAddress(addr, pcAddrRef);
+			}
 
 			// Log screen pixel writes
-			if (Screen.IsScreenAddress(addr))
+			if constexpr (bEventTrace)
 			{
-				debugger.RegisterEvent((uint8_t)EEventType::ScreenPixWrite, pcAddrRef, addr, value, scanlinePos);
+				if (Screen.IsScreenAddress(addr))
+					debugger.RegisterEvent((uint8_t)EEventType::ScreenPixWrite, pcAddrRef, addr, value, scanlinePos);
 			}
 		}
 	}
@@ -273,13 +283,14 @@ uint64_t FCPCEmu::Z80Tick(int num, uint64_t pins)
 	//CodeAnalysis.MemoryAnalyser.SetScreenMemoryArea(Screen.GetScreenAddrStart(), Screen.GetScreenAddrEnd());
 	//pScreenMemDescGenerator->UpdateScreenMemoryLocation();
 
-	CodeAnalysis.OnCPUTick(pins);
+	CodeAnalysis.OnCPUTick<kTickFeatures>(pins);
 
 	const am40010_t& ga = CPCEmuState.ga;
 	if (pins & Z80_IORQ)
 	{
 		// This is still needed because it deals with adding events to the event trace.
-		IOAnalysis.IOHandler(pc, pins);
+		if constexpr (bEventTrace || bIOAnalysis)
+			IOAnalysis.IOHandler(pc, pins);
 
 		// note: some of this code logic is duplicated in IOAnalysis.cpp in HandleGateArray
 		if (pins & (Z80_RD | Z80_WR))
@@ -320,8 +331,11 @@ uint64_t FCPCEmu::Z80Tick(int num, uint64_t pins)
 					CurUpperROMSlot = selectedRomSlot;
 				}
 
-				const FAddressRef pcAddrRef = state.AddressRefFromPhysicalAddress(pc);
-				debugger.RegisterEvent((uint8_t)EEventType::UpperROMSelect, pcAddrRef, Z80_GET_ADDR(pins), Z80_GET_DATA(pins), scanlinePos);
+				if constexpr (bEventTrace)
+				{
+					const FAddressRef pcAddrRef = state.AddressRefFromPhysicalAddress(pc);
+					debugger.RegisterEvent((uint8_t)EEventType::UpperROMSelect, pcAddrRef, Z80_GET_ADDR(pins), Z80_GET_DATA(pins), scanlinePos);
+				}
 			}
 
 			if ((pins & (AM40010_A14 | AM40010_A15)) == AM40010_A14)
@@ -341,7 +355,8 @@ uint64_t FCPCEmu::Z80Tick(int num, uint64_t pins)
 						if (ROMEnableDirty != 0)
 						{
 							UpdateBankMappings();
-							debugger.RegisterEvent((uint8_t)EEventType::ROMBankSwitch, pcAddrRef, addr, data, scanlinePos);
+							if constexpr (bEventTrace)
+								debugger.RegisterEvent((uint8_t)EEventType::ROMBankSwitch, pcAddrRef, addr, data, scanlinePos);
 						}
 						LastGateArrayConfig = ga.regs.config;
 					}
@@ -356,7 +371,8 @@ uint64_t FCPCEmu::Z80Tick(int num, uint64_t pins)
 							if (RAMConfigDirty)
 							{
 								UpdateBankMappings();
-								debugger.RegisterEvent((uint8_t)EEventType::RAMBankSwitch, pcAddrRef, addr, data, scanlinePos);
+								if constexpr (bEventTrace)
+									debugger.RegisterEvent((uint8_t)EEventType::RAMBankSwitch, pcAddrRef, addr, data, scanlinePos);
 							}
 							LastGateArrayRAMConfig = CPCEmuState.ga.ram_config;
 						}
@@ -370,6 +386,24 @@ uint64_t FCPCEmu::Z80Tick(int num, uint64_t pins)
 	return pins;
 }
 
+// one tick handler for each feature combination
+typedef uint64_t (FCPCEmu::*FZ80TickHandler)(int num, uint64_t pins);
+
+template<uint32_t... kFeatureSets>
+static constexpr std::array<FZ80TickHandler, sizeof...(kFeatureSets)> MakeZ80TickHandlers(std::integer_sequence<uint32_t, kFeatureSets...>)
+{
+	return { &FCPCEmu::Z80TickWithFeatures<kFeatureSets>... };
+}
+
+static constexpr auto g_Z80TickHandlers = MakeZ80TickHandlers(std::make_integer_sequence<uint32_t, ETickFeature::NoCombinations>());
+
+// Note - you can't read the cpu vars during tick
+// They are only written back at end of exec function
+uint64_t FCPCEmu::Z80Tick(int num, uint64_t pins)
+{
+	return (this->*g_Z80TickHandlers[CodeAnalysis.GetTickFeatures()])(num, pins);
+}
+
 static uint64_t Z80TickThunk(int num, uint64_t pins, void* user_data)
 {
 	FCPCEmu* pEmu = (FCPCEmu*)user_data;
@@ -423,6 +457,7 @@ bool FCPCEmu::InitBankMappings()
 #endif
 
 	UpdateBankMappings();
+	CodeAnalysis.SetAllBanksDirty();	// new machine state so rebuild everything
 
 #if ENABLE_EXTERNAL_ROM_SUPPORT
 	if (bExternalROMSupport)
@@ -494,41 +529,20 @@ void FCPCEmu::UpdateBankMappings()
 
 	const int bankIndex[4] = { gCPCRAMConfig[ramPreset][0], gCPCRAMConfig[ramPreset][1], gCPCRAMConfig[ramPreset][2], gCPCRAMConfig[ramPreset][3] };
 
-	// 0x0000 - 0x3fff
-	if (romEnable & AM40010_CONFIG_LROMEN)
-	{
-		SetRAMBank(0, bankIndex[0], EBankAccess::ReadWrite);	
-	}
-	else
-	{
-		// ROM now shares the same address space as RAM.
-		// Reads go to ROM and writes go to RAM. RAM behind ROM.
-		CodeAnalysis.MapBank(ROMBanks[EROMBank::OS], 0, EBankAccess::Read);
-		SetRAMBank(0, bankIndex[0], EBankAccess::Write);
-	}
+	// switch to the precomputed config - see InitMemoryConfigs()
+	const int configIndex = (ramPreset << 3) |
+		((romEnable & AM40010_CONFIG_LROMEN) ? 1 : 0) |
+		((romEnable & AM40010_CONFIG_HROMEN) ? 2 : 0) |
+		(upperRomBank == ROMBanks[EROMBank::AMSDOS] ? 4 : 0);
+	CodeAnalysis.ApplyMemoryConfig(MemoryConfigs[configIndex]);
 
-	SetRAMBank(1, bankIndex[1], EBankAccess::ReadWrite);	// 0x4000 - 0x7fff
-	SetRAMBank(2, bankIndex[2], EBankAccess::ReadWrite);	// 0x8000 - 0xbfff
+	for (int slot = 0; slot < 4; slot++)
+		SetRAMBank(slot, bankIndex[slot], EBankAccess::None);
 
-	// 0xc000 - 0xffff
-	if (romEnable & AM40010_CONFIG_HROMEN)
-	{
-		SetRAMBank(3, bankIndex[3], EBankAccess::ReadWrite);
-	}
-	else
-	{
 #if ENABLE_EXTERNAL_ROM_SUPPORT
-		if (bExternalROMSupport)
-		{
-			CodeAnalysis.MapBank(UpperROMSlot[CurUpperROMSlot], 48, EBankAccess::Read);
-		}
-		else
+	if (bExternalROMSupport && (romEnable & AM40010_CONFIG_HROMEN) == 0)
+		CodeAnalysis.MapBank(UpperROMSlot[CurUpperROMSlot], 48, EBankAccess::Read);
 #endif
-		{
-			CodeAnalysis.MapBank(upperRomBank, 48, EBankAccess::Read);
-		}
-		SetRAMBank(3, bankIndex[3], EBankAccess::Write);	
-	}
 
 #ifdef BANK_SWITCH_DEBUG
 	std::string wBanks[4]; // writeable banks (could be read/write or write only)
@@ -565,6 +579,7 @@ void FCPCEmu::UpdateBankMappings()
 					if (pNewBank->PrimaryMappedPage != prevMappedPage[bankIndex[r]])
 					{
 						bFixupNeeded = true;
+						CodeAnalysis.SetCodeAnalysisDirty(FAddressRef(pNewBank->Id, pNewBank->GetMappedAddress()));	// item addresses have changed
 
 						BANK_LOG("'%s' changed mapped address: 0x%x -> 0x%x", pNewBank->Name.c_str(), prevMappedPage[bankIndex[r]] * FCodeAnalysisPage::kPageSize, pNewBank->GetMappedAddress());
 					}
@@ -582,19 +597,49 @@ void FCPCEmu::UpdateBankMappings()
 	// could we check our banks match the chips ones?
 	// it would be a great sanity test
 	
-	// Force all banks to update their item list.
-	// Also force the code analysis state to update it's ItemList too
-	CodeAnalysis.SetAllBanksDirty();
+	// Only banks that have moved need their item lists rebuilding (done above).
+	// The UI will pick up the remapping when it next draws.
+}
+
+// Build a memory config for every RAM preset/ROM enable combination so bank switching doesn't have to go through MapBank
+void FCPCEmu::InitMemoryConfigs()
+{
+	for (int configIndex = 0; configIndex < kNoMemoryConfigs; configIndex++)
+	{
+		const int ramPreset = configIndex >> 3;
+		const bool bLowerRAM = configIndex & 1;
+		const bool bUpperRAM = configIndex & 2;
+		const int16_t upperRomBank = (configIndex & 4) ? ROMBanks[EROMBank::AMSDOS] : ROMBanks[EROMBank::BASIC];
+
+		FCodeAnalysisMemoryConfig& config = MemoryConfigs[configIndex];
+		config.Reset();
+
+		// 0x0000 - 0x3fff
+		// When the ROM is enabled reads go to ROM and writes go to RAM. RAM behind ROM.
+		if (bLowerRAM == false)
+			config.MapBank(CodeAnalysis.GetBank(ROMBanks[EROMBank::OS]), 0, EBankAccess::Read);
+		config.MapBank(CodeAnalysis.GetBank(RAMBanks[gCPCRAMConfig[ramPreset][0]]), 0, bLowerRAM ? EBankAccess::ReadWrite : EBankAccess::Write);
+
+		config.MapBank(CodeAnalysis.GetBank(RAMBanks[gCPCRAMConfig[ramPreset][1]]), 16, EBankAccess::ReadWrite);	// 0x4000 - 0x7fff
+		config.MapBank(CodeAnalysis.GetBank(RAMBanks[gCPCRAMConfig[ramPreset][2]]), 32, EBankAccess::ReadWrite);	// 0x8000 - 0xbfff
+
+		// 0xc000 - 0xffff
+		if (bUpperRAM == false)
+			config.MapBank(CodeAnalysis.GetBank(upperRomBank), 48, EBankAccess::Read);
+		config.MapBank(CodeAnalysis.GetBank(RAMBanks[gCPCRAMConfig[ramPreset][3]]), 48, bUpperRAM ? EBankAccess::ReadWrite : EBankAccess::Write);
+	}
 }
 
 // Slot is physical 16K memory region (0-3) 
 // bankNo is a 16K CPC RAM bank (0-7)
+// access of None just updates the slot's bank - used when a memory config has already mapped it
 void FCPCEmu::SetRAMBank(int slot, int bankNo, EBankAccess access)
 {
 	const int16_t bankId = RAMBanks[bankNo];
 	
 	const int startPage = slot * kNoBankPages;
-	CodeAnalysis.MapBank(bankId, startPage, access);
+	if (access != EBankAccess::None)
+		CodeAnalysis.MapBank(bankId, startPage, access);
 	
 	if (CPCEmuState.type == CPC_TYPE_6128)
 		CodeAnalysis.SetBankPrimaryPage(bankId, slot * 16);
@@ -930,6 +975,7 @@ bool FCPCEmu::Init(const FEmulatorLaunchConfig& launchConfig)
 		sprintf(bankName, "RAM %d", bankNo);
 		RAMBanks[bankNo] = CodeAnalysis.CreateBank(bankName, 16, CPCEmuState.ram[bankNo], false, 0x0000);
 	}
+	InitMemoryConfigs();
 
 	if (InitForModel(pCPCConfig->GetDefaultModel()) == false)
 		return false;
@@ -974,7 +1020,7 @@ bool FCPCEmu::Init(const FEmulatorLaunchConfig& launchConfig)
 		{
 			if (FileExists(kROMAnalysisFilename6128))
 			{
-				ImportAnalysisJson(CodeAnalysis, kROMAnalysisFilename6128);
+				ImportRomAnalysis(CodeAnalysis, kROMAnalysisFilename6128);
 			}
 		}
 	}
@@ -1269,7 +1315,7 @@ bool FCPCEmu::LoadProject(FProjectConfig* pProjectConfig, bool bLoadGameData)
 		// Snapshot can change machine type, so do this after loading the snapshot
 		if (FileExists(kROMAnalysisFilename6128))
 		{
-			ImportAnalysisJson(CodeAnalysis, kROMAnalysisFilename6128);
+			ImportRomAnalysis(CodeAnalysis, kROMAnalysisFilename6128);
 		}
 	}
 
@@ -1416,6 +1462,7 @@ bool FCPCEmu::LoadGameState(const char* fname)
 	const bool bSuccess = cpc_load_snapshot(&CPCEmuState, 1, &g_SaveSlot);
 
 	UpdateBankMappings();
+	CodeAnalysis.SetAllBanksDirty();
 
 	fclose(fp);
 	return bSuccess;
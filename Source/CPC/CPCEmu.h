@@ -121,6 +121,7 @@ public:
 
 	void				OnInstructionExecuted(int ticks, uint64_t pins);
 	uint64_t			Z80Tick(int num, uint64_t pins);
+	template<uint32_t kTickFeatures> uint64_t	Z80TickWithFeatures(int num, uint64_t pins);
 
 	// FEmuBase Begin
 	void				FileMenuAdditions(void) override;		
@@ -147,6 +148,7 @@ public:
 	bool				CanSelectUpperROM(uint8_t romSlot);
 	bool				InitBankMappings();
 	void				UpdateBankMappings();
+	void				InitMemoryConfigs();
 	ECPCModel		GetCurrentCPCModel() const { return CPCEmuState.type == CPC_TYPE_6128 ? ECPCModel::CPC_6128 : ECPCModel::CPC_464; }
 	void				SetRAMBank(int slot, int bankNo, EBankAccess access);
 
@@ -191,6 +193,10 @@ public:
 
 	int16_t			CurRAMBank[4] = { -1,-1,-1,-1 };
 
+	// precomputed mappings for each RAM preset, ROM enable & upper ROM combination
+	static const int	kNoMemoryConfigs = 8 * 2 * 2 * 2;
+	FCodeAnalysisMemoryConfig	MemoryConfigs[kNoMemoryConfigs];
+
 	// Temp variables so we can tell when Chips registers are dirty
 	uint8_t			LastGateArrayRAMConfig = 0;
 	uint8_t			LastGateArrayConfig = 0;
@@ -203,6 +209,7 @@ public:
 
 	uint16_t		PreviousPC = 0;		// store previous pc
 	int			InstructionsTicks = 0;
+	uint16_t	LastScanlinePos = 0;
 
 	FCPCScreen	Screen;
 
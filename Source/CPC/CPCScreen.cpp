@@ -50,8 +50,8 @@ void FCPCScreen::Reset()
 	ScreenTopScanline = 0;
 	ScreenLeftEdgeOffset = 0;
 
-	for (int i = 0; i < AM40010_DISPLAY_HEIGHT; i++)
-		ScreenModePerScanline[i] = -1;
+	ScanlineChanges[0].Reset();
+	ScanlineChanges[1].Reset();
 }
 
 int FCPCScreen::GetHeight() const
@@ -108,12 +108,22 @@ int FCPCScreen::GetLeftPixelEdge() const
 #endif
 }
 
+const FScanlineState& FCPCScreen::GetStateForScanline(int scanline) const
+{
+	const FScanlineState* pState = nullptr;
+	if (scanline <= LastScanline)
+		pState = ScanlineChanges[CurrentChangeList].FindScanline(scanline);
+	if (pState == nullptr)
+		pState = ScanlineChanges[CurrentChangeList ^ 1].FindScanline(scanline);
+	return pState != nullptr ? *pState : DefaultScanlineState;
+}
+
 int FCPCScreen::GetScreenModeForScanline(int scanline) const
 {
 	if (scanline < 0 || scanline >= AM40010_DISPLAY_HEIGHT)
 		return -1;
 
-	return ScreenModePerScanline[scanline];
+	return GetStateForScanline(scanline).ScreenMode;
 }
 
 int FCPCScreen::GetScreenModeForYPos(int yPos) const
@@ -126,7 +136,7 @@ const FPalette& FCPCScreen::GetPaletteForScanline(int scanline) const
 	if (scanline < 0 || scanline >= AM40010_DISPLAY_HEIGHT)
 		return CurrentPalette;
 
-	return PalettePerScanline[scanline];
+	return GetStateForScanline(scanline).Palette;
 }
 
 const FPalette& FCPCScreen::GetPaletteForYPos(int yPos) const
@@ -134,6 +144,18 @@ const FPalette& FCPCScreen::GetPaletteForYPos(int yPos) const
 	return GetPaletteForScanline(ScreenTopScanline + yPos);
 }
 
+int FCPCScreen::GetNoPaletteChanges() const
+{
+	const FScanlineChangeList& changeList = ScanlineChanges[CurrentChangeList ^ 1];
+	int noChanges = 0;
+	for (int i = 1; i < changeList.NoChanges; i++)
+	{
+		if (changeList.Changes[i].Palette != changeList.Changes[i - 1].Palette)
+			noChanges++;
+	}
+	return noChanges;
+}
+
 uint16_t FCPCScreen::GetScreenPage() const
 {
 	const uint16_t pageAddr = (pCPCEmu->CPCEmuState.crtc.start_addr_hi & 0x30) << 10;
@@ -176,16 +198,20 @@ void FCPCScreen::Tick()
 	// Store the screen mode per scanline.
 	// Shame to do this here. Would be nice to have a horizontal blank callback
 	const int curScanline = pCRT->pos_y;
-	if (LastScanline != curScanline)
+	if (LastScanline != curScanline && curScanline < AM40010_DISPLAY_HEIGHT)
 	{
-		const uint8_t screenMode = pGateArray->video.mode;
-		ScreenModePerScanline[curScanline] = screenMode;
+		// new frame - the one just finished is kept for the scanlines we haven't got to yet
+		if (curScanline < LastScanline)
+		{
+			CurrentChangeList ^= 1;
+			ScanlineChanges[CurrentChangeList].Reset();
+		}
 
-		FPalette& palette = PalettePerScanline[curScanline];
-		for (int i = 0; i < palette.GetColourCount(); i++)
-			palette.SetColour(i, pGateArray->hw_colors[pGateArray->regs.ink[i]]);
+		for (int i = 0; i < ScanlinePalette.GetColourCount(); i++)
+			ScanlinePalette.SetColour(i, pGateArray->hw_colors[pGateArray->regs.ink[i]]);
+		ScanlineChanges[CurrentChangeList].AddScanline(curScanline, pGateArray->video.mode, ScanlinePalette);
 
-		LastScanline = pCRT->pos_y;
+		LastScanline = curScanline;
 	}
 }
 
@@ -329,50 +355,80 @@ bool FCPCScreen::GetScreenAddressCoords(uint16_t addr, int& x, int& y) const
 	return false;
 }
 
+// Scanline changes
+
+void FScanlineChangeList::AddScanline(int scanline, int screenMode, const FPalette& palette)
+{
+	if (NoChanges != 0)
+	{
+		const FScanlineState& lastChange = Changes[NoChanges - 1];
+		if (scanline <= lastChange.FirstScanline)	// shouldn't happen - scanlines only go forward in a frame
+			return;
+		if (lastChange.ScreenMode == screenMode && lastChange.Palette == palette)
+			return;
+	}
+
+	FScanlineState& change = Changes[NoChanges++];
+	change.FirstScanline = scanline;
+	change.ScreenMode = screenMode;
+	change.Palette = palette;
+}
+
+const FScanlineState* FScanlineChangeList::FindScanline(int scanline) const
+{
+	// find the last change at or before the scanline
+	int low = 0;
+	int high = NoChanges;
+	while (low < high)
+	{
+		const int mid = (low + high) / 2;
+		if (Changes[mid].FirstScanline <= scanline)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low == 0 ? nullptr : &Changes[low - 1];
+}
+
 // Palette related
 
 FPalette::FPalette()
 {
-	SetColourCount(16);
 }
 
 bool FPalette::operator == (const FPalette& p) const
 {
-	const size_t numColours = GetColourCount();
-	if (numColours != p.GetColourCount())
+	if (NoColours != p.NoColours)
 		return false;
-	for (int c = 0; c < numColours; c++)
-		if (Colours[c] != p.Colours[c])
-			return false;
-	return true;
+	return memcmp(Colours, p.Colours, NoColours * sizeof(uint32_t)) == 0;
 }
 
 void FPalette::SetColourCount(int count)
 {
-	Colours.resize(count);
+	assert(count <= kMaxColours);
+	NoColours = count < kMaxColours ? count : kMaxColours;
 }
 
 void FPalette::SetColour(int colourIndex, uint32_t rgb)
 {
-	assert(colourIndex < Colours.size());
+	assert(colourIndex < NoColours);
 	Colours[colourIndex] = rgb;
 }
 
 uint32_t FPalette::GetColour(int colourIndex) const
 {
-	assert(colourIndex < Colours.size());
-	uint32_t colour = Colours[colourIndex];
+	assert(colourIndex < NoColours);
 	return Colours[colourIndex];
 }
 
 size_t FPalette::GetColourCount() const
 {
-	return Colours.size();
+	return NoColours;
 }
 
 const uint32_t* FPalette::GetData() const
 {
-	return Colours.data();
+	return Colours;
 }
 
 // Given a byte containing multiple pixels, decode the colour index for a specified pixel.
@@ -8,10 +8,14 @@
 class FCPCEmu;
 
 // Palette
+// colours are stored inline so palettes can be copied around without allocating
 struct FPalette
 {
+	static const int kMaxColours = 16;
+
 	FPalette();
 	bool operator == (const FPalette& p) const;
+	bool operator != (const FPalette& p) const { return !(*this == p); }
 	void SetColourCount(int count);
 	void SetColour(int colourIndex, uint32_t rgb);
 	size_t GetColourCount() const;
@@ -19,7 +23,27 @@ struct FPalette
 	const uint32_t* GetData() const;
 
 protected:
-	std::vector<uint32_t> Colours;
+	uint32_t	Colours[kMaxColours] = { 0 };
+	int			NoColours = kMaxColours;
+};
+
+// Screen mode & palette from a scanline onwards
+struct FScanlineState
+{
+	int			FirstScanline = 0;
+	int			ScreenMode = -1;
+	FPalette	Palette;
+};
+
+// The scanlines in a frame where the screen mode or palette changed - in scanline order
+struct FScanlineChangeList
+{
+	void	Reset() { NoChanges = 0; }
+	void	AddScanline(int scanline, int screenMode, const FPalette& palette);
+	const FScanlineState* FindScanline(int scanline) const;
+
+	FScanlineState	Changes[AM40010_DISPLAY_HEIGHT];
+	int				NoChanges = 0;
 };
 
 // A class of helper functions related to the CPC screen.
@@ -45,6 +69,8 @@ public:
 	int GetScreenModeForYPos(int yPos) const;
 	const FPalette& GetPaletteForScanline(int scanline) const;
 	const FPalette& GetPaletteForYPos(int yPos) const;
+	// number of times the palette changed during the last frame
+	int GetNoPaletteChanges() const;
 
 	// Get the address of the 16k physical bank used for screen memory.
 	uint16_t GetScreenPage() const;
@@ -76,8 +102,14 @@ private:
 
 	// should this be AM40010_FRAMEBUFFER_HEIGHT? this is 272. 
 	// I thought the cpc had 312 scanlines?
-	int ScreenModePerScanline[AM40010_DISPLAY_HEIGHT] = { -1 };
-	FPalette PalettePerScanline[AM40010_DISPLAY_HEIGHT];
+	const FScanlineState& GetStateForScanline(int scanline) const;
+
+	// Scanlines up to LastScanline come from the frame being drawn, the rest from the last frame
+	// - the same as the frame buffer when the emulator is stopped mid frame
+	FScanlineChangeList ScanlineChanges[2];
+	int CurrentChangeList = 0;
+	FScanlineState DefaultScanlineState;	// for scanlines which haven't been drawn
+	FPalette ScanlinePalette;	// reused when reading the palette each scanline
 	int LastScanline = -1;
 	bool bInVblank = false;
 	bool bDrawingPixels = false;
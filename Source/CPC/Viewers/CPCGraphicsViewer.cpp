@@ -255,7 +255,7 @@ void FCPCGraphicsViewer::DrawScreenViewer()
 		if (ImGui::Button("AddComment"))
 		{
 			FCommentBlock* pCommentBlock = AddCommentBlock(GetCodeAnalysis(), FAddressRef(pBank->Id, start));
-			pCommentBlock->Comment = "COMMENT";
+			GetCodeAnalysis().SetItemComment(FAddressRef(pBank->Id, start), pCommentBlock, "COMMENT");
 		}
 		ImGui::PopID();
 	}*/
@@ -107,15 +107,7 @@ void FCPCViewer::Draw()
 		pCPCEmu->Screen.IsScrolled() ? "Yes" : "No");
 
 	// see if palette changes occured during last frame
-	int numPaletteChanges = 0;
-	if (bHasScreen)
-	{
-		for (int p = 1; p < AM40010_DISPLAY_HEIGHT; p++)
-		{
-			if (pCPCEmu->Screen.GetPaletteForScanline(p - 1) != pCPCEmu->Screen.GetPaletteForScanline(p))
-				numPaletteChanges++;
-		}
-	}
+	const int numPaletteChanges = bHasScreen ? pCPCEmu->Screen.GetNoPaletteChanges() : 0;
 	ImGui::Text("Palette changes: %d", numPaletteChanges);
 
 	// draw the cpc display
@@ -182,6 +174,7 @@ void FCPCViewer::Draw()
 			dl->AddLine(start, end, col, 1 * scale);
 		}
 	}
+	debugger.GetScanlineTimeline().DrawBeamChart(ImVec2(pos.x + (TextureWidth + 36) * scale, pos.y), 96 * scale, scale, scanlineStart, AM40010_DISPLAY_HEIGHT);
 
 	// highlight scanline
 	if (debugger.IsStopped())
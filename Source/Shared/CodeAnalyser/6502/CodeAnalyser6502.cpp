@@ -268,6 +268,17 @@ bool CheckStopInstruction6502(const FCodeAnalysisState& state, uint16_t pc)
 	return false;
 }
 
+// registers as they are on entry to the instruction
+void CaptureRegisterProfileSample6502(FCodeAnalysisState& state, FCodeInfo* pCodeInfo)
+{
+	const m6502_t* pCPU = static_cast<m6502_t*>(state.CPUInterface->GetCPUEmulator());
+	uint16_t* pValues = state.RegisterProfiler.AddSample(pCodeInfo);
+	pValues[E6502ProfileReg::A] = pCPU->A;
+	pValues[E6502ProfileReg::X] = pCPU->X;
+	pValues[E6502ProfileReg::Y] = pCPU->Y;
+	pValues[E6502ProfileReg::S] = pCPU->S;
+}
+
 bool RegisterCodeExecuted6502(FCodeAnalysisState& state, uint16_t pc, uint16_t oldpc)
 {
 	const ICPUInterface* pCPUInterface = state.CPUInterface;
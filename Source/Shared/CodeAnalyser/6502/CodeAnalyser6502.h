@@ -13,5 +13,6 @@ bool CheckJumpInstruction6502(const FCodeAnalysisState& state, uint16_t pc, uint
 bool CheckCallInstruction6502(const FCodeAnalysisState& state, uint16_t pc);
 bool CheckStopInstruction6502(const FCodeAnalysisState& state, uint16_t pc);
 bool RegisterCodeExecuted6502(FCodeAnalysisState& state, uint16_t pc, uint16_t oldpc);
+void CaptureRegisterProfileSample6502(FCodeAnalysisState& state, FCodeInfo* pCodeInfo);
 
 EInstructionType GetInstructionType6502(FCodeAnalysisState& state, FAddressRef addr);
@@ -509,7 +509,7 @@ static void AnalysisOutputCB(char c, void* pUserData)
 #endif
 
 // Helper function to generate the disassembly for a code info item
-uint16_t M6502DisassembleCodeInfoItem(uint16_t pc, FCodeAnalysisState& state, FCodeInfo* pCodeInfo)
+uint16_t M6502DisassembleCodeInfoItem(uint16_t pc, FCodeAnalysisState& state, const FCodeInfo* pCodeInfo, std::string& outText)
 {
 	FAnalysisDasmState dasmState;
 	dasmState.pCodeInfoItem = pCodeInfo;
@@ -517,7 +517,7 @@ uint16_t M6502DisassembleCodeInfoItem(uint16_t pc, FCodeAnalysisState& state, FC
 	dasmState.CurrentAddress = pc;
 	SetNumberOutput(&dasmState);
 	const uint16_t newPC = m6502dasm_op(pc, AnalysisDasmInputCB, AnalysisOutputCB, &dasmState);
-	pCodeInfo->Text = dasmState.Text;
+	outText = std::move(dasmState.Text);
 	SetNumberOutput(nullptr);
 	return newPC;
 }
@@ -9,7 +9,7 @@ class FCodeAnalysisState;
 class FExportDasmState;
 struct FCodeInfo;
 
-uint16_t M6502DisassembleCodeInfoItem(uint16_t pc, FCodeAnalysisState& state, FCodeInfo* pCodeInfo);
+uint16_t M6502DisassembleCodeInfoItem(uint16_t pc, FCodeAnalysisState& state, const FCodeInfo* pCodeInfo, std::string& outText);
 uint16_t M6502DisassembleGetNextPC(uint16_t pc, FCodeAnalysisState& state, std::vector<uint8_t>& opcodes);
 //std::string M6502GenerateDasmStringForAddress(FCodeAnalysisState& state, uint16_t pc, ENumberDisplayMode hexMode);
 bool M6502GenerateDasmExportString(FExportDasmState& exportState);
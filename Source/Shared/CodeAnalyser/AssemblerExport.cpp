@@ -6,7 +6,10 @@
 #include <util/z80dasm.h>
 #include "Debug/DebugLog.h"
 #include "Misc/GameConfig.h"
+#include "Misc/ExportJob.h"
 
+#include <algorithm>
+#include <chrono>
 #include <string.h>
 #include <stdarg.h>
 
@@ -48,50 +51,86 @@ FASMExporter* GetAssemblerExporter(const char* pConfigName)
 bool FASMExporter::Init(const char* pFilename, FEmuBase* pEmu)
 {
 	pEmulator = pEmu;
-	FilePtr = fopen(pFilename, "wt");
+	Filename = pFilename;
+	BodyFilename = Filename + ".body";
 
-	if (FilePtr == nullptr)
+	if (BodyWriter.Open(BodyFilename.c_str()) == false)
 		return false;
 
 	HeaderText.clear();
-	BodyText.clear();
+	SegmentText.clear();
 	DasmState.CodeAnalysisState = &pEmu->GetCodeAnalysis();
 	DasmState.HexDisplayMode = HexMode;
+	DasmState.LabelsOutsideRange.clear();
 
-	OldNumberMode = GetNumberDisplayMode();
-	SetNumberDisplayMode(HexMode);
 	bInitialised = true;
 	return true;
 }
 
 bool FASMExporter::Finish()
 {
-	if (FilePtr != nullptr)
+	if (bInitialised == false)
+		return false;
+	bInitialised = false;
+
+	BodyWriter.Write(SegmentText);
+	SegmentText.clear();
+	bool bSuccess = BodyWriter.Close();
+
+	// header goes first as it's only complete once the body has been exported
+	FBufferedFileWriter fileWriter;
+	if (bSuccess && fileWriter.Open(Filename.c_str()))
+	{
+		fileWriter.Write(HeaderText);
+		bSuccess = fileWriter.AppendFile(BodyFilename.c_str());
+		bSuccess &= fileWriter.Close();
+	}
+	else
 	{
-		fwrite(HeaderText.c_str(), HeaderText.size(), 1, FilePtr);
-		fwrite(BodyText.c_str(), BodyText.size(),1,FilePtr);
-		fclose(FilePtr);
+		bSuccess = false;
 	}
+	remove(BodyFilename.c_str());
+	HeaderText.clear();
 
-	SetNumberDisplayMode(OldNumberMode);
-	return true;
+	return bSuccess;
 }
 
+void FASMExporter::Abort()
+{
+	if (bInitialised == false)
+		return;
+	bInitialised = false;
 
+	BodyWriter.Close();
+	remove(BodyFilename.c_str());
+	HeaderText.clear();
+	SegmentText.clear();
+}
 
 void FASMExporter::Output(const char* pFormat, ...)
 {
 	va_list ap;
 	va_start(ap, pFormat);
-	//vfprintf(FilePtr, pFormat, ap);
 
 	if (OutputString != nullptr)
 	{
 		const int kStringBufferSize = 256;
 		char stringBuffer[kStringBufferSize];
-		int ret = vsnprintf(stringBuffer, kStringBufferSize, pFormat, ap);
-		assert(ret < kStringBufferSize);	// increase kStrignBufferSize if this gets hit
-		*OutputString += stringBuffer;
+		const int ret = vsnprintf(stringBuffer, kStringBufferSize, pFormat, ap);
+		if (ret < kStringBufferSize)
+		{
+			*OutputString += stringBuffer;
+		}
+		else
+		{
+			// long comments can overflow the buffer so format straight onto the end of the output
+			va_end(ap);
+			va_start(ap, pFormat);
+			const size_t oldSize = OutputString->size();
+			OutputString->resize(oldSize + ret + 1);
+			vsnprintf(&(*OutputString)[oldSize], ret + 1, pFormat, ap);
+			OutputString->resize(oldSize + ret);
+		}
 	}
 	va_end(ap);
 }
@@ -245,100 +284,140 @@ void FASMExporter::ExportDataInfoASM(FAddressRef addr)
 	}
 }
 
-bool FASMExporter::ExportAddressRange(uint16_t startAddr , uint16_t endAddr)
+void FASMExporter::ExportItem(const FCodeAnalysisItem& item)
 {
 	FCodeAnalysisState& state = pEmulator->GetCodeAnalysis();
+	const uint16_t addr = item.AddressRef.Address;
 
-	DasmState.ExportMin = startAddr;
-	DasmState.ExportMax = endAddr;
-	
-	// place an 'org' at the start
-	SetOutputToBody();
+	switch (item.Item->Type)
+	{
+	case EItemType::Label:
+	{
+		const FLabelInfo* pLabelInfo = static_cast<FLabelInfo*>(item.Item);
+		if(IsLabelStubbed(pLabelInfo->GetName()))
+			Output("%s_Stubbed:", pLabelInfo->GetName());
+		else
+			Output("%s:", pLabelInfo->GetName());
+	}
+	break;
+	case EItemType::Code:
+	{
+		const FCodeInfo* pCodeInfo = static_cast<FCodeInfo*>(item.Item);
 
-	Output("%s %s\n", Config.ORGText, NumStr(startAddr));
+		WriteCodeInfoForAddress(state, addr);	// needed to refresh code info
+		if (addr == g_DbgAddress)
+			LOGINFO("DebugAddress");
 
-	for (const FCodeAnalysisItem &item : state.ItemList)
-	{
-		const uint16_t addr = item.AddressRef.Address;
+		DasmState.CurrentAddress = addr;
+		DasmState.pCodeInfoItem = pCodeInfo;
+		DasmState.Text.clear();
 
-		if (addr < startAddr)
-			continue;
+		GenerateDasmExportString(DasmState);
+		//const std::string dasmString = GenerateDasmStringForAddress(state, addr, HexMode);
 
-		if (addr > endAddr)
-			break;
+		Markup::SetCodeInfo(pCodeInfo);
+		const std::string expString = Markup::ExpandString(state,DasmState.Text.c_str());
+		Output("\t%s", expString.c_str());
 
-		switch (item.Item->Type)
-		{
-		case EItemType::Label:
+		/*if (pCodeInfo->OperandAddress.IsValid())
 		{
-			const FLabelInfo* pLabelInfo = static_cast<FLabelInfo*>(item.Item);
-			if(IsLabelStubbed(pLabelInfo->GetName()))
-				Output("%s_Stubbed:", pLabelInfo->GetName());
-			else
-				Output("%s:", pLabelInfo->GetName());
-		}
-		break;
-		case EItemType::Code:
-		{
-			const FCodeInfo* pCodeInfo = static_cast<FCodeInfo*>(item.Item);
+			const std::string labelStr = GenerateAddressLabelString(pCodeInfo->OperandAddress);
+			if (labelStr.empty() == false)
+				fprintf(fp, "\t;%s", labelStr.c_str());
 
-			WriteCodeInfoForAddress(state, addr);	// needed to refresh code info
-			if (addr == g_DbgAddress)
-				LOGINFO("DebugAddress");
+		}*/
+	}
 
-			DasmState.CurrentAddress = addr;
-			DasmState.pCodeInfoItem = pCodeInfo;
-			DasmState.Text.clear();
+	break;
+	case EItemType::Data:
+	{
+		ExportDataInfoASM(item.AddressRef);
+	}
+	break;
+	case EItemType::CommentLine:
+	{
+		const std::string expString = Markup::ExpandString(state, item.Item->Comment.c_str());
 
-			GenerateDasmExportString(DasmState);
-			//const std::string dasmString = GenerateDasmStringForAddress(state, addr, HexMode);
+		Output("; %s", expString.c_str());
+	}
+	break;
+	default:
+		LOGINFO("ASM export - unhandled type:%",(int)item.Item->Type);
+	break;
+	}
 
-			Markup::SetCodeInfo(pCodeInfo);
-			const std::string expString = Markup::ExpandString(state,DasmState.Text.c_str());
-			Output("\t%s", expString.c_str());
+	// put comment on the end - not for comment lines
+	if (item.Item->Type != EItemType::CommentLine && item.Item->Comment.empty() == false)
+	{
+		const std::string expString = Markup::ExpandString(state, item.Item->Comment.c_str());
+		Output("\t\t\t; %s", expString.c_str());
+	}
+	Output("\n");
+}
 
-			/*if (pCodeInfo->OperandAddress.IsValid())
-			{
-				const std::string labelStr = GenerateAddressLabelString(pCodeInfo->OperandAddress);
-				if (labelStr.empty() == false)
-					fprintf(fp, "\t;%s", labelStr.c_str());
+void FASMExporter::BeginAddressRange(uint16_t startAddr, uint16_t endAddr)
+{
+	DasmState.ExportMin = startAddr;
+	DasmState.ExportMax = endAddr;
+	NextSegmentAddress = startAddr;
 
-			}*/
-		}
+	// place an 'org' at the start
+	SetOutputToBody();
+	Output("%s %s\n", Config.ORGText, NumStr(startAddr));
+}
 
-		break;
-		case EItemType::Data:
-		{
-			ExportDataInfoASM(item.AddressRef);
-		}
-		break;
-		case EItemType::CommentLine:
-		{
-			const std::string expString = Markup::ExpandString(state, item.Item->Comment.c_str());
+// segments finish on address boundaries so the next one can find its place in the item list even if the list gets rebuilt in between
+bool FASMExporter::ExportNextSegment()
+{
+	FCodeAnalysisState& state = pEmulator->GetCodeAnalysis();
+	const int endAddr = DasmState.ExportMax;
+	if (NextSegmentAddress > endAddr)
+		return false;
 
-			Output("; %s", expString.c_str());
-		}
-		break;
-        default:
-			LOGINFO("ASM export - unhandled type:%",(int)item.Item->Type);
-        break;
-		}
+	const int segmentEnd = NextSegmentAddress + kSegmentSize - 1 < endAddr ? NextSegmentAddress + kSegmentSize - 1 : endAddr;
 
-		// put comment on the end - not for comment lines
-		if (item.Item->Type != EItemType::CommentLine && item.Item->Comment.empty() == false)
-		{
-			const std::string expString = Markup::ExpandString(state, item.Item->Comment.c_str());
-			Output("\t\t\t; %s", expString.c_str());
-		}
-		Output("\n");
+	auto itemIt = std::lower_bound(state.ItemList.begin(), state.ItemList.end(), NextSegmentAddress, [](const FCodeAnalysisItem& item, int addr)
+	{
+		return item.AddressRef.Address < addr;
+	});
+
+	SetOutputToBody();
+	for (; itemIt != state.ItemList.end() && itemIt->AddressRef.Address <= segmentEnd; ++itemIt)
+		ExportItem(*itemIt);
+
+	BodyWriter.Write(SegmentText);
+	SegmentText.clear();
+
+	NextSegmentAddress = segmentEnd + 1;
+	return NextSegmentAddress <= endAddr;
+}
+
+float FASMExporter::GetProgress() const
+{
+	const int rangeSize = DasmState.ExportMax - DasmState.ExportMin + 1;
+	return (float)(NextSegmentAddress - DasmState.ExportMin) / (float)rangeSize;
+}
+
+bool FASMExporter::ExportAddressRange(uint16_t startAddr , uint16_t endAddr)
+{
+	BeginAddressRange(startAddr, endAddr);
+	while (ExportNextSegment())
+	{
 	}
 
 	ProcessLabelsOutsideExportedRange();
-	
-	
 	return true;
 }
 
+// exporters format numbers with the global number mode
+class FScopedNumberDisplayMode
+{
+public:
+	FScopedNumberDisplayMode(ENumberDisplayMode mode) : OldMode(GetNumberDisplayMode()) { SetNumberDisplayMode(mode); }
+	~FScopedNumberDisplayMode() { SetNumberDisplayMode(OldMode); }
+private:
+	ENumberDisplayMode	OldMode;
+};
 
 bool ExportAssembler(FEmuBase* pEmu, const char* pTextFileName, uint16_t startAddr, uint16_t endAddr)
 {
@@ -350,13 +429,68 @@ bool ExportAssembler(FEmuBase* pEmu, const char* pTextFileName, uint16_t startAd
 	if(pExporter->Init(pTextFileName, pEmu) == false)
 		return false;
 
+	FScopedNumberDisplayMode numberMode(pExporter->GetHexMode());
 	pExporter->SetOutputToHeader();
 	pExporter->AddHeader();
 		
 	const bool bSuccess = pExporter->ExportAddressRange(startAddr,endAddr);
 
-	pExporter->Finish();
-	return bSuccess;
+	return pExporter->Finish() && bSuccess;
+}
+
+class FASMExportJob : public FExportJob
+{
+public:
+	FASMExportJob(FASMExporter* pExp, const char* pTextFileName) : pExporter(pExp)
+	{
+		Description = std::string("Exporting ") + pTextFileName;
+	}
+
+	bool Step(double timeBudgetMs) override
+	{
+		FScopedNumberDisplayMode numberMode(pExporter->GetHexMode());
+		const auto startTime = std::chrono::high_resolution_clock::now();
+		bool bMoreSegments = true;
+		do
+		{
+			bMoreSegments = pExporter->ExportNextSegment();
+		} 
+		while (bMoreSegments && std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count() < timeBudgetMs);
+
+		Progress = pExporter->GetProgress();
+		if (bMoreSegments)
+			return true;
+
+		pExporter->ProcessLabelsOutsideExportedRange();
+		bSuccess = pExporter->Finish();
+		return false;
+	}
+
+	void Cancel() override
+	{
+		pExporter->Abort();
+	}
+
+private:
+	FASMExporter*	pExporter = nullptr;
+};
+
+FExportJob* CreateAssemblerExportJob(FEmuBase* pEmu, const char* pTextFileName, uint16_t startAddr, uint16_t endAddr)
+{
+	FCodeAnalysisState& state = pEmu->GetCodeAnalysis();
+	FASMExporter* pExporter = GetAssemblerExporter(state.pGlobalConfig->ExportAssembler.c_str());
+	if (pExporter == nullptr)
+		return nullptr;
+
+	if (pExporter->Init(pTextFileName, pEmu) == false)
+		return nullptr;
+
+	FScopedNumberDisplayMode numberMode(pExporter->GetHexMode());
+	pExporter->SetOutputToHeader();
+	pExporter->AddHeader();
+	pExporter->BeginAddressRange(startAddr, endAddr);
+
+	return new FASMExportJob(pExporter, pTextFileName);
 }
 
 // Util functions
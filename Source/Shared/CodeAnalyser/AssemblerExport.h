@@ -7,8 +7,11 @@
 #include "CodeAnalyserTypes.h"
 #include "Disassembler.h"
 #include "Util/Misc.h"
+#include "Util/BufferedFileWriter.h"
 
 class FCodeAnalysisState;
+class FExportJob;
+struct FCodeAnalysisItem;
 
 struct FAssemblerConfig
 {
@@ -20,37 +23,49 @@ struct FAssemblerConfig
 };
 
 // Class to encapsulate ASM exporting
+// The body is exported a segment at a time & streamed to a temporary file, the header gets written in front of it when finished
 class FASMExporter
 {
 public:
 	bool		Init(const char* pFilename, class FEmuBase* pEmu);
 	bool		Finish();
+	void		Abort();	// remove partial output
 	void		SetOutputToHeader(){OutputString = &HeaderText;}
-	void		SetOutputToBody(){OutputString = &BodyText;}
+	void		SetOutputToBody(){OutputString = &SegmentText;}
 	void		Output(const char* pFormat, ...);
 	virtual void	AddHeader(void){}
 	virtual void	ProcessLabelsOutsideExportedRange(void){}
 	bool		ExportAddressRange(uint16_t startAddr, uint16_t endAddr);
 
+	// export a range in steps
+	void		BeginAddressRange(uint16_t startAddr, uint16_t endAddr);
+	bool		ExportNextSegment();	// returns false when the range is done
+	float		GetProgress() const;
+	ENumberDisplayMode	GetHexMode() const { return HexMode; }
+
 	//std::string		GenerateAddressLabelString(FAddressRef addr);
 	void			ExportDataInfoASM(FAddressRef addr);
 
 protected:
+	void				ExportItem(const FCodeAnalysisItem& item);
 	void				OutputDataItemBytes(FAddressRef addr, const FDataInfo* pDataInfo);
 	ENumberDisplayMode	GetNumberDisplayModeForDataItem(const FDataInfo* pDataInfo);
 	bool			IsLabelStubbed(const char* pLabelName) const;
 
 	bool			bInitialised = false;
 	ENumberDisplayMode HexMode = ENumberDisplayMode::HexDollar;
-	ENumberDisplayMode OldNumberMode;
+
+	static const int	kSegmentSize = 0x400;	// addresses exported per segment
 
 	std::string		Filename;
-	FILE* FilePtr = nullptr;
+	std::string		BodyFilename;
+	FBufferedFileWriter	BodyWriter;
 	FEmuBase* pEmulator = nullptr;
 
 	FExportDasmState	DasmState;
+	int				NextSegmentAddress = 0;
 	std::string		HeaderText;
-	std::string		BodyText;
+	std::string		SegmentText;	// body text for the current segment
 	std::string*	OutputString = nullptr;
 
 	FAssemblerConfig	Config;
@@ -63,3 +78,6 @@ bool AddAssemblerExporter(const char* pName, FASMExporter* pExporter);
 
 // TODO: we should have a bank based approach?
 bool ExportAssembler(class FEmuBase* pEmu, const char* pTextFileName, uint16_t startAddr, uint16_t endAddr);
+
+// export run in slices from the emulator tick - see FEmuBase::StartExportJob
+FExportJob* CreateAssemblerExportJob(class FEmuBase* pEmu, const char* pTextFileName, uint16_t startAddr, uint16_t endAddr);
@@ -88,44 +88,95 @@ bool FCodeAnalysisState::MapBank(int16_t bankId, int startPageNo, EBankAccess ac
 	}
 	assert(pBank->PrimaryMappedPage != -1);
 
-	// unmap old banks
-	if (access == EBankAccess::Read || access == EBankAccess::ReadWrite)
-	{
-		FCodeAnalysisBank* pOldBank = GetBank(MappedReadBanks[startPageNo]);
-		if (pOldBank != nullptr && pOldBank != pBank)
-			pOldBank->UnmapFromPage(startPageNo, EBankAccess::Read);
-	}
-	if (access == EBankAccess::Write || access == EBankAccess::ReadWrite)
-	{
-		FCodeAnalysisBank* pOldBank = GetBank(MappedWriteBanks[startPageNo]);
-		if (pOldBank != nullptr && pOldBank != pBank)
-			pOldBank->UnmapFromPage(startPageNo, EBankAccess::Write);
-	}
-
-	pBank->MapToPage(startPageNo, access);
 	for (int bankPageNo = 0; bankPageNo < pBank->NoPages; bankPageNo++)
 	{
+		const int pageNo = startPageNo + bankPageNo;
+
 		// Set Read Page
 		if(access == EBankAccess::Read || access == EBankAccess::ReadWrite)
 		{
-			MappedReadBanks[startPageNo + bankPageNo] = bankId;
-			SetCodeAnalysisReadPage(startPageNo + bankPageNo, &pBank->Pages[bankPageNo]);	// Read
+			FCodeAnalysisBank* pOldBank = GetBank(MappedReadBanks[pageNo]);
+			if (pOldBank != nullptr && pOldBank != pBank)
+				pOldBank->UnmapFromPage(pageNo, EBankAccess::Read);
+			MappedReadBanks[pageNo] = bankId;
+			SetCodeAnalysisReadPage(pageNo, &pBank->Pages[bankPageNo]);	// Read
 		}
 
 		// Set Write Page
 		if (access == EBankAccess::Write || access == EBankAccess::ReadWrite)
 		{
-			MappedWriteBanks[startPageNo + bankPageNo] = bankId;
-			SetCodeAnalysisWritePage(startPageNo + bankPageNo, &pBank->Pages[bankPageNo]);	// Write
+			FCodeAnalysisBank* pOldBank = GetBank(MappedWriteBanks[pageNo]);
+			if (pOldBank != nullptr && pOldBank != pBank)
+				pOldBank->UnmapFromPage(pageNo, EBankAccess::Write);
+			MappedWriteBanks[pageNo] = bankId;
+			SetCodeAnalysisWritePage(pageNo, &pBank->Pages[bankPageNo]);	// Write
 		}
+
+		pBank->MapToPage(pageNo, access);
 	}
-	bMemoryRemapped = true;
 
-	bCodeAnalysisDataDirty = true;
+	// item list gets rebuilt when the UI sees the layout has changed
+	bMemoryRemapped = true;
+	pLastMemoryConfig = nullptr;
 
 	return true;
 }
 
+// Switch to a precomputed memory configuration
+// Only pages where the bank actually changes get touched
+void FCodeAnalysisState::ApplyMemoryConfig(const FCodeAnalysisMemoryConfig& config)
+{
+	if (pLastMemoryConfig == &config)	// nothing mapped since we last applied this
+		return;
+
+	for (int pageNo = 0; pageNo < kNoPagesInAddressSpace; pageNo++)
+	{
+		const int16_t readBankId = config.ReadBanks[pageNo];
+		if (readBankId != -1 && readBankId != MappedReadBanks[pageNo])
+		{
+			FCodeAnalysisBank* pOldBank = GetBank(MappedReadBanks[pageNo]);
+			if (pOldBank != nullptr)
+				pOldBank->UnmapFromPage(pageNo, EBankAccess::Read);
+
+			FCodeAnalysisBank* pBank = GetBank(readBankId);
+			if (pBank->bEverBeenMapped == false)
+			{
+				if (pBank->PrimaryMappedPage == -1)
+					pBank->PrimaryMappedPage = pageNo - config.ReadBankPages[pageNo];
+				pBank->bIsDirty = true;
+				bCodeAnalysisDataDirty = true;
+			}
+			pBank->MapToPage(pageNo, EBankAccess::Read);
+			MappedReadBanks[pageNo] = readBankId;
+			SetCodeAnalysisReadPage(pageNo, &pBank->Pages[config.ReadBankPages[pageNo]]);
+			bMemoryRemapped = true;
+		}
+
+		const int16_t writeBankId = config.WriteBanks[pageNo];
+		if (writeBankId != -1 && writeBankId != MappedWriteBanks[pageNo])
+		{
+			FCodeAnalysisBank* pOldBank = GetBank(MappedWriteBanks[pageNo]);
+			if (pOldBank != nullptr)
+				pOldBank->UnmapFromPage(pageNo, EBankAccess::Write);
+
+			FCodeAnalysisBank* pBank = GetBank(writeBankId);
+			if (pBank->bEverBeenMapped == false)
+			{
+				if (pBank->PrimaryMappedPage == -1)
+					pBank->PrimaryMappedPage = pageNo - config.WriteBankPages[pageNo];
+				pBank->bIsDirty = true;
+				bCodeAnalysisDataDirty = true;
+			}
+			pBank->MapToPage(pageNo, EBankAccess::Write);
+			MappedWriteBanks[pageNo] = writeBankId;
+			SetCodeAnalysisWritePage(pageNo, &pBank->Pages[config.WriteBankPages[pageNo]]);
+			bMemoryRemapped = true;
+		}
+	}
+
+	pLastMemoryConfig = &config;
+}
+
 #if 0
 bool FCodeAnalysisState::UnMapBank(int16_t bankId, int startPageNo, EBankAccess access)
 {
@@ -273,87 +324,9 @@ std::vector<FAddressRef> FCodeAnalysisState::FindAllMemoryPatterns(const uint8_t
 	return results;	
 }
 
-bool ContainsTextLower(const std::string& searchText, const std::string& stringToSearch)
-{
-	if(stringToSearch.empty())
-		return false;	// early out
-
-	std::string stringToSearchLower = stringToSearch;
-	std::transform(stringToSearchLower.begin(), stringToSearchLower.end(), stringToSearchLower.begin(), [](unsigned char c) { return std::tolower(c); });
-
-	return stringToSearchLower.find(searchText) != std::string::npos;
-}
-
 std::vector<FAddressRef> FCodeAnalysisState::FindInAnalysis(const char* pString, bool bSearchROM)
 {
-	std::vector<FAddressRef> results;
-
-	std::string searchTextLower = pString;
-	std::transform(searchTextLower.begin(), searchTextLower.end(), searchTextLower.begin(), [](unsigned char c) { return std::tolower(c); });
-
-	// iterate through banks
-	for (auto& bank : Banks)
-	{
-		if (bank.bMachineROM && bSearchROM == false)
-			continue;
-
-		for(int pageNo=0;pageNo<bank.NoPages;pageNo++)
-		{
-			const FCodeAnalysisPage& page = bank.Pages[pageNo];
-			for(int pageAddr=0;pageAddr< FCodeAnalysisPage::kPageSize;pageAddr++)
-			{
-				bool bFound = false;
-
-				// search code 
-				const FCodeInfo* pCodeInfo = page.CodeInfo[pageAddr];
-				if(pCodeInfo)
-				{
-					if(ContainsTextLower(searchTextLower,pCodeInfo->Comment))
-						bFound = true;
-				
-					// Generate code if there's no text
-					if(pCodeInfo->Text.empty())
-					{
-						MapBankForAnalysis(bank);	// map so we generate code for the correct bank
-						const uint16_t physAddress = bank.GetMappedAddress() + (pageNo * FCodeAnalysisPage::kPageSize) + pageAddr;
-						WriteCodeInfoForAddress(*this, physAddress);
-						UnMapAnalysisBanks();
-					}
-
-					Markup::SetCodeInfo(pCodeInfo);
-					const std::string expString = Markup::ExpandString(*this,pCodeInfo->Text.c_str());
-
-					// search code text
-					if (ContainsTextLower(searchTextLower, expString))
-						bFound = true;
-				}
-
-				// search label comment
-				const FLabelInfo* pLabelInfo = page.Labels[pageAddr];
-				if (pLabelInfo && ContainsTextLower(searchTextLower, pLabelInfo->Comment))
-					bFound = true;
-
-				// search label name
-				if (pLabelInfo && ContainsTextLower(searchTextLower, pLabelInfo->GetName()))
-					bFound = true;
-
-				// search data comment
-				if(ContainsTextLower(searchTextLower, page.DataInfo[pageAddr].Comment))
-					bFound = true;
-
-				// search comment block
-				const FCommentBlock* pCommentBlock = page.CommentBlocks[pageAddr];
-				if (pCommentBlock && ContainsTextLower(searchTextLower, pCommentBlock->Comment))
-					bFound = true;
-
-				if(bFound)
-					results.push_back(FAddressRef(bank.Id, bank.GetMappedAddress() + (pageNo * FCodeAnalysisPage::kPageSize) + pageAddr));
-
-			}
-		}
-	}
-
-	return results;
+	return SearchIndex.Find(*this, pString, bSearchROM);
 }
 
 bool IsAscii(uint8_t byte)
@@ -708,9 +681,8 @@ FLabelInfo* GenerateLabelForAddress(FCodeAnalysisState &state, FAddressRef addre
 	}
 
 	pLabel->InitialiseName(label);
-	if (pLabel->Global)
-		GenerateGlobalInfo(state);
 	state.SetLabelForAddress(address, pLabel);
+	UpdateGlobalInfoForAddress(state, address);
 	state.SetCodeAnalysisDirty(address);
 	return pLabel;	
 }
@@ -722,11 +694,16 @@ void UpdateCodeInfoForAddress(FCodeAnalysisState &state, uint16_t pc)
 		return;
 
 	pCodeInfo->bIsCall = CheckCallInstruction(state, pc);
+	state.DisassemblyCache.Invalidate(state.AddressRefFromPhysicalAddress(pc));
+}
 
-	if (state.CPUInterface->CPUType == ECPUType::Z80)
-		Z80DisassembleCodeInfoItem(pc, state, pCodeInfo);
-	else if (state.CPUInterface->CPUType == ECPUType::M6502)
-		M6502DisassembleCodeInfoItem(pc, state, pCodeInfo);
+// the referencing code's text now has the label name in it
+static void RegisterLabelReference(FCodeAnalysisState& state, FLabelInfo* pLabel, FAddressRef codeAddr)
+{
+	if (pLabel->References.HasReferenceTo(codeAddr))
+		return;
+	pLabel->References.RegisterAccess(codeAddr);
+	state.SearchIndex.MarkDirty(codeAddr);
 }
 
 // This assumes that the address passed in is mapped to physical memory
@@ -746,7 +723,7 @@ uint16_t WriteCodeInfoForAddress(FCodeAnalysisState &state, uint16_t pc)
 		pCodeInfo->bIsCall = CheckCallInstruction(state, pc);
 		FLabelInfo* pLabel = GenerateLabelForAddress(state, state.AddressRefFromPhysicalAddress(jumpAddr), pCodeInfo->bIsCall ? ELabelType::Function : ELabelType::Code);
 		if(pLabel)
-			pLabel->References.RegisterAccess(state.AddressRefFromPhysicalAddress(pc));
+			RegisterLabelReference(state, pLabel, state.AddressRefFromPhysicalAddress(pc));
 
 		pCodeInfo->OperandAddress = state.AddressRefFromPhysicalAddress(jumpAddr);
 		assert(state.IsAddressValid(pCodeInfo->OperandAddress));
@@ -777,17 +754,24 @@ uint16_t WriteCodeInfoForAddress(FCodeAnalysisState &state, uint16_t pc)
 			
 			FLabelInfo* pLabel = GenerateLabelForAddress(state, ptrAddr, ELabelType::Data);
 			if (pLabel)
-				pLabel->References.RegisterAccess(state.AddressRefFromPhysicalAddress(pc));
+				RegisterLabelReference(state, pLabel, state.AddressRefFromPhysicalAddress(pc));
 		}
 	}
 
-	// generate disassembly
+	// get instruction size - the text is generated on demand by the disassembly cache
 	uint16_t newPC = pc;
+	std::vector<uint8_t> opcodes;
 
 	if (state.CPUInterface->CPUType == ECPUType::Z80)
-		newPC = Z80DisassembleCodeInfoItem(pc,state,pCodeInfo);
+		newPC = Z80DisassembleGetNextPC(pc, state, opcodes);
 	else if (state.CPUInterface->CPUType == ECPUType::M6502)
-		newPC = M6502DisassembleCodeInfoItem(pc, state, pCodeInfo);
+		newPC = M6502DisassembleGetNextPC(pc, state, opcodes);
+
+	const FAddressRef pcAddr = state.AddressRefFromPhysicalAddress(pc);
+	state.DisassemblyCache.Invalidate(pcAddr);
+	if (pCodeInfo->bNeedsRewrite)	// SMC gets rewritten every time it's drawn so don't keep re-indexing it
+		state.SearchIndex.MarkDirty(pcAddr);
+	pCodeInfo->bNeedsRewrite = false;
 
 	state.SetCodeInfoForAddress(pc, pCodeInfo);	
 
@@ -861,7 +845,7 @@ bool AnalyseAtPC(FCodeAnalysisState &state, uint16_t& pc)
 	// get new code info
 	pCodeInfo = state.GetCodeInfoForPhysicalAddress(pc);
 	if (pOldComment != nullptr)	// restore old comment
-		pCodeInfo->Comment = std::string(pOldComment);
+		state.SetItemComment(state.AddressRefFromPhysicalAddress(pc), pCodeInfo, pOldComment);
 
 	if (CheckStopInstruction(state, pc) || newPC < pc)
 		return false;
@@ -902,6 +886,15 @@ bool RegisterCodeExecuted(FCodeAnalysisState &state, uint16_t pc, uint16_t oldpc
 
 		pCodeInfo->FrameLastExecuted = state.CurrentFrameNo;
 		pCodeInfo->ExecutionCount++;
+		state.GetReadPage(pc)->LastFrameAccessed = state.CurrentFrameNo;
+
+		if (state.RegisterProfiler.IsEnabled())
+		{
+			if (state.CPUInterface->CPUType == ECPUType::Z80)
+				CaptureRegisterProfileSampleZ80(state, pCodeInfo);
+			else if (state.CPUInterface->CPUType == ECPUType::M6502)
+				CaptureRegisterProfileSample6502(state, pCodeInfo);
+		}
 	}
 
 	if (state.CPUInterface->CPUType == ECPUType::Z80)
@@ -928,11 +921,13 @@ void RegisterDataRead(FCodeAnalysisState& state, uint16_t pc, uint16_t dataAddr)
 
 	if (state.GetCodeInfoForPhysicalAddress(dataAddr) == nullptr)	// don't register instruction data reads
 	{
-		FDataInfo* pDataInfo = state.GetReadDataInfoForAddress(dataAddr);
+		FCodeAnalysisPage* pPage = state.GetReadPage(dataAddr);
+		FDataInfo* pDataInfo = &pPage->DataInfo[dataAddr & FCodeAnalysisPage::kPageMask];
 		if(pDataInfo->DataType != EDataType::InstructionOperand)
 		{
 			pDataInfo->ReadCount++;
 			pDataInfo->LastFrameRead = state.CurrentFrameNo;
+			pPage->LastFrameAccessed = state.CurrentFrameNo;
 			pDataInfo->Reads.RegisterAccess(state.AddressRefFromPhysicalAddress(pc));
 		
 			FCodeInfo* pCodeInfo = state.GetCodeInfoForAddress(state.AddressRefFromPhysicalAddress(pc));
@@ -945,9 +940,12 @@ void RegisterDataRead(FCodeAnalysisState& state, uint16_t pc, uint16_t dataAddr)
 void RegisterDataWrite(FCodeAnalysisState &state, uint16_t pc,uint16_t dataAddr,uint8_t value)
 {
 	const FAddressRef pcAddr = state.AddressRefFromPhysicalAddress(pc);
-	FDataInfo* pDataInfo = state.GetWriteDataInfoForAddress(dataAddr);
+	FCodeAnalysisPage* pPage = state.GetWritePage(dataAddr);
+	FDataInfo* pDataInfo = &pPage->DataInfo[dataAddr & FCodeAnalysisPage::kPageMask];
 	pDataInfo->WriteCount++;
 	pDataInfo->LastFrameWritten = state.CurrentFrameNo;
+	pPage->WriteGeneration++;
+	pPage->LastFrameAccessed = state.CurrentFrameNo;
 	pDataInfo->Writes.RegisterAccess(pcAddr);
 
 	// check for SMC
@@ -959,6 +957,14 @@ void RegisterDataWrite(FCodeAnalysisState &state, uint16_t pc,uint16_t dataAddr,
 			pCodeWrittenTo->bSelfModifyingCode = true;
 	}
 
+	// writing to code changes what static analysis sees
+	if (pDataInfo->DataType == EDataType::InstructionOperand || pPage->CodeInfo[dataAddr & FCodeAnalysisPage::kPageMask] != nullptr)
+	{
+		FCodeAnalysisBank* pBank = state.GetBank(state.GetWriteBankFromAddress(dataAddr));
+		if (pBank != nullptr)
+			pBank->CodeChangeCount++;
+	}
+
 	FCodeInfo* pCodeInfo = state.GetCodeInfoForAddress(pcAddr);
 	if(pCodeInfo)
 	{
@@ -1065,9 +1071,7 @@ FLabelInfo* AddLabel(FCodeAnalysisState &state, uint16_t address,const char *nam
 	pLabel->MemoryRange = memoryRange;
 	pLabel->EnsureUniqueName();
 	state.SetLabelForPhysicalAddress(address, pLabel);
-
-	if (pLabel->Global)
-		GenerateGlobalInfo(state);
+	UpdateGlobalInfoForAddress(state, state.AddressRefFromPhysicalAddress(address));
 
 	return pLabel;
 }
@@ -1082,9 +1086,7 @@ FLabelInfo* AddLabel(FCodeAnalysisState& state, FAddressRef address, const char*
 	pLabel->Global = type == ELabelType::Function;
 	pLabel->MemoryRange = memoryRange;
 	state.SetLabelForAddress(address, pLabel);
-
-	if (pLabel->Global)
-		GenerateGlobalInfo(state);
+	UpdateGlobalInfoForAddress(state, address);
 
 	return pLabel;
 }
@@ -1105,6 +1107,13 @@ FCommentBlock* AddCommentBlock(FCodeAnalysisState& state, FAddressRef addressRef
 	return pExistingBlock;
 }
 
+// move the change numbers past every view so they all rebuild their filtered global lists
+static void ResetChangedGlobalLabels(FCodeAnalysisState& state)
+{
+	state.FirstChangedGlobalLabelNo += (uint32_t)state.ChangedGlobalLabels.size() + 1;
+	state.ChangedGlobalLabels.clear();
+}
+
 // Generate Global Info for items in address space
 void GenerateGlobalInfo(FCodeAnalysisState &state)
 {
@@ -1137,6 +1146,11 @@ void GenerateGlobalInfo(FCodeAnalysisState &state)
 		}
 	}
 
+	// keep in address order so UpdateGlobalInfoForAddress can binary search
+	auto addressOrder = [](const FCodeAnalysisItem& a, const FCodeAnalysisItem& b) { return a.AddressRef < b.AddressRef; };
+	std::sort(state.GlobalDataItems.begin(), state.GlobalDataItems.end(), addressOrder);
+	std::sort(state.GlobalFunctions.begin(), state.GlobalFunctions.end(), addressOrder);
+
 	/*for (int addr = 0; addr < (1 << 16); addr++)
 	{
 		FLabelInfo *pLabel = state.GetLabelForAddress(addr);
@@ -1153,8 +1167,48 @@ void GenerateGlobalInfo(FCodeAnalysisState &state)
 		
 	}*/
 
-	state.bRebuildFilteredGlobalDataItems = true;
-	state.bRebuildFilteredGlobalFunctions = true;
+	ResetChangedGlobalLabels(state);
+}
+
+// Update the global lists for a label that's been added, removed, retyped or renamed
+// Much cheaper than GenerateGlobalInfo which scans every bank
+void UpdateGlobalInfoForAddress(FCodeAnalysisState& state, FAddressRef addr)
+{
+	FLabelInfo* pLabel = nullptr;
+	const FCodeAnalysisBank* pBank = state.GetBank(addr.BankId);
+	if (pBank != nullptr && pBank->PrimaryMappedPage != -1)	// same rule as GenerateGlobalInfo
+		pLabel = state.GetLabelForAddress(addr);
+
+	// returns if the list has an entry for the address before or after
+	auto updateList = [addr](std::vector<FCodeAnalysisItem>& list, FLabelInfo* pListLabel)
+	{
+		auto it = std::lower_bound(list.begin(), list.end(), addr, [](const FCodeAnalysisItem& item, FAddressRef addr) { return item.AddressRef < addr; });
+		const bool bInList = it != list.end() && it->AddressRef == addr;
+		if (pListLabel == nullptr)
+		{
+			if (bInList)
+				list.erase(it);
+			return bInList;
+		}
+		
+		if (bInList)
+			it->Item = pListLabel;
+		else
+			list.insert(it, FCodeAnalysisItem(pListLabel, addr));
+		return true;
+	};
+
+	bool bChanged = updateList(state.GlobalDataItems, pLabel != nullptr && pLabel->LabelType == ELabelType::Data && pLabel->Global ? pLabel : nullptr);
+	bChanged |= updateList(state.GlobalFunctions, pLabel != nullptr && pLabel->LabelType == ELabelType::Function ? pLabel : nullptr);
+	if (bChanged == false)	// not a global
+		return;
+
+	// let the filtered lists catch up, past a point it's quicker to rebuild them
+	static const size_t kMaxChangedGlobalLabels = 256;
+	if (state.ChangedGlobalLabels.size() < kMaxChangedGlobalLabels)
+		state.ChangedGlobalLabels.push_back(addr);
+	else
+		ResetChangedGlobalLabels(state);
 }
 
 FCodeAnalysisState::FCodeAnalysisState()
@@ -1166,6 +1220,7 @@ FCodeAnalysisState::FCodeAnalysisState()
 		MappedWriteBanks[i] = -1;
 		MappedReadBanksBackup[i] = -1;
 		MappedWriteBanksBackup[i] = -1;
+		ViewedReadBanks[i] = -1;
 		ReadPageTable[i] = nullptr;
 		WritePageTable[i] = nullptr;
 	}
@@ -1202,9 +1257,15 @@ void FCodeAnalysisState::Init(FEmuBase* pEmu)
 	for (int i = 0; i < kNoPagesInAddressSpace; i++)
 	{
 		MappedMem[i] = nullptr;
+		ViewedReadBanks[i] = -1;	// force item list rebuild
 	}
+	bMemoryRemapped = true;
+	pLastMemoryConfig = nullptr;
 	
 	FreeMachineStates(*this);
+	SearchIndex.Reset();
+	DisassemblyCache.Reset();
+	RegisterProfiler.Init(pEmu->CPUType == ECPUType::Z80 ? EZ80ProfileReg::Count : E6502ProfileReg::Count);	// samples point at code infos
 	FLabelInfo::FreeAll();
 	FCodeInfo::FreeAll();
 	FCommentBlock::FreeAll();
@@ -1260,14 +1321,30 @@ void FCodeAnalysisState::Init(FEmuBase* pEmu)
 // Start/End handlers for host (imgui) frame
 void FCodeAnalysisState::OnFrameStart()
 {
+	UpdateTickFeatures();
 	Debugger.StartFrame();
 }
 
+// work out which tick handler variant the machine should use this frame
+void FCodeAnalysisState::UpdateTickFeatures()
+{
+	uint32_t features = 0;
+	if (bRegisterDataAccesses)
+		features |= ETickFeature::AccessTracking;
+	if (Debugger.IsEventTraceEnabled())
+		features |= ETickFeature::EventTrace;
+	if (bRegisterIOAccesses)
+		features |= ETickFeature::IOAnalysis;
+	TickFeatures = features;
+}
+
 void FCodeAnalysisState::OnFrameEnd()
 {
 	UpdateRegionDescs();
 	MemoryAnalyser.FrameTick();
 	IOAnalyser.FrameTick();
+	RegisterProfiler.Flush();
+	StaticAnalysis.FrameTick();
 	if (Debugger.FrameTick())
 	{
 		GetFocussedViewState().GoToAddress(CPUInterface->GetPC());
@@ -1288,7 +1365,7 @@ void	FCodeAnalysisState::OnMachineFrameEnd()
         CurrentFrameNo++;
 }
 
-void FCodeAnalysisState::OnCPUTick(uint64_t pins)
+void FCodeAnalysisState::RegisterIOAccesses(uint64_t pins)
 {
 	// Only Z80 has IO operations
 	if(CPUInterface->CPUType == ECPUType::Z80)
@@ -1305,8 +1382,6 @@ void FCodeAnalysisState::OnCPUTick(uint64_t pins)
 				IOAnalyser.RegisterIOWrite(Debugger.GetPC(), addr, data);
 		}
 	}
-
-	Debugger.CPUTick(pins);
 }
 
 void FixupDataInfoAddressRefs(const FCodeAnalysisState& state, FDataInfo* pDataInfo)
@@ -1479,10 +1554,11 @@ void RemoveLabelAtAddress(FCodeAnalysisState &state, FAddressRef address)
 
 	if (pLabelInfo != nullptr)
 	{
+		state.SearchIndex.MarkLabelDirty(address, pLabelInfo);
 		state.SetLabelForAddress(address, nullptr);
 		// Remove from globals
 		if (pLabelInfo->Global || pLabelInfo->LabelType == ELabelType::Function)
-			GenerateGlobalInfo(state);
+			UpdateGlobalInfoForAddress(state, address);
 
 		state.SetCodeAnalysisDirty(address);
 	}
@@ -1491,7 +1567,7 @@ void RemoveLabelAtAddress(FCodeAnalysisState &state, FAddressRef address)
 void SetItemCommentText(FCodeAnalysisState &state, const FCodeAnalysisItem& item, const char *pText)
 {
 	//DoCommand(state, new FSetItemCommentCommand(item,pText));
-	item.Item->Comment = pText;
+	state.SetItemComment(item.AddressRef, item.Item, pText);
 }
 
 
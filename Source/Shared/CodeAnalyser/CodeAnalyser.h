@@ -1,5 +1,6 @@
 #pragma once
 #include <cstdint>
+#include <cstring>
 #include <string>
 #include <map>
 #include <unordered_set>
@@ -12,6 +13,9 @@
 #include "Debugger.h"
 #include "MemoryAnalyser.h"
 #include "IOAnalyser.h"
+#include "RegisterProfiler.h"
+#include "SearchIndex.h"
+#include "DisassemblyCache.h"
 #include "StaticAnalysis.h"
 #include <Misc/GlobalConfig.h>
 #include "Commands/FormatDataCommand.h"
@@ -37,6 +41,7 @@ public:
 	virtual uint16_t	ReadWord(uint16_t address) const = 0;
 	virtual const uint8_t*	GetMemPtr(uint16_t address) const = 0;
 	virtual void		WriteByte(uint16_t address, uint8_t value) = 0;
+	virtual bool		QueuePoke(uint16_t address, uint8_t value) { return false; }	// true if the write will be done by the emulation thread
 
 	virtual FAddressRef	GetPC(void) = 0;
 	virtual uint16_t	GetSP(void) = 0;
@@ -181,6 +186,9 @@ struct FCodeAnalysisViewState
 	std::vector<FCodeAnalysisItem>	FilteredGlobalDataItems;
 	FLabelListFilter				GlobalFunctionsFilter;
 	std::vector<FCodeAnalysisItem>	FilteredGlobalFunctions;
+	bool							bRebuildFilteredGlobalDataItems = true;
+	bool							bRebuildFilteredGlobalFunctions = true;
+	uint32_t						GlobalLabelChangeNo = 0;	// how far through the state's global label changes the filtered lists are
 	EFunctionSortMode				FunctionSortMode = EFunctionSortMode::Location;
 	std::vector< FAddressCoord>		AddressCoords;
 	int								JumpLineIndent;
@@ -232,9 +240,8 @@ struct FCodeAnalysisBank
 	int16_t				Id = -1;
 	int					NoPages = 0;
 	uint32_t			SizeMask = 0;
-	//std::vector<int>	MappedPages;	// banks can be mapped to multiple pages
-	std::unordered_set<int>	MappedReadPages;
-	std::unordered_set<int>	MappedWritePages;
+	uint64_t			MappedReadPageMask = 0;	// bit per address space page the bank is mapped to
+	uint64_t			MappedWritePageMask = 0;
 	int					PrimaryMappedPage = -1;	// the page this bank is normally mapped to
 	uint8_t*			Memory = nullptr;	// pointer to memory bank occupies
 	FCodeAnalysisPage*	Pages = nullptr;
@@ -244,6 +251,7 @@ struct FCodeAnalysisBank
 	bool				bMachineROM = false;
 	bool				bFixed = false;	// bank is never remapped
 	bool				bIsDirty = false;
+	uint32_t			CodeChangeCount = 0;	// bumped when code infos are set or cleared or code is written to, for static analysis
 	bool				bEverBeenMapped = false;
 	bool				bHidden = false;
 	std::vector<FCodeAnalysisItem>		ItemList;
@@ -255,29 +263,29 @@ struct FCodeAnalysisBank
 	void UpdateMapping()
 	{
 		int mapping = 0;
-		if(MappedReadPages.empty() == false)
+		if(MappedReadPageMask != 0)
 			mapping |= 1;
-		if (MappedWritePages.empty() == false)
+		if (MappedWritePageMask != 0)
 			mapping |= 2;
 
 		Mapping = (EBankAccess)mapping;
 	}
-	void MapToPage(int startPageNo, EBankAccess access)
+	void MapToPage(int pageNo, EBankAccess access)
 	{
 		if((int)access & 1)
-			MappedReadPages.insert(startPageNo);
+			MappedReadPageMask |= 1ull << pageNo;
 		if ((int)access & 2)
-			MappedWritePages.insert(startPageNo);
+			MappedWritePageMask |= 1ull << pageNo;
 
 		bEverBeenMapped = true;
 		UpdateMapping();
 	}
-	void UnmapFromPage(int startPageNo, EBankAccess access)
+	void UnmapFromPage(int pageNo, EBankAccess access)
 	{
 		if ((int)access & 1)
-			MappedReadPages.erase(startPageNo);
+			MappedReadPageMask &= ~(1ull << pageNo);
 		if ((int)access & 2)
-			MappedWritePages.erase(startPageNo);
+			MappedWritePageMask &= ~(1ull << pageNo);
 		UpdateMapping();
 	}
 
@@ -290,6 +298,62 @@ struct FCodeAnalysisBank
 };
 
 
+// Precomputed bank mapping for one machine paging configuration (e.g. a port value)
+// Built once at init so switching configuration doesn't need a series of MapBank calls
+// Only the pages the configuration sets are touched when it is applied
+struct FCodeAnalysisMemoryConfig
+{
+	static const int kNoPages = (1 << 16) / FCodeAnalysisPage::kPageSize;
+
+	FCodeAnalysisMemoryConfig() { Reset(); }
+
+	void Reset()
+	{
+		for (int pageNo = 0; pageNo < kNoPages; pageNo++)
+		{
+			ReadBanks[pageNo] = -1;
+			WriteBanks[pageNo] = -1;
+		}
+	}
+
+	// same arguments as FCodeAnalysisState::MapBank
+	void MapBank(const FCodeAnalysisBank* pBank, int startPageNo, EBankAccess access = EBankAccess::ReadWrite)
+	{
+		for (int bankPageNo = 0; bankPageNo < pBank->NoPages; bankPageNo++)
+		{
+			if ((int)access & 1)
+			{
+				ReadBanks[startPageNo + bankPageNo] = pBank->Id;
+				ReadBankPages[startPageNo + bankPageNo] = (uint8_t)bankPageNo;
+			}
+			if ((int)access & 2)
+			{
+				WriteBanks[startPageNo + bankPageNo] = pBank->Id;
+				WriteBankPages[startPageNo + bankPageNo] = (uint8_t)bankPageNo;
+			}
+		}
+	}
+
+	int16_t		ReadBanks[kNoPages];	// -1 means page isn't set by this config
+	int16_t		WriteBanks[kNoPages];
+	uint8_t		ReadBankPages[kNoPages];	// page index within the bank
+	uint8_t		WriteBankPages[kNoPages];
+};
+
+// Optional analysis done in the machine CPU tick handlers
+// Machines instantiate a tick handler for each combination so features that are turned off cost nothing
+namespace ETickFeature
+{
+	enum : uint32_t
+	{
+		AccessTracking	= 1 << 0,	// data reads/writes, last writer & self modifying code
+		EventTrace		= 1 << 1,	// debugger event trace
+		IOAnalysis		= 1 << 2,	// IO port/chip register analysis
+
+		All = AccessTracking | EventTrace | IOAnalysis,
+		NoCombinations = All + 1
+	};
+}
 
 // code analysis information
 class FCodeAnalysisState
@@ -300,6 +364,7 @@ public:
 	static const int kPageShift = 10;
 	static const int kPageMask = 1023;
 	static const int kNoPagesInAddressSpace = kAddressSize / FCodeAnalysisPage::kPageSize;
+	static_assert(kNoPagesInAddressSpace <= 64, "bank page masks are 64 bits");
 
 	FCodeAnalysisState();
 	void	Init(FEmuBase* pEmu);
@@ -307,7 +372,17 @@ public:
 	void	OnFrameEnd();
 	void	OnMachineFrameStart();
 	void	OnMachineFrameEnd();
-	void	OnCPUTick(uint64_t pins);
+	void	UpdateTickFeatures();
+	uint32_t	GetTickFeatures() const { return TickFeatures; }
+
+	template<uint32_t kTickFeatures = ETickFeature::All>
+	void	OnCPUTick(uint64_t pins)
+	{
+		if constexpr ((kTickFeatures & ETickFeature::IOAnalysis) != 0)
+			RegisterIOAccesses(pins);
+		Debugger.CPUTick(pins);
+	}
+	void	RegisterIOAccesses(uint64_t pins);
 
 	const FEmuBase* GetEmulator() const { return pEmulator; }
 	FEmuBase* GetEmulator() { return pEmulator; }
@@ -327,6 +402,7 @@ public:
 	bool		FreeBanksFrom(int16_t bankId);
 	bool		SetBankPrimaryPage(int16_t bankId, int startPageNo);
 	bool		MapBank(int16_t bankId, int startPageNo, EBankAccess access = EBankAccess::ReadWrite);
+	void		ApplyMemoryConfig(const FCodeAnalysisMemoryConfig& config);
 
 	bool		IsBankIdMapped(int16_t bankId) const;
 	bool		IsAddressValid(FAddressRef addr) const;
@@ -383,9 +459,29 @@ public:
 	void		WriteByte(uint16_t address, uint8_t value) 
 	{ 
 		if (MappedMem[address >> kPageShift] == nullptr)
+		{
 			CPUInterface->WriteByte(address, value);
+		}
 		else
+		{
 			*(MappedMem[(address >> kPageShift)] + (address & kPageMask)) = value;
+			OnMemoryPoked(address);
+		}
+	}
+
+	// for writes the CPU didn't make (pokes, memory editing, Lua) so anything cached from the page gets refreshed
+	void		OnMemoryPoked(uint16_t address)
+	{
+		FCodeAnalysisPage* pPage = WritePageTable[address >> kPageShift];
+		if (pPage != nullptr)
+			pPage->WriteGeneration++;
+	}
+
+	// write from the UI - this goes via the emulation thread if the machine is running on one
+	void		PokeByte(uint16_t address, uint8_t value)
+	{
+		if (MappedMem[address >> kPageShift] != nullptr || CPUInterface->QueuePoke(address, value) == false)
+			WriteByte(address, value);
 	}
 	
 	int GetNoPages() const { return (int)RegisteredPages.size();}
@@ -418,6 +514,7 @@ public:
 		if (pBank != nullptr)
 			pBank->bIsDirty = true;
 		bCodeAnalysisDataDirty = true;
+		SearchIndex.MarkDirty(addrRef);
 	}
 
 	void	SetCodeAnalysisDirty(uint16_t address)	
@@ -451,9 +548,14 @@ public:
 		bCodeAnalysisDataDirty = false;
 	}
 	
-	bool IsCodeAnalysisDataDirty() const { return bCodeAnalysisDataDirty; }
-	void ClearRemappings() { bMemoryRemapped = false; }
-	bool HasMemoryBeenRemapped() const { return bMemoryRemapped; }
+	// bank switching only flags a remap - the UI works out if the layout it built for has actually changed
+	bool IsCodeAnalysisDataDirty() const { return bCodeAnalysisDataDirty || HasMemoryBeenRemapped(); }
+	void ClearRemappings() 
+	{ 
+		bMemoryRemapped = false; 
+		memcpy(ViewedReadBanks, MappedReadBanks, sizeof(ViewedReadBanks));
+	}
+	bool HasMemoryBeenRemapped() const { return bMemoryRemapped && memcmp(ViewedReadBanks, MappedReadBanks, sizeof(ViewedReadBanks)) != 0; }
 
 	bool RunStaticAnalysis() { return StaticAnalysis.RunAnalysis();}
 	//const std::vector<int16_t>& GetDirtyBanks() const { return RemappedBanks; }
@@ -466,14 +568,18 @@ public:
 public:
 
 	bool					bRegisterDataAccesses = true;
+	bool					bRegisterIOAccesses = true;
+	uint32_t				TickFeatures = ETickFeature::All;	// updated at the start of each frame
 
 	std::vector<FCodeAnalysisItem>	ItemList;
 
 	std::vector<FCodeAnalysisItem>	GlobalDataItems;
-	bool						bRebuildFilteredGlobalDataItems = true;	// should this be in the view 
-	
 	std::vector<FCodeAnalysisItem>	GlobalFunctions;
-	bool						bRebuildFilteredGlobalFunctions = true;
+
+	// global labels that have changed, each view applies them to its own filtered lists
+	// views that are further behind than FirstChangedGlobalLabelNo rebuild their lists
+	std::vector<FAddressRef>	ChangedGlobalLabels;
+	uint32_t					FirstChangedGlobalLabelNo = 0;	// change number of ChangedGlobalLabels[0]
 
 	static const int kNoViewStates = 4;
 	FCodeAnalysisViewState	ViewState[kNoViewStates];	// new multiple view states
@@ -485,6 +591,9 @@ public:
 	FMemoryAnalyser			MemoryAnalyser;
 	FIOAnalyser				IOAnalyser;
 	FStaticAnalyser			StaticAnalysis;
+	FRegisterProfiler		RegisterProfiler;
+	FSearchIndex			SearchIndex;
+	FDisassemblyCache		DisassemblyCache;
 
 	FAddressRef				CopiedAddress;
 
@@ -546,6 +655,7 @@ public:
 		if(pLabel != nullptr)	// ensure no name clashes
 			pLabel->EnsureUniqueName();
 		GetReadPage(addr)->Labels[addr & kPageMask] = pLabel; 
+		SearchIndex.MarkLabelDirty(AddressRefFromPhysicalAddress(addr), pLabel);
 	}
 	void SetLabelForAddress(FAddressRef addrRef, FLabelInfo* pLabel)
 	{
@@ -559,6 +669,7 @@ public:
 			assert(bankAddr < pBank->NoPages * FCodeAnalysisPage::kPageSize);	// This assert gets caused by banks being mapped into more than one location in physical memory
 			pBank->Pages[(bankAddr >> FCodeAnalysisPage::kPageShift) & pBank->SizeMask].Labels[bankAddr & FCodeAnalysisPage::kPageMask] = pLabel;
 		}
+		SearchIndex.MarkLabelDirty(addrRef, pLabel);
 	}
 
 	//FCommentBlock* GetCommentBlockForAddress(uint16_t addr) const { return GetReadPage(addr)->CommentBlocks[addr & kPageMask]; }
@@ -585,9 +696,22 @@ public:
 			assert(bankAddr < pBank->NoPages * FCodeAnalysisPage::kPageSize);	// This assert gets caused by banks being mapped into more than one location in physical memory
 			pBank->Pages[(bankAddr >> FCodeAnalysisPage::kPageShift) & pBank->SizeMask].CommentBlocks[bankAddr & FCodeAnalysisPage::kPageMask] = pCommentBlock;
 		}
+		SearchIndex.MarkDirty(addrRef);
 		//GetReadPage(addr)->CommentBlocks[addr & kPageMask] = pCommentBlock;
 	}
 
+	// text changes go through the state so the search index hears about them
+	void SetItemComment(FAddressRef addrRef, FItem* pItem, std::string comment)
+	{
+		pItem->Comment = std::move(comment);
+		SearchIndex.MarkDirty(addrRef);
+	}
+	void SetLabelName(FAddressRef addrRef, FLabelInfo* pLabel, const char* pNewName)
+	{
+		pLabel->ChangeName(pNewName);
+		SearchIndex.MarkLabelDirty(addrRef, pLabel);
+	}
+
 	const FCodeInfo* GetCodeInfoForPhysicalAddress(uint16_t addr) const { return GetReadPage(addr)->CodeInfo[addr & kPageMask]; }
 	FCodeInfo* GetCodeInfoForPhysicalAddress(uint16_t addr) { return GetReadPage(addr)->CodeInfo[addr & kPageMask]; }
 	FCodeInfo* GetCodeInfoForAddress(FAddressRef addrRef)
@@ -605,7 +729,17 @@ public:
 		}
 	}
 
-	void SetCodeInfoForAddress(uint16_t addr, FCodeInfo* pCodeInfo) { GetReadPage(addr)->CodeInfo[addr & kPageMask] = pCodeInfo; }
+	void SetCodeInfoForAddress(uint16_t addr, FCodeInfo* pCodeInfo) 
+	{ 
+		FCodeInfo*& pPageCodeInfo = GetReadPage(addr)->CodeInfo[addr & kPageMask];
+		if (pPageCodeInfo != pCodeInfo)
+		{
+			FCodeAnalysisBank* pBank = GetBank(GetReadBankFromAddress(addr));
+			if (pBank != nullptr)
+				pBank->CodeChangeCount++;
+		}
+		pPageCodeInfo = pCodeInfo; 
+	}
 	void SetCodeInfoForAddress(FAddressRef addrRef, FCodeInfo* pCodeInfo)
 	{ 
 		FCodeAnalysisBank* pBank = GetBank(addrRef.BankId);
@@ -613,7 +747,10 @@ public:
 		{
 			const uint16_t bankAddr = addrRef.Address - (pBank->PrimaryMappedPage * FCodeAnalysisPage::kPageSize);
 			assert(bankAddr < pBank->NoPages * FCodeAnalysisPage::kPageSize);	// This assert gets caused by banks being mapped into more than one location in physical memory
-			pBank->Pages[(bankAddr >> FCodeAnalysisPage::kPageShift) & pBank->SizeMask].CodeInfo[bankAddr & FCodeAnalysisPage::kPageMask] = pCodeInfo;
+			FCodeInfo*& pPageCodeInfo = pBank->Pages[(bankAddr >> FCodeAnalysisPage::kPageShift) & pBank->SizeMask].CodeInfo[bankAddr & FCodeAnalysisPage::kPageMask];
+			if (pPageCodeInfo != pCodeInfo)
+				pBank->CodeChangeCount++;
+			pPageCodeInfo = pCodeInfo;
 		}
 	}
 
@@ -699,6 +836,8 @@ private:
 	int16_t							MappedWriteBanks[kNoPagesInAddressSpace];	// banks mapped into address space
 	int16_t							MappedReadBanksBackup[kNoPagesInAddressSpace];	// banks mapped into address space
 	int16_t							MappedWriteBanksBackup[kNoPagesInAddressSpace];	// banks mapped into address space
+	int16_t							ViewedReadBanks[kNoPagesInAddressSpace];	// read banks when the item list was last built
+	const FCodeAnalysisMemoryConfig*	pLastMemoryConfig = nullptr;
 
 	uint8_t*						MappedMem[kNoPagesInAddressSpace];	// mapped analysis memory
 				
@@ -722,6 +861,7 @@ bool RegisterCodeExecuted(FCodeAnalysisState &state, uint16_t pc, uint16_t oldpc
 void ReAnalyseCode(FCodeAnalysisState &state);
 uint16_t WriteCodeInfoForAddress(FCodeAnalysisState& state, uint16_t pc);
 void GenerateGlobalInfo(FCodeAnalysisState &state);
+void UpdateGlobalInfoForAddress(FCodeAnalysisState& state, FAddressRef addr);
 void RegisterDataRead(FCodeAnalysisState& state, uint16_t pc, uint16_t dataAddr);
 void RegisterDataWrite(FCodeAnalysisState &state, uint16_t pc, uint16_t dataAddr, uint8_t value);
 void UpdateCodeInfoForAddress(FCodeAnalysisState &state, uint16_t pc);
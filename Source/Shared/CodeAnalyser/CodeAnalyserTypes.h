@@ -6,6 +6,8 @@
 #include <vector>
 #include <unordered_map>
 
+#include "LabelNameTable.h"
+
 // Enums
 
 // CPU abstraction
@@ -250,63 +252,70 @@ struct FLabelInfo : FItem
 	static FLabelInfo* Duplicate(const FLabelInfo* pSourceLabel);
 	static void FreeAll();
 
+	// take ownership of the name, adding a suffix if another label has it
 	bool EnsureUniqueName(void)
 	{
-		auto labelIt = LabelUsage.find(Name);
-		if (labelIt == LabelUsage.end())
-		{
-			LabelUsage[Name] = 0;
+		if (bNameAcquired)
 			return false;
-		}
 
-		char postFix[32];
-		snprintf(postFix, 32, "_%d", ++LabelUsage[Name]);
-		Name += std::string(postFix);
+		const uint32_t uniqueId = LabelNames.AcquireUniqueName(NameId);
+		bNameAcquired = true;
+		if (uniqueId == NameId)
+			return false;
 
+		NameId = uniqueId;
 		return true;
 	}
 
 	void SanitizeName(void)
 	{
-		for (int i = 0; i < Name.size(); i++)
+		if (strchr(GetName(), ' ') == nullptr)
+			return;
+
+		std::string name = GetName();
+		for (int i = 0; i < name.size(); i++)
 		{
-			const char ch = Name[i];
+			const char ch = name[i];
 			if(ch == ' ')
-				Name[i] = '_';
+				name[i] = '_';
 		}
+
+		const bool bWasAcquired = bNameAcquired;
+		ReleaseName();
+		NameId = LabelNames.Intern(name);
+		if (bWasAcquired)
+			EnsureUniqueName();
 	}
 
-	static bool RemoveLabelName(const std::string& labelName)
+	// label no longer uses its name so another label can have it
+	void ReleaseName(void)
 	{
-		auto labelIt = LabelUsage.find(labelName);
-		//assert(labelIt != LabelUsage.end());	// shouldn't happen - it does though - investigate
-		if (labelIt == LabelUsage.end())
-			return false;
-
-		if (labelIt->second == 0)	// only a single use so we can remove from the map
-		{
-			LabelUsage.erase(labelIt);
-			return true;
-		}
-
-		return false;
+		if (bNameAcquired)
+			LabelNames.ReleaseName(NameId);
+		bNameAcquired = false;
 	}
 
-	static void	ResetLabelNames() { LabelUsage.clear(); }
+	static void	ResetLabelNames() { LabelNames.Reset(); }
+	static FLabelNameTable& GetLabelNameTable() { return LabelNames; }
 
-
-	void			InitialiseName(const char* pNewName) { Name = pNewName; }
+	void			InitialiseName(const char* pNewName) 
+	{
+		ReleaseName();
+		NameId = LabelNames.Intern(pNewName); 
+	}
 	void			ChangeName(const char* pNewName) 
 	{
 		if (strlen(pNewName) == 0)	// don't let a label be empty
 			return;
 
-		RemoveLabelName(Name);
-		Name = pNewName;
+		ReleaseName();
+		NameId = LabelNames.Intern(pNewName);
 		EnsureUniqueName();
 		Edited = true;
 	}
-	const char*		GetName() const {return Name.c_str(); }
+	const char*		GetName() const { return LabelNames.GetString(NameId); }
+	uint32_t		GetNameId() const { return NameId; }
+	uint32_t		GetNameSortKey() const { return LabelNames.GetSortKey(NameId); }
 
 	bool					Global = false;
 	bool					Edited = false;	// has the name been changed since generation?
@@ -318,10 +327,11 @@ private:
 	FLabelInfo() { Type = EItemType::Label; }
 	~FLabelInfo() = default;
 
-	std::string				Name;
+	uint32_t				NameId = FLabelNameTable::kEmptyNameId;	// in LabelNames
+	bool					bNameAcquired = false;	// has EnsureUniqueName claimed the name
 
 	static std::vector<FLabelInfo*>	AllocatedList;
-	static std::unordered_map<std::string, int>	LabelUsage;
+	static FLabelNameTable			LabelNames;
 
 };
 
@@ -332,7 +342,6 @@ struct FCodeInfo : FItem
 
 	EOperandType	OperandType = EOperandType::Unknown;
 	int				StructId = -1;
-	std::string		Text;				// Disassembly text
 	FAddressRef		OperandAddress;	// optional operand address
 	int				FrameLastExecuted = -1;
 	int				ExecutionCount = 0;
@@ -352,11 +361,14 @@ struct FCodeInfo : FItem
 	};
 
 	bool	bNOPped = false;
+	bool	bNeedsRewrite = true;	// operand info needs regenerating with WriteCodeInfoForAddress - text comes from FDisassemblyCache
 	uint8_t	OpcodeBkp[4] = { 0 };
 
 	FItemReferenceTracker	Reads;	// addresses read by this instruction
 	FItemReferenceTracker	Writes;	// addresses written to by this function
 
+	struct FRegisterProfile*	pRegisterProfile = nullptr;	// owned by FRegisterProfiler
+
 private:
 	FCodeInfo() :FItem() { Type = EItemType::Code; }
 	~FCodeInfo() = default;
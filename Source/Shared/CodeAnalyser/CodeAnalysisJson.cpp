@@ -21,6 +21,7 @@ FCodeInfo* CreateCodeInfoFromJson(const json& codeInfoJson);
 FLabelInfo* CreateLabelInfoFromJson(const json& labelInfoJson);
 void LoadDataInfoFromJson(FCodeAnalysisState& state, FDataInfo* pDataInfo, const json& dataInfoJson);
 void FixupPostLoad(FCodeAnalysisState& state);
+void ReadGlobalsFromJson(FCodeAnalysisState& state, const json& jsonGameData);
 
 bool ExportAnalysisJson(FCodeAnalysisState& state, const char* pJsonFileName, bool bExportMachineROM)
 {
@@ -225,6 +226,16 @@ bool ImportAnalysisJson(FCodeAnalysisState& state, const char* pJsonFileName)
 		}
 	}
 
+	ReadGlobalsFromJson(state, jsonGameData);
+
+	FixupPostLoad(state);
+
+	return true;
+}
+
+// palettes, character sets/maps & data types - anything not stored per page
+void ReadGlobalsFromJson(FCodeAnalysisState& state, const json& jsonGameData)
+{
 	// Read in palettes.
 	// May be needed to create the character set.
 	LoadPalettesFromJson(jsonGameData);
@@ -296,10 +307,6 @@ bool ImportAnalysisJson(FCodeAnalysisState& state, const char* pJsonFileName)
     {
         pDataTypes->ReadFromJson(jsonGameData["DataTypes"]);
     }
-
-	FixupPostLoad(state);
-
-	return true;
 }
 
 bool WriteDataInfoToJson(uint16_t addr, const FDataInfo* pDataInfo, json& jsonDoc, int addressOverride = -1)
@@ -630,7 +637,7 @@ void FixupPostLoad(FCodeAnalysisState& state)
 				{
 					if(dataInfo.InstructionAddress != dataRef)	// is label inside instruction?
 					{
-						FLabelInfo::RemoveLabelName(pLabel->GetName());
+						pLabel->ReleaseName();
 						page.Labels[addr] = nullptr;
 					}
 				}
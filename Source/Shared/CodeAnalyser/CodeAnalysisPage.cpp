@@ -9,7 +9,7 @@
 //#include "json.hpp"
 std::vector<FCodeInfo*>		FCodeInfo::AllocatedList;
 std::vector<FLabelInfo*>				FLabelInfo::AllocatedList;
-std::unordered_map<std::string, int>	FLabelInfo::LabelUsage;
+FLabelNameTable						FLabelInfo::LabelNames;
 std::vector<FCommentBlock*>	FCommentBlock::AllocatedList;
 
 FImageData::~FImageData() 
@@ -46,6 +46,7 @@ FLabelInfo* FLabelInfo::Duplicate(const FLabelInfo* pSourceLabel)
 
 	FLabelInfo* pDuplicateLabel = Allocate();
 	*pDuplicateLabel = *pSourceLabel;
+	pDuplicateLabel->bNameAcquired = false;	// the source label still owns the name
 	return pDuplicateLabel;
 }
 
@@ -110,6 +111,8 @@ void FCodeAnalysisPage::Reset(void)
 		DataInfo[addr].Reset();
 		MachineState[addr] = nullptr;
 	}
+	WriteGeneration++;	// anything cached from this page is stale
+	LastFrameAccessed = -1;
 
 	Initialise();
 }
@@ -35,6 +35,8 @@ struct FCodeAnalysisPage
 
 	bool			bUsed = false;	// has this page been used?
 	int16_t			PageId = -1;
+	uint32_t		WriteGeneration = 0;	// bumped on every write the analyser sees, never goes back
+	int				LastFrameAccessed = -1;	// last frame any address was read, written or executed
 	FLabelInfo*		Labels[kPageSize];
 	FCodeInfo*		CodeInfo[kPageSize];
 	FDataInfo		DataInfo[kPageSize];
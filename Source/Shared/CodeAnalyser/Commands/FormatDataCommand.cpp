@@ -154,7 +154,7 @@ void FFormatDataCommand::Do(FCodeAnalysisState& state)
 		if (pLabel == nullptr)
 			pLabel = AddLabel(state, firstAddress, labelText.c_str(), ELabelType::Data);
 		else
-			pLabel->ChangeName(labelText.c_str());
+			state.SetLabelName(firstAddress, pLabel, labelText.c_str());
 
 		if(pLabel)
 			pLabel->Global = true;
@@ -169,11 +169,11 @@ void FFormatDataCommand::Do(FCodeAnalysisState& state)
 		if (pCommentBlock == nullptr)
 		{
 			pCommentBlock = AddCommentBlock(state, firstAddress);
-			pCommentBlock->Comment = FormatOptions.CommentText;
+			state.SetItemComment(firstAddress, pCommentBlock, FormatOptions.CommentText);
 		}
 		else
 		{
-			pCommentBlock->Comment += '\n' + FormatOptions.CommentText;
+			state.SetItemComment(firstAddress, pCommentBlock, pCommentBlock->Comment + '\n' + FormatOptions.CommentText);
 		}
 	}
 }
@@ -0,0 +1,29 @@
+#include "RenameLabelCommand.h"
+
+#include "../CodeAnalyser.h"
+
+void FRenameLabelCommand::Do(FCodeAnalysisState& state)
+{
+	FLabelInfo* pLabel = state.GetLabelForAddress(AddressRef);
+	if (pLabel == nullptr)
+		return;
+
+	OldName = pLabel->GetName();
+	state.SetLabelName(AddressRef, pLabel, NewName.c_str());
+	UpdateGlobalInfoForAddress(state, AddressRef);	// for filters & sorting
+}
+
+void FRenameLabelCommand::Undo(FCodeAnalysisState& state)
+{
+	FLabelInfo* pLabel = state.GetLabelForAddress(AddressRef);
+	if (pLabel == nullptr || OldName.empty())
+		return;
+
+	state.SetLabelName(AddressRef, pLabel, OldName.c_str());
+	UpdateGlobalInfoForAddress(state, AddressRef);	// for filters & sorting
+}
+
+void FRenameLabelCommand::FixupAddressRefs(const FCodeAnalysisState& state)
+{
+	FixupAddressRef(state, AddressRef);
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include "CommandProcessor.h"
+#include "../CodeAnalysisPage.h"
+#include "../CodeAnalyser.h"
+
+class FCodeAnalysisState;
+
+class FRenameLabelCommand : public FCommand
+{
+public:
+	FRenameLabelCommand(FAddressRef addr, const char* pNewName) :AddressRef(addr), NewName(pNewName) {}
+
+	virtual void Do(FCodeAnalysisState& state) override;
+	virtual void Undo(FCodeAnalysisState& state) override;
+	virtual void FixupAddressRefs(const FCodeAnalysisState& state) override;
+
+	FAddressRef		AddressRef;
+	std::string		NewName;
+	std::string		OldName;
+};
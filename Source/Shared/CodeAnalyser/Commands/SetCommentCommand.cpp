@@ -5,12 +5,12 @@
 void FSetItemCommentCommand::Do(FCodeAnalysisState& state)
 {
 	OldCommentText = Item.Item->Comment;
-	Item.Item->Comment = CommentText;
+	state.SetItemComment(Item.AddressRef, Item.Item, CommentText);
 }
  
 void FSetItemCommentCommand::Undo(FCodeAnalysisState& state)
 {
-	Item.Item->Comment = OldCommentText;
+	state.SetItemComment(Item.AddressRef, Item.Item, OldCommentText);
 }
 
 void FSetItemCommentCommand::FixupAddressRefs(const FCodeAnalysisState& state)
@@ -39,7 +39,7 @@ void FSetItemDataCommand::Do(FCodeAnalysisState& state)
 		if (pCodeItem->bDisabled == false)
 		{
 			pCodeItem->bDisabled = true;
-			pCodeItem->Text.clear();
+			pCodeItem->bNeedsRewrite = true;
 
 			// set all bytes to be data
 			for (int i = 0; i < pCodeItem->ByteSize; i++)
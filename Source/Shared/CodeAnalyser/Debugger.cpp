@@ -10,6 +10,7 @@
 #include "6502/M6502Disassembler.h"
 #include <Util/GraphicsView.h>
 #include "Misc/EmuBase.h"
+#include "Util/Misc.h"
 #include <ImGuiSupport/ImGuiScaling.h>
 
 static const uint32_t	BPMask_Exec			= 0x0001;
@@ -43,6 +44,8 @@ void FDebugger::Init(FCodeAnalysisState* pCA)
 	Breakpoints.clear();
 	CallStack.clear();
 	FrameTrace.clear();
+	FunctionProfiler.Init(pCA);
+	ScanlineTimeline.Init(pCA);
 }
 
 void FDebugger::CPUTick(uint64_t pins)
@@ -85,6 +88,8 @@ void FDebugger::CPUTick(uint64_t pins)
 		bNMI = risingPins & M6502_NMI;
 	}
 	
+    FunctionProfiler.Tick();
+    ScanlineTimeline.Tick();
     const FAddressRef addrRef = pCodeAnalysis->AddressRefFromPhysicalAddress(addr);
 
     if (bNewOp)
@@ -268,8 +273,8 @@ int FDebugger::OnInstructionExecuted(uint64_t pins)
 	{
 		FCPUFunctionCall callInfo;
 		callInfo.CallAddr = PC;
-		if (CPUType == ECPUType::Z80)
-			callInfo.FunctionAddr = PC;	// Z80TODO: get interrupt handler address
+		if (CPUType == ECPUType::Z80)	// assumes 0xff on the data bus for IM 2
+			callInfo.FunctionAddr = pCodeAnalysis->AddressRefFromPhysicalAddress(pZ80->im == 2 ? pCodeAnalysis->ReadWord((pZ80->i << 8) | 0xff) : 0x0038);
 		else if (CPUType == ECPUType::M6502)
 			callInfo.FunctionAddr = pCodeAnalysis->AddressRefFromPhysicalAddress(pCodeAnalysis->ReadWord(0xfffe));
 	
@@ -278,6 +283,11 @@ int FDebugger::OnInstructionExecuted(uint64_t pins)
 		//return UI_DBG_BP_BASE_TRAPID + 255;	//hack
 	}
 
+	if (FunctionProfiler.IsEnabled())
+		FunctionProfiler.OnInstructionExecuted(CallStack);
+	if (ScanlineTimeline.IsEnabled())
+		ScanlineTimeline.OnInstructionExecuted(PC, CallStack.empty() ? FAddressRef() : CallStack.back().FunctionAddr);
+
 	FrameTrace.push_back(PC);
 
 	// update stack size
@@ -301,6 +311,9 @@ int FDebugger::OnInstructionExecuted(uint64_t pins)
 // called at the start of every scanline
 void FDebugger::OnScanlineStart(int scanlineNo)
 {
+	if (ScanlineTimeline.IsEnabled())
+		ScanlineTimeline.OnScanlineStart(scanlineNo);
+
 	//if (BreakpointMask & BPMask_Scanline)
 	{
 		// TODO: check for scanline breakpoint
@@ -313,14 +326,18 @@ void FDebugger::OnScanlineStart(int scanlineNo)
 // will get called in the middle of emulation
 void FDebugger::OnMachineFrameStart()
 {
-	if (bClearEventsEveryFrame)
-		ClearEvents();
+	if (ScanlineTimeline.IsEnabled())
+		ScanlineTimeline.OnMachineFrameStart();
+
+	EventTrace.OnMachineFrameStart();
 
 	ResetScanlineEvents();
 }
 
 void FDebugger::OnMachineFrameEnd()
 {
+	FunctionProfiler.OnMachineFrameEnd();
+
 	// handle frame stepping - should this be in the machine frame handler?
 	if (StepMode == EDebugStepMode::Frame)
 	{
@@ -492,25 +509,61 @@ void	FDebugger::SaveToFile(FILE* fp)
 }
 
 
-void FDebugger::Break()
-{ 
-    StepMode = EDebugStepMode::None;
-    bDebuggerStopped = true;
-}
+void FDebugger::Break()				{ RunCommand(EDebuggerCommand::Break); }
+void FDebugger::Continue()			{ RunCommand(EDebuggerCommand::Continue); }
+void FDebugger::StepInto()			{ RunCommand(EDebuggerCommand::StepInto); }
+void FDebugger::StepOver()			{ RunCommand(EDebuggerCommand::StepOver); }
+void FDebugger::StepFrame()			{ RunCommand(EDebuggerCommand::StepFrame); }
+void FDebugger::StepScreenWrite()	{ RunCommand(EDebuggerCommand::StepScreenWrite); }
+void FDebugger::StepIORead()		{ RunCommand(EDebuggerCommand::StepIORead); }
+void FDebugger::StepIOWrite()		{ RunCommand(EDebuggerCommand::StepIOWrite); }
 
-void FDebugger::Continue()
-{ 
-    StepMode = EDebugStepMode::None; 
-    bDebuggerStopped = false; 
+// send the command to the emulation thread if there is one
+void FDebugger::RunCommand(EDebuggerCommand command)
+{
+	if (pCommandHandler != nullptr && pCommandHandler->QueueDebuggerCommand(command))
+		return;
 
-    SelectedCallstackNo = -1;
+	ExecuteCommand(command);
 }
 
-
-void FDebugger::StepInto()
+void FDebugger::ExecuteCommand(EDebuggerCommand command)
 {
-    StepMode = EDebugStepMode::StepInto;
-    bDebuggerStopped = false;
+	switch (command)
+	{
+	case EDebuggerCommand::Break:
+		StepMode = EDebugStepMode::None;
+		bDebuggerStopped = true;
+		break;
+	case EDebuggerCommand::Continue:
+		StepMode = EDebugStepMode::None;
+		bDebuggerStopped = false;
+		SelectedCallstackNo = -1;
+		break;
+	case EDebuggerCommand::StepInto:
+		StepMode = EDebugStepMode::StepInto;
+		bDebuggerStopped = false;
+		break;
+	case EDebuggerCommand::StepOver:
+		SetupStepOver();
+		break;
+	case EDebuggerCommand::StepFrame:
+		StepMode = EDebugStepMode::Frame;
+		bDebuggerStopped = false;
+		break;
+	case EDebuggerCommand::StepScreenWrite:
+		StepMode = EDebugStepMode::ScreenWrite;
+		bDebuggerStopped = false;
+		break;
+	case EDebuggerCommand::StepIORead:
+		StepMode = EDebugStepMode::IORead;
+		bDebuggerStopped = false;
+		break;
+	case EDebuggerCommand::StepIOWrite:
+		StepMode = EDebugStepMode::IOWrite;
+		bDebuggerStopped = false;
+		break;
+	}
 }
 
 // check if the an instruction is a 'step over' op 
@@ -556,7 +609,7 @@ static bool IsStepOverOpcode(ECPUType cpuType, const std::vector<uint8_t>& opcod
     }
 }
 
-void	FDebugger::StepOver()
+void	FDebugger::SetupStepOver()
 {
 	std::vector<uint8_t> stepOpcodes;
    
@@ -578,30 +631,6 @@ void	FDebugger::StepOver()
     }
 }
 
-void	FDebugger::StepFrame()
-{
-	StepMode = EDebugStepMode::Frame;
-    bDebuggerStopped = false;
-}
-
-void	FDebugger::StepScreenWrite()
-{
-    StepMode = EDebugStepMode::ScreenWrite;
-    bDebuggerStopped = false;
-}
-
-void	FDebugger::StepIORead()
-{
-	StepMode = EDebugStepMode::IORead;
-	bDebuggerStopped = false;
-}
-
-void	FDebugger::StepIOWrite()
-{
-	StepMode = EDebugStepMode::IOWrite;
-	bDebuggerStopped = false;
-}
-
 // Breakpoints
 
 bool FDebugger::AddExecBreakpoint(FAddressRef addr)
@@ -809,11 +838,11 @@ void FDebugger::RegisterEvent(uint8_t type, FAddressRef pc, uint16_t address, ui
 {
 	std::vector<FEventTypeInfo>& eventTypeInfo = g_EventTypeInfo;
 
-	if (!eventTypeInfo[type].bEnabled)
+	if (!bEventTraceEnabled || !eventTypeInfo[type].bEnabled)
 		return;
 
 	ScanlineEvents[scanlinePos] = type;
-	EventTrace.emplace_back(type, pc, address, value, scanlinePos);
+	EventTrace.AddEvent(type, pc, address, value, scanlinePos);
 
 	if(bWriteEventComments)
 	{ 
@@ -821,7 +850,7 @@ void FDebugger::RegisterEvent(uint8_t type, FAddressRef pc, uint16_t address, ui
 		FCodeInfo* pCodeInfo = state.GetCodeInfoForAddress(pc);
 
 		if (pCodeInfo != nullptr && pCodeInfo->Comment.empty())
-			pCodeInfo->Comment = GetEventName(type);
+			state.SetItemComment(pc, pCodeInfo, GetEventName(type));
 	}
 }
 
@@ -837,7 +866,8 @@ const char* FDebugger::GetEventName(uint8_t type)
 
 void FDebugger::ClearEvents()
 {
-	EventTrace.clear();
+	EventTrace.Reset();
+	SelectedEvent = -1;
 }
 
 bool	FDebugger::TraceForward(FCodeAnalysisViewState& viewState)
@@ -1320,20 +1350,87 @@ void FDebugger::DrawEvents(void)
 	if (ImGui::Button("Clear"))
 		ClearEvents();
 	ImGui::SameLine();
-	ImGui::Checkbox("Clear Every Frame", &bClearEventsEveryFrame);
+	ImGui::Checkbox("Current Frame Only", &bShowCurrentFrameEventsOnly);
+	ImGui::SameLine();
+	ImGui::Checkbox("Enabled", &bEventTraceEnabled);
+	ImGui::SameLine();
+	const bool bWriteComments = ImGui::Button("Write Comments");
+	//disabled for now as it's a bit dangerous
+	//ImGui::SameLine();
+	//ImGui::Checkbox("Write On Register", &bWriteEventComments);
+
+	int noFramesToKeep = EventTrace.GetNoFramesToKeep();
+	ImGui::SetNextItemWidth(ImGui::GetFontSize() * 6);
+	if (ImGui::InputInt("Frames Kept", &noFramesToKeep))
+		EventTrace.SetNoFramesToKeep(noFramesToKeep);
+	if (!bShowCurrentFrameEventsOnly)
+	{
+		ImGui::SameLine();
+		ImGui::SetNextItemWidth(ImGui::GetFontSize() * 6);
+		ImGui::InputInt("Frames Shown", &EventFramesToShow);
+		EventFramesToShow = std::max(1, std::min(EventFramesToShow, EventTrace.GetNoFramesToKeep()));
+	}
+
+	// filters
+	ImGui::SetNextItemWidth(ImGui::GetFontSize() * 12);
+	if (ImGui::BeginCombo("Type", EventFilterType == -1 ? "All" : GetEventName((uint8_t)EventFilterType)))
+	{
+		if (ImGui::Selectable("All", EventFilterType == -1))
+			EventFilterType = -1;
+		for (int typeNo = 0; typeNo < (int)eventTypeInfo.size(); typeNo++)
+		{
+			if (eventTypeInfo[typeNo].EventName[0] == 0)	// Skip 'None'
+				continue;
+			if (ImGui::Selectable(eventTypeInfo[typeNo].EventName, EventFilterType == typeNo))
+				EventFilterType = typeNo;
+		}
+		ImGui::EndCombo();
+	}
+	const bool bHex = GetNumberDisplayMode() != ENumberDisplayMode::Decimal;
+	const char* formatStr = bHex ? "%x" : "%u";
+	const ImGuiInputTextFlags inputFlags = bHex ? ImGuiInputTextFlags_CharsHexadecimal : ImGuiInputTextFlags_CharsDecimal;
+	ImGui::SameLine();
+	ImGui::Checkbox("Address##filter", &bEventFilterAddress);
+	if (bEventFilterAddress)
+	{
+		ImGui::SameLine();
+		ImGui::SetNextItemWidth(ImGui::GetFontSize() * 4);
+		ImGui::InputScalar("##filteraddress", ImGuiDataType_U16, &EventFilterAddress, NULL, NULL, formatStr, inputFlags);
+	}
 	ImGui::SameLine();
-	if (ImGui::Button("Write Comments"))
+	ImGui::Checkbox("PC##filter", &bEventFilterPC);
+	if (bEventFilterPC)
 	{
-		for (const auto& event : EventTrace)
+		ImGui::SameLine();
+		ImGui::SetNextItemWidth(ImGui::GetFontSize() * 4);
+		ImGui::InputScalar("##filterpc", ImGuiDataType_U16, &EventFilterPC, NULL, NULL, formatStr, inputFlags);
+	}
+
+	// gather the events to show - the whole range if there's no filter
+	const uint64_t firstEvent = EventTrace.GetFrameStartEvent(bShowCurrentFrameEventsOnly ? 0 : EventFramesToShow - 1);
+	const bool bFiltered = EventFilterType != -1 || bEventFilterAddress || bEventFilterPC;
+	if (bFiltered)
+	{
+		FEventQuery query;
+		query.Type = EventFilterType;
+		query.Address = bEventFilterAddress ? EventFilterAddress : -1;
+		query.PCAddress = bEventFilterPC ? EventFilterPC : -1;
+		query.FirstEvent = firstEvent;
+		EventTrace.FindEvents(query, EventViewList);
+	}
+	const int noEventsShown = bFiltered ? (int)EventViewList.size() : (int)(EventTrace.GetEndEvent() - firstEvent);
+	auto getShownEvent = [this, bFiltered, firstEvent](int i) { return bFiltered ? EventViewList[i] : firstEvent + i; };
+
+	if (bWriteComments)
+	{
+		for (int i = 0; i < noEventsShown; i++)
 		{
-			FCodeInfo* pCodeInfo = state.GetCodeInfoForAddress(event.PC);
+			const uint64_t eventNo = getShownEvent(i);
+			FCodeInfo* pCodeInfo = state.GetCodeInfoForAddress(EventTrace.GetEventPC(eventNo));
 			if(pCodeInfo != nullptr && pCodeInfo->Comment.empty())
-				pCodeInfo->Comment = GetEventName(event.Type);
+				state.SetItemComment(EventTrace.GetEventPC(eventNo), pCodeInfo, GetEventName(EventTrace.GetEventType(eventNo)));
 		}
 	}
-	//disabled for now as it's a bit dangerous
-	//ImGui::SameLine();
-	//ImGui::Checkbox("Write On Register", &bWriteEventComments);
 
 	FCodeAnalysisViewState& viewState = state.GetFocussedViewState();
 	const float lineHeight = ImGui::GetTextLineHeight();
@@ -1373,11 +1470,12 @@ void FDebugger::DrawEvents(void)
 	viewState.HighlightScanline = -1;
 
 	static ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable;
-	if (ImGui::BeginTable("Events", 5, flags))
+	if (ImGui::BeginTable("Events", 6, flags))
 	{
 		const float fontSize = ImGui::GetFontSize();
 
 		ImGui::TableSetupScrollFreeze(0, 1); // Make top row always visible
+		ImGui::TableSetupColumn("Frame", ImGuiTableColumnFlags_WidthFixed, fontSize * 4);
 		ImGui::TableSetupColumn("Scanline", ImGuiTableColumnFlags_WidthFixed, fontSize * 3);
 		ImGui::TableSetupColumn("Type", ImGuiTableColumnFlags_WidthFixed, fontSize * 14);
 		ImGui::TableSetupColumn("PC", ImGuiTableColumnFlags_WidthStretch);
@@ -1385,25 +1483,29 @@ void FDebugger::DrawEvents(void)
 		ImGui::TableSetupColumn("Value", ImGuiTableColumnFlags_WidthFixed, fontSize * 8);
 		ImGui::TableHeadersRow();
 		ImGuiListClipper clipper;
-		clipper.Begin((int)EventTrace.size());
+		clipper.Begin(noEventsShown);
 		while (clipper.Step())
 		{
 			for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++)
 			{
-				const FEvent& event = EventTrace[i];
+				const uint64_t eventNo = getShownEvent(i);
+				const FEvent event = EventTrace.GetEvent(eventNo);
 				const FEventTypeInfo& typeInfo = g_EventTypeInfo[event.Type];
 				ImGui::PushID(i);
 				ImGui::TableNextRow();
 
 				ImGui::TableSetColumnIndex(0);
-				const bool bSelected = SelectedEventIndex == i;
+				const bool bSelected = SelectedEvent == (int64_t)eventNo;
 				ImGuiSelectableFlags selectableFlags = ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowOverlap;
 				if (ImGui::Selectable("##eventselect", bSelected, selectableFlags, ImVec2(0, 0)))
 				{
-					SelectedEventIndex = i;
+					SelectedEvent = eventNo;
 				}
 				ImGui::SetItemAllowOverlap();	// allow buttons
 				ImGui::SameLine();
+				ImGui::Text("%d", EventTrace.GetEventFrameNo(eventNo));
+
+				ImGui::TableSetColumnIndex(1);
 				ImGui::Text("%d", event.ScanlinePos);
 				
 				// highlight scanline
@@ -1412,7 +1514,7 @@ void FDebugger::DrawEvents(void)
 					const uint32_t col = GetEventColour(event.Type);
 					pEmuBase->SetScanlineHighlight(event.ScanlinePos, col);
 				}
-				ImGui::TableSetColumnIndex(1);
+				ImGui::TableSetColumnIndex(2);
 				ImVec2 pos = ImGui::GetCursorScreenPos();
 					
 				// Type
@@ -1428,12 +1530,12 @@ void FDebugger::DrawEvents(void)
 				}
 
 				// PC
-				ImGui::TableSetColumnIndex(2);
+				ImGui::TableSetColumnIndex(3);
 				ImGui::Text("%s:", NumStr(event.PC.Address));
 				DrawAddressLabel(state, viewState, event.PC);
 
 				// Address
-				ImGui::TableSetColumnIndex(3);
+				ImGui::TableSetColumnIndex(4);
 				if (typeInfo.ShowAddressCB != nullptr)
 				{
 					typeInfo.ShowAddressCB(state, event);
@@ -1445,7 +1547,7 @@ void FDebugger::DrawEvents(void)
 				}
 
 				// Value
-				ImGui::TableSetColumnIndex(4);
+				ImGui::TableSetColumnIndex(5);
 				if (typeInfo.ShowValueCB != nullptr)
 				{
 					typeInfo.ShowValueCB(state, event);
@@ -1515,6 +1617,18 @@ void FDebugger::DrawUI(void)
 			ImGui::EndTabItem();
 		}
 
+		if (ImGui::BeginTabItem("Profiler"))
+		{
+			FunctionProfiler.DrawUI();
+			ImGui::EndTabItem();
+		}
+
+		if (ImGui::BeginTabItem("Timeline"))
+		{
+			ScanlineTimeline.DrawUI();
+			ImGui::EndTabItem();
+		}
+
 		ImGui::EndTabBar();
 	}
 }
@@ -1541,8 +1655,5 @@ void FDebugger::FixupAddresRefs(void)
 		FixupAddressRef(*pCodeAnalysis, functionCall.ReturnAddr);
 	}
 
-	for (FEvent& event : EventTrace)
-	{
-		FixupAddressRef(*pCodeAnalysis, event.PC);
-	}
+	EventTrace.FixupAddressRefs(*pCodeAnalysis);
 }
\ No newline at end of file
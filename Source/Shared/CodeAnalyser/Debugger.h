@@ -1,6 +1,9 @@
 #pragma once
 
 #include <CodeAnalyser/CodeAnalyserTypes.h>
+#include "EventLog.h"
+#include "FunctionProfiler.h"
+#include "ScanlineTimeline.h"
 
 #include <chips/z80.h>
 #include <chips/m6502.h>
@@ -30,6 +33,27 @@ enum class EDebugStepMode
 	NMI,
 };
 
+// debugger actions which can be sent to the thread running the emulator
+enum class EDebuggerCommand
+{
+	Break,
+	Continue,
+	StepInto,
+	StepOver,
+	StepFrame,
+	StepScreenWrite,
+	StepIORead,
+	StepIOWrite,
+};
+
+// implemented by emulators which run on their own thread
+class IDebuggerCommandHandler
+{
+public:
+	// return true if the command has been queued for the emulation thread, false to execute it now
+	virtual bool	QueueDebuggerCommand(EDebuggerCommand command) = 0;
+};
+
 // only add to end otherwise you'll break the file format
 enum class EBreakpointType
 {
@@ -85,18 +109,6 @@ struct FCPUFunctionCall
 };*/
 
 
-struct FEvent
-{
-	FEvent(uint8_t type, FAddressRef pc, uint16_t address, uint8_t value, uint16_t scanlinePos)
-		: Type(type), PC(pc), Address(address), Value(value), ScanlinePos(scanlinePos) {}
-
-	uint8_t			Type;
-	uint16_t		Address;
-	uint8_t			Value;
-	uint16_t		ScanlinePos;
-	FAddressRef		PC;
-};
-
 typedef void (*ShowEventInfoCB)(FCodeAnalysisState& state, const FEvent& event);
 
 
@@ -126,6 +138,9 @@ public:
 	void	StepIOWrite();
 	void	SetPC(FAddressRef newPC) { PC = newPC; }
 
+	void	SetCommandHandler(IDebuggerCommandHandler* pHandler) { pCommandHandler = pHandler; }
+	void	ExecuteCommand(EDebuggerCommand command);
+
 	// Breakpoints
 	bool	AddExecBreakpoint(FAddressRef addr);
 	bool	AddDataBreakpoint(FAddressRef addr, uint16_t size);
@@ -147,11 +162,14 @@ public:
 	void RegisterEventType(uint8_t type, const char* pName, uint32_t col, ShowEventInfoCB pShowAddress = nullptr, ShowEventInfoCB pShowValue = nullptr);
 	void ResetScanlineEvents(void);
 	void RegisterEvent(uint8_t type, FAddressRef pc, uint16_t address, uint8_t value, uint16_t scanlinePos);
-	const std::vector<FEvent>& GetEventTrace() const { return EventTrace; }
+	const FEventLog& GetEventTrace() const { return EventTrace; }
+	FEventLog& GetEventTrace() { return EventTrace; }
 	const uint8_t* GetScanlineEvents() const { return ScanlineEvents; }
 	uint32_t GetEventColour(uint8_t type);
 	const char* GetEventName(uint8_t type);
 	void ClearEvents();
+	bool IsEventTraceEnabled() const { return bEventTraceEnabled; }
+	void SetEventTraceEnabled(bool bEnabled) { bEventTraceEnabled = bEnabled; }
 
 	// Frame Trace
 	const std::vector<FAddressRef>& GetFrameTrace() const { return FrameTrace; }
@@ -164,6 +182,10 @@ public:
 
 	std::vector<FCPUFunctionCall>& GetCallstack() { return CallStack; }
 
+	// Profiling
+	FFunctionProfiler&	GetFunctionProfiler() { return FunctionProfiler; }
+	FScanlineTimeline&	GetScanlineTimeline() { return ScanlineTimeline; }
+
 	// Queries
 	bool	IsStopped() const { return bDebuggerStopped; }
 	bool	IsAddressBreakpointed(FAddressRef addr) const;
@@ -187,9 +209,12 @@ public:
 	void FixupAddresRefs(void);
 private:
 	int		GetFrameTraceItemIndex(FAddressRef address);
+	void	RunCommand(EDebuggerCommand command);
+	void	SetupStepOver();
 
 private:
 	FCodeAnalysisState*	pCodeAnalysis = nullptr;
+	IDebuggerCommandHandler*	pCommandHandler = nullptr;
 
 	ECPUType		CPUType = ECPUType::Unknown;
 	z80_t*			pZ80 = nullptr;
@@ -206,10 +231,18 @@ private:
 	std::vector<FWatch>			Watches;
 	FWatch						SelectedWatch;
 	std::vector<FAddressRef>	FrameTrace;
-	std::vector<FEvent>			EventTrace;
-	int							SelectedEventIndex = -1;
+	FEventLog					EventTrace;
+	int64_t						SelectedEvent = -1;	// event number in the log
+	std::vector<uint64_t>		EventViewList;	// events matching the view filters
+	int							EventFramesToShow = 1;
+	int							EventFilterType = -1;
+	bool						bEventFilterAddress = false;
+	uint16_t					EventFilterAddress = 0;
+	bool						bEventFilterPC = false;
+	uint16_t					EventFilterPC = 0;
 	uint8_t						ScanlineEvents[320] = {0};
-	bool						bClearEventsEveryFrame = true;
+	bool						bEventTraceEnabled = true;
+	bool						bShowCurrentFrameEventsOnly = true;
 	bool						bWriteEventComments = false;
 
 	//bool						bInterruptTriggered = false;
@@ -217,6 +250,8 @@ private:
 	int							FrameTraceItemIndex = -1;
 	std::vector<FCPUFunctionCall>	CallStack;
 	int														SelectedCallstackNo = -1;
+	FFunctionProfiler				FunctionProfiler;
+	FScanlineTimeline				ScanlineTimeline;
 
 	std::vector<FAddressRef>	StackSetLocations;
 	//std::vector<FStackInfo>		Stacks;
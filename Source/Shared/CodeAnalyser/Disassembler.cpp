@@ -282,14 +282,16 @@ void DasmOutputD8(int8_t val, dasm_output_t out_cb, void* user_data)
 	if (pNumberOutput)
 		pNumberOutput->OutputD8(val, out_cb);
 }
-/*
-std::string GenerateDasmStringForAddress(FCodeAnalysisState& state, uint16_t pc, ENumberDisplayMode hexMode)
+
+std::string GenerateDasmStringForAddress(FCodeAnalysisState& state, uint16_t pc, const FCodeInfo* pCodeInfo)
 {
+	std::string text;
 	if(state.CPUInterface->CPUType == ECPUType::Z80)
-		return Z80GenerateDasmStringForAddress(state,pc,hexMode);
-	else
-		return M6502GenerateDasmStringForAddress(state, pc, hexMode);
-}*/
+		Z80DisassembleCodeInfoItem(pc, state, pCodeInfo, text);
+	else if (state.CPUInterface->CPUType == ECPUType::M6502)
+		M6502DisassembleCodeInfoItem(pc, state, pCodeInfo, text);
+	return text;
+}
 
 bool GenerateDasmExportString(FExportDasmState& exportState)
 {
@@ -45,7 +45,7 @@ public:
 	void OutputU16(uint16_t val, dasm_output_t outputCallback) override;
 	void OutputD8(int8_t val, dasm_output_t outputCallback) override;
 
-	FCodeInfo* pCodeInfoItem = nullptr;
+	const FCodeInfo* pCodeInfoItem = nullptr;
 };
 
 uint8_t AnalysisDasmInputCB(void* pUserData);
@@ -75,6 +75,7 @@ void DasmOutputU8(uint8_t val, dasm_output_t out_cb, void* user_data);
 void DasmOutputU16(uint16_t val, dasm_output_t out_cb, void* user_data);
 void DasmOutputD8(int8_t val, dasm_output_t out_cb, void* user_data);
 
-//std::string GenerateDasmStringForAddress(FCodeAnalysisState& state, uint16_t pc, ENumberDisplayMode hexMode);
+// generate the markup text for an instruction - use FDisassemblyCache in the UI
+std::string GenerateDasmStringForAddress(FCodeAnalysisState& state, uint16_t pc, const FCodeInfo* pCodeInfo);
 
 bool GenerateDasmExportString(FExportDasmState& exportState);
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include "DisassemblyCache.h"
+
+#include "CodeAnalyser.h"
+#include "Disassembler.h"
+
+#include <algorithm>
+
+FDisassemblyCache::FDisassemblyCache()
+{
+	Entries.reserve(kMaxEntries);
+}
+
+void FDisassemblyCache::Reset()
+{
+	Entries.clear();
+	Lookup.clear();
+	Head = -1;
+	Tail = -1;
+	NoHits = 0;
+	NoMisses = 0;
+}
+
+void FDisassemblyCache::Unlink(int entryIndex)
+{
+	FDasmEntry& entry = Entries[entryIndex];
+	if (entry.Prev != -1)
+		Entries[entry.Prev].Next = entry.Next;
+	else
+		Head = entry.Next;
+	if (entry.Next != -1)
+		Entries[entry.Next].Prev = entry.Prev;
+	else
+		Tail = entry.Prev;
+	entry.Prev = entry.Next = -1;
+}
+
+void FDisassemblyCache::LinkAtHead(int entryIndex)
+{
+	FDasmEntry& entry = Entries[entryIndex];
+	entry.Prev = -1;
+	entry.Next = Head;
+	if (Head != -1)
+		Entries[Head].Prev = entryIndex;
+	Head = entryIndex;
+	if (Tail == -1)
+		Tail = entryIndex;
+}
+
+const std::string& FDisassemblyCache::GetText(FCodeAnalysisState& state, FAddressRef addr, const FCodeInfo* pCodeInfo)
+{
+	FDasmKey key;
+	key.ByteSize = (uint8_t)std::min(pCodeInfo->ByteSize, (uint16_t)4);
+	for (int i = 0; i < key.ByteSize; i++)
+		key.Bytes |= state.ReadByte(addr.Address + i) << (i * 8);
+	key.NumberMode = (int8_t)GetNumberDisplayMode();
+	key.HexNumberMode = (int8_t)GetHexNumberDisplayMode();
+	key.OperandType = (uint8_t)pCodeInfo->OperandType;
+	key.bOperandAddressValid = pCodeInfo->OperandAddress.IsValid();
+	key.Epoch = Epoch;
+
+	int entryIndex = -1;
+	auto lookupIt = Lookup.find(addr);
+	if (lookupIt != Lookup.end())
+	{
+		entryIndex = lookupIt->second;
+		Unlink(entryIndex);
+		LinkAtHead(entryIndex);
+
+		FDasmEntry& entry = Entries[entryIndex];
+		if (entry.Key == key)
+		{
+			NoHits++;
+			return entry.Text;
+		}
+	}
+	else if ((int)Entries.size() < kMaxEntries)
+	{
+		entryIndex = (int)Entries.size();
+		Entries.emplace_back();
+		LinkAtHead(entryIndex);
+	}
+	else
+	{
+		// recycle the least recently used entry
+		entryIndex = Tail;
+		Lookup.erase(Entries[entryIndex].Address);
+		Unlink(entryIndex);
+		LinkAtHead(entryIndex);
+	}
+
+	NoMisses++;
+	FDasmEntry& entry = Entries[entryIndex];
+	entry.Address = addr;
+	entry.Key = key;
+	entry.Text = GenerateDasmStringForAddress(state, addr.Address, pCodeInfo);
+	Lookup[addr] = entryIndex;
+	return entry.Text;
+}
+
+void FDisassemblyCache::Invalidate(FAddressRef addr)
+{
+	auto lookupIt = Lookup.find(addr);
+	if (lookupIt == Lookup.end())
+		return;
+
+	// leave the entry in the list, it'll get recycled
+	Entries[lookupIt->second].Key.Epoch = Epoch - 1;
+}
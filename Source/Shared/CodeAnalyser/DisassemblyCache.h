@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CodeAnalyserTypes.h"
+
+class FCodeAnalysisState;
+struct FCodeInfo;
+
+// Disassembly text is generated when an instruction is drawn & kept in a fixed size LRU cache
+// Entries are keyed on everything the text depends on so number mode changes, SMC etc. just miss the cache
+// Label names aren't in the text - they're expanded from the markup when drawing
+class FDisassemblyCache
+{
+public:
+	FDisassemblyCache();
+
+	void	Reset();
+
+	// address must be mapped in
+	const std::string&	GetText(FCodeAnalysisState& state, FAddressRef addr, const FCodeInfo* pCodeInfo);
+
+	void	Invalidate(FAddressRef addr);
+	void	InvalidateAll() { Epoch++; }	// entries get regenerated when next used
+
+	int		GetNoHits() const { return NoHits; }
+	int		GetNoMisses() const { return NoMisses; }
+private:
+	struct FDasmKey
+	{
+		bool operator==(const FDasmKey& other) const
+		{
+			return Bytes == other.Bytes && ByteSize == other.ByteSize && NumberMode == other.NumberMode && HexNumberMode == other.HexNumberMode &&
+				OperandType == other.OperandType && bOperandAddressValid == other.bOperandAddressValid && Epoch == other.Epoch;
+		}
+
+		uint32_t	Bytes = 0;	// instruction bytes
+		uint8_t		ByteSize = 0;
+		int8_t		NumberMode = 0;
+		int8_t		HexNumberMode = 0;
+		uint8_t		OperandType = 0;
+		bool		bOperandAddressValid = false;
+		uint32_t	Epoch = 0;
+	};
+
+	struct FDasmEntry
+	{
+		FAddressRef	Address;
+		FDasmKey	Key;
+		std::string	Text;
+		int			Prev = -1;	// LRU list - head is most recently used
+		int			Next = -1;
+	};
+
+	void	Unlink(int entryIndex);
+	void	LinkAtHead(int entryIndex);
+
+	static const int kMaxEntries = 4096;	// plenty for the visible rows of all the code views
+
+	std::vector<FDasmEntry>					Entries;
+	std::unordered_map<FAddressRef, int>	Lookup;
+	int			Head = -1;
+	int			Tail = -1;
+	uint32_t	Epoch = 0;
+
+	int			NoHits = 0;
+	int			NoMisses = 0;
+};
@@ -0,0 +1,146 @@
+#include "EventLog.h"
+
+#include "CodeAnalyser.h"
+
+#include <algorithm>
+
+void FEventIndexList::RemoveBefore(uint64_t eventNo)
+{
+	while (Start < Events.size() && Events[Start] < eventNo)
+		Start++;
+
+	// shuffle down once the dead part gets big
+	if (Start > 1024 && Start * 2 > Events.size())
+	{
+		Events.erase(Events.begin(), Events.begin() + Start);
+		Start = 0;
+	}
+}
+
+FEventLog::FEventLog()
+{
+	Types.resize(kMaxEvents);
+	PCs.resize(kMaxEvents);
+	Addresses.resize(kMaxEvents);
+	Values.resize(kMaxEvents);
+	ScanlinePositions.resize(kMaxEvents);
+	TypeIndex.resize(256);
+	AddressIndex.resize(65536);
+	Reset();
+}
+
+void FEventLog::Reset()
+{
+	FirstEvent = NextEvent;	// keep numbering so old event numbers don't alias new events
+	for (FEventIndexList& list : TypeIndex)
+		list.Clear();
+	for (FEventIndexList& list : AddressIndex)
+		list.Clear();
+
+	Frames.clear();
+	Frames.push_back({ FrameNo, NextEvent });
+	FramesSinceSweep = 0;
+}
+
+void FEventLog::SetNoFramesToKeep(int noFrames)
+{
+	NoFramesToKeep = std::max(1, noFrames);
+}
+
+void FEventLog::OnMachineFrameStart()
+{
+	FrameNo++;
+	Frames.push_back({ FrameNo, NextEvent });
+
+	// drop frames we don't want to keep & frames which have been overwritten
+	const int noFramesToKeep = std::max(NoFramesToKeep, MinFramesToKeep);
+	while ((int)Frames.size() > noFramesToKeep)
+		Frames.pop_front();
+	while (Frames.size() > 1 && Frames[1].FirstEvent <= FirstEvent)
+		Frames.pop_front();
+	FirstEvent = std::max(FirstEvent, Frames.front().FirstEvent);
+
+	if (++FramesSinceSweep >= kSweepInterval)
+		SweepIndexes();
+}
+
+// lists only get trimmed when added to, so trim them all now & again
+void FEventLog::SweepIndexes()
+{
+	for (FEventIndexList& list : TypeIndex)
+		list.RemoveBefore(FirstEvent);
+	for (FEventIndexList& list : AddressIndex)
+		list.RemoveBefore(FirstEvent);
+	FramesSinceSweep = 0;
+}
+
+uint64_t FEventLog::GetFrameStartEvent(int framesAgo) const
+{
+	if (framesAgo >= (int)Frames.size())
+		return FirstEvent;
+	return std::max(FirstEvent, Frames[Frames.size() - 1 - framesAgo].FirstEvent);
+}
+
+uint32_t FEventLog::GetEventFrameNo(uint64_t eventNo) const
+{
+	auto frameIt = std::upper_bound(Frames.begin(), Frames.end(), eventNo, [](uint64_t eventNo, const FEventFrame& frame)
+	{
+		return eventNo < frame.FirstEvent;
+	});
+	if (frameIt == Frames.begin())
+		return Frames.front().FrameNo;
+	return (frameIt - 1)->FrameNo;
+}
+
+void FEventLog::FindEvents(const FEventQuery& query, std::vector<uint64_t>& outEvents) const
+{
+	outEvents.clear();
+
+	const uint64_t firstEvent = std::max(query.FirstEvent, FirstEvent);
+	const uint64_t endEvent = std::min(query.EndEvent, NextEvent);
+	if (firstEvent >= endEvent)
+		return;
+
+	auto matches = [this, &query](uint64_t eventNo)
+	{
+		const uint32_t index = (uint32_t)eventNo & kEventMask;
+		return (query.Type == -1 || Types[index] == query.Type) &&
+			(query.Address == -1 || Addresses[index] == query.Address) &&
+			(query.PCAddress == -1 || PCs[index].Address == query.PCAddress);
+	};
+
+	// use the smallest index
+	const FEventIndexList* pIndex = nullptr;
+	if (query.Type != -1)
+		pIndex = &TypeIndex[query.Type & 0xff];
+	if (query.Address != -1)
+	{
+		const FEventIndexList* pAddressIndex = &AddressIndex[query.Address & 0xffff];
+		if (pIndex == nullptr || pAddressIndex->Size() < pIndex->Size())
+			pIndex = pAddressIndex;
+	}
+
+	if (pIndex == nullptr)
+	{
+		// no index for this - scan the range
+		for (uint64_t eventNo = firstEvent; eventNo < endEvent; eventNo++)
+		{
+			if (matches(eventNo))
+				outEvents.push_back(eventNo);
+		}
+		return;
+	}
+
+	auto eventIt = std::lower_bound(pIndex->Events.begin() + pIndex->Start, pIndex->Events.end(), firstEvent);
+	for (; eventIt != pIndex->Events.end() && *eventIt < endEvent; ++eventIt)
+	{
+		if (matches(*eventIt))
+			outEvents.push_back(*eventIt);
+	}
+}
+
+void FEventLog::FixupAddressRefs(const FCodeAnalysisState& state)
+{
+	for (uint64_t eventNo = FirstEvent; eventNo < NextEvent; eventNo++)
+		FixupAddressRef(state, PCs[(uint32_t)eventNo & kEventMask]);
+}
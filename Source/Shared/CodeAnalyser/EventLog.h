@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "CodeAnalyserTypes.h"
+
+class FCodeAnalysisState;
+
+struct FEvent
+{
+	FEvent(uint8_t type, FAddressRef pc, uint16_t address, uint8_t value, uint16_t scanlinePos)
+		: Type(type), PC(pc), Address(address), Value(value), ScanlinePos(scanlinePos) {}
+
+	uint8_t			Type;
+	uint16_t		Address;
+	uint8_t			Value;
+	uint16_t		ScanlinePos;
+	FAddressRef		PC;
+};
+
+// sorted event numbers - expired events get trimmed off the front
+struct FEventIndexList
+{
+	void	Add(uint64_t eventNo) { Events.push_back(eventNo); }
+	void	RemoveBefore(uint64_t eventNo);
+	void	Clear() { Events.clear(); Start = 0; }
+	size_t	Size() const { return Events.size() - Start; }
+
+	std::vector<uint64_t>	Events;
+	size_t					Start = 0;
+};
+
+struct FEventQuery
+{
+	int			Type = -1;		// -1 for any
+	int			Address = -1;	// -1 for any
+	int			PCAddress = -1;	// -1 for any
+	uint64_t	FirstEvent = 0;	// range of event numbers to look through
+	uint64_t	EndEvent = UINT64_MAX;
+};
+
+// Debugger event log kept over a number of machine frames
+// Events are stored a column per field in a ring buffer & numbered in the order they happened
+// The type & address indexes let queries find their events without scanning the log
+class FEventLog
+{
+public:
+	FEventLog();
+	void	Reset();
+	void	OnMachineFrameStart();
+	void	AddEvent(uint8_t type, FAddressRef pc, uint16_t address, uint8_t value, uint16_t scanlinePos)
+	{
+		// ring is full - lose the oldest
+		if (NextEvent - FirstEvent == kMaxEvents)
+			FirstEvent++;
+
+		const uint32_t index = (uint32_t)NextEvent & kEventMask;
+		Types[index] = type;
+		PCs[index] = pc;
+		Addresses[index] = address;
+		Values[index] = value;
+		ScanlinePositions[index] = scanlinePos;
+
+		FEventIndexList& typeList = TypeIndex[type];
+		typeList.RemoveBefore(FirstEvent);
+		typeList.Add(NextEvent);
+		FEventIndexList& addressList = AddressIndex[address];
+		addressList.RemoveBefore(FirstEvent);
+		addressList.Add(NextEvent);
+
+		NextEvent++;
+	}
+
+	void	SetNoFramesToKeep(int noFrames);
+	int		GetNoFramesToKeep() const { return NoFramesToKeep; }
+	void	SetMinFramesToKeep(int noFrames) { MinFramesToKeep = noFrames; }	// for viewers which hold on to event ranges
+	int		GetNoFrames() const { return (int)Frames.size(); }
+
+	// events are numbered from the start of the log
+	uint64_t	GetFirstEvent() const { return FirstEvent; }	// oldest event still in the log
+	uint64_t	GetEndEvent() const { return NextEvent; }	// one past the newest
+	uint64_t	GetFrameStartEvent(int framesAgo) const;	// 0 is the current frame
+	bool		IsEventValid(uint64_t eventNo) const { return eventNo >= FirstEvent && eventNo < NextEvent; }
+
+	FEvent		GetEvent(uint64_t eventNo) const
+	{
+		const uint32_t index = (uint32_t)eventNo & kEventMask;
+		return FEvent(Types[index], PCs[index], Addresses[index], Values[index], ScanlinePositions[index]);
+	}
+	uint8_t		GetEventType(uint64_t eventNo) const { return Types[(uint32_t)eventNo & kEventMask]; }
+	FAddressRef	GetEventPC(uint64_t eventNo) const { return PCs[(uint32_t)eventNo & kEventMask]; }
+	uint32_t	GetEventFrameNo(uint64_t eventNo) const;
+	uint32_t	GetFrameNo() const { return FrameNo; }
+
+	// event numbers matching the query in order
+	void		FindEvents(const FEventQuery& query, std::vector<uint64_t>& outEvents) const;
+
+	void		FixupAddressRefs(const FCodeAnalysisState& state);
+
+	static const int	kMaxEvents = 1 << 20;
+private:
+	void		SweepIndexes();
+
+	static const uint32_t	kEventMask = kMaxEvents - 1;
+	static const int		kSweepInterval = 64;	// frames between trimming all the indexes
+
+	// event columns
+	std::vector<uint8_t>		Types;
+	std::vector<FAddressRef>	PCs;
+	std::vector<uint16_t>		Addresses;
+	std::vector<uint8_t>		Values;
+	std::vector<uint16_t>		ScanlinePositions;
+
+	struct FEventFrame
+	{
+		uint32_t	FrameNo = 0;
+		uint64_t	FirstEvent = 0;
+	};
+	std::deque<FEventFrame>		Frames;	// oldest first
+
+	std::vector<FEventIndexList>	TypeIndex;		// indexed by event type
+	std::vector<FEventIndexList>	AddressIndex;	// indexed by IO/memory address
+
+	uint64_t	FirstEvent = 0;
+	uint64_t	NextEvent = 0;
+	uint32_t	FrameNo = 0;
+	int			NoFramesToKeep = 50;
+	int			MinFramesToKeep = 0;
+	int			FramesSinceSweep = 0;
+};
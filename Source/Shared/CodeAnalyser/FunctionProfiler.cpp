@@ -0,0 +1,417 @@
+#include "FunctionProfiler.h"
+
+#include "CodeAnalyser.h"
+#include "UI/CodeAnalyserUI.h"
+#include <Util/Misc.h>
+#include <Debug/DebugLog.h>
+
+#include <imgui.h>
+#include <algorithm>
+
+void FFunctionProfiler::Init(FCodeAnalysisState* pCA)
+{
+	pCodeAnalysis = pCA;
+	Reset();
+}
+
+void FFunctionProfiler::Reset()
+{
+	Functions.clear();
+	FunctionLookup.clear();
+	CallSites.clear();
+	CallSiteLookup.clear();
+	CallTree.clear();
+	Stack.clear();
+
+	// root entry for code outside of any call we've seen
+	FStackEntry rootEntry;
+	rootEntry.EntryTick = TickCount;
+	rootEntry.FunctionIndex = GetFunctionIndex(FAddressRef());
+	rootEntry.NodeIndex = 0;
+	CallTree.emplace_back();
+	Stack.push_back(rootEntry);
+
+	FrameStartTick = TickCount;
+	LastFrameTicks = 0;
+	FramesProfiled = 0;
+}
+
+void FFunctionProfiler::SetEnabled(bool bEnable)
+{
+	if (bEnable && bEnabled == false)
+		Reset();
+	bEnabled = bEnable;
+}
+
+// keep our stack in step with the debugger call stack
+void FFunctionProfiler::OnInstructionExecuted(const std::vector<FCPUFunctionCall>& callStack)
+{
+	// pop anything that has returned or been unwound
+	while (Stack.size() > 1)
+	{
+		const size_t depth = Stack.size() - 1;
+		const FStackEntry& top = Stack.back();
+		if (depth <= callStack.size() && top.FunctionAddr == callStack[depth - 1].FunctionAddr && top.CallAddr == callStack[depth - 1].CallAddr)
+			break;
+		PopEntry();
+	}
+
+	while (Stack.size() - 1 < callStack.size())
+		PushEntry(callStack[Stack.size() - 1]);
+}
+
+void FFunctionProfiler::PushEntry(const FCPUFunctionCall& call)
+{
+	FStackEntry entry;
+	entry.FunctionAddr = call.FunctionAddr;
+	entry.CallAddr = call.CallAddr;
+	entry.EntryTick = TickCount;
+	entry.FunctionIndex = GetFunctionIndex(call.FunctionAddr);
+	entry.CallSiteIndex = GetCallSiteIndex(call);
+	entry.NodeIndex = GetChildNode(Stack.back().NodeIndex, call.FunctionAddr);
+
+	FFunctionProfile& function = Functions[entry.FunctionIndex];
+	function.Frame.Calls++;
+	function.Total.Calls++;
+	FCallSiteProfile& callSite = CallSites[entry.CallSiteIndex];
+	callSite.Frame.Calls++;
+	callSite.Total.Calls++;
+
+	Stack.push_back(entry);
+}
+
+void FFunctionProfiler::PopEntry()
+{
+	FStackEntry& entry = Stack.back();
+	const uint64_t inclusiveTicks = TickCount - entry.EntryTick;
+	AccountEntry(entry);
+	Stack.pop_back();
+	Stack.back().ChildTicks += inclusiveTicks;
+}
+
+// add the ticks since the entry started to the stats
+void FFunctionProfiler::AccountEntry(FStackEntry& entry)
+{
+	const uint64_t inclusiveTicks = TickCount - entry.EntryTick;
+	const uint64_t exclusiveTicks = inclusiveTicks - entry.ChildTicks;
+
+	FFunctionProfile& function = Functions[entry.FunctionIndex];
+	function.Frame.InclusiveTicks += inclusiveTicks;
+	function.Frame.ExclusiveTicks += exclusiveTicks;
+	function.Total.InclusiveTicks += inclusiveTicks;
+	function.Total.ExclusiveTicks += exclusiveTicks;
+
+	if (entry.CallSiteIndex != -1)
+	{
+		FCallSiteProfile& callSite = CallSites[entry.CallSiteIndex];
+		callSite.Frame.InclusiveTicks += inclusiveTicks;
+		callSite.Frame.ExclusiveTicks += exclusiveTicks;
+		callSite.Total.InclusiveTicks += inclusiveTicks;
+		callSite.Total.ExclusiveTicks += exclusiveTicks;
+	}
+
+	FProfileCallTreeNode& node = CallTree[entry.NodeIndex];
+	node.FrameTicks += exclusiveTicks;
+	node.TotalTicks += exclusiveTicks;
+}
+
+void FFunctionProfiler::OnMachineFrameEnd()
+{
+	if (bEnabled == false)
+		return;
+
+	// account for the functions that are still running - deepest first so parents get the child time
+	for (int i = (int)Stack.size() - 1; i >= 0; i--)
+	{
+		FStackEntry& entry = Stack[i];
+		const uint64_t inclusiveTicks = TickCount - entry.EntryTick;
+		AccountEntry(entry);
+		entry.EntryTick = TickCount;
+		entry.ChildTicks = 0;
+		if (i > 0)
+			Stack[i - 1].ChildTicks += inclusiveTicks;
+	}
+
+	for (FFunctionProfile& function : Functions)
+	{
+		function.LastFrame = function.Frame;
+		function.Frame = FFunctionProfileStats();
+	}
+	for (FCallSiteProfile& callSite : CallSites)
+	{
+		callSite.LastFrame = callSite.Frame;
+		callSite.Frame = FFunctionProfileStats();
+	}
+	for (FProfileCallTreeNode& node : CallTree)
+	{
+		node.LastFrameTicks = node.FrameTicks;
+		node.FrameTicks = 0;
+	}
+
+	LastFrameTicks = TickCount - FrameStartTick;
+	FrameStartTick = TickCount;
+	FramesProfiled++;
+}
+
+int FFunctionProfiler::GetFunctionIndex(FAddressRef functionAddr)
+{
+	auto it = FunctionLookup.find(functionAddr);
+	if (it != FunctionLookup.end())
+		return it->second;
+
+	const int index = (int)Functions.size();
+	FFunctionProfile& function = Functions.emplace_back();
+	function.FunctionAddr = functionAddr;
+	FunctionLookup[functionAddr] = index;
+	return index;
+}
+
+int FFunctionProfiler::GetCallSiteIndex(const FCPUFunctionCall& call)
+{
+	// the debugger pushes interrupts with the interrupted PC as the return address
+	const bool bInterrupt = call.CallAddr == call.ReturnAddr;
+	const FAddressRef key = bInterrupt ? FAddressRef() : call.CallAddr;
+
+	auto it = CallSiteLookup.find(key);
+	if (it != CallSiteLookup.end())
+		return it->second;
+
+	const int index = (int)CallSites.size();
+	FCallSiteProfile& callSite = CallSites.emplace_back();
+	callSite.CallAddr = key;
+	callSite.FunctionAddr = call.FunctionAddr;
+	callSite.bInterrupt = bInterrupt;
+	CallSiteLookup[key] = index;
+	return index;
+}
+
+int FFunctionProfiler::GetChildNode(int parentNode, FAddressRef functionAddr)
+{
+	for (int childNode : CallTree[parentNode].Children)
+	{
+		if (CallTree[childNode].FunctionAddr == functionAddr)
+			return childNode;
+	}
+
+	const int index = (int)CallTree.size();
+	FProfileCallTreeNode& node = CallTree.emplace_back();
+	node.FunctionAddr = functionAddr;
+	node.Parent = parentNode;
+	CallTree[parentNode].Children.push_back(index);
+	return index;
+}
+
+std::string FFunctionProfiler::GetFunctionName(FAddressRef functionAddr) const
+{
+	if (functionAddr.IsValid() == false)
+		return "root";
+
+	const FLabelInfo* pLabel = pCodeAnalysis->GetLabelForAddress(functionAddr);
+	if (pLabel != nullptr)
+		return pLabel->GetName();
+
+	return NumStr(functionAddr.Address);
+}
+
+// Brendan Gregg's folded stack format: "root;func;subfunc ticks" - one line per unique call path
+bool FFunctionProfiler::ExportFoldedStacks(const char* pFileName, bool bLastFrame) const
+{
+	FILE* fp = fopen(pFileName, "wt");
+	if (fp == nullptr)
+		return false;
+
+	std::vector<std::string> nodePaths(CallTree.size());
+	for (int nodeNo = 0; nodeNo < (int)CallTree.size(); nodeNo++)
+	{
+		// parents are always created before their children
+		const FProfileCallTreeNode& node = CallTree[nodeNo];
+		const std::string name = GetFunctionName(node.FunctionAddr);
+		nodePaths[nodeNo] = node.Parent == -1 ? name : nodePaths[node.Parent] + ";" + name;
+
+		const uint64_t ticks = bLastFrame ? node.LastFrameTicks : node.TotalTicks;
+		if (ticks != 0)
+			fprintf(fp, "%s %llu\n", nodePaths[nodeNo].c_str(), (unsigned long long)ticks);
+	}
+
+	fclose(fp);
+	LOGINFO("Exported %d call paths to %s", (int)CallTree.size(), pFileName);
+	return true;
+}
+
+// UI
+
+template<typename T>
+static void SortProfileItems(std::vector<int>& sortedItems, const std::vector<T>& items, bool bLastFrame, const ImGuiTableSortSpecs* pSortSpecs)
+{
+	sortedItems.resize(items.size());
+	for (int i = 0; i < (int)items.size(); i++)
+		sortedItems[i] = i;
+
+	if (pSortSpecs == nullptr || pSortSpecs->SpecsCount == 0)
+		return;
+
+	const int column = pSortSpecs->Specs[0].ColumnIndex;
+	const bool bAscending = pSortSpecs->Specs[0].SortDirection == ImGuiSortDirection_Ascending;
+	std::sort(sortedItems.begin(), sortedItems.end(), [&](int a, int b)
+	{
+		const FFunctionProfileStats& statsA = bLastFrame ? items[a].LastFrame : items[a].Total;
+		const FFunctionProfileStats& statsB = bLastFrame ? items[b].LastFrame : items[b].Total;
+		uint64_t valA = 0, valB = 0;
+		switch (column)
+		{
+		case 0:
+			valA = items[a].FunctionAddr.Val;
+			valB = items[b].FunctionAddr.Val;
+			break;
+		case 1:
+			valA = statsA.Calls;
+			valB = statsB.Calls;
+			break;
+		case 2:
+			valA = statsA.InclusiveTicks;
+			valB = statsB.InclusiveTicks;
+			break;
+		case 3:
+			valA = statsA.ExclusiveTicks;
+			valB = statsB.ExclusiveTicks;
+			break;
+		default:
+			valA = statsA.InclusiveTicks;
+			valB = statsB.InclusiveTicks;
+			break;
+		}
+		return bAscending ? valA < valB : valA > valB;
+	});
+}
+
+void FFunctionProfiler::DrawUI()
+{
+	bool bEnable = bEnabled;
+	if (ImGui::Checkbox("Enabled", &bEnable))
+		SetEnabled(bEnable);
+	ImGui::SameLine();
+	if (ImGui::Button("Reset"))
+		Reset();
+	ImGui::SameLine();
+	ImGui::Checkbox("Last Frame", &bShowLastFrame);
+	ImGui::SameLine();
+	ImGui::Text("%d frames, last frame %llu ticks", FramesProfiled, (unsigned long long)LastFrameTicks);
+
+	ImGui::InputText("File Name", ExportFileName, IM_ARRAYSIZE(ExportFileName));
+	ImGui::SameLine();
+	if (ImGui::Button("Export Flame Graph"))
+		ExportFoldedStacks(ExportFileName, bShowLastFrame);
+
+	if (ImGui::BeginTabBar("ProfilerTabBar"))
+	{
+		if (ImGui::BeginTabItem("Functions"))
+		{
+			DrawFunctionTable();
+			ImGui::EndTabItem();
+		}
+		if (ImGui::BeginTabItem("Call Sites"))
+		{
+			DrawCallSiteTable();
+			ImGui::EndTabItem();
+		}
+		ImGui::EndTabBar();
+	}
+}
+
+static const ImGuiTableFlags kProfileTableFlags = ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_BordersOuter | ImGuiTableFlags_Sortable;
+
+void FFunctionProfiler::DrawFunctionTable()
+{
+	FCodeAnalysisState& state = *pCodeAnalysis;
+	FCodeAnalysisViewState& viewState = state.GetFocussedViewState();
+	const float frameTicks = LastFrameTicks ? (float)LastFrameTicks : 1.0f;
+
+	if (ImGui::BeginTable("ProfileFunctions", 5, kProfileTableFlags))
+	{
+		ImGui::TableSetupScrollFreeze(0, 1);
+		ImGui::TableSetupColumn("Function");
+		ImGui::TableSetupColumn("Calls");
+		ImGui::TableSetupColumn("Inclusive");
+		ImGui::TableSetupColumn("Exclusive", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending);
+		ImGui::TableSetupColumn("Frame %");
+		ImGui::TableHeadersRow();
+
+		SortProfileItems(SortedFunctions, Functions, bShowLastFrame, ImGui::TableGetSortSpecs());
+
+		ImGuiListClipper clipper;
+		clipper.Begin((int)SortedFunctions.size());
+		while (clipper.Step())
+		{
+			for (int rowNum = clipper.DisplayStart; rowNum < clipper.DisplayEnd; rowNum++)
+			{
+				const FFunctionProfile& function = Functions[SortedFunctions[rowNum]];
+				const FFunctionProfileStats& stats = bShowLastFrame ? function.LastFrame : function.Total;
+				ImGui::TableNextRow();
+				ImGui::PushID(rowNum);
+
+				ImGui::TableSetColumnIndex(0);
+				if (ImGui::Selectable(GetFunctionName(function.FunctionAddr).c_str(), false, ImGuiSelectableFlags_SpanAllColumns) && function.FunctionAddr.IsValid())
+					viewState.GoToAddress(function.FunctionAddr);
+				ImGui::TableSetColumnIndex(1);
+				ImGui::Text("%u", stats.Calls);
+				ImGui::TableSetColumnIndex(2);
+				ImGui::Text("%llu", (unsigned long long)stats.InclusiveTicks);
+				ImGui::TableSetColumnIndex(3);
+				ImGui::Text("%llu", (unsigned long long)stats.ExclusiveTicks);
+				ImGui::TableSetColumnIndex(4);
+				if (bShowLastFrame)
+					ImGui::Text("%.1f", (float)stats.InclusiveTicks * 100.0f / frameTicks);
+				ImGui::PopID();
+			}
+		}
+		ImGui::EndTable();
+	}
+}
+
+void FFunctionProfiler::DrawCallSiteTable()
+{
+	FCodeAnalysisState& state = *pCodeAnalysis;
+	FCodeAnalysisViewState& viewState = state.GetFocussedViewState();
+
+	if (ImGui::BeginTable("ProfileCallSites", 5, kProfileTableFlags))
+	{
+		ImGui::TableSetupScrollFreeze(0, 1);
+		ImGui::TableSetupColumn("Function");
+		ImGui::TableSetupColumn("Calls");
+		ImGui::TableSetupColumn("Inclusive", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending);
+		ImGui::TableSetupColumn("Exclusive");
+		ImGui::TableSetupColumn("Call Site", ImGuiTableColumnFlags_NoSort);
+		ImGui::TableHeadersRow();
+
+		SortProfileItems(SortedCallSites, CallSites, bShowLastFrame, ImGui::TableGetSortSpecs());
+
+		ImGuiListClipper clipper;
+		clipper.Begin((int)SortedCallSites.size());
+		while (clipper.Step())
+		{
+			for (int rowNum = clipper.DisplayStart; rowNum < clipper.DisplayEnd; rowNum++)
+			{
+				const FCallSiteProfile& callSite = CallSites[SortedCallSites[rowNum]];
+				const FFunctionProfileStats& stats = bShowLastFrame ? callSite.LastFrame : callSite.Total;
+				ImGui::TableNextRow();
+				ImGui::PushID(rowNum);
+
+				ImGui::TableSetColumnIndex(0);
+				ImGui::Text("%s", GetFunctionName(callSite.FunctionAddr).c_str());
+				ImGui::TableSetColumnIndex(1);
+				ImGui::Text("%u", stats.Calls);
+				ImGui::TableSetColumnIndex(2);
+				ImGui::Text("%llu", (unsigned long long)stats.InclusiveTicks);
+				ImGui::TableSetColumnIndex(3);
+				ImGui::Text("%llu", (unsigned long long)stats.ExclusiveTicks);
+				ImGui::TableSetColumnIndex(4);
+				if (callSite.bInterrupt)
+					ImGui::Text("Interrupt");
+				else
+					DrawCodeAddress(state, viewState, callSite.CallAddr);
+				ImGui::PopID();
+			}
+		}
+		ImGui::EndTable();
+	}
+}
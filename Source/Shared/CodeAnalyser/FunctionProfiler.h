@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CodeAnalyserTypes.h"
+
+class FCodeAnalysisState;
+struct FCPUFunctionCall;
+
+// Cycle costs - one tick is a T-state on the Z80 and a cycle on the 6502
+struct FFunctionProfileStats
+{
+	uint32_t	Calls = 0;
+	uint64_t	InclusiveTicks = 0;	// recursive calls get counted more than once
+	uint64_t	ExclusiveTicks = 0;
+};
+
+struct FFunctionProfile
+{
+	FAddressRef				FunctionAddr;	// invalid for code that isn't in a function we know about
+	FFunctionProfileStats	Frame;
+	FFunctionProfileStats	LastFrame;
+	FFunctionProfileStats	Total;
+};
+
+struct FCallSiteProfile
+{
+	FAddressRef				CallAddr;
+	FAddressRef				FunctionAddr;	// first function called from here
+	bool					bInterrupt = false;
+	FFunctionProfileStats	Frame;
+	FFunctionProfileStats	LastFrame;
+	FFunctionProfileStats	Total;
+};
+
+// call tree for the flame graph - exclusive ticks for each unique call path
+struct FProfileCallTreeNode
+{
+	FAddressRef			FunctionAddr;
+	int					Parent = -1;
+	std::vector<int>	Children;
+	uint64_t			FrameTicks = 0;
+	uint64_t			LastFrameTicks = 0;
+	uint64_t			TotalTicks = 0;
+};
+
+// Attributes CPU ticks to functions by shadowing the debugger call stack
+class FFunctionProfiler
+{
+public:
+	void	Init(FCodeAnalysisState* pCodeAnalysis);
+	void	Reset();
+
+	bool	IsEnabled() const { return bEnabled; }
+	void	SetEnabled(bool bEnable);
+
+	void	Tick() { TickCount++; }
+	void	OnInstructionExecuted(const std::vector<FCPUFunctionCall>& callStack);
+	void	OnMachineFrameEnd();
+
+	bool	ExportFoldedStacks(const char* pFileName, bool bLastFrame) const;
+
+	void	DrawUI();
+
+	const std::vector<FFunctionProfile>&	GetFunctions() const { return Functions; }
+	const std::vector<FCallSiteProfile>&	GetCallSites() const { return CallSites; }
+private:
+	struct FStackEntry
+	{
+		FAddressRef	FunctionAddr;
+		FAddressRef	CallAddr;
+		uint64_t	EntryTick = 0;
+		uint64_t	ChildTicks = 0;
+		int			FunctionIndex = -1;
+		int			CallSiteIndex = -1;
+		int			NodeIndex = 0;
+	};
+
+	void	PushEntry(const FCPUFunctionCall& call);
+	void	PopEntry();
+	void	AccountEntry(FStackEntry& entry);
+	int		GetFunctionIndex(FAddressRef functionAddr);
+	int		GetCallSiteIndex(const FCPUFunctionCall& call);
+	int		GetChildNode(int parentNode, FAddressRef functionAddr);
+	std::string	GetFunctionName(FAddressRef functionAddr) const;
+
+	void	DrawFunctionTable();
+	void	DrawCallSiteTable();
+
+	FCodeAnalysisState*	pCodeAnalysis = nullptr;
+	bool		bEnabled = false;
+	uint64_t	TickCount = 0;
+	uint64_t	FrameStartTick = 0;
+	uint64_t	LastFrameTicks = 0;
+	int			FramesProfiled = 0;
+
+	std::vector<FStackEntry>	Stack;	// entry 0 is the root
+
+	std::vector<FFunctionProfile>			Functions;
+	std::unordered_map<FAddressRef, int>	FunctionLookup;
+	std::vector<FCallSiteProfile>			CallSites;
+	std::unordered_map<FAddressRef, int>	CallSiteLookup;
+	std::vector<FProfileCallTreeNode>		CallTree;
+
+	// UI
+	bool			bShowLastFrame = true;
+	char			ExportFileName[128] = "Profile.folded";
+	std::vector<int>	SortedFunctions;
+	std::vector<int>	SortedCallSites;
+};
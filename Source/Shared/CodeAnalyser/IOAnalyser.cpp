@@ -7,6 +7,9 @@
 
 #include "CodeAnalyser.h"
 #include "UI/CodeAnalyserUI.h"
+#include "Util/FileUtil.h"
+
+#include <cstring>
 
 #if 0
 #define CHIPS_UI_IMPL
@@ -148,6 +151,7 @@ ui_ay38910_t	g_AYUI;
 FAYAudioDevice::FAYAudioDevice()
 {
 	Name = "AYAudio";
+	WriteLog.resize(kLogSize);
 }
 
 bool FAYAudioDevice::Init(ay38910_t* ay)
@@ -176,27 +180,136 @@ void FAYAudioDevice::OnMachineFrameEnd()
 	FrameNo++;
 }
 
-void	FAYAudioDevice::WriteAYRegister(FAddressRef pc, uint8_t value)
+void	FAYAudioDevice::WriteAYRegister(FAddressRef pc, uint8_t value, uint64_t tState)
 {
 	if (SelectedAYRegister == 255)
 		return;
 
-	AYRegisters[SelectedAYRegister] = value;
-
-	// write to state buffer
-	WriteBufferDisplayIndex = WriteBufferWriteIndex;
+	// store the register state before this write every so often so we can reconstruct it later
+	if ((WriteCount % kKeyframeInterval) == 0)
+	{
+		FAYKeyframe& keyframe = Keyframes[(WriteCount / kKeyframeInterval) % kNoKeyframes];
+		keyframe.WriteIndex = WriteCount;
+		memcpy(keyframe.Registers, AYRegisters, sizeof(AYRegisters));
+	}
 
-	FAYRegisterWrite& ayRegWrite = WriteBuffer[WriteBufferWriteIndex];
-	ayRegWrite.EmuState = *pAYEmulator;
+	FAYRegisterWrite& ayRegWrite = WriteLog[WriteCount & (kLogSize - 1)];
+	ayRegWrite.TState = tState;
 	ayRegWrite.PC = pc;
 	ayRegWrite.FrameNo = FrameNo;
 	ayRegWrite.Register = SelectedAYRegister;
 	ayRegWrite.Value = value;
+	WriteCount++;
+
+	AYRegisters[SelectedAYRegister] = value;
+}
+
+void FAYAudioDevice::ClearLog()
+{
+	WriteCount = 0;
+	SelectedLogIndex = -1;
+}
+
+// Replay writes from the nearest keyframe
+bool FAYAudioDevice::GetRegistersAfterWrite(uint64_t index, uint8_t outRegisters[16]) const
+{
+	if (index < GetFirstLogIndex() || index >= WriteCount)
+		return false;
+
+	const uint64_t keyframeIndex = index - (index % kKeyframeInterval);
+	const FAYKeyframe& keyframe = Keyframes[(index / kKeyframeInterval) % kNoKeyframes];
+	if (keyframe.WriteIndex != keyframeIndex)	// overwritten
+		return false;
+
+	memcpy(outRegisters, keyframe.Registers, sizeof(keyframe.Registers));
+	for (uint64_t i = keyframeIndex; i <= index; i++)
+	{
+		const FAYRegisterWrite& write = GetLogEntry(i);
+		outRegisters[write.Register] = write.Value;
+	}
+	return true;
+}
+
+// Call the callback with the register state at the end of each frame in the log
+void FAYAudioDevice::ForEachLoggedFrame(const std::function<void(const uint8_t* pRegisters, bool bEnvShapeWritten)>& frameCallback) const
+{
+	// start from the first keyframe we have all the writes for
+	const uint64_t firstIndex = GetFirstLogIndex();
+	const uint64_t startIndex = ((firstIndex + kKeyframeInterval - 1) / kKeyframeInterval) * kKeyframeInterval;
+	if (startIndex >= WriteCount)
+		return;
+
+	uint8_t registers[16];
+	memcpy(registers, Keyframes[(startIndex / kKeyframeInterval) % kNoKeyframes].Registers, sizeof(registers));
+	uint32_t curFrame = GetLogEntry(startIndex).FrameNo;
+	bool bEnvShapeWritten = false;
+
+	for (uint64_t i = startIndex; i < WriteCount; i++)
+	{
+		const FAYRegisterWrite& write = GetLogEntry(i);
+
+		// frames with no writes repeat the last state
+		for (; curFrame < write.FrameNo; curFrame++)
+		{
+			frameCallback(registers, bEnvShapeWritten);
+			bEnvShapeWritten = false;
+		}
+
+		registers[write.Register] = write.Value;
+		if (write.Register == AY38910_REG_ENV_SHAPE_CYCLE)
+			bEnvShapeWritten = true;
+	}
+	frameCallback(registers, bEnvShapeWritten);
+}
 
-	WriteBufferWriteIndex++;
+// PSG format - a stream of register/value pairs with 0xFF marking the end of each frame
+bool FAYAudioDevice::ExportPSG(const char* pFileName) const
+{
+	std::vector<uint8_t> psgData = { 'P', 'S', 'G', 0x1A, 0x10, 50 };
+	psgData.resize(16, 0);
+
+	const uint8_t* pPrevRegisters = nullptr;
+	uint8_t prevRegisters[16];
+	ForEachLoggedFrame([&](const uint8_t* pRegisters, bool bEnvShapeWritten)
+	{
+		psgData.push_back(0xFF);	// frame start
+		for (int regNo = 0; regNo < 14; regNo++)
+		{
+			const bool bChanged = pPrevRegisters == nullptr || pPrevRegisters[regNo] != pRegisters[regNo];
+			if (bChanged || (regNo == AY38910_REG_ENV_SHAPE_CYCLE && bEnvShapeWritten))
+			{
+				psgData.push_back((uint8_t)regNo);
+				psgData.push_back(pRegisters[regNo]);
+			}
+		}
+		memcpy(prevRegisters, pRegisters, sizeof(prevRegisters));
+		pPrevRegisters = prevRegisters;
+	});
+
+	return SaveBinaryFile(pFileName, psgData.data(), psgData.size());
+}
+
+// YM3 format - 14 registers per frame, stored a register at a time
+bool FAYAudioDevice::ExportYM(const char* pFileName) const
+{
+	std::vector<uint8_t> frameRegisters;
+	ForEachLoggedFrame([&](const uint8_t* pRegisters, bool bEnvShapeWritten)
+	{
+		for (int regNo = 0; regNo < 14; regNo++)
+			frameRegisters.push_back(pRegisters[regNo]);
+		if (bEnvShapeWritten == false)
+			frameRegisters.back() = 0xFF;	// don't retrigger the envelope
+	});
+
+	const size_t noFrames = frameRegisters.size() / 14;
+	std::vector<uint8_t> ymData = { 'Y', 'M', '3', '!' };
+	for (int regNo = 0; regNo < 14; regNo++)
+	{
+		for (size_t frameNo = 0; frameNo < noFrames; frameNo++)
+			ymData.push_back(frameRegisters[frameNo * 14 + regNo]);
+	}
 
-	if(WriteBufferWriteIndex == kWriteBufferSize)
-		WriteBufferWriteIndex = 0;
+	return SaveBinaryFile(pFileName, ymData.data(), ymData.size());
 }
 
 void FAYAudioDevice::DrawAYStateUI()
@@ -226,6 +339,91 @@ void FAYAudioDevice::DrawAYStateUI()
 	GraphOffset = (GraphOffset + 1) % IM_ARRAYSIZE(ChanAValues);
 }
 
+void FAYAudioDevice::DrawLogUI()
+{
+	FCodeAnalysisState& state = *pCodeAnalyser;
+	FCodeAnalysisViewState& viewState = state.GetFocussedViewState();
+	const uint64_t firstIndex = GetFirstLogIndex();
+	const int noEntries = (int)(WriteCount - firstIndex);
+
+	ImGui::Text("%d writes logged", noEntries);
+	ImGui::SameLine();
+	if (ImGui::Button("Clear"))
+		ClearLog();
+	ImGui::SameLine();
+	ImGui::Checkbox("Follow", &bLogFollow);
+
+	ImGui::InputText("File Name", ExportFileName, IM_ARRAYSIZE(ExportFileName));
+	if (ImGui::Button("Export PSG"))
+		ExportPSG((std::string(ExportFileName) + ".psg").c_str());
+	ImGui::SameLine();
+	if (ImGui::Button("Export YM"))
+		ExportYM((std::string(ExportFileName) + ".ym").c_str());
+
+	const float regViewHeight = ImGui::GetTextLineHeightWithSpacing() * 5;
+	const ImGuiTableFlags tableFlags = ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_BordersOuter;
+	if (ImGui::BeginTable("AYLog", 5, tableFlags, ImVec2(0, ImGui::GetContentRegionAvail().y - regViewHeight)))
+	{
+		ImGui::TableSetupScrollFreeze(0, 1);
+		ImGui::TableSetupColumn("Frame");
+		ImGui::TableSetupColumn("T-State");
+		ImGui::TableSetupColumn("PC");
+		ImGui::TableSetupColumn("Register");
+		ImGui::TableSetupColumn("Value");
+		ImGui::TableHeadersRow();
+
+		ImGuiListClipper clipper;
+		clipper.Begin(noEntries);
+		while (clipper.Step())
+		{
+			for (int rowNum = clipper.DisplayStart; rowNum < clipper.DisplayEnd; rowNum++)
+			{
+				const uint64_t logIndex = firstIndex + rowNum;
+				const FAYRegisterWrite& write = GetLogEntry(logIndex);
+				ImGui::TableNextRow();
+				ImGui::PushID(rowNum);
+
+				ImGui::TableSetColumnIndex(0);
+				if (ImGui::Selectable("##logrow", SelectedLogIndex == (int64_t)logIndex, ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowItemOverlap))
+				{
+					SelectedLogIndex = logIndex;
+					bLogFollow = false;
+				}
+				ImGui::SameLine();
+				ImGui::Text("%d", write.FrameNo);
+				ImGui::TableSetColumnIndex(1);
+				ImGui::Text("%llu", (unsigned long long)write.TState);
+				ImGui::TableSetColumnIndex(2);
+				ImGui::Text("%s", NumStr(write.PC.Address));
+				DrawAddressLabel(state, viewState, write.PC);
+				ImGui::TableSetColumnIndex(3);
+				ImGui::Text("%s", g_AYRegNames[write.Register]);
+				ImGui::TableSetColumnIndex(4);
+				ImGui::Text("%s", NumStr(write.Value));
+
+				ImGui::PopID();
+			}
+		}
+
+		if (bLogFollow)
+			ImGui::SetScrollHereY(1.0f);
+		ImGui::EndTable();
+	}
+
+	// reconstructed register state at the selected write
+	uint8_t registers[16];
+	if (SelectedLogIndex >= 0 && GetRegistersAfterWrite(SelectedLogIndex, registers))
+	{
+		ImGui::Text("Registers after write:");
+		for (int regNo = 0; regNo < 16; regNo++)
+		{
+			if (regNo % 8)
+				ImGui::SameLine();
+			ImGui::Text("R%d:%s", regNo, NumStr(registers[regNo]));
+		}
+	}
+}
+
 // chips
 void DrawAYStateUIChips(const ay38910_t* ay)
 {
@@ -317,7 +515,7 @@ void FAYAudioDevice::DrawDetailsUI()
 	{
 		if (ImGui::BeginTabItem("Log"))
 		{
-			//DrawMemoryDiffUI();
+			DrawLogUI();
 			ImGui::EndTabItem();
 		}
 
@@ -6,6 +6,8 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <string>
+#include <vector>
+#include <functional>
 
 class FCodeAnalysisState;
 
@@ -74,13 +76,21 @@ private:
 // AY-3-8910 Audio Chip - move
 #include <chips/ay38910.h>
 
+// Compact log entry - the AY state at any entry is reconstructed from keyframes
 struct FAYRegisterWrite
 {
-	ay38910_t	EmuState;
+	uint64_t	TState = 0;
 	FAddressRef	PC;
-	int			FrameNo;
-	uint8_t		Register;
-	uint8_t		Value;
+	uint32_t	FrameNo = 0;
+	uint8_t		Register = 0;
+	uint8_t		Value = 0;
+};
+
+// Register state before a write - stored every kKeyframeInterval writes
+struct FAYKeyframe
+{
+	uint64_t	WriteIndex = 0;
+	uint8_t		Registers[16] = { 0 };
 };
 
 class FAYAudioDevice : public FIODevice
@@ -90,26 +100,45 @@ public:
 
 	bool	Init(ay38910_t* pAY);
 	void	SelectAYRegister(FAddressRef pc, uint8_t regNo) { SelectPC = pc; SelectedAYRegister = regNo & 15; }
-	void	WriteAYRegister(FAddressRef pc, uint8_t value);
+	void	WriteAYRegister(FAddressRef pc, uint8_t value, uint64_t tState = 0);
 	
 	void	OnFrameTick() override;
 	void	OnMachineFrameEnd() override;
 	void	DrawDetailsUI() override;
 
 	void	DrawAYStateUI(void);
+	void	DrawLogUI(void);
+
+	// log access - indices are absolute write numbers
+	uint64_t	GetFirstLogIndex() const { return WriteCount > kLogSize ? WriteCount - kLogSize : 0; }
+	uint64_t	GetWriteCount() const { return WriteCount; }
+	const FAYRegisterWrite&	GetLogEntry(uint64_t index) const { return WriteLog[index & (kLogSize - 1)]; }
+	bool		GetRegistersAfterWrite(uint64_t index, uint8_t outRegisters[16]) const;
+	void		ClearLog();
+
+	// music ripping
+	bool	ExportPSG(const char* pFileName) const;
+	bool	ExportYM(const char* pFileName) const;
 
 private:
+	void	ForEachLoggedFrame(const std::function<void(const uint8_t* pRegisters, bool bEnvShapeWritten)>& frameCallback) const;
 
 	FAddressRef	SelectPC;
 	uint8_t		SelectedAYRegister = 255;
-	uint8_t		AYRegisters[16];
-
-	int			FrameNo = 0;
-	// state ring buffer
-	static const int	kWriteBufferSize = 100;
-	FAYRegisterWrite	WriteBuffer[kWriteBufferSize];
-	int					WriteBufferWriteIndex = 0;
-	int					WriteBufferDisplayIndex = 0;
+	uint8_t		AYRegisters[16] = { 0 };
+
+	uint32_t	FrameNo = 0;
+
+	// register write log
+	static const int	kLogSize = 1 << 18;	// must be a power of 2, many minutes of music
+	static const int	kKeyframeInterval = 1024;
+	static const int	kNoKeyframes = kLogSize / kKeyframeInterval;
+	std::vector<FAYRegisterWrite>	WriteLog;
+	FAYKeyframe			Keyframes[kNoKeyframes];
+	uint64_t			WriteCount = 0;
+	int64_t				SelectedLogIndex = -1;
+	bool				bLogFollow = true;
+	char				ExportFileName[128] = "AYMusic";	// without the extension
 
 	static const int kNoValues = 100;
 	float	ChanAValues[kNoValues];
@@ -0,0 +1,112 @@
+#include "LabelNameTable.h"
+
+#include <algorithm>
+#include <cstring>
+
+void FLabelNameTable::Reset()
+{
+	Names.clear();
+	Lookup.clear();
+	StringBlocks.clear();
+	BlockUsed = kBlockSize;
+	bSortKeysDirty = true;
+
+	Intern("");	// id 0 is always the empty name
+}
+
+const char* FLabelNameTable::StoreString(std::string_view name)
+{
+	const size_t size = name.size() + 1;	// null terminated so GetString can return a c string
+	char* pBlock = nullptr;
+
+	if (size > kBlockSize)	// large names get their own block
+	{
+		StringBlocks.emplace(StringBlocks.begin(), new char[size]);
+		pBlock = StringBlocks.front().get();
+	}
+	else
+	{
+		if (BlockUsed + size > kBlockSize)
+		{
+			StringBlocks.emplace_back(new char[kBlockSize]);
+			BlockUsed = 0;
+		}
+		pBlock = StringBlocks.back().get() + BlockUsed;
+		BlockUsed += size;
+	}
+
+	memcpy(pBlock, name.data(), name.size());
+	pBlock[name.size()] = 0;
+	return pBlock;
+}
+
+uint32_t FLabelNameTable::Intern(std::string_view name)
+{
+	auto nameIt = Lookup.find(name);
+	if (nameIt != Lookup.end())
+		return nameIt->second;
+
+	const uint32_t nameId = (uint32_t)Names.size();
+	FName& newName = Names.emplace_back();
+	newName.pString = StoreString(name);
+	newName.Length = (uint32_t)name.size();
+	Lookup[std::string_view(newName.pString, newName.Length)] = nameId;
+	bSortKeysDirty = true;
+	return nameId;
+}
+
+uint32_t FLabelNameTable::AcquireUniqueName(uint32_t nameId)
+{
+	if (Names[nameId].UseCount == 0)
+	{
+		Names[nameId].UseCount++;
+		return nameId;
+	}
+
+	// suffixes are tracked per base name so we don't retry ones we've already handed out
+	std::string uniqueName;
+	uniqueName.reserve(Names[nameId].Length + 8);
+	while (true)
+	{
+		const uint32_t suffix = ++Names[nameId].NextSuffix;
+		uniqueName.assign(Names[nameId].pString, Names[nameId].Length);
+		uniqueName += "_" + std::to_string(suffix);
+
+		const uint32_t uniqueId = Intern(uniqueName);	// can grow Names, hence indexing each time
+		if (Names[uniqueId].UseCount == 0)
+		{
+			Names[uniqueId].UseCount++;
+			return uniqueId;
+		}
+	}
+}
+
+bool FLabelNameTable::ReleaseName(uint32_t nameId)
+{
+	if (nameId == kEmptyNameId || Names[nameId].UseCount == 0)
+		return false;
+
+	Names[nameId].UseCount--;
+	return true;
+}
+
+uint32_t FLabelNameTable::GetSortKey(uint32_t nameId)
+{
+	if (bSortKeysDirty)
+	{
+		std::vector<uint32_t> sortedIds(Names.size());
+		for (uint32_t i = 0; i < (uint32_t)sortedIds.size(); i++)
+			sortedIds[i] = i;
+
+		std::sort(sortedIds.begin(), sortedIds.end(), [this](uint32_t a, uint32_t b)
+		{
+			return strcmp(Names[a].pString, Names[b].pString) < 0;
+		});
+
+		for (uint32_t rank = 0; rank < (uint32_t)sortedIds.size(); rank++)
+			Names[sortedIds[rank]].SortKey = rank;
+		bSortKeysDirty = false;
+	}
+
+	return Names[nameId].SortKey;
+}
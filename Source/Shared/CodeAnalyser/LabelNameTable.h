@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Interned label names
+// Each distinct name is stored once & referred to by a stable id, so labels don't own strings
+// and name comparisons are integer compares
+class FLabelNameTable
+{
+public:
+	static const uint32_t kEmptyNameId = 0;
+
+	FLabelNameTable() { Reset(); }
+
+	void		Reset();
+
+	uint32_t	Intern(std::string_view name);
+	const char*	GetString(uint32_t nameId) const { return Names[nameId].pString; }
+	size_t		GetLength(uint32_t nameId) const { return Names[nameId].Length; }
+
+	// take ownership of a name for a label - suffixes it with _n if it's already in use
+	uint32_t	AcquireUniqueName(uint32_t nameId);
+	// name no longer used by a label
+	bool		ReleaseName(uint32_t nameId);
+	bool		IsNameInUse(uint32_t nameId) const { return Names[nameId].UseCount != 0; }
+
+	// alphabetical rank of a name - sorts are then just integer compares
+	uint32_t	GetSortKey(uint32_t nameId);
+
+	size_t		GetNoNames() const { return Names.size(); }
+private:
+	struct FName
+	{
+		const char*	pString = nullptr;	// points into the string blocks
+		uint32_t	Length = 0;
+		uint32_t	UseCount = 0;	// labels using this name
+		uint32_t	NextSuffix = 0;	// next _n to try when this name is taken
+		uint32_t	SortKey = 0;
+	};
+
+	const char*	StoreString(std::string_view name);
+
+	static const size_t kBlockSize = 64 * 1024;
+
+	std::vector<FName>							Names;
+	std::unordered_map<std::string_view, uint32_t>	Lookup;	// views point into the string blocks
+	std::vector<std::unique_ptr<char[]>>		StringBlocks;
+	size_t										BlockUsed = kBlockSize;
+	bool										bSortKeysDirty = true;
+};
@@ -0,0 +1,93 @@
+#include "RegisterProfiler.h"
+#include "CodeAnalyserTypes.h"
+
+#include <Util/Misc.h>
+
+FRegisterProfiler::FRegisterProfiler()
+{
+	Samples = new FRegisterProfileSample[kMaxSamples];
+}
+
+FRegisterProfiler::~FRegisterProfiler()
+{
+	Reset();
+	delete[] Samples;
+}
+
+void FRegisterProfiler::Init(int noRegisters)
+{
+	Reset();
+	NoRegisters = noRegisters < kMaxProfiledRegisters ? noRegisters : kMaxProfiledRegisters;
+}
+
+void FRegisterProfiler::Reset()
+{
+	NoSamples = 0;
+	for (FRegisterProfile* pProfile : AllocatedProfiles)
+		delete pProfile;
+	AllocatedProfiles.clear();
+}
+
+void FRegisterProfiler::SetEnabled(bool bEnable)
+{
+	if (bEnable == false)
+		Flush();
+	bEnabled = bEnable;
+}
+
+void FRegisterProfiler::Flush()
+{
+	for (int sampleNo = 0; sampleNo < NoSamples; sampleNo++)
+	{
+		const FRegisterProfileSample& sample = Samples[sampleNo];
+		FCodeInfo* pCodeInfo = sample.pCodeInfo;
+		FRegisterProfile* pProfile = pCodeInfo->pRegisterProfile;
+		if (pProfile == nullptr)
+		{
+			pProfile = new FRegisterProfile;
+			AllocatedProfiles.push_back(pProfile);
+			pCodeInfo->pRegisterProfile = pProfile;
+		}
+
+		pProfile->SampleCount++;
+		for (int regNo = 0; regNo < NoRegisters; regNo++)
+			pProfile->Registers[regNo].AddValue(sample.Values[regNo]);
+	}
+
+	NoSamples = 0;
+}
+
+const FRegisterProfile* FRegisterProfiler::GetProfile(const FCodeInfo* pCodeInfo)
+{
+	if (pCodeInfo == nullptr)
+		return nullptr;
+	Flush();
+	return pCodeInfo->pRegisterProfile;
+}
+
+std::string GetRegisterProfileString(const FRegisterValueSummary& summary, const char* pRegName, bool b8Bit)
+{
+	std::string profileStr = pRegName;
+	profileStr += ": ";
+
+	if (summary.HasTooManyValues())
+	{
+		profileStr += b8Bit ? NumStr((uint8_t)summary.Min) : NumStr(summary.Min);
+		profileStr += " - ";
+		profileStr += b8Bit ? NumStr((uint8_t)summary.Max) : NumStr(summary.Max);
+		profileStr += " (last ";
+		profileStr += b8Bit ? NumStr((uint8_t)summary.Last) : NumStr(summary.Last);
+		profileStr += ")";
+	}
+	else
+	{
+		for (int i = 0; i < summary.NoDistinctValues; i++)
+		{
+			if (i != 0)
+				profileStr += ", ";
+			profileStr += b8Bit ? NumStr((uint8_t)summary.DistinctValues[i]) : NumStr(summary.DistinctValues[i]);
+		}
+	}
+
+	return profileStr;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct FCodeInfo;
+
+// Cheap always-on register value profiling
+// The CPU tick just appends a sample, samples are folded into the per-instruction profiles in bulk
+
+static const int kMaxProfiledRegisters = 8;
+
+// Z80 registers in profile order
+namespace EZ80ProfileReg
+{
+	enum : int { A, BC, DE, HL, IX, IY, SP, Count };
+}
+
+// 6502 registers in profile order
+namespace E6502ProfileReg
+{
+	enum : int { A, X, Y, S, Count };
+}
+
+// summary of the values a register had when an instruction was executed
+struct FRegisterValueSummary
+{
+	static const int kMaxDistinctValues = 4;
+
+	void	AddValue(uint16_t value)
+	{
+		if (value < Min)
+			Min = value;
+		if (value > Max)
+			Max = value;
+		Last = value;
+
+		if (NoDistinctValues > kMaxDistinctValues)	// saturated
+			return;
+		for (int i = 0; i < NoDistinctValues; i++)
+		{
+			if (DistinctValues[i] == value)
+				return;
+		}
+		if (NoDistinctValues < kMaxDistinctValues)
+			DistinctValues[NoDistinctValues] = value;
+		NoDistinctValues++;
+	}
+
+	bool	HasTooManyValues() const { return NoDistinctValues > kMaxDistinctValues; }
+
+	uint16_t	Min = 0xffff;
+	uint16_t	Max = 0;
+	uint16_t	Last = 0;
+	uint16_t	DistinctValues[kMaxDistinctValues] = { 0 };
+	uint8_t		NoDistinctValues = 0;
+};
+
+struct FRegisterProfile
+{
+	uint32_t				SampleCount = 0;
+	FRegisterValueSummary	Registers[kMaxProfiledRegisters];
+};
+
+struct FRegisterProfileSample
+{
+	FCodeInfo*	pCodeInfo = nullptr;
+	uint16_t	Values[kMaxProfiledRegisters];
+};
+
+class FRegisterProfiler
+{
+public:
+	FRegisterProfiler();
+	~FRegisterProfiler();
+
+	void	Init(int noRegisters);
+	void	Reset();	// must be called before code infos are freed
+
+	bool	IsEnabled() const { return bEnabled; }
+	void	SetEnabled(bool bEnable);
+
+	// called per instruction - returns the sample slot to fill in
+	uint16_t*	AddSample(FCodeInfo* pCodeInfo)
+	{
+		if (NoSamples == kMaxSamples)
+			Flush();
+		FRegisterProfileSample& sample = Samples[NoSamples++];
+		sample.pCodeInfo = pCodeInfo;
+		return sample.Values;
+	}
+
+	// fold pending samples into the instruction profiles - called at the end of the frame & before reading profiles
+	void	Flush();
+
+	const FRegisterProfile*	GetProfile(const FCodeInfo* pCodeInfo);
+
+	int		GetNoRegisters() const { return NoRegisters; }
+	size_t	GetNoProfiles() const { return AllocatedProfiles.size(); }
+
+private:
+	static const int kMaxSamples = 1 << 14;
+
+	bool	bEnabled = true;
+	int		NoRegisters = 0;
+
+	FRegisterProfileSample*	Samples = nullptr;
+	int						NoSamples = 0;
+
+	std::vector<FRegisterProfile*>	AllocatedProfiles;
+};
+
+// format a profile summary e.g. "HL: 4000h - 57FFh (last 4020h)"
+std::string GetRegisterProfileString(const FRegisterValueSummary& summary, const char* pRegName, bool b8Bit);
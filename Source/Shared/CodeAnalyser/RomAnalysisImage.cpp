@@ -0,0 +1,529 @@
+#include "RomAnalysisImage.h"
+
+#include "CodeAnalyser.h"
+#include "CodeAnalysisPage.h"
+#include "Util/FileUtil.h"
+#include "Util/MemoryBuffer.h"
+#include "Debug/DebugLog.h"
+
+#include <json.hpp>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <unordered_map>
+using json = nlohmann::json;
+
+// CodeAnalysisJson.cpp
+void LoadDataInfoFromJson(FCodeAnalysisState& state, FDataInfo* pDataInfo, const json& dataInfoJson);
+void ReadGlobalsFromJson(FCodeAnalysisState& state, const json& jsonGameData);
+void FixupPostLoad(FCodeAnalysisState& state);
+
+static const uint32_t kRomImageMagic = 0xC0DEB00C;
+static const uint32_t kRomImageVersion = 1;
+
+// Flat records - strings are offsets into the image string pool
+struct FRomBankRecord
+{
+	int16_t		BankId;
+	uint32_t	Description;
+};
+
+struct FRomCommentBlockRecord
+{
+	int16_t		PageId;
+	uint16_t	PageAddr;
+	uint32_t	Comment;
+};
+
+struct FRomLabelRecord
+{
+	int16_t		PageId;
+	uint16_t	PageAddr;
+	uint32_t	Name;
+	uint32_t	Comment;
+	uint8_t		LabelType;
+	bool		bGlobal;
+	bool		bSanitize;	// legacy labels didn't get sanitised
+};
+
+struct FRomCodeRecord
+{
+	int16_t		PageId;
+	uint16_t	PageAddr;
+	uint32_t	Comment;
+	uint32_t	Flags;
+	int32_t		StructId;
+	uint16_t	ByteSize;
+	uint8_t		OperandType;
+	bool		bSelfModifyingCode;
+	bool		bHasFlags;
+};
+
+struct FRomDataRecord
+{
+	int16_t		PageId;
+	uint16_t	PageAddr;
+	uint32_t	Comment;
+	uint32_t	Flags;
+	uint32_t	AddressRef;	// char set, graphics set or instruction address
+	int32_t		PaletteNo;
+	uint16_t	ByteSize;
+	uint8_t		DataType;
+	uint8_t		DisplayType;
+	uint8_t		EmptyCharNo;
+};
+
+struct FRomLastWriterRecord	// legacy
+{
+	uint16_t	Address;
+	uint32_t	Writer;
+};
+
+struct FRomAnalysisImage
+{
+	uint32_t AddString(const std::string& str)
+	{
+		if (str.empty())
+			return 0;
+		const uint32_t offset = (uint32_t)Strings.size();
+		Strings.insert(Strings.end(), str.begin(), str.end());
+		Strings.push_back(0);
+		return offset;
+	}
+
+	const char* GetString(uint32_t offset) const
+	{
+		return offset < Strings.size() ? &Strings[offset] : "";
+	}
+
+	// what the image was built from
+	uint64_t	SourceSize = 0;
+	uint64_t	SourceHash = 0;
+	uint32_t	NoPages = 0;
+
+	std::vector<char>	Strings = { 0 };	// offset 0 is the empty string
+
+	std::vector<FRomBankRecord>			Banks;
+	std::vector<int16_t>				UsedPages;
+	std::vector<int16_t>				CodeBanks;	// banks to bump the code change count on
+	std::vector<FRomLastWriterRecord>	LastWriters;
+	std::vector<FRomCommentBlockRecord>	CommentBlocks;
+	std::vector<FRomLabelRecord>		Labels;
+	std::vector<FRomCodeRecord>			CodeInfos;
+	std::vector<FRomDataRecord>			DataInfos;
+
+	json	Globals;	// palettes, character sets etc. - small so kept as json
+};
+
+// images stay around for the session so switching projects doesn't rebuild them
+static std::unordered_map<std::string, std::unique_ptr<FRomAnalysisImage>> g_RomImages;
+
+static uint64_t HashBytes(const uint8_t* pData, size_t noBytes)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;	// FNV-1a
+	for (size_t i = 0; i < noBytes; i++)
+	{
+		hash ^= pData[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+// Compile
+
+static void AddLabelRecord(FRomAnalysisImage& image, const FCodeAnalysisPage* pPage, uint16_t pageAddr, const json& labelInfoJson, bool bSanitize)
+{
+	FRomLabelRecord& label = image.Labels.emplace_back();
+	label.PageId = pPage->PageId;
+	label.PageAddr = pageAddr;
+	label.Name = image.AddString(labelInfoJson["Name"].get<std::string>());
+	label.Comment = labelInfoJson.contains("Comment") ? image.AddString(labelInfoJson["Comment"].get<std::string>()) : 0;
+	label.LabelType = labelInfoJson.contains("LabelType") ? (uint8_t)(int)labelInfoJson["LabelType"] : (uint8_t)ELabelType::Data;
+	label.bGlobal = labelInfoJson.contains("Global");
+	label.bSanitize = bSanitize;
+}
+
+static void AddCodeRecord(FRomAnalysisImage& image, const FCodeAnalysisPage* pPage, uint16_t pageAddr, const json& codeInfoJson)
+{
+	FRomCodeRecord& code = image.CodeInfos.emplace_back();
+	code.PageId = pPage->PageId;
+	code.PageAddr = pageAddr;
+	code.ByteSize = codeInfoJson["ByteSize"];
+	code.bSelfModifyingCode = codeInfoJson.contains("SMC") && (bool)codeInfoJson["SMC"];
+	EOperandType operandType = codeInfoJson.contains("OperandType") ? (EOperandType)(int)codeInfoJson["OperandType"] : EOperandType::Unknown;
+	if (operandType == EOperandType::Struct)	// same hack patch as CreateCodeInfoFromJson
+		operandType = EOperandType::Unknown;
+	code.OperandType = (uint8_t)operandType;
+	code.StructId = codeInfoJson.contains("StructId") ? (int32_t)codeInfoJson["StructId"] : -1;
+	code.bHasFlags = codeInfoJson.contains("Flags");
+	code.Flags = code.bHasFlags ? (uint32_t)codeInfoJson["Flags"] : 0;
+	code.Comment = codeInfoJson.contains("Comment") ? image.AddString(codeInfoJson["Comment"].get<std::string>()) : 0;
+}
+
+static uint32_t GetDataKey(const FCodeAnalysisPage* pPage, uint16_t pageAddr)
+{
+	return ((uint32_t)pPage->PageId << 16) | pageAddr;
+}
+
+// Parse the Json into the image, following what ImportAnalysisJson does
+// Legacy physical addresses are resolved with the current memory map which is what the import would use
+static void CompileRomImage(FCodeAnalysisState& state, const json& jsonDoc, FRomAnalysisImage& image)
+{
+	// data infos get built up as json entries can add to the same item
+	std::map<uint32_t, FDataInfo>	dataInfos;
+
+	if (jsonDoc.contains("Banks"))
+	{
+		for (const auto& bankJson : jsonDoc["Banks"])
+		{
+			if (bankJson.contains("Description"))
+				image.Banks.push_back({ (int16_t)bankJson["Id"], image.AddString(bankJson["Description"].get<std::string>()) });
+		}
+	}
+
+	if (jsonDoc.contains("Pages"))
+	{
+		for (const auto& pageJson : jsonDoc["Pages"])
+		{
+			const int pageId = pageJson["PageId"];
+			if (state.IsValidPageId(pageId) == false)
+				continue;
+			const FCodeAnalysisPage* pPage = state.GetPage(pageId);
+			image.UsedPages.push_back(pPage->PageId);
+
+			if (pageJson.contains("CommentBlocks"))
+			{
+				for (const auto& commentBlockJson : pageJson["CommentBlocks"])
+					image.CommentBlocks.push_back({ pPage->PageId, (uint16_t)commentBlockJson["Address"], image.AddString(commentBlockJson["Comment"].get<std::string>()) });
+			}
+
+			if (pageJson.contains("LabelInfo"))
+			{
+				for (const auto& labelInfoJson : pageJson["LabelInfo"])
+					AddLabelRecord(image, pPage, labelInfoJson["Address"], labelInfoJson, true);
+			}
+
+			if (pageJson.contains("CodeInfo"))
+			{
+				for (const auto& codeInfoJson : pageJson["CodeInfo"])
+					AddCodeRecord(image, pPage, codeInfoJson["Address"], codeInfoJson);
+			}
+
+			if (pageJson.contains("DataInfo"))
+			{
+				for (const auto& dataInfoJson : pageJson["DataInfo"])
+					LoadDataInfoFromJson(state, &dataInfos[GetDataKey(pPage, dataInfoJson["Address"])], dataInfoJson);
+			}
+		}
+	}
+
+	// legacy format using physical addresses
+	if (jsonDoc.contains("LastWriterStart"))
+	{
+		const int lwStart = jsonDoc["LastWriterStart"];
+		const json& lastWriterArray = jsonDoc["LastWriter"];
+		for (int i = 0; i < (int)lastWriterArray.size(); i++)
+			image.LastWriters.push_back({ (uint16_t)(lwStart + i), state.AddressRefFromPhysicalAddress(lastWriterArray[i]).Val });
+	}
+
+	if (jsonDoc.contains("CommentBlocks"))
+	{
+		for (const auto& commentBlockJson : jsonDoc["CommentBlocks"])
+		{
+			const uint16_t addr = commentBlockJson["Address"];
+			image.CommentBlocks.push_back({ state.GetReadPage(addr)->PageId, (uint16_t)(addr & FCodeAnalysisPage::kPageMask), image.AddString(commentBlockJson["Comment"].get<std::string>()) });
+		}
+	}
+
+	if (jsonDoc.contains("CodeInfo"))
+	{
+		for (const auto& codeInfoJson : jsonDoc["CodeInfo"])
+		{
+			if (codeInfoJson.contains("Address") == false)
+				continue;
+			const uint16_t addr = codeInfoJson["Address"];
+			AddCodeRecord(image, state.GetReadPage(addr), addr & FCodeAnalysisPage::kPageMask, codeInfoJson);
+
+			// operand data items
+			for (int codeByte = 1; codeByte < image.CodeInfos.back().ByteSize; codeByte++)
+			{
+				const uint16_t operandAddr = addr + codeByte;
+				FDataInfo& dataInfo = dataInfos[GetDataKey(state.GetReadPage(operandAddr), operandAddr & FCodeAnalysisPage::kPageMask)];
+				dataInfo.DataType = EDataType::InstructionOperand;
+				dataInfo.ByteSize = 1;
+				dataInfo.InstructionAddress = state.AddressRefFromPhysicalAddress(addr);
+			}
+		}
+	}
+
+	if (jsonDoc.contains("LabelInfo"))
+	{
+		for (const auto& labelInfoJson : jsonDoc["LabelInfo"])
+		{
+			const uint16_t addr = labelInfoJson["Address"];
+			AddLabelRecord(image, state.GetReadPage(addr), addr & FCodeAnalysisPage::kPageMask, labelInfoJson, false);
+		}
+	}
+
+	if (jsonDoc.contains("DataInfo"))
+	{
+		for (const auto& dataInfoJson : jsonDoc["DataInfo"])
+		{
+			const uint16_t addr = dataInfoJson["Address"];
+			LoadDataInfoFromJson(state, &dataInfos[GetDataKey(state.GetReadPage(addr), addr & FCodeAnalysisPage::kPageMask)], dataInfoJson);
+		}
+	}
+
+	for (const auto& dataIt : dataInfos)
+	{
+		const FDataInfo& dataInfo = dataIt.second;
+		FRomDataRecord& data = image.DataInfos.emplace_back();
+		data.PageId = (int16_t)(dataIt.first >> 16);
+		data.PageAddr = (uint16_t)(dataIt.first & 0xffff);
+		data.Comment = image.AddString(dataInfo.Comment);
+		data.Flags = dataInfo.Flags;
+		data.AddressRef = dataInfo.InstructionAddress.Val;
+		data.PaletteNo = dataInfo.PaletteNo;
+		data.ByteSize = dataInfo.ByteSize;
+		data.DataType = (uint8_t)dataInfo.DataType;
+		data.DisplayType = (uint8_t)dataInfo.DisplayType;
+		data.EmptyCharNo = dataInfo.EmptyCharNo;
+	}
+
+	// banks which will get code
+	for (const FCodeAnalysisBank& bank : state.GetBanks())
+	{
+		for (int pageNo = 0; pageNo < bank.NoPages; pageNo++)
+		{
+			const int16_t pageId = bank.Pages[pageNo].PageId;
+			if (std::find_if(image.CodeInfos.begin(), image.CodeInfos.end(), [pageId](const FRomCodeRecord& code) { return code.PageId == pageId; }) != image.CodeInfos.end())
+			{
+				image.CodeBanks.push_back(bank.Id);
+				break;
+			}
+		}
+	}
+
+	// everything that isn't per address
+	image.Globals = jsonDoc;
+	for (const char* pKey : { "Banks", "Pages", "LastWriterStart", "LastWriter", "CommentBlocks", "CodeInfo", "LabelInfo", "DataInfo" })
+		image.Globals.erase(pKey);
+}
+
+// Binary cache
+
+template <class T>
+static void WriteArray(FMemoryBuffer& buffer, const std::vector<T>& items)
+{
+	buffer.Write<uint32_t>((uint32_t)items.size());
+	if (items.empty() == false)
+		buffer.WriteBytes(items.data(), items.size() * sizeof(T));
+}
+
+template <class T>
+static bool ReadArray(FMemoryBuffer& buffer, std::vector<T>& items)
+{
+	uint32_t noItems = 0;
+	if (buffer.Read(noItems) == false || noItems * sizeof(T) > buffer.BytesRemaining())
+		return false;
+	items.resize(noItems);
+	return noItems == 0 || buffer.ReadBytes(items.data(), noItems * sizeof(T));
+}
+
+static bool SaveRomImage(const FRomAnalysisImage& image, const char* pFileName)
+{
+	FMemoryBuffer buffer;
+	buffer.Init(1024 * 1024);
+
+	buffer.Write(kRomImageMagic);
+	buffer.Write(kRomImageVersion);
+	buffer.Write(image.SourceSize);
+	buffer.Write(image.SourceHash);
+	buffer.Write(image.NoPages);
+
+	WriteArray(buffer, image.Strings);
+	WriteArray(buffer, image.Banks);
+	WriteArray(buffer, image.UsedPages);
+	WriteArray(buffer, image.CodeBanks);
+	WriteArray(buffer, image.LastWriters);
+	WriteArray(buffer, image.CommentBlocks);
+	WriteArray(buffer, image.Labels);
+	WriteArray(buffer, image.CodeInfos);
+	WriteArray(buffer, image.DataInfos);
+
+	const std::string globalsText = image.Globals.dump();
+	std::vector<char> globals(globalsText.begin(), globalsText.end());
+	WriteArray(buffer, globals);
+
+	return buffer.SaveToFile(pFileName);
+}
+
+static bool LoadRomImage(FRomAnalysisImage& image, const char* pFileName)
+{
+	FMemoryBuffer buffer;
+	if (buffer.LoadFromFile(pFileName) == false)
+		return false;
+
+	uint32_t magic = 0, version = 0;
+	if (buffer.Read(magic) == false || magic != kRomImageMagic)
+		return false;
+	if (buffer.Read(version) == false || version != kRomImageVersion)
+		return false;
+
+	buffer.Read(image.SourceSize);
+	buffer.Read(image.SourceHash);
+	buffer.Read(image.NoPages);
+
+	std::vector<char> globals;
+	if (ReadArray(buffer, image.Strings) == false || image.Strings.empty() || image.Strings.back() != 0 ||
+		ReadArray(buffer, image.Banks) == false ||
+		ReadArray(buffer, image.UsedPages) == false ||
+		ReadArray(buffer, image.CodeBanks) == false ||
+		ReadArray(buffer, image.LastWriters) == false ||
+		ReadArray(buffer, image.CommentBlocks) == false ||
+		ReadArray(buffer, image.Labels) == false ||
+		ReadArray(buffer, image.CodeInfos) == false ||
+		ReadArray(buffer, image.DataInfos) == false ||
+		ReadArray(buffer, globals) == false)
+		return false;
+
+	image.Globals = json::parse(globals.begin(), globals.end(), nullptr, false);
+	return image.Globals.is_discarded() == false;
+}
+
+static std::string GetRomImageCacheFileName(const FCodeAnalysisState& state, const char* pJsonFileName)
+{
+	if (state.pGlobalConfig == nullptr || state.pGlobalConfig->WorkspaceRoot.empty())
+		return std::string();
+
+	const std::string cacheDir = state.pGlobalConfig->WorkspaceRoot + "RomCache/";
+	EnsureDirectoryExists(cacheDir.c_str());
+	return cacheDir + GetFileFromPath(pJsonFileName) + ".bin";
+}
+
+// Apply
+
+static void ApplyRomImage(FCodeAnalysisState& state, const FRomAnalysisImage& image)
+{
+	for (const FRomBankRecord& bankRecord : image.Banks)
+	{
+		FCodeAnalysisBank* pBank = state.GetBank(bankRecord.BankId);
+		if (pBank != nullptr)
+			pBank->Description = image.GetString(bankRecord.Description);
+	}
+
+	for (int16_t pageId : image.UsedPages)
+		state.GetPage(pageId)->bUsed = true;
+
+	for (const FRomLastWriterRecord& lastWriter : image.LastWriters)
+	{
+		FAddressRef writer;
+		writer.Val = lastWriter.Writer;
+		state.SetLastWriterForAddress(lastWriter.Address, writer);
+	}
+
+	for (const FRomCommentBlockRecord& commentBlock : image.CommentBlocks)
+	{
+		FCommentBlock* pCommentBlock = FCommentBlock::Allocate();
+		pCommentBlock->Comment = image.GetString(commentBlock.Comment);
+		state.GetPage(commentBlock.PageId)->CommentBlocks[commentBlock.PageAddr] = pCommentBlock;
+	}
+
+	for (const FRomLabelRecord& label : image.Labels)
+	{
+		FLabelInfo* pLabelInfo = FLabelInfo::Allocate();
+		pLabelInfo->InitialiseName(image.GetString(label.Name));	// already in the name table after the first import
+		pLabelInfo->Global = label.bGlobal;
+		pLabelInfo->LabelType = (ELabelType)label.LabelType;
+		pLabelInfo->Comment = image.GetString(label.Comment);
+		pLabelInfo->EnsureUniqueName();
+		if (label.bSanitize)
+			pLabelInfo->SanitizeName();
+		state.GetPage(label.PageId)->Labels[label.PageAddr] = pLabelInfo;
+	}
+
+	for (const FRomCodeRecord& code : image.CodeInfos)
+	{
+		FCodeInfo* pCodeInfo = FCodeInfo::Allocate();
+		pCodeInfo->ByteSize = code.ByteSize;
+		pCodeInfo->bSelfModifyingCode = code.bSelfModifyingCode;
+		pCodeInfo->OperandType = (EOperandType)code.OperandType;
+		pCodeInfo->StructId = code.StructId;
+		if (code.bHasFlags)
+			pCodeInfo->Flags = code.Flags;
+		pCodeInfo->Comment = image.GetString(code.Comment);
+		state.GetPage(code.PageId)->CodeInfo[code.PageAddr] = pCodeInfo;
+	}
+
+	for (int16_t bankId : image.CodeBanks)
+	{
+		FCodeAnalysisBank* pBank = state.GetBank(bankId);
+		if (pBank != nullptr)
+			pBank->CodeChangeCount++;
+	}
+
+	for (const FRomDataRecord& data : image.DataInfos)
+	{
+		FDataInfo& dataInfo = state.GetPage(data.PageId)->DataInfo[data.PageAddr];
+		dataInfo.DataType = (EDataType)data.DataType;
+		dataInfo.DisplayType = (EDataItemDisplayType)data.DisplayType;
+		dataInfo.ByteSize = data.ByteSize;
+		dataInfo.Flags = data.Flags;
+		dataInfo.InstructionAddress.Val = data.AddressRef;
+		dataInfo.EmptyCharNo = data.EmptyCharNo;
+		dataInfo.PaletteNo = data.PaletteNo;
+		dataInfo.Comment = image.GetString(data.Comment);
+	}
+
+	ReadGlobalsFromJson(state, image.Globals);
+
+	FixupPostLoad(state);
+}
+
+bool ImportRomAnalysis(FCodeAnalysisState& state, const char* pJsonFileName)
+{
+	// page ids depend on the machine config
+	auto imageIt = g_RomImages.find(pJsonFileName);
+	if (imageIt != g_RomImages.end() && imageIt->second->NoPages == (uint32_t)state.GetNoPages())
+	{
+		ApplyRomImage(state, *imageIt->second);
+		return true;
+	}
+
+	size_t jsonSize = 0;
+	uint8_t* pJsonData = (uint8_t*)LoadBinaryFile(pJsonFileName, jsonSize);
+	if (pJsonData == nullptr)
+		return false;
+
+	std::unique_ptr<FRomAnalysisImage> pImage = std::make_unique<FRomAnalysisImage>();
+	const uint64_t jsonHash = HashBytes(pJsonData, jsonSize);
+	const std::string cacheFileName = GetRomImageCacheFileName(state, pJsonFileName);
+
+	bool bCacheValid = cacheFileName.empty() == false && LoadRomImage(*pImage, cacheFileName.c_str());
+	bCacheValid = bCacheValid && pImage->SourceSize == jsonSize && pImage->SourceHash == jsonHash && pImage->NoPages == (uint32_t)state.GetNoPages();
+	if (bCacheValid == false)
+	{
+		const json jsonDoc = json::parse(pJsonData, pJsonData + jsonSize, nullptr, false);
+		if (jsonDoc.is_discarded())
+		{
+			LOGWARNING("Could not parse ROM analysis '%s'", pJsonFileName);
+			free(pJsonData);
+			return false;
+		}
+
+		pImage = std::make_unique<FRomAnalysisImage>();
+		pImage->SourceSize = jsonSize;
+		pImage->SourceHash = jsonHash;
+		pImage->NoPages = (uint32_t)state.GetNoPages();
+		CompileRomImage(state, jsonDoc, *pImage);
+
+		if (cacheFileName.empty() == false && SaveRomImage(*pImage, cacheFileName.c_str()) == false)
+			LOGWARNING("Could not save ROM analysis cache '%s'", cacheFileName.c_str());
+	}
+	free(pJsonData);
+
+	FRomAnalysisImage& image = *pImage;
+	g_RomImages[pJsonFileName] = std::move(pImage);
+	ApplyRomImage(state, image);
+	return true;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+class FCodeAnalysisState;
+
+// Import the analysis for the machine ROMs
+// The ROM Json is only parsed once - it gets compiled to a flat image which is kept for later project loads
+// and cached in the workspace so later runs don't need to parse it either
+bool ImportRomAnalysis(FCodeAnalysisState& state, const char* pJsonFileName);
@@ -0,0 +1,251 @@
+#include "ScanlineTimeline.h"
+
+#include "CodeAnalyser.h"
+#include "UI/CodeAnalyserUI.h"
+#include <Util/Misc.h>
+
+#include <imgui.h>
+#include <algorithm>
+
+void FScanlineTimeline::Init(FCodeAnalysisState* pCA)
+{
+	pCodeAnalysis = pCA;
+	Reset();
+}
+
+void FScanlineTimeline::Reset()
+{
+	Frames[0].Reset();
+	Frames[1].Reset();
+	Frames[0].Ranges.reserve(kMaxRangesPerFrame);
+	Frames[1].Ranges.reserve(kMaxRangesPerFrame);
+	ScanlineStartTick = TickCount;
+	RangeStartTick = TickCount;
+	SelectedScanline = -1;
+}
+
+void FScanlineTimeline::SetEnabled(bool bEnable)
+{
+	if (bEnable && bEnabled == false)
+		Reset();
+	bEnabled = bEnable;
+}
+
+void FScanlineTimeline::OnInstructionExecuted(FAddressRef pc, FAddressRef functionAddr)
+{
+	FTimelineFrame& frame = Frames[CurrentFrameIndex];
+	FScanlineTiming& scanline = frame.Scanlines[CurrentScanline];
+
+	if (scanline.NoRanges != 0)
+	{
+		FScanlineCodeRange& range = frame.Ranges.back();
+		if (pc.BankId == range.Start.BankId && pc.Address >= range.Start.Address && pc.Address <= range.End + kMaxRangeGap)
+		{
+			range.End = std::max(range.End, pc.Address);
+			range.NoInstructions++;
+			return;
+		}
+
+		range.Ticks = (uint32_t)(TickCount - RangeStartTick);
+	}
+
+	if (frame.Ranges.size() == kMaxRangesPerFrame)	// keep adding time to the last range
+		return;
+
+	if (scanline.NoRanges == 0)
+		scanline.FirstRange = (int)frame.Ranges.size();
+
+	FScanlineCodeRange& newRange = frame.Ranges.emplace_back();
+	newRange.Start = pc;
+	newRange.End = pc.Address;
+	newRange.NoInstructions = 1;
+	newRange.FunctionAddr = functionAddr;
+	scanline.NoRanges++;
+	RangeStartTick = TickCount;
+}
+
+void FScanlineTimeline::EndScanline()
+{
+	FTimelineFrame& frame = Frames[CurrentFrameIndex];
+	FScanlineTiming& scanline = frame.Scanlines[CurrentScanline];
+
+	if (scanline.NoRanges != 0)
+		frame.Ranges[scanline.FirstRange + scanline.NoRanges - 1].Ticks = (uint32_t)(TickCount - RangeStartTick);
+	scanline.Ticks = (uint32_t)(TickCount - ScanlineStartTick);
+	frame.MaxScanlineTicks = std::max(frame.MaxScanlineTicks, scanline.Ticks);
+}
+
+void FScanlineTimeline::OnScanlineStart(int scanlineNo)
+{
+	EndScanline();
+
+	CurrentScanline = std::min(std::max(scanlineNo, 0), FTimelineFrame::kMaxScanlines - 1);
+	Frames[CurrentFrameIndex].Scanlines[CurrentScanline] = FScanlineTiming();
+	ScanlineStartTick = TickCount;
+	RangeStartTick = TickCount;
+}
+
+// frames start on scanline 0 - finish the old frame's last scanline & start the new frame on scanline 0
+void FScanlineTimeline::OnMachineFrameStart()
+{
+	EndScanline();
+
+	std::swap(CurrentFrameIndex, LastFrameIndex);
+	Frames[CurrentFrameIndex].Reset();
+	CurrentScanline = 0;
+	ScanlineStartTick = TickCount;
+	RangeStartTick = TickCount;
+}
+
+uint32_t FScanlineTimeline::GetFunctionColour(FAddressRef functionAddr) const
+{
+	if (functionAddr.IsValid() == false)
+		return 0xff808080;
+
+	const uint32_t hash = functionAddr.Val * 2654435761u;	// Knuth's multiplicative hash to spread nearby addresses
+	return ImColor::HSV((float)(hash >> 24) / 255.0f, 0.6f, 0.9f);
+}
+
+// UI
+
+void FScanlineTimeline::DrawBeamChart(const ImVec2& pos, float width, float scale, int firstScanline, int noScanlines)
+{
+	if (bEnabled == false || bShowBeamChart == false)
+		return;
+
+	const FTimelineFrame& frame = GetLastFrame();
+	if (frame.MaxScanlineTicks == 0)
+		return;
+
+	ImDrawList* dl = ImGui::GetWindowDrawList();
+	const float tickWidth = width / (float)frame.MaxScanlineTicks;
+
+	dl->AddRectFilled(pos, ImVec2(pos.x + width, pos.y + noScanlines * scale), 0x80000000);
+
+	for (int lineNo = 0; lineNo < noScanlines; lineNo++)
+	{
+		const int scanlineNo = firstScanline + lineNo;
+		if (scanlineNo < 0 || scanlineNo >= FTimelineFrame::kMaxScanlines)
+			continue;
+
+		const FScanlineTiming& scanline = frame.Scanlines[scanlineNo];
+		const float y = pos.y + lineNo * scale;
+		float x = pos.x;
+		for (int i = 0; i < scanline.NoRanges; i++)
+		{
+			const FScanlineCodeRange& range = frame.Ranges[scanline.FirstRange + i];
+			const float rangeWidth = range.Ticks * tickWidth;
+			dl->AddRectFilled(ImVec2(x, y), ImVec2(x + rangeWidth, y + scale), GetFunctionColour(range.FunctionAddr));
+			x += rangeWidth;
+		}
+	}
+
+	// hovering shows what ran on the scanline, clicking goes to the code
+	const ImVec2 chartMax(pos.x + width, pos.y + noScanlines * scale);
+	if (ImGui::IsMouseHoveringRect(pos, chartMax))
+	{
+		const ImVec2 mousePos = ImGui::GetMousePos();
+		const int scanlineNo = firstScanline + (int)((mousePos.y - pos.y) / scale);
+		if (scanlineNo >= 0 && scanlineNo < FTimelineFrame::kMaxScanlines)
+		{
+			dl->AddRect(ImVec2(pos.x, pos.y + (scanlineNo - firstScanline) * scale), ImVec2(chartMax.x, pos.y + (scanlineNo - firstScanline + 1) * scale), 0xffffffff);
+			DrawScanlineTooltip(scanlineNo);
+
+			if (ImGui::IsMouseClicked(ImGuiMouseButton_Left))
+			{
+				// find the range under the mouse
+				const FScanlineTiming& scanline = frame.Scanlines[scanlineNo];
+				float x = pos.x;
+				for (int i = 0; i < scanline.NoRanges; i++)
+				{
+					const FScanlineCodeRange& range = frame.Ranges[scanline.FirstRange + i];
+					x += range.Ticks * tickWidth;
+					if (mousePos.x < x || i == scanline.NoRanges - 1)
+					{
+						pCodeAnalysis->GetFocussedViewState().GoToAddress(range.Start);
+						break;
+					}
+				}
+				SelectedScanline = scanlineNo;
+			}
+		}
+	}
+}
+
+void FScanlineTimeline::DrawScanlineTooltip(int scanlineNo)
+{
+	FCodeAnalysisState& state = *pCodeAnalysis;
+	const FTimelineFrame& frame = GetLastFrame();
+	const FScanlineTiming& scanline = frame.Scanlines[scanlineNo];
+	static const int kMaxTooltipRanges = 16;
+
+	ImGui::BeginTooltip();
+	ImGui::Text("Scanline %d: %u ticks", scanlineNo, scanline.Ticks);
+	for (int i = 0; i < scanline.NoRanges && i < kMaxTooltipRanges; i++)
+	{
+		const FScanlineCodeRange& range = frame.Ranges[scanline.FirstRange + i];
+		const FLabelInfo* pLabel = range.FunctionAddr.IsValid() ? state.GetLabelForAddress(range.FunctionAddr) : nullptr;
+		ImGui::TextColored(ImColor(GetFunctionColour(range.FunctionAddr)), "%s-%s %s: %u ticks, %d instructions",
+			NumStr(range.Start.Address), NumStr(range.End), pLabel ? pLabel->GetName() : "", range.Ticks, range.NoInstructions);
+	}
+	if (scanline.NoRanges > kMaxTooltipRanges)
+		ImGui::Text("+ %d more", scanline.NoRanges - kMaxTooltipRanges);
+	ImGui::EndTooltip();
+}
+
+void FScanlineTimeline::DrawUI()
+{
+	FCodeAnalysisState& state = *pCodeAnalysis;
+	FCodeAnalysisViewState& viewState = state.GetFocussedViewState();
+
+	bool bEnable = bEnabled;
+	if (ImGui::Checkbox("Enabled", &bEnable))
+		SetEnabled(bEnable);
+	ImGui::SameLine();
+	ImGui::Checkbox("Show Beam Chart", &bShowBeamChart);
+
+	const FTimelineFrame& frame = GetLastFrame();
+	ImGui::Text("%d code ranges, longest scanline %u ticks", (int)frame.Ranges.size(), frame.MaxScanlineTicks);
+
+	const ImGuiTableFlags tableFlags = ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_BordersOuter;
+	if (ImGui::BeginTable("ScanlineTimeline", 3, tableFlags))
+	{
+		ImGui::TableSetupScrollFreeze(0, 1);
+		ImGui::TableSetupColumn("Scanline");
+		ImGui::TableSetupColumn("Ticks");
+		ImGui::TableSetupColumn("Code");
+		ImGui::TableHeadersRow();
+
+		ImGuiListClipper clipper;
+		clipper.Begin(FTimelineFrame::kMaxScanlines);
+		while (clipper.Step())
+		{
+			for (int scanlineNo = clipper.DisplayStart; scanlineNo < clipper.DisplayEnd; scanlineNo++)
+			{
+				const FScanlineTiming& scanline = frame.Scanlines[scanlineNo];
+				ImGui::TableNextRow();
+				ImGui::PushID(scanlineNo);
+
+				ImGui::TableSetColumnIndex(0);
+				if (ImGui::Selectable("##scanline", SelectedScanline == scanlineNo, ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowItemOverlap))
+					SelectedScanline = scanlineNo;
+				ImGui::SameLine();
+				ImGui::Text("%d", scanlineNo);
+				ImGui::TableSetColumnIndex(1);
+				ImGui::Text("%u", scanline.Ticks);
+				ImGui::TableSetColumnIndex(2);
+				for (int i = 0; i < scanline.NoRanges; i++)
+				{
+					const FScanlineCodeRange& range = frame.Ranges[scanline.FirstRange + i];
+					if (i != 0)
+						ImGui::SameLine();
+					ImGui::PushID(i);
+					DrawCodeAddress(state, viewState, range.Start);
+					ImGui::PopID();
+				}
+				ImGui::PopID();
+			}
+		}
+		ImGui::EndTable();
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "CodeAnalyserTypes.h"
+
+class FCodeAnalysisState;
+struct ImVec2;
+
+// a run of instructions executed on a scanline - loops within the range don't split it
+struct FScanlineCodeRange
+{
+	FAddressRef	Start;
+	uint16_t	End = 0;	// address of the last instruction
+	uint16_t	NoInstructions = 0;
+	FAddressRef	FunctionAddr;	// function on top of the call stack
+	uint32_t	Ticks = 0;
+};
+
+struct FScanlineTiming
+{
+	int			FirstRange = 0;
+	int			NoRanges = 0;
+	uint32_t	Ticks = 0;
+};
+
+struct FTimelineFrame
+{
+	static const int kMaxScanlines = 320;
+
+	void	Reset()
+	{
+		Ranges.clear();
+		for (FScanlineTiming& scanline : Scanlines)
+			scanline = FScanlineTiming();
+		MaxScanlineTicks = 0;
+	}
+
+	FScanlineTiming					Scanlines[kMaxScanlines];
+	std::vector<FScanlineCodeRange>	Ranges;
+	uint32_t						MaxScanlineTicks = 0;
+};
+
+// Records what code ran on each scanline of a frame - for tuning raster effects
+class FScanlineTimeline
+{
+public:
+	void	Init(FCodeAnalysisState* pCodeAnalysis);
+	void	Reset();
+
+	bool	IsEnabled() const { return bEnabled; }
+	void	SetEnabled(bool bEnable);
+
+	void	Tick() { TickCount++; }
+	void	OnInstructionExecuted(FAddressRef pc, FAddressRef functionAddr);
+	void	OnScanlineStart(int scanlineNo);
+	void	OnMachineFrameStart();
+
+	const FTimelineFrame&	GetLastFrame() const { return Frames[LastFrameIndex]; }
+
+	// draw a bar per scanline of the last frame, showing the code that executed - for drawing beside the screen
+	void	DrawBeamChart(const ImVec2& pos, float width, float scale, int firstScanline, int noScanlines);
+	void	DrawUI();
+
+	bool	bShowBeamChart = true;
+private:
+	void	EndScanline();
+	void	DrawScanlineTooltip(int scanlineNo);
+	uint32_t	GetFunctionColour(FAddressRef functionAddr) const;
+
+	FCodeAnalysisState*	pCodeAnalysis = nullptr;
+	bool		bEnabled = false;
+	uint64_t	TickCount = 0;
+
+	static const int kMaxRangesPerFrame = 1 << 16;
+	static const int kMaxRangeGap = 4;	// instructions this far past the range end extend it
+
+	FTimelineFrame	Frames[2];
+	int				CurrentFrameIndex = 0;
+	int				LastFrameIndex = 1;
+	int				CurrentScanline = 0;
+	uint64_t		ScanlineStartTick = 0;
+	uint64_t		RangeStartTick = 0;
+
+	int				SelectedScanline = -1;
+};
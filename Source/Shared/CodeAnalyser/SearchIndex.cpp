@@ -0,0 +1,276 @@
+#include "SearchIndex.h"
+
+#include "CodeAnalyser.h"
+#include "Disassembler.h"
+#include "UI/CodeAnalyserUI.h"
+
+#include <algorithm>
+
+static inline char ToLowerAscii(char c)
+{
+	return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+static inline uint32_t GetTrigram(const char* pText)
+{
+	return ((uint8_t)pText[0] << 16) | ((uint8_t)pText[1] << 8) | (uint8_t)pText[2];
+}
+
+static void AppendLower(std::string& outText, const std::string& text)
+{
+	if (text.empty())
+		return;
+	if (outText.empty() == false)
+		outText += '\n';	// so matches can't span fields
+	for (char c : text)
+		outText += ToLowerAscii(c);
+}
+
+void FSearchIndex::Reset()
+{
+	bBuilt = false;
+	bNeedsRebuild = false;
+	DirtyAddresses.clear();
+	Documents.clear();
+	DocumentLookup.clear();
+	Postings.clear();
+	NoPostings = 0;
+	NoStalePostings = 0;
+	DocumentSearchStamp.clear();
+}
+
+void FSearchIndex::MarkLabelDirty(FAddressRef addr, const FLabelInfo* pLabel)
+{
+	if (bBuilt == false)
+		return;
+
+	MarkDirty(addr);
+	if (pLabel != nullptr)
+	{
+		for (const FAddressRef& refAddr : pLabel->References.GetReferences())
+			MarkDirty(refAddr);
+	}
+}
+
+void FSearchIndex::Build(FCodeAnalysisState& state)
+{
+	Reset();
+
+	for (const FCodeAnalysisBank& bank : state.GetBanks())
+	{
+		for (int pageNo = 0; pageNo < bank.NoPages; pageNo++)
+		{
+			const FCodeAnalysisPage& page = bank.Pages[pageNo];
+			for (int pageAddr = 0; pageAddr < FCodeAnalysisPage::kPageSize; pageAddr++)
+			{
+				// skip addresses with nothing to search
+				if (page.CodeInfo[pageAddr] == nullptr && page.Labels[pageAddr] == nullptr &&
+					page.CommentBlocks[pageAddr] == nullptr && page.DataInfo[pageAddr].Comment.empty())
+					continue;
+
+				IndexAddress(state, FAddressRef(bank.Id, bank.GetMappedAddress() + (pageNo * FCodeAnalysisPage::kPageSize) + pageAddr));
+			}
+		}
+	}
+
+	bBuilt = true;
+	BuildNumberMode = (int)GetNumberDisplayMode();
+}
+
+void FSearchIndex::Update(FCodeAnalysisState& state)
+{
+	if (bNeedsRebuild)
+	{
+		Build(state);
+		return;
+	}
+	IndexDirtyAddresses(state);
+
+	if (NoStalePostings > NoPostings / 2)
+		CompactPostings();
+}
+
+void FSearchIndex::IndexDirtyAddresses(FCodeAnalysisState& state)
+{
+	// indexing can generate code text which marks addresses dirty again
+	std::vector<FAddressRef> dirtyAddresses;
+	dirtyAddresses.swap(DirtyAddresses);
+	std::sort(dirtyAddresses.begin(), dirtyAddresses.end());
+	dirtyAddresses.erase(std::unique(dirtyAddresses.begin(), dirtyAddresses.end()), dirtyAddresses.end());
+	for (const FAddressRef& addr : dirtyAddresses)
+	{
+		if (state.IsAddressValid(addr))
+			IndexAddress(state, addr);
+	}
+}
+
+// gather the searchable text for an address & update the trigram postings
+void FSearchIndex::IndexAddress(FCodeAnalysisState& state, FAddressRef addr)
+{
+	FCodeAnalysisBank* pBank = state.GetBank(addr.BankId);
+	if (pBank == nullptr)
+		return;
+
+	const uint16_t bankAddr = addr.Address - pBank->GetMappedAddress();
+	const int pageNo = bankAddr >> FCodeAnalysisPage::kPageShift;
+	const int pageAddr = bankAddr & FCodeAnalysisPage::kPageMask;
+	const FCodeAnalysisPage& page = pBank->Pages[pageNo];
+
+	TextBuffer.clear();
+
+	FCodeInfo* pCodeInfo = page.CodeInfo[pageAddr];
+	if (pCodeInfo != nullptr)
+	{
+		AppendLower(TextBuffer, pCodeInfo->Comment);
+
+		// map so we generate code for the correct bank
+		// not using the disassembly cache as building the index would flush it
+		state.MapBankForAnalysis(*pBank);
+		if (pCodeInfo->bNeedsRewrite)
+			WriteCodeInfoForAddress(state, addr.Address);
+		const std::string codeText = GenerateDasmStringForAddress(state, addr.Address, pCodeInfo);
+		state.UnMapAnalysisBanks();
+
+		Markup::SetCodeInfo(pCodeInfo);
+		AppendLower(TextBuffer, Markup::ExpandString(state, codeText.c_str()));
+	}
+
+	const FLabelInfo* pLabelInfo = page.Labels[pageAddr];
+	if (pLabelInfo != nullptr)
+	{
+		AppendLower(TextBuffer, pLabelInfo->Comment);
+		AppendLower(TextBuffer, pLabelInfo->GetName());
+	}
+
+	AppendLower(TextBuffer, page.DataInfo[pageAddr].Comment);
+
+	const FCommentBlock* pCommentBlock = page.CommentBlocks[pageAddr];
+	if (pCommentBlock != nullptr)
+		AppendLower(TextBuffer, pCommentBlock->Comment);
+
+	// find or add document
+	int docIndex = -1;
+	auto docIt = DocumentLookup.find(addr);
+	if (docIt != DocumentLookup.end())
+	{
+		docIndex = docIt->second;
+		if (Documents[docIndex].Text == TextBuffer)
+			return;	// no change
+	}
+	else
+	{
+		if (TextBuffer.empty())
+			return;
+		docIndex = (int)Documents.size();
+		Documents.emplace_back().Address = addr;
+		DocumentLookup[addr] = docIndex;
+	}
+
+	FSearchDocument& doc = Documents[docIndex];
+	doc.Text = TextBuffer;
+
+	std::vector<uint32_t> newTrigrams;
+	for (size_t i = 0; i + 3 <= doc.Text.size(); i++)
+		newTrigrams.push_back(GetTrigram(&doc.Text[i]));
+	std::sort(newTrigrams.begin(), newTrigrams.end());
+	newTrigrams.erase(std::unique(newTrigrams.begin(), newTrigrams.end()), newTrigrams.end());
+
+	// add postings for trigrams the document didn't have before
+	size_t oldIndex = 0;
+	for (uint32_t trigram : newTrigrams)
+	{
+		while (oldIndex < doc.Trigrams.size() && doc.Trigrams[oldIndex] < trigram)
+		{
+			oldIndex++;
+			NoStalePostings++;	// trigram removed
+		}
+		if (oldIndex < doc.Trigrams.size() && doc.Trigrams[oldIndex] == trigram)
+		{
+			oldIndex++;
+			continue;
+		}
+		Postings[trigram].push_back(docIndex);
+		NoPostings++;
+	}
+	NoStalePostings += doc.Trigrams.size() - oldIndex;
+
+	doc.Trigrams.swap(newTrigrams);
+}
+
+void FSearchIndex::CompactPostings()
+{
+	Postings.clear();
+	NoPostings = 0;
+	NoStalePostings = 0;
+	for (int docIndex = 0; docIndex < (int)Documents.size(); docIndex++)
+	{
+		for (uint32_t trigram : Documents[docIndex].Trigrams)
+		{
+			Postings[trigram].push_back(docIndex);
+			NoPostings++;
+		}
+	}
+}
+
+std::vector<FAddressRef> FSearchIndex::Find(FCodeAnalysisState& state, const char* pText, bool bSearchROM)
+{
+	std::vector<FAddressRef> results;
+
+	std::string searchText = pText;
+	for (char& c : searchText)
+		c = ToLowerAscii(c);
+	if (searchText.empty())
+		return results;
+
+	if (bBuilt == false || bNeedsRebuild || BuildNumberMode != (int)GetNumberDisplayMode())
+		Build(state);
+	else if (DirtyAddresses.empty() == false)
+		Update(state);
+
+	auto checkDocument = [&](const FSearchDocument& doc)
+	{
+		if (doc.Text.find(searchText) == std::string::npos)
+			return;
+		const FCodeAnalysisBank* pBank = state.GetBank(doc.Address.BankId);
+		if (pBank == nullptr || (pBank->bMachineROM && bSearchROM == false))
+			return;
+		results.push_back(doc.Address);
+	};
+
+	if (searchText.size() < 3)
+	{
+		// too short for trigrams - just scan the text
+		for (const FSearchDocument& doc : Documents)
+			checkDocument(doc);
+	}
+	else
+	{
+		// the rarest trigram in the search text gives the fewest candidates
+		const std::vector<int>* pCandidates = nullptr;
+		for (size_t i = 0; i + 3 <= searchText.size(); i++)
+		{
+			auto postingIt = Postings.find(GetTrigram(&searchText[i]));
+			if (postingIt == Postings.end())
+				return results;
+			if (pCandidates == nullptr || postingIt->second.size() < pCandidates->size())
+				pCandidates = &postingIt->second;
+		}
+
+		DocumentSearchStamp.resize(Documents.size(), 0);
+		SearchStamp++;
+		for (int docIndex : *pCandidates)
+		{
+			if (DocumentSearchStamp[docIndex] == SearchStamp)
+				continue;
+			DocumentSearchStamp[docIndex] = SearchStamp;
+			checkDocument(Documents[docIndex]);
+		}
+	}
+
+	// bank then address order
+	std::sort(results.begin(), results.end(), [](const FAddressRef& a, const FAddressRef& b)
+	{
+		return a.BankId != b.BankId ? a.BankId < b.BankId : a.Address < b.Address;
+	});
+	return results;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CodeAnalyserTypes.h"
+
+class FCodeAnalysisState;
+struct FLabelInfo;
+
+// Trigram index over the searchable text at each address - labels, comments & disassembly
+// Built on the first search, then kept up to date from the addresses that get marked dirty
+class FSearchIndex
+{
+public:
+	void	Reset();	// index is rebuilt on the next search
+
+	void	MarkDirty(FAddressRef addr)
+	{
+		if (bBuilt == false)
+			return;
+		if (DirtyAddresses.size() < kMaxDirtyAddresses)
+			DirtyAddresses.push_back(addr);
+		else
+			bNeedsRebuild = true;	// quicker to rebuild than keep track
+	}
+	// label names appear in the disassembly of the code referencing them
+	void	MarkLabelDirty(FAddressRef addr, const FLabelInfo* pLabel);
+
+	std::vector<FAddressRef>	Find(FCodeAnalysisState& state, const char* pText, bool bSearchROM);
+
+	size_t	GetNoDocuments() const { return Documents.size(); }
+private:
+	struct FSearchDocument
+	{
+		FAddressRef				Address;
+		std::string				Text;	// lower case, fields separated by '\n'
+		std::vector<uint32_t>	Trigrams;	// sorted
+	};
+
+	void	Build(FCodeAnalysisState& state);
+	void	Update(FCodeAnalysisState& state);
+	void	IndexDirtyAddresses(FCodeAnalysisState& state);
+	void	IndexAddress(FCodeAnalysisState& state, FAddressRef addr);
+	void	CompactPostings();
+
+	static const size_t kMaxDirtyAddresses = 1 << 16;	// just rebuild past this
+
+	bool	bBuilt = false;
+	bool	bNeedsRebuild = false;
+	int		BuildNumberMode = 0;	// code text depends on the number display mode
+	std::vector<FAddressRef>	DirtyAddresses;
+
+	std::vector<FSearchDocument>			Documents;
+	std::unordered_map<FAddressRef, int>	DocumentLookup;
+
+	// document lists per trigram - removed trigrams are left in and filtered out when searching
+	std::unordered_map<uint32_t, std::vector<int>>	Postings;
+	size_t	NoPostings = 0;
+	size_t	NoStalePostings = 0;
+
+	// for de-duplicating candidates
+	std::vector<uint32_t>	DocumentSearchStamp;
+	uint32_t				SearchStamp = 0;
+
+	std::string		TextBuffer;	// reused when generating document text
+};
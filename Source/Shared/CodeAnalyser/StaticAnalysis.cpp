@@ -4,6 +4,12 @@
 #include "CodeAnalyser.h"
 #include "UI/CodeAnalyserUI.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 // check for multiplies using adds
 class FMultByAddCheck : public FStaticAnalysisCheck
 {
@@ -15,7 +21,7 @@ public:
 		AddRunLength = 0;
 	}
 
-	FStaticAnalysisItem* RunCheck(FCodeAnalysisState& state, FAddressRef addrRef) override
+	bool RunCheck(FCodeAnalysisState& state, FAddressRef addrRef, FStaticAnalysisItem& outItem) override
 	{
 		const EInstructionType instType = GetInstructionType(state, addrRef);
 
@@ -30,14 +36,13 @@ public:
 			if (AddRunLength > 0)
 			{
 				// Register item
-				char itemName[32];
-				snprintf(itemName, 32, "Multiply by %d", 1 << AddRunLength);
+				outItem = FStaticAnalysisItem(Start, "Multiply by", 1 << AddRunLength);
 				AddRunLength = 0;
-				return new FStaticAnalysisItem(Start, itemName);
+				return true;
 			}
 		}
 
-		return nullptr;
+		return false;
 	}
 private:
 	FAddressRef		Start;
@@ -48,118 +53,280 @@ private:
 class FSimpleChecks : public FStaticAnalysisCheck
 {
 public:
-	FStaticAnalysisItem* RunCheck(FCodeAnalysisState& state, FAddressRef addrRef) override
+	bool RunCheck(FCodeAnalysisState& state, FAddressRef addrRef, FStaticAnalysisItem& outItem) override
 	{
 		const EInstructionType instType = GetInstructionType(state, addrRef);
+		const char* pName = nullptr;
 
 		switch (instType)
 		{
 			case EInstructionType::PortInput:
-				return new FStaticAnalysisItem(addrRef, "Port Input");
+				pName = "Port Input";
+				break;
 			case EInstructionType::PortOutput:
-				return new FStaticAnalysisItem(addrRef, "Port Output");
+				pName = "Port Output";
+				break;
 			case EInstructionType::ChangeInterruptMode:
-				return new FStaticAnalysisItem(addrRef, "Interrupt Mode");
+				pName = "Interrupt Mode";
+				break;
 			case EInstructionType::JumpToPointer:
-				return new FStaticAnalysisItem(addrRef, "Jump to Pointer");
+				pName = "Jump to Pointer";
+				break;
 			case EInstructionType::Halt:
-				return new FStaticAnalysisItem(addrRef, "Halt");
+				pName = "Halt";
+				break;
 			case EInstructionType::SetStackPointer:
-				return new FStaticAnalysisItem(addrRef, "Set Stack Pointer");
+				pName = "Set Stack Pointer";
+				break;
 			default:
-				return nullptr;
+				return false;
 		}
+
+		outItem = FStaticAnalysisItem(addrRef, pName);
+		return true;
 	}
 
 };
 
-
-bool FStaticAnalyser::Init(FCodeAnalysisState* pState)
+void FStaticAnalyser::CreateChecks(std::vector<FStaticAnalysisCheck*>& checks)
 {
-	pCodeAnalysis = pState;
+	checks.push_back(new FMultByAddCheck);
+	checks.push_back(new FSimpleChecks);
+}
 
-	for (auto check : Checks)
+void FStaticAnalyser::DeleteChecks(std::vector<FStaticAnalysisCheck*>& checks)
+{
+	for (auto check : checks)
 		delete check;
-	Checks.clear();
-	Checks.push_back(new FMultByAddCheck);
-	Checks.push_back(new FSimpleChecks);
-	return true;
+	checks.clear();
 }
 
-void FStaticAnalyser::Reset()
+// Banks are independent so they're farmed out to worker threads
+// The threads are started once & wait for work, each keeps its own set of checks
+// Workers only read the analysis state & each writes to its own bank results
+class FStaticAnalysisWorkerPool
 {
-	// reset item list
-	for (auto item : Items)
+public:
+	FStaticAnalysisWorkerPool(FStaticAnalyser& analyser, int noThreads) : Analyser(analyser)
 	{
-		delete item;
+		FStaticAnalyser::CreateChecks(Checks);
+		for (int i = 0; i < noThreads; i++)
+			Threads.emplace_back(&FStaticAnalysisWorkerPool::WorkerMain, this);
 	}
 
-	Items.clear();
+	~FStaticAnalysisWorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			bQuit = true;
+		}
+		WorkReady.notify_all();
+		for (std::thread& thread : Threads)
+			thread.join();
+		FStaticAnalyser::DeleteChecks(Checks);
+	}
 
-	// reset checks
-	for (auto check : Checks)
+	// returns when all the banks have been analysed - the calling thread helps out
+	void AnalyseBanks(const std::vector<int16_t>& banks)
 	{
-		check->Reset();
+		if (Threads.empty() || banks.size() == 1)	// not worth waking the workers
+		{
+			for (int16_t bankId : banks)
+				Analyser.AnalyseBank(bankId, Checks);
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			pBanks = &banks;
+			NextBank = 0;
+			NoWorkersBusy = (int)Threads.size();
+			JobNo++;
+		}
+		WorkReady.notify_all();
+
+		AnalyseNextBanks(Checks);
+
+		std::unique_lock<std::mutex> lock(Mutex);
+		WorkDone.wait(lock, [this] { return NoWorkersBusy == 0; });
+		pBanks = nullptr;
 	}
 
-}
+private:
+	void AnalyseNextBanks(std::vector<FStaticAnalysisCheck*>& checks)
+	{
+		const std::vector<int16_t>& banks = *pBanks;
+		for (int bankIndex = NextBank++; bankIndex < (int)banks.size(); bankIndex = NextBank++)
+			Analyser.AnalyseBank(banks[bankIndex], checks);
+	}
 
-bool FStaticAnalyser::RunAnalysis(void)
-{
-	FCodeAnalysisState& state = *pCodeAnalysis;
-	const auto& banks = pCodeAnalysis->GetBanks();
+	void WorkerMain()
+	{
+		std::vector<FStaticAnalysisCheck*> checks;
+		FStaticAnalyser::CreateChecks(checks);
+
+		uint32_t lastJobNo = 0;
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(Mutex);
+				WorkReady.wait(lock, [this, lastJobNo] { return bQuit || JobNo != lastJobNo; });
+				if (bQuit)
+					break;
+				lastJobNo = JobNo;
+			}
+
+			AnalyseNextBanks(checks);
+
+			std::lock_guard<std::mutex> lock(Mutex);
+			if (--NoWorkersBusy == 0)
+				WorkDone.notify_one();
+		}
+
+		FStaticAnalyser::DeleteChecks(checks);
+	}
+
+	FStaticAnalyser&		Analyser;
+	std::vector<std::thread>	Threads;
+	std::vector<FStaticAnalysisCheck*>	Checks;	// for the calling thread
+
+	std::mutex				Mutex;
+	std::condition_variable	WorkReady;
+	std::condition_variable	WorkDone;
+	const std::vector<int16_t>*	pBanks = nullptr;
+	std::atomic<int>		NextBank = { 0 };
+	uint32_t				JobNo = 0;
+	int						NoWorkersBusy = 0;
+	bool					bQuit = false;
+};
+
+FStaticAnalyser::~FStaticAnalyser() = default;
 
+bool FStaticAnalyser::Init(FCodeAnalysisState* pState)
+{
+	pCodeAnalysis = pState;
 	Reset();
 
-	// iterate through all registered banks
-	for (int bankNo = 0; bankNo < banks.size(); bankNo++)
+	if (pWorkerPool == nullptr)
 	{
-		const FCodeAnalysisBank& bank = banks[bankNo];
+		const int noThreads = std::max(1, (int)std::thread::hardware_concurrency() - 1) - 1;	// the analysing thread is one of them
+		pWorkerPool = std::make_unique<FStaticAnalysisWorkerPool>(*this, noThreads);
+	}
+	return true;
+}
 
-		if(bank.bMachineROM)
-			continue;
+void FStaticAnalyser::Reset()
+{
+	BankResults.clear();
+	NoItems = 0;
+}
+
+void FStaticAnalyser::AnalyseBank(int16_t bankId, std::vector<FStaticAnalysisCheck*>& checks)
+{
+	FCodeAnalysisState& state = *pCodeAnalysis;
+	const FCodeAnalysisBank* pBank = state.GetBank(bankId);
+	FStaticAnalysisBankResults& results = BankResults[bankId];
+	results.Items.clear();
 
-		int addToSelfRun = 0;
-		FAddressRef addToSelfRunStart;
+	for (auto check : checks)
+		check->Reset();
 
-		// iterate through all address in bank
-		int addr = bank.GetMappedAddress();
-		while (addr < bank.GetMappedAddress() + bank.GetSizeBytes())
+	// iterate through all address in bank
+	FStaticAnalysisItem item;
+	int addr = pBank->GetMappedAddress();
+	while (addr < pBank->GetMappedAddress() + pBank->GetSizeBytes())
+	{
+		FAddressRef addrRef(bankId, addr);
+		const FCodeInfo* pCodeInfoItem = state.GetCodeInfoForAddress(addrRef);
+		if (pCodeInfoItem)
 		{
-			FAddressRef addrRef(bank.Id,addr);
-			const FCodeInfo* pCodeInfoItem = pCodeAnalysis->GetCodeInfoForAddress(addrRef);
-			if (pCodeInfoItem)
-			{
-				for (auto check : Checks)	// perform each check
-				{
-					FStaticAnalysisItem* pItem = check->RunCheck(state,addrRef);
-					if(pItem)
-						Items.push_back(pItem);
-				}
-
-				addr += pCodeInfoItem->ByteSize;
-			}
-			else
+			for (auto check : checks)	// perform each check
 			{
-				addr++;
+				if (check->RunCheck(state, addrRef, item))
+					results.Items.push_back(item);
 			}
 
+			addr += pCodeInfoItem->ByteSize > 0 ? pCodeInfoItem->ByteSize : 1;
+		}
+		else
+		{
+			addr++;
 		}
 	}
+}
 
+bool FStaticAnalyser::RunAnalysis(void)
+{
+	FCodeAnalysisState& state = *pCodeAnalysis;
+	const auto& banks = state.GetBanks();
+	const auto startTime = std::chrono::high_resolution_clock::now();
+
+	// find the banks which have changed since they were last analysed
+	std::vector<int16_t> dirtyBanks;
+	for (const FCodeAnalysisBank& bank : banks)
+	{
+		if (bank.Id >= (int)BankResults.size())
+			BankResults.resize(bank.Id + 1);
+
+		FStaticAnalysisBankResults& results = BankResults[bank.Id];
+		if (bank.bMachineROM)
+			continue;
+		if (results.bAnalysed && results.CodeChangeCount == bank.CodeChangeCount)
+			continue;
+
+		results.CodeChangeCount = bank.CodeChangeCount;
+		results.bAnalysed = true;
+		dirtyBanks.push_back(bank.Id);
+	}
+
+	LastNoBanksAnalysed = (int)dirtyBanks.size();
+	if (dirtyBanks.empty())
+		return true;
+
+	pWorkerPool->AnalyseBanks(dirtyBanks);
+
+	NoItems = 0;
+	for (const FStaticAnalysisBankResults& results : BankResults)
+		NoItems += (int)results.Items.size();
+
+	const auto endTime = std::chrono::high_resolution_clock::now();
+	LastAnalysisTimeMs = std::chrono::duration<float, std::milli>(endTime - startTime).count();
 	return true;
 }
 
+void FStaticAnalyser::FrameTick(void)
+{
+	if (bAutoRun)
+		RunAnalysis();
+}
+
 void FStaticAnalyser::DrawUI(void)
 {
-	for (auto item : Items)
+	FCodeAnalysisState& state = *pCodeAnalysis;
+
+	ImGui::Checkbox("Auto Analyse", &bAutoRun);
+	ImGui::SameLine();
+	if (ImGui::Button("Analyse Now"))
+		RunAnalysis();
+	ImGui::Text("%d items, last analysed %d banks in %.2fms", NoItems, LastNoBanksAnalysed, LastAnalysisTimeMs);
+	ImGui::Separator();
+
+	for (const FStaticAnalysisBankResults& results : BankResults)
 	{
-		item->DrawUi(*pCodeAnalysis,pCodeAnalysis->GetFocussedViewState());
+		for (const FStaticAnalysisItem& item : results.Items)
+		{
+			ImGui::PushID(item.AddressRef.Val);
+			item.DrawUi(state, state.GetFocussedViewState());
+			ImGui::PopID();
+		}
 	}
 }
 
-void FStaticAnalysisItem::DrawUi(FCodeAnalysisState& state, FCodeAnalysisViewState& viewState)
+void FStaticAnalysisItem::DrawUi(FCodeAnalysisState& state, FCodeAnalysisViewState& viewState) const
 {
-	ImGui::Text("%s : ",Name.c_str());
+	if (Value != -1)
+		ImGui::Text("%s %d : ", Name, Value);
+	else
+		ImGui::Text("%s : ",Name);
 	DrawAddressLabel(state, viewState, AddressRef);
 }
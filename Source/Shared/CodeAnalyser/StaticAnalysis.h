@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <string>
+#include <memory>
 #include "CodeAnalyserTypes.h"
 
 enum class EInstructionType
@@ -20,40 +21,65 @@ enum class EInstructionType
 
 class FCodeAnalysisState;
 struct FCodeAnalysisViewState;
+class FStaticAnalysisWorkerPool;
 
+// results are stored by value - names are static strings
 struct FStaticAnalysisItem
 {
-	FStaticAnalysisItem(FAddressRef addr, const char* name):AddressRef(addr),Name(name){}
+	FStaticAnalysisItem() = default;
+	FStaticAnalysisItem(FAddressRef addr, const char* name, int value = -1):AddressRef(addr),Name(name),Value(value){}
 
 	FAddressRef		AddressRef;
-	std::string		Name;
+	const char*		Name = nullptr;
+	int				Value = -1;	// optional value shown after the name
 
-	virtual void	DrawUi(FCodeAnalysisState& state, FCodeAnalysisViewState& viewState);
+	void	DrawUi(FCodeAnalysisState& state, FCodeAnalysisViewState& viewState) const;
 };
 
+// Checks are run over a bank at a time, each bank gets its own instances so they can keep state between instructions
 class FStaticAnalysisCheck
 {
 public:
 	virtual ~FStaticAnalysisCheck(){}
 	
 	virtual void Reset(){}
-	virtual FStaticAnalysisItem* RunCheck(FCodeAnalysisState& state, FAddressRef addrRef) = 0;
+	// returns true if outItem has been filled in
+	virtual bool RunCheck(FCodeAnalysisState& state, FAddressRef addrRef, FStaticAnalysisItem& outItem) = 0;
+};
+
+// cached results for a bank
+struct FStaticAnalysisBankResults
+{
+	std::vector<FStaticAnalysisItem>	Items;
+	uint32_t	CodeChangeCount = 0;	// bank's count when analysed
+	bool		bAnalysed = false;
 };
 
 class FStaticAnalyser
 {
+	friend class FStaticAnalysisWorkerPool;
 public:
+	~FStaticAnalyser();
+
 	bool	Init(FCodeAnalysisState* pState);
 
 	void	Reset();
-	bool	RunAnalysis(void);
+	bool	RunAnalysis(void);	// only analyses banks whose code has changed
+	void	FrameTick(void);
 
 	void	DrawUI(void);
+
+	bool	bAutoRun = true;	// analyse each frame if code has changed
 private:
+	void	AnalyseBank(int16_t bankId, std::vector<FStaticAnalysisCheck*>& checks);
+	static void	CreateChecks(std::vector<FStaticAnalysisCheck*>& checks);
+	static void	DeleteChecks(std::vector<FStaticAnalysisCheck*>& checks);
 
 	FCodeAnalysisState*	pCodeAnalysis = nullptr;
+	std::unique_ptr<FStaticAnalysisWorkerPool>	pWorkerPool;	// started on Init, kept for the analyser's lifetime
 
-	std::vector<FStaticAnalysisCheck*>	Checks;
-
-	std::vector<FStaticAnalysisItem*> Items;
-};
\ No newline at end of file
+	std::vector<FStaticAnalysisBankResults>	BankResults;	// indexed by bank id
+	int		NoItems = 0;
+	float	LastAnalysisTimeMs = 0.0f;
+	int		LastNoBanksAnalysed = 0;
+};
@@ -0,0 +1,162 @@
+#include "CodeAnalyser/EventLog.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+// Checks the debugger event log's ring buffer & indexes
+
+static void AddTestEvent(FEventLog& eventLog, uint8_t type, uint16_t address, uint16_t pcAddress = 0x8000)
+{
+	eventLog.AddEvent(type, FAddressRef(0, pcAddress), address, (uint8_t)address, 0);
+}
+
+// what FindEvents should return - every event in the log checked in turn
+static void FindEventsLinear(const FEventLog& eventLog, const FEventQuery& query, std::vector<uint64_t>& outEvents)
+{
+	outEvents.clear();
+	for (uint64_t eventNo = eventLog.GetFirstEvent(); eventNo < eventLog.GetEndEvent(); eventNo++)
+	{
+		if (eventNo < query.FirstEvent || eventNo >= query.EndEvent)
+			continue;
+
+		const FEvent event = eventLog.GetEvent(eventNo);
+		if ((query.Type == -1 || event.Type == query.Type) &&
+			(query.Address == -1 || event.Address == query.Address) &&
+			(query.PCAddress == -1 || event.PC.Address == query.PCAddress))
+			outEvents.push_back(eventNo);
+	}
+}
+
+static void CheckQueryMatchesLinear(const FEventLog& eventLog, const FEventQuery& query)
+{
+	std::vector<uint64_t> foundEvents;
+	std::vector<uint64_t> expectedEvents;
+	eventLog.FindEvents(query, foundEvents);
+	FindEventsLinear(eventLog, query, expectedEvents);
+	EXPECT_EQ(foundEvents, expectedEvents) << "Type " << query.Type << " Address " << query.Address << " PC " << query.PCAddress;
+}
+
+TEST(EventLogTest, IndexListRemoveBefore)
+{
+	FEventIndexList list;
+	for (uint64_t eventNo = 0; eventNo < 3000; eventNo++)
+		list.Add(eventNo);
+
+	// small amounts are skipped over
+	list.RemoveBefore(500);
+	EXPECT_EQ(list.Start, 500);
+	EXPECT_EQ(list.Events.size(), 3000);
+	EXPECT_EQ(list.Size(), 2500);
+
+	// then shuffled down once the dead part is most of the list
+	list.RemoveBefore(2000);
+	EXPECT_EQ(list.Start, 0);
+	EXPECT_EQ(list.Events.size(), 1000);
+	EXPECT_EQ(list.Size(), 1000);
+	EXPECT_EQ(list.Events.front(), 2000);
+	EXPECT_EQ(list.Events.back(), 2999);
+
+	list.RemoveBefore(5000);
+	EXPECT_EQ(list.Size(), 0);
+}
+
+TEST(EventLogTest, WrapAtMaxEvents)
+{
+	std::unique_ptr<FEventLog> pEventLog = std::make_unique<FEventLog>();
+	FEventLog& eventLog = *pEventLog;
+	const int kNoExtraEvents = 100;
+
+	for (int eventNo = 0; eventNo < FEventLog::kMaxEvents + kNoExtraEvents; eventNo++)
+		AddTestEvent(eventLog, (uint8_t)(eventNo & 3), (uint16_t)eventNo);
+
+	// the oldest events have been overwritten
+	EXPECT_EQ(eventLog.GetFirstEvent(), kNoExtraEvents);
+	EXPECT_EQ(eventLog.GetEndEvent(), FEventLog::kMaxEvents + kNoExtraEvents);
+	EXPECT_FALSE(eventLog.IsEventValid(kNoExtraEvents - 1));
+	EXPECT_TRUE(eventLog.IsEventValid(kNoExtraEvents));
+	EXPECT_FALSE(eventLog.IsEventValid(eventLog.GetEndEvent()));
+
+	// newest events share ring slots with the lost ones
+	const uint64_t lastEvent = eventLog.GetEndEvent() - 1;
+	EXPECT_EQ(eventLog.GetEvent(lastEvent).Address, (uint16_t)lastEvent);
+	EXPECT_EQ(eventLog.GetEventType(lastEvent), (uint8_t)(lastEvent & 3));
+	EXPECT_EQ(eventLog.GetEvent(kNoExtraEvents).Address, (uint16_t)kNoExtraEvents);
+
+	// queries don't return the lost events, even when asked for them
+	FEventQuery query;
+	query.Type = 0;
+	query.FirstEvent = 0;
+	std::vector<uint64_t> foundEvents;
+	eventLog.FindEvents(query, foundEvents);
+	ASSERT_FALSE(foundEvents.empty());
+	EXPECT_GE(foundEvents.front(), eventLog.GetFirstEvent());
+	EXPECT_EQ(foundEvents.size(), FEventLog::kMaxEvents / 4);
+	CheckQueryMatchesLinear(eventLog, query);
+}
+
+TEST(EventLogTest, FramesToKeep)
+{
+	std::unique_ptr<FEventLog> pEventLog = std::make_unique<FEventLog>();
+	FEventLog& eventLog = *pEventLog;
+	eventLog.SetNoFramesToKeep(4);
+	eventLog.SetMinFramesToKeep(10);
+
+	for (int frameNo = 0; frameNo < 20; frameNo++)
+	{
+		eventLog.OnMachineFrameStart();
+		for (int eventNo = 0; eventNo < 10; eventNo++)
+			AddTestEvent(eventLog, 1, (uint16_t)eventNo);
+	}
+
+	// the minimum wins over the frames to keep setting
+	EXPECT_EQ(eventLog.GetNoFrames(), 10);
+	EXPECT_EQ(eventLog.GetFirstEvent(), eventLog.GetFrameStartEvent(9));
+	EXPECT_EQ(eventLog.GetEndEvent() - eventLog.GetFirstEvent(), 100);
+
+	eventLog.SetMinFramesToKeep(0);
+	eventLog.OnMachineFrameStart();
+	EXPECT_EQ(eventLog.GetNoFrames(), 4);
+}
+
+TEST(EventLogTest, FindEventsMatchesLinearScan)
+{
+	std::unique_ptr<FEventLog> pEventLog = std::make_unique<FEventLog>();
+	FEventLog& eventLog = *pEventLog;
+	eventLog.SetNoFramesToKeep(8);
+
+	// few types & addresses so the queries find plenty
+	std::mt19937 rng(1234);
+	for (int frameNo = 0; frameNo < 20; frameNo++)
+	{
+		eventLog.OnMachineFrameStart();
+		for (int eventNo = 0; eventNo < 5000; eventNo++)
+			AddTestEvent(eventLog, (uint8_t)(rng() % 8), (uint16_t)(0xfe00 + rng() % 16), (uint16_t)(0x8000 + rng() % 32));
+	}
+
+	const uint64_t midEvent = eventLog.GetFrameStartEvent(3);
+	for (int type = -1; type < 8; type++)
+	{
+		for (int address = -1; address < 16; address += 5)
+		{
+			FEventQuery query;
+			query.Type = type;
+			query.Address = address == -1 ? -1 : 0xfe00 + address;
+			CheckQueryMatchesLinear(eventLog, query);	// whole log, from the index if there is one
+
+			query.FirstEvent = midEvent;
+			query.EndEvent = midEvent + 1000;
+			CheckQueryMatchesLinear(eventLog, query);
+
+			query.PCAddress = 0x8005;	// PC only filters
+			CheckQueryMatchesLinear(eventLog, query);
+		}
+	}
+
+	// PC only queries have no index & scan the range
+	FEventQuery pcQuery;
+	pcQuery.PCAddress = 0x8010;
+	CheckQueryMatchesLinear(eventLog, pcQuery);
+}
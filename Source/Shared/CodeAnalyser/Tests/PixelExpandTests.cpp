@@ -0,0 +1,305 @@
+#include "Util/PixelExpand.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Checks the graphics view pixel expanders against the per-pixel code they replaced
+
+typedef void (*Expand1BppFunc)(uint32_t* pDest, uint8_t pixels, uint8_t writeMask, uint32_t paperCol, uint32_t inkCol);
+
+struct FExpand1BppVariant
+{
+	const char*		Name;
+	Expand1BppFunc	Func;
+};
+
+static const FExpand1BppVariant g_Expand1BppVariants[] =
+{
+	{ "Scalar", Expand1BppSpan_Scalar },
+#if PIXELEXPAND_SSE2
+	{ "SSE2", Expand1BppSpan_SSE2 },
+#endif
+#if PIXELEXPAND_AVX2
+	{ "AVX2", Expand1BppSpan_AVX2 },
+#endif
+	{ "Default", Expand1BppSpan },
+};
+
+// Reference implementations
+static void RefDrawCharLine(uint32_t* pBase, uint8_t charLine, uint32_t inkCol, uint32_t paperCol)
+{
+	for (int xpix = 0; xpix < 8; xpix++)
+	{
+		const bool bSet = (charLine & (1 << (7 - xpix))) != 0;
+		const uint32_t col = bSet ? inkCol : paperCol;
+		if (col != 0xFF000000)
+			*(pBase + xpix) = col;
+	}
+}
+
+static void RefDrawMaskedLine(uint32_t* pBase, uint8_t pixels, uint8_t mask, const uint32_t* cols)
+{
+	for (int xpix = 0; xpix < 8; xpix++)
+	{
+		const bool bMasked = (mask & (1 << (7 - xpix))) != 0;
+		const bool bSet = (pixels & (1 << (7 - xpix))) != 0;
+		const uint32_t col = bSet ? cols[1] : cols[0];
+		if (bMasked == false)
+			*(pBase + xpix) = col;
+	}
+}
+
+static void RefDraw2BppLine(uint32_t* pBase, const uint8_t* pSrc, int noBytes, const uint32_t* cols)
+{
+	for (int x = 0; x < noBytes; x++)
+	{
+		const uint8_t val = *pSrc++;
+
+		for (int xpix = 0; xpix < 4; xpix++)
+		{
+			uint8_t colNo = 0;
+
+			switch (xpix)
+			{
+			case 0:
+				colNo = (val & 0x8 ? 2 : 0) | (val & 0x80 ? 1 : 0);
+				break;
+			case 1:
+				colNo = (val & 0x4 ? 2 : 0) | (val & 0x40 ? 1 : 0);
+				break;
+			case 2:
+				colNo = (val & 0x2 ? 2 : 0) | (val & 0x20 ? 1 : 0);
+				break;
+			case 3:
+				colNo = (val & 0x1 ? 2 : 0) | (val & 0x10 ? 1 : 0);
+				break;
+			}
+			const uint32_t pixelCol = cols ? cols[colNo] : colNo == 0 ? 0 : 0xffffffff;
+			*(pBase + xpix + (x * 4)) = pixelCol;
+		}
+	}
+}
+
+static void RefDraw2BppWideLine(uint32_t* pBase, const uint8_t* pSrc, int noBytes, const uint32_t* cols)
+{
+	for (int x = 0; x < noBytes; x++)
+	{
+		const uint8_t charLine = *pSrc++;
+
+		for (int xpix = 0; xpix < 4; xpix++)
+		{
+			const uint8_t colNo = (charLine >> (6 - (xpix * 2))) & 3;
+			*(pBase + (xpix * 2) + (x * 8)) = cols[colNo];
+			*(pBase + (xpix * 2) + 1 + (x * 8)) = cols[colNo];
+		}
+	}
+}
+
+static void RefDraw4BppWideLine(uint32_t* pBase, const uint8_t* pSrc, int noBytes, const uint32_t* cols)
+{
+	for (int x = 0; x < noBytes; x++)
+	{
+		const uint8_t val = *pSrc++;
+
+		for (int xpix = 0; xpix < 2; xpix++)
+		{
+			uint8_t colNo = 0;
+
+			if (xpix == 0)
+				colNo = (val & 0x80 ? 1 : 0) | (val & 0x8 ? 2 : 0) | (val & 0x20 ? 4 : 0) | (val & 0x2 ? 8 : 0);
+			else
+				colNo = (val & 0x40 ? 1 : 0) | (val & 0x4 ? 2 : 0) | (val & 0x10 ? 4 : 0) | (val & 0x1 ? 8 : 0);
+
+			*(pBase + (xpix * 2) + (x * 4)) = cols[colNo];
+			*(pBase + (xpix * 2) + 1 + (x * 4)) = cols[colNo];
+		}
+	}
+}
+
+// random colour, sometimes opaque black so the skip gets tested
+static uint32_t RandomCol(std::mt19937& rng)
+{
+	return (rng() % 4) == 0 ? 0xFF000000 : (uint32_t)rng();
+}
+
+static void FillRandom(std::vector<uint32_t>& buffer, std::mt19937& rng)
+{
+	for (uint32_t& pixel : buffer)
+		pixel = (uint32_t)rng();
+}
+
+TEST(PixelExpandTest, Expand1BppMatchesReference)
+{
+	std::mt19937 rng(1234);
+	std::vector<uint32_t> expected(8), result(8);
+
+	for (const FExpand1BppVariant& variant : g_Expand1BppVariants)
+	{
+		for (int i = 0; i < 20000; i++)
+		{
+			const uint8_t pixels = (uint8_t)rng();
+			const uint32_t inkCol = RandomCol(rng);
+			const uint32_t paperCol = RandomCol(rng);
+			FillRandom(expected, rng);
+			result = expected;
+
+			RefDrawCharLine(expected.data(), pixels, inkCol, paperCol);
+			variant.Func(result.data(), pixels, Get1BppWriteMask(pixels, paperCol != 0xFF000000, inkCol != 0xFF000000), paperCol, inkCol);
+			ASSERT_EQ(expected, result) << variant.Name << " pixels " << (int)pixels;
+		}
+	}
+}
+
+TEST(PixelExpandTest, ExpandMasked1BppMatchesReference)
+{
+	std::mt19937 rng(5678);
+	std::vector<uint32_t> expected(8), result(8);
+
+	for (const FExpand1BppVariant& variant : g_Expand1BppVariants)
+	{
+		for (int i = 0; i < 20000; i++)
+		{
+			const uint8_t pixels = (uint8_t)rng();
+			const uint8_t mask = (uint8_t)rng();
+			const uint32_t cols[2] = { (uint32_t)rng(), (uint32_t)rng() };
+			FillRandom(expected, rng);
+			result = expected;
+
+			RefDrawMaskedLine(expected.data(), pixels, mask, cols);
+			variant.Func(result.data(), pixels, (uint8_t)~mask, cols[0], cols[1]);
+			ASSERT_EQ(expected, result) << variant.Name << " pixels " << (int)pixels << " mask " << (int)mask;
+		}
+	}
+}
+
+TEST(PixelExpandTest, ExpandMultiColourMatchesReference)
+{
+	std::mt19937 rng(9012);
+	const int kNoBytes = 32;
+	std::vector<uint8_t> src(kNoBytes);
+	std::vector<uint32_t> expected(kNoBytes * 8), result(kNoBytes * 8);
+	uint32_t cols[16];
+
+	for (int i = 0; i < 2000; i++)
+	{
+		for (uint8_t& val : src)
+			val = (uint8_t)rng();
+		for (uint32_t& col : cols)
+			col = RandomCol(rng);
+
+		FillRandom(expected, rng);
+		result = expected;
+		RefDraw2BppLine(expected.data(), src.data(), kNoBytes, cols);
+		Expand2BppSpan(result.data(), src.data(), kNoBytes, cols);
+		ASSERT_EQ(expected, result) << "2bpp";
+
+		RefDraw2BppLine(expected.data(), src.data(), kNoBytes, nullptr);
+		Expand2BppSpan(result.data(), src.data(), kNoBytes, nullptr);
+		ASSERT_EQ(expected, result) << "2bpp default colours";
+
+		RefDraw2BppWideLine(expected.data(), src.data(), kNoBytes, cols);
+		Expand2BppWideSpan(result.data(), src.data(), kNoBytes, cols);
+		ASSERT_EQ(expected, result) << "2bpp wide";
+
+		RefDraw4BppWideLine(expected.data(), src.data(), kNoBytes, cols);
+		Expand4BppWideSpan(result.data(), src.data(), kNoBytes, cols);
+		ASSERT_EQ(expected, result) << "4bpp wide";
+	}
+}
+
+// Benchmark - run with --gtest_also_run_disabled_tests
+// draws a 64x16 pixel image into a 256x192 view like the graphics viewers do
+static const int kBenchViewWidth = 256;
+static const int kBenchImageWidthBytes = 8;
+static const int kBenchImageHeight = 16;
+static const int kBenchNoDraws = 200000;
+
+template <typename TDrawLine>
+static void BenchmarkDraw(const char* pName, const std::vector<uint8_t>& image, std::vector<uint32_t>& view, TDrawLine drawLine)
+{
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < kBenchNoDraws; i++)
+	{
+		for (int y = 0; y < kBenchImageHeight; y++)
+			drawLine(&view[y * kBenchViewWidth + (i & 7)], &image[y * kBenchImageWidthBytes]);
+	}
+	const long long ms = (long long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+	printf("%-24s %lldms\n", pName, ms);
+}
+
+TEST(PixelExpandTest, DISABLED_Benchmark)
+{
+	std::mt19937 rng(42);
+	std::vector<uint8_t> image(kBenchImageWidthBytes * kBenchImageHeight);
+	for (uint8_t& val : image)
+		val = (uint8_t)rng();
+	std::vector<uint32_t> view(kBenchViewWidth * 192);
+	uint32_t cols[16];
+	for (uint32_t& col : cols)
+		col = 0xFF000000 | (uint32_t)rng();
+
+	BenchmarkDraw("1bpp reference", image, view, [&](uint32_t* pDest, const uint8_t* pSrc)
+	{
+		for (int x = 0; x < kBenchImageWidthBytes; x++)
+			RefDrawCharLine(pDest + x * 8, pSrc[x], cols[1], cols[0]);
+	});
+	BenchmarkDraw("1bpp scalar", image, view, [&](uint32_t* pDest, const uint8_t* pSrc)
+	{
+		for (int x = 0; x < kBenchImageWidthBytes; x++)
+			Expand1BppSpan_Scalar(pDest + x * 8, pSrc[x], Get1BppWriteMask(pSrc[x], true, true), cols[0], cols[1]);
+	});
+#if PIXELEXPAND_SSE2
+	BenchmarkDraw("1bpp SSE2", image, view, [&](uint32_t* pDest, const uint8_t* pSrc)
+	{
+		for (int x = 0; x < kBenchImageWidthBytes; x++)
+			Expand1BppSpan_SSE2(pDest + x * 8, pSrc[x], Get1BppWriteMask(pSrc[x], true, true), cols[0], cols[1]);
+	});
+#endif
+#if PIXELEXPAND_AVX2
+	BenchmarkDraw("1bpp AVX2", image, view, [&](uint32_t* pDest, const uint8_t* pSrc)
+	{
+		for (int x = 0; x < kBenchImageWidthBytes; x++)
+			Expand1BppSpan_AVX2(pDest + x * 8, pSrc[x], Get1BppWriteMask(pSrc[x], true, true), cols[0], cols[1]);
+	});
+#endif
+	BenchmarkDraw("1bpp masked reference", image, view, [&](uint32_t* pDest, const uint8_t* pSrc)
+	{
+		for (int x = 0; x < kBenchImageWidthBytes; x++)
+			RefDrawMaskedLine(pDest + x * 8, pSrc[x], pSrc[x ^ 1], cols);
+	});
+	BenchmarkDraw("1bpp masked", image, view, [&](uint32_t* pDest, const uint8_t* pSrc)
+	{
+		for (int x = 0; x < kBenchImageWidthBytes; x++)
+			Expand1BppSpan(pDest + x * 8, pSrc[x], (uint8_t)~pSrc[x ^ 1], cols[0], cols[1]);
+	});
+	BenchmarkDraw("2bpp reference", image, view, [&](uint32_t* pDest, const uint8_t* pSrc)
+	{
+		RefDraw2BppLine(pDest, pSrc, kBenchImageWidthBytes, cols);
+	});
+	BenchmarkDraw("2bpp", image, view, [&](uint32_t* pDest, const uint8_t* pSrc)
+	{
+		Expand2BppSpan(pDest, pSrc, kBenchImageWidthBytes, cols);
+	});
+	BenchmarkDraw("2bpp wide reference", image, view, [&](uint32_t* pDest, const uint8_t* pSrc)
+	{
+		RefDraw2BppWideLine(pDest, pSrc, kBenchImageWidthBytes, cols);
+	});
+	BenchmarkDraw("2bpp wide", image, view, [&](uint32_t* pDest, const uint8_t* pSrc)
+	{
+		Expand2BppWideSpan(pDest, pSrc, kBenchImageWidthBytes, cols);
+	});
+	BenchmarkDraw("4bpp wide reference", image, view, [&](uint32_t* pDest, const uint8_t* pSrc)
+	{
+		RefDraw4BppWideLine(pDest, pSrc, kBenchImageWidthBytes, cols);
+	});
+	BenchmarkDraw("4bpp wide", image, view, [&](uint32_t* pDest, const uint8_t* pSrc)
+	{
+		Expand4BppWideSpan(pDest, pSrc, kBenchImageWidthBytes, cols);
+	});
+
+	EXPECT_NE(view[0], 0u);	// keep the optimiser honest
+}
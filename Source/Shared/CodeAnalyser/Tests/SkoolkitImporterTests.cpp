@@ -0,0 +1,491 @@
+#include "Importers/SkoolkitImporter.h"
+#include "Util/FileUtil.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Checks the in place skool file tokenizer against the line copying one it replaced
+
+// what an instruction line turns into - the same for both tokenizers
+struct FTokenizedInstruction
+{
+	uint16_t	Address = 0;
+	char		BlockDirective = kSkoolkitDirectiveNone;
+	char		SubBlockDirective = kSkoolkitDirectiveNone;
+	char		CurBlockDirective = kSkoolkitDirectiveNone;
+	bool		bBranchDestination = false;
+	std::string	Operation;
+	std::string	Comment;	// with the continuation lines added
+	std::string	CommentBlock;
+	std::string	Label;
+
+	bool operator==(const FTokenizedInstruction& other) const
+	{
+		return Address == other.Address && BlockDirective == other.BlockDirective && SubBlockDirective == other.SubBlockDirective &&
+			CurBlockDirective == other.CurBlockDirective && bBranchDestination == other.bBranchDestination &&
+			Operation == other.Operation && Comment == other.Comment && CommentBlock == other.CommentBlock && Label == other.Label;
+	}
+};
+
+struct FTokenizedEquate
+{
+	std::string	Label;
+	uint16_t	Address = 0;
+
+	bool operator==(const FTokenizedEquate& other) const { return Label == other.Label && Address == other.Address; }
+};
+
+std::ostream& operator<<(std::ostream& os, const FTokenizedInstruction& instruction)
+{
+	return os << instruction.Address << " '" << instruction.Operation << "' comment '" << instruction.Comment << "' block '" << instruction.CommentBlock << "' label '" << instruction.Label << "'";
+}
+
+std::ostream& operator<<(std::ostream& os, const FTokenizedEquate& equate)
+{
+	return os << equate.Label << "=" << equate.Address;
+}
+
+// New tokenizer
+class FTestTokenHandler : public ISkoolkitTokenHandler
+{
+public:
+	void OnEquate(std::string_view label, uint16_t address) override
+	{
+		FTokenizedEquate& equate = Equates.emplace_back();
+		equate.Label = label;
+		equate.Address = address;
+	}
+
+	void OnInstructions(std::vector<FSkoolkitInstruction>& instructions) override
+	{
+		NoPages++;
+		for (const FSkoolkitInstruction& instruction : instructions)
+		{
+			FTokenizedInstruction& result = Instructions.emplace_back();
+			result.Address = instruction.Address;
+			result.BlockDirective = instruction.BlockDirective;
+			result.SubBlockDirective = instruction.SubBlockDirective;
+			result.CurBlockDirective = instruction.CurBlockDirective;
+			result.bBranchDestination = instruction.bBranchDestination;
+			result.Operation = instruction.Operation;
+			result.Comment = instruction.Comment;
+			for (std::string_view continuation : instruction.CommentContinuations)
+				AppendCommentContinuation(result.Comment, continuation);
+			result.CommentBlock = instruction.CommentBlock;
+			result.Label = instruction.Label;
+		}
+	}
+
+	std::vector<FTokenizedInstruction>	Instructions;
+	std::vector<FTokenizedEquate>		Equates;
+	int									NoPages = 0;
+};
+
+// Reference - the tokenizing part of the old importer, which copied each line read with fgets
+namespace SkoolkitReference
+{
+	const std::string kWhiteSpace = " \n\r\t\f\v";
+
+	std::string TrimLeadingChars(const std::string& str, const std::string& charsToTrim)
+	{
+		size_t start = str.find_first_not_of(charsToTrim);
+		return (start == std::string::npos) ? "" : str.substr(start);
+	}
+
+	void RemoveCarriageReturn(std::string& str)
+	{
+		if (str.empty())
+			return;
+		if (str.back() == '\n' || str.back() == '\r')
+			str.pop_back();
+	}
+
+	bool StringStartsWith(const std::string& str, const std::string& substring)
+	{
+		return (str.rfind(substring, 0) == 0);
+	}
+
+	char GetDirectiveFromAsm(const std::string& str)
+	{
+		if (StringStartsWith(str, "DEF") || StringStartsWith(str, "def"))
+		{
+			if (str[3] == 'B' || str[3] == 'b')
+				return 'b';
+			if (str[3] == 'W' || str[3] == 'w')
+				return 'w';
+			if (str[3] == 'M' || str[3] == 'm')
+				return 't';
+			if (str[3] == 'S' || str[3] == 's')
+				return 'b';
+		}
+		return 'c';
+	}
+
+	bool ParseInstruction(std::string strLine, FTokenizedInstruction& instruction)
+	{
+		if (strLine.length() < 6)
+			return false;
+
+		if (strLine[0] == '*')
+			instruction.bBranchDestination = true;
+		else if (strLine[0] != ' ')
+			instruction.BlockDirective = strLine[0];
+
+		if (strLine[1] == '$')
+		{
+			std::string numStr = strLine.substr(2, 4);
+			instruction.Address = static_cast<uint16_t>(strtol(numStr.c_str(), nullptr, 16));
+			if (instruction.Address == 0 && numStr != "0000")
+				return false;
+		}
+		else
+		{
+			std::string numStr = strLine.substr(1, 5);
+			instruction.Address = static_cast<uint16_t>(strtol(numStr.c_str(), nullptr, 10));
+			if (instruction.Address == 0 && numStr != "00000")
+				return false;
+		}
+
+		const size_t opStart = 7;
+		size_t opLen = std::string::npos;
+
+		const size_t semicolonPos = strLine.find_first_of(';');
+		if (semicolonPos != std::string::npos)
+		{
+			opLen = semicolonPos - opStart;
+
+			size_t strLen = strLine.length();
+			size_t commentStart = semicolonPos + 2;
+
+			if (commentStart == strLen)
+			{
+				instruction.Comment = "\n";
+			}
+			else if (commentStart < strLen)
+			{
+				instruction.Comment = strLine.substr(commentStart);
+				RemoveCarriageReturn(instruction.Comment);
+			}
+		}
+
+		if (semicolonPos != std::string::npos)
+		{
+			size_t opEnd = strLine.find_last_not_of(' ', semicolonPos - 1);
+			if (opEnd != std::string::npos)
+				opLen = opEnd + 1 - opStart;
+		}
+
+		instruction.Operation = strLine.substr(opStart, opLen);
+		RemoveCarriageReturn(instruction.Operation);
+
+		instruction.SubBlockDirective = GetDirectiveFromAsm(instruction.Operation);
+		return true;
+	}
+
+	bool ParseAsmDirective(const std::string& strLine, std::string& label, std::vector<FTokenizedEquate>& equates)
+	{
+		if (StringStartsWith(strLine, "@label="))
+		{
+			size_t eqLoc = strLine.find('=');
+			if (eqLoc != std::string::npos)
+			{
+				label = strLine.substr(eqLoc + 1);
+				if (label.back() == '\n' || label.back() == '\r')
+					label.pop_back();
+			}
+			return true;
+		}
+		else if (StringStartsWith(strLine, "@equ="))
+		{
+			size_t eqLoc = strLine.find('=');
+			if (eqLoc != std::string::npos)
+			{
+				std::string str = strLine.substr(eqLoc + 1);
+				eqLoc = str.find('=');
+				if (eqLoc != std::string::npos)
+				{
+					std::string labelStr = str.substr(0, eqLoc);
+					std::string addressStr = str.substr(eqLoc + 1);
+					if (addressStr[0] == '$')
+					{
+						addressStr = addressStr.substr(1, 4);
+						equates.push_back({ labelStr, static_cast<uint16_t>(std::stoul(addressStr, nullptr, 16)) });
+					}
+					return false;
+				}
+			}
+		}
+		return false;
+	}
+
+	bool Tokenize(const std::string& text, std::vector<FTokenizedInstruction>& instructions, std::vector<FTokenizedEquate>& equates)
+	{
+		char blockDirective = kSkoolkitDirectiveNone;
+		char subBlockDirective = kSkoolkitDirectiveNone;
+		std::string comments;
+		std::string label;
+		bool bInRsubSection = false;
+
+		size_t lineStart = 0;
+		while (lineStart < text.size())
+		{
+			// what fgets would give us
+			const size_t lineEnd = text.find('\n', lineStart);
+			const size_t lineLen = lineEnd == std::string::npos ? std::string::npos : lineEnd + 1 - lineStart;
+			std::string strLine = text.substr(lineStart, lineLen);
+			lineStart = lineEnd == std::string::npos ? text.size() : lineEnd + 1;
+
+			if (bInRsubSection)
+			{
+				if (StringStartsWith(strLine, "@rsub+end"))
+					bInRsubSection = false;
+				continue;
+			}
+
+			if (strLine[0] == '@')
+			{
+				if (!ParseAsmDirective(strLine, label, equates))
+					comments += strLine;
+				if (StringStartsWith(strLine, "@rsub+begin"))
+					bInRsubSection = true;
+				continue;
+			}
+
+			if (strLine[0] == ';')
+			{
+				comments += TrimLeadingChars(strLine, "; ");
+				continue;
+			}
+
+			std::string trimmed = TrimLeadingChars(strLine, kWhiteSpace);
+			if (trimmed[0] == ';')
+			{
+				if (!instructions.empty())
+				{
+					std::string& comment = instructions.back().Comment;
+					if (!comment.empty() && comment.back() != '\n')
+						comment += "\n";
+					comment += trimmed.substr(2);
+					RemoveCarriageReturn(comment);
+				}
+				continue;
+			}
+
+			if (trimmed.empty())
+				continue;
+
+			FTokenizedInstruction instruction;
+			if (!ParseInstruction(strLine, instruction))
+				return false;
+			if (!instructions.empty() && instruction.Address < instructions.back().Address)
+				return false;
+
+			if (instruction.BlockDirective != kSkoolkitDirectiveNone && blockDirective != instruction.BlockDirective)
+			{
+				blockDirective = instruction.BlockDirective;
+				subBlockDirective = instruction.SubBlockDirective;
+			}
+			if (instruction.SubBlockDirective != subBlockDirective)
+				subBlockDirective = instruction.SubBlockDirective;
+
+			instruction.CurBlockDirective = blockDirective;
+			instruction.CommentBlock = comments;
+			comments.clear();
+			instruction.Label = label;
+			label.clear();
+			instructions.push_back(instruction);
+		}
+		return true;
+	}
+}
+
+static const char* kSkoolFixture =
+	"@start\n"
+	"@org=32768\n"
+	"@equ=KSTATE=$5C00\n"
+	"@equ=FLAGS=$5C3B\n"
+	"; Main entry point\n"
+	";\n"
+	"; Sets things up and jumps to the game loop.\n"
+	"@label=START\n"
+	"c32768 DI                  ; Disable interrupts\n"
+	"*32769 LD SP,$FFFF         ; Set the stack\n"
+	"                           ; right at the top of memory\n"
+	"                           ;\n"
+	"                           ; \n"
+	"                           ; and carry on\n"
+	" 32772 CALL 32800\n"
+	" 32775 JR 32769            ;\n"
+	"\n"
+	"; Game state\n"
+	"@label=LIVES\n"
+	"g32777 DEFB 3              ; Lives {\n"
+	" 32778 DEFB 0              ;\n"
+	" 32779 DEFB 0,0,0          ; }\n"
+	" 32782 DEFW 0,32768        ; Pointers\n"
+	"\n"
+	"@rsub+begin\n"
+	"       LD A,1\n"
+	"@rsub+end\n"
+	"; Messages\n"
+	"t32786 DEFM \"Hello; world\" ; Greeting\n"
+	" 32798 DEFB 0\n"
+	"s32799 DEFS 1\n"
+	"; Routine in another page\n"
+	"@label=SUB\n"
+	"c32800 LD A,(32777)        ; Get lives\n"
+	" 32803 DEC A\n"
+	"*32804 RET Z\n"
+	" 32805 RET\n"
+	"u33792 NOP                 ; unused\n"
+	" 33793 NOP\n"
+	"b$8500 DEFB 255\n"
+	" $8501 defw 1234           ; lower case\n"
+	"i$8503 LD A,B\n";
+
+static void TokenizeBoth(const std::string& text, FTestTokenHandler& handler, std::vector<FTokenizedInstruction>& refInstructions, std::vector<FTokenizedEquate>& refEquates)
+{
+	ASSERT_TRUE(SkoolkitReference::Tokenize(text, refInstructions, refEquates));
+	ASSERT_TRUE(TokenizeSkoolKitText(text, handler));
+}
+
+TEST(SkoolkitImporterTest, TokenizerMatchesReference)
+{
+	FTestTokenHandler handler;
+	std::vector<FTokenizedInstruction> refInstructions;
+	std::vector<FTokenizedEquate> refEquates;
+	TokenizeBoth(kSkoolFixture, handler, refInstructions, refEquates);
+
+	EXPECT_EQ(refInstructions.size(), 20u);
+	EXPECT_EQ(handler.Instructions, refInstructions);
+	EXPECT_EQ(handler.Equates, refEquates);
+	EXPECT_EQ(handler.NoPages, 2);	// $8000 & $8400 pages
+}
+
+TEST(SkoolkitImporterTest, TokenizerHandlesWindowsLineEndings)
+{
+	std::string crlfText;
+	for (const char* pChar = kSkoolFixture; *pChar != 0; pChar++)
+	{
+		if (*pChar == '\n')
+			crlfText += '\r';
+		crlfText += *pChar;
+	}
+
+	FTestTokenHandler lfHandler, crlfHandler;
+	ASSERT_TRUE(TokenizeSkoolKitText(kSkoolFixture, lfHandler));
+	ASSERT_TRUE(TokenizeSkoolKitText(crlfText, crlfHandler));
+	EXPECT_EQ(lfHandler.Instructions, crlfHandler.Instructions);
+	EXPECT_EQ(lfHandler.Equates, crlfHandler.Equates);
+}
+
+TEST(SkoolkitImporterTest, TokenizerStopsOnErrors)
+{
+	// instructions before the error still get handed over
+	FTestTokenHandler handler;
+	EXPECT_FALSE(TokenizeSkoolKitText("c32768 NOP\n 32769 NOP\n 3276 NOP\n", handler));
+	EXPECT_EQ(handler.Instructions.size(), 2u);
+
+	FTestTokenHandler badAddressHandler;
+	EXPECT_FALSE(TokenizeSkoolKitText("c32768 NOP\n xyzzy NOP\n", badAddressHandler));
+	EXPECT_EQ(badAddressHandler.Instructions.size(), 1u);
+}
+
+TEST(SkoolkitImporterTest, EmptyFile)
+{
+	FTestTokenHandler handler;
+	EXPECT_TRUE(TokenizeSkoolKitText(std::string_view(), handler));
+	EXPECT_TRUE(handler.Instructions.empty());
+	EXPECT_EQ(handler.NoPages, 0);
+
+	// empty files load as an empty buffer rather than failing
+	const char* pFileName = "SkoolkitImporterTest_Empty.skool";
+	FILE* fp = fopen(pFileName, "wb");
+	ASSERT_NE(fp, nullptr);
+	fclose(fp);
+
+	size_t fileSize = 1;
+	void* pFileData = LoadBinaryFile(pFileName, fileSize);
+	EXPECT_NE(pFileData, nullptr);
+	EXPECT_EQ(fileSize, 0u);
+	free(pFileData);
+	remove(pFileName);
+}
+
+// a few MB of skool file covering the 64K address space
+static std::string GenerateSkoolText()
+{
+	std::string text;
+	char line[128];
+	for (int address = 16384; address < 65536; address++)
+	{
+		if ((address & 63) == 0)
+		{
+			snprintf(line, sizeof(line), "; Routine at %d\n;\n; Does something useful with the data at %d.\n@label=ROUTINE_%d\n", address, address + 1, address);
+			text += line;
+			snprintf(line, sizeof(line), "c%05d LD HL,%-13d ; Point at the data\n", address, address + 1);
+		}
+		else if ((address & 63) < 48)
+		{
+			snprintf(line, sizeof(line), " %05d LD A,(HL)           ; Get the next byte from %d\n", address, address);
+		}
+		else
+		{
+			snprintf(line, sizeof(line), " %05d DEFB %d,%d,%d        ; Data\n                           ; continued\n", address, address & 255, (address >> 8) & 255, 0);
+		}
+		text += line;
+	}
+	return text;
+}
+
+// Benchmark - run with --gtest_also_run_disabled_tests
+TEST(SkoolkitImporterTest, DISABLED_Benchmark)
+{
+	using FClock = std::chrono::steady_clock;
+	const std::string text = GenerateSkoolText();
+	const int kNoRuns = 10;
+
+	std::vector<FTokenizedInstruction> refInstructions;
+	std::vector<FTokenizedEquate> refEquates;
+	FClock::time_point start = FClock::now();
+	for (int i = 0; i < kNoRuns; i++)
+	{
+		refInstructions.clear();
+		refEquates.clear();
+		SkoolkitReference::Tokenize(text, refInstructions, refEquates);
+	}
+	const double refMs = std::chrono::duration<double, std::milli>(FClock::now() - start).count() / kNoRuns;
+
+	// count only - the reference doesn't build the results the importer does
+	class FCountingHandler : public ISkoolkitTokenHandler
+	{
+	public:
+		void OnEquate(std::string_view label, uint16_t address) override {}
+		void OnInstructions(std::vector<FSkoolkitInstruction>& instructions) override { NoInstructions += instructions.size(); }
+		size_t NoInstructions = 0;
+	};
+
+	FCountingHandler handler;
+	start = FClock::now();
+	for (int i = 0; i < kNoRuns; i++)
+	{
+		handler.NoInstructions = 0;
+		TokenizeSkoolKitText(text, handler);
+	}
+	const double newMs = std::chrono::duration<double, std::milli>(FClock::now() - start).count() / kNoRuns;
+
+	printf("%.1fMB skool file, %zu instructions\n", text.size() / (1024.0 * 1024.0), handler.NoInstructions);
+	printf("reference tokenizer      %.2fms\n", refMs);
+	printf("tokenizer                %.2fms\n", newMs);
+	EXPECT_EQ(handler.NoInstructions, refInstructions.size());
+
+	// and check they agree on the big file too
+	FTestTokenHandler checkHandler;
+	TokenizeSkoolKitText(text, checkHandler);
+	EXPECT_EQ(checkHandler.Instructions, refInstructions);
+}
@@ -357,9 +357,32 @@ void OutputInstructionTooltip(FCodeAnalysisState& state, uint16_t addr)
 
 }
 
+// show the range of values the registers have had when the instruction was executed
+static void DrawRegisterProfile6502(FCodeAnalysisState& state, uint16_t addr)
+{
+	const FRegisterProfile* pProfile = state.RegisterProfiler.GetProfile(state.GetCodeInfoForPhysicalAddress(addr));
+	if (pProfile == nullptr)
+		return;
+
+	ImGui::Separator();
+	ImGui::Text("Values over %u executions", pProfile->SampleCount);
+
+	static const char* regNames[] = { "A", "X", "Y", "S" };
+	const uint8_t opcode = state.ReadByte(addr);
+	const bool bStackOp = opcode == 0x08 || opcode == 0x28 || opcode == 0x48 || opcode == 0x68 ||	// PHP, PLP, PHA, PLA
+		opcode == 0x20 || opcode == 0x40 || opcode == 0x60 || opcode == 0x9A || opcode == 0xBA;	// JSR, RTI, RTS, TXS, TSX
+	const int noRegs = bStackOp ? E6502ProfileReg::Count : E6502ProfileReg::S;
+	for (int regNo = 0; regNo < noRegs; regNo++)
+	{
+		const std::string profileStr = GetRegisterProfileString(pProfile->Registers[regNo], regNames[regNo], true);
+		ImGui::TextUnformatted(profileStr.c_str());
+	}
+}
+
 void ShowCodeToolTip6502(FCodeAnalysisState& state, uint16_t addr)
 {
 	ImGui::BeginTooltip();
 	OutputInstructionTooltip(state,addr);
+	DrawRegisterProfile6502(state, addr);
 	ImGui::EndTooltip();
 }
\ No newline at end of file
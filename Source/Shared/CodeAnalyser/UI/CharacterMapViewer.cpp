@@ -7,6 +7,7 @@
 #include "CodeAnalyserUI.h"
 
 #include <cmath>
+#include <algorithm>
 #include <ImGuiSupport/ImGuiScaling.h>
 #include "UIColours.h"
 #include "ComboBoxes.h"
@@ -194,6 +195,115 @@ void FCharacterMapViewer::DrawCharacterSetViewer()
 	ImGui::EndChild();
 }
 
+static const int kMaxCachedCharMapSize = 256;	// in chars - bigger maps get drawn directly
+static const int kCharMapReadInterval = 50;	// updates between full reads - catches writes the analyser doesn't see e.g. tape fast loading
+static const int kAccessHighlightFrames = 32;	// read/write highlights fade out over this many frames
+
+static bool IsSameCharMapLayout(const FCharMapCreateParams& a, const FCharMapCreateParams& b)
+{
+	return a.Address == b.Address && a.Width == b.Width && a.Height == b.Height && a.Stride == b.Stride &&
+		a.CharacterSet == b.CharacterSet && a.IgnoreCharacter == b.IgnoreCharacter;
+}
+
+// Redraw the cells which have changed into the cached view
+// Memory is only looked at when a page the map comes from has been written to or the character set has changed
+// returns false if the map can't be cached
+bool FCharacterMapViewer::UpdateCharacterMapCache(const FCharMapCreateParams& params, const FCharacterSet* pCharSet)
+{
+	FCodeAnalysisState& state = pEmulator->GetCodeAnalysis();
+	FCharacterMapRenderCache& cache = MapCache;
+
+	if (pCharSet == nullptr || params.Width <= 0 || params.Height <= 0 || params.Width > kMaxCachedCharMapSize || params.Height > kMaxCachedCharMapSize)
+		return false;
+
+	const int noCells = params.Width * params.Height;
+	bool bRedrawAll = IsSameCharMapLayout(params, cache.Params) == false || cache.OffsetX != UIState.OffsetX || cache.OffsetY != UIState.OffsetY ||
+		cache.pCharSet != pCharSet || (int)cache.CellValues.size() != noCells;
+	if (cache.View == nullptr || cache.View->GetWidth() != params.Width * 8 || cache.View->GetHeight() != params.Height * 8)
+	{
+		delete cache.View;
+		cache.View = new FGraphicsView(params.Width * 8, params.Height * 8);
+		bRedrawAll = true;
+	}
+
+	// pages the cells come from
+	const uint16_t startAddress = params.Address.Address + UIState.OffsetX + (UIState.OffsetY * params.Stride);
+	std::vector<const FCodeAnalysisPage*>& pages = cache.PagesScratch;
+	pages.clear();
+	for (int y = 0; y < params.Height; y++)
+	{
+		const uint16_t lineAddress = startAddress + (y * params.Stride);
+		for (int addr = lineAddress & ~FCodeAnalysisPage::kPageMask; addr < lineAddress + params.Width; addr += FCodeAnalysisPage::kPageSize)
+		{
+			const FCodeAnalysisPage* pPage = state.GetReadPage((uint16_t)addr);
+			if (std::find(pages.begin(), pages.end(), pPage) == pages.end())
+				pages.push_back(pPage);
+		}
+	}
+
+	// without access tracking we won't know about writes so always check
+	bool bReadCells = bRedrawAll || state.bRegisterDataAccesses == false || pages != cache.Pages || pCharSet->ImageGeneration != cache.CharSetGeneration;
+	if (++cache.UpdatesSinceRead >= kCharMapReadInterval)
+		bReadCells = true;
+	for (size_t i = 0; i < pages.size() && bReadCells == false; i++)
+	{
+		if (pages[i]->WriteGeneration != cache.PageWriteGenerations[i])
+			bReadCells = true;
+	}
+	if (bReadCells == false)
+		return true;
+
+	if (bRedrawAll)
+	{
+		cache.View->Clear(0);
+		cache.CellValues.assign(noCells, -1);
+		cache.Params = params;
+		cache.OffsetX = UIState.OffsetX;
+		cache.OffsetY = UIState.OffsetY;
+		cache.pCharSet = pCharSet;
+	}
+	cache.UpdatesSinceRead = 0;
+	cache.Pages = pages;
+	cache.PageWriteGenerations.clear();
+	for (const FCodeAnalysisPage* pPage : pages)
+		cache.PageWriteGenerations.push_back(pPage->WriteGeneration);
+
+	const uint32_t* pCharSetPixels = pCharSet->Image->GetPixelBuffer();
+	const int charSetWidth = pCharSet->Image->GetWidth();
+	uint32_t* pMapPixels = cache.View->GetPixelBuffer();
+	const int mapWidth = cache.View->GetWidth();
+	bool bChanged = false;
+
+	for (int y = 0; y < params.Height; y++)
+	{
+		for (int x = 0; x < params.Width; x++)
+		{
+			const uint8_t val = state.ReadByte(startAddress + x + (y * params.Stride));
+			int16_t& cellValue = cache.CellValues[x + (y * params.Width)];
+			if (cellValue == val && pCharSet->GlyphGenerations[val] <= cache.CharSetGeneration)
+				continue;
+
+			cellValue = val;
+			bChanged = true;
+
+			uint32_t* pDest = pMapPixels + (x * 8) + (y * 8 * mapWidth);
+			const uint32_t* pSrc = pCharSetPixels + ((val & 15) * 8) + ((val >> 4) * 8 * charSetWidth);
+			for (int line = 0; line < 8; line++)
+			{
+				if (val == params.IgnoreCharacter)	// empty chars are left clear
+					memset(pDest + (line * mapWidth), 0, 8 * sizeof(uint32_t));
+				else
+					memcpy(pDest + (line * mapWidth), pSrc + (line * charSetWidth), 8 * sizeof(uint32_t));
+			}
+		}
+	}
+
+	cache.CharSetGeneration = pCharSet->ImageGeneration;
+	if (bChanged)
+		cache.View->UpdateTexture();
+	return true;
+}
+
 // this assumes the character map is in address space
 void FCharacterMapViewer::DrawCharacterMap()
 {
@@ -257,11 +367,22 @@ void FCharacterMapViewer::DrawCharacterMap()
 	const uint16_t physAddress = params.Address.Address;
 	const float rectSize = 12.0f * scale * UIState.Scale;
 
-	for (int y = 0; y < params.Height; y++)
+	const bool bCached = UpdateCharacterMapCache(params, pCharSet);
+	if (bCached)
+		dl->AddImage((ImTextureID)MapCache.View->GetTexture(), pos, ImVec2(pos.x + (params.Width * rectSize), pos.y + (params.Height * rectSize)));
+
+	for (int y = 0; y < params.Height && (bCached == false || bShowReadWrites); y++)
 	{
 		for (int x = 0; x < params.Width; x++)
 		{
 			const int byte = (x + UIState.OffsetX) + ((y + UIState.OffsetY) * params.Stride);
+			if (bCached)
+			{
+				// glyphs come from the cache so only recent reads & writes need drawing
+				const FCodeAnalysisPage* pPage = state.GetReadPage(physAddress + byte);
+				if (pPage->LastFrameAccessed == -1 || state.CurrentFrameNo - pPage->LastFrameAccessed >= kAccessHighlightFrames)
+					continue;
+			}
 			const uint8_t val = state.ReadByte(physAddress + byte);
 			FDataInfo* pDataInfo = state.GetReadDataInfoForAddress(physAddress + byte);
 			const int framesSinceWritten = pDataInfo->LastFrameWritten == -1 ? 255 : state.CurrentFrameNo - pDataInfo->LastFrameWritten;
@@ -273,7 +394,7 @@ void FCharacterMapViewer::DrawCharacterMap()
 			ImVec2 rectMin(xp, yp);
 			ImVec2 rectMax(xp + rectSize, yp + rectSize);
 
-			if (val != params.IgnoreCharacter || wBrightVal > 0 || rBrightVal > 0)	// skip empty chars
+			if (bCached == false && (val != params.IgnoreCharacter || wBrightVal > 0 || rBrightVal > 0))	// skip empty chars
 			{
 				
 
@@ -25,6 +25,24 @@ struct FCharacterMapViewerUIState
 	float					Scale = 1.0f;
 };
 
+// Character map drawn into a texture - cells are only redrawn when their value or glyph changes
+struct FCharacterMapRenderCache
+{
+	~FCharacterMapRenderCache() { delete View; }
+
+	FGraphicsView*			View = nullptr;
+	FCharMapCreateParams	Params;	// what the view was drawn with
+	int						OffsetX = 0;
+	int						OffsetY = 0;
+	const FCharacterSet*	pCharSet = nullptr;
+	uint32_t				CharSetGeneration = 0;
+	std::vector<const FCodeAnalysisPage*>	Pages;
+	std::vector<uint32_t>	PageWriteGenerations;
+	std::vector<int16_t>	CellValues;	// -1 if not drawn yet
+	int						UpdatesSinceRead = 0;
+	std::vector<const FCodeAnalysisPage*>	PagesScratch;	// pages the map needs this update
+};
+
 class FCharacterMapViewer : public FViewerBase
 {
 public:
@@ -46,6 +64,7 @@ private:
 	void	DrawCharacterSetViewer(void);
 	void	DrawCharacterMaps(void);
 	void	DrawCharacterMap(void);
+	bool	UpdateCharacterMapCache(const FCharMapCreateParams& params, const FCharacterSet* pCharSet);
 
 	// Viewer setup
 	FCharacterMapGrid*	ViewerGrid = nullptr;
@@ -53,4 +72,5 @@ private:
 	FAddressRef SelectedCharSetAddr;
 	FCharSetCreateParams CharSetParams;
 	FCharacterMapViewerUIState UIState;
+	FCharacterMapRenderCache	MapCache;
 };
\ No newline at end of file
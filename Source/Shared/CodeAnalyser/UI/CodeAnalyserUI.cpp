@@ -16,6 +16,8 @@
 #include <cctype>
 #include "chips/z80.h"
 #include "CodeToolTips.h"
+#include "../Commands/CommandProcessor.h"
+#include "../Commands/RenameLabelCommand.h"
 #include <functional>
 
 #include "UIColours.h"
@@ -418,7 +420,7 @@ void DrawLabelDetails(FCodeAnalysisState &state, FCodeAnalysisViewState& viewSta
 		if (LabelText.empty())
 			LabelText = pLabelInfo->GetName();
 
-		pLabelInfo->ChangeName(LabelText.c_str());
+		DoCommand(state, new FRenameLabelCommand(item.AddressRef, LabelText.c_str()));
 	}
 
 	if(ImGui::Checkbox("Global", &pLabelInfo->Global))
@@ -427,7 +429,7 @@ void DrawLabelDetails(FCodeAnalysisState &state, FCodeAnalysisViewState& viewSta
 			pLabelInfo->LabelType = ELabelType::Function;
 		if (pLabelInfo->LabelType == ELabelType::Function && pLabelInfo->Global == false)
 			pLabelInfo->LabelType = ELabelType::Code;
-		GenerateGlobalInfo(state);
+		UpdateGlobalInfoForAddress(state, item.AddressRef);
 	}
 
 	ImGui::Text("References:");
@@ -556,7 +558,7 @@ void ProcessKeyCommands(FCodeAnalysisState& state, FCodeAnalysisViewState& viewS
 			{
 				FCodeInfo* pCodeItem = static_cast<FCodeInfo*>(cursorItem.Item);
 				pCodeItem->OperandType = EOperandType::Binary;
-				pCodeItem->Text.clear();
+				pCodeItem->bNeedsRewrite = true;
 			}
 		}
 		else if (ImGui::IsKeyPressed((ImGuiKey)state.KeyConfig[(int)EKey::SetItemPointer]))
@@ -573,7 +575,7 @@ void ProcessKeyCommands(FCodeAnalysisState& state, FCodeAnalysisViewState& viewS
 			{
 				FCodeInfo* pCodeItem = static_cast<FCodeInfo*>(cursorItem.Item);
 				pCodeItem->OperandType = EOperandType::Pointer;
-				pCodeItem->Text.clear();
+				pCodeItem->bNeedsRewrite = true;
 			}
 		} 
 		else if (ImGui::IsKeyPressed((ImGuiKey)state.KeyConfig[(int)EKey::SetItemJumpAddress]))
@@ -600,7 +602,7 @@ void ProcessKeyCommands(FCodeAnalysisState& state, FCodeAnalysisViewState& viewS
 			{
 				FCodeInfo* pCodeItem = static_cast<FCodeInfo*>(cursorItem.Item);
 				pCodeItem->OperandType = EOperandType::JumpAddress;
-				pCodeItem->Text.clear();
+				pCodeItem->bNeedsRewrite = true;
 			}
 		}
 		else if (ImGui::IsKeyPressed((ImGuiKey)state.KeyConfig[(int)EKey::SetItemAscii]))
@@ -615,7 +617,7 @@ void ProcessKeyCommands(FCodeAnalysisState& state, FCodeAnalysisViewState& viewS
 			{
 				FCodeInfo* pCodeItem = static_cast<FCodeInfo*>(cursorItem.Item);
 				pCodeItem->OperandType = EOperandType::Ascii;
-				pCodeItem->Text.clear();
+				pCodeItem->bNeedsRewrite = true;
 			}
 		}
 		else if (ImGui::IsKeyPressed((ImGuiKey)state.KeyConfig[(int)EKey::SetItemNumber]))
@@ -633,7 +635,7 @@ void ProcessKeyCommands(FCodeAnalysisState& state, FCodeAnalysisViewState& viewS
 			{
 				FCodeInfo* pCodeItem = static_cast<FCodeInfo*>(cursorItem.Item);
 				pCodeItem->OperandType = EOperandType::SignedNumber;
-				pCodeItem->Text.clear();
+				pCodeItem->bNeedsRewrite = true;
 			}
 		}
 		else if (ImGui::IsKeyPressed((ImGuiKey)state.KeyConfig[(int)EKey::SetItemUnknown]))
@@ -648,7 +650,7 @@ void ProcessKeyCommands(FCodeAnalysisState& state, FCodeAnalysisViewState& viewS
 			{
 				FCodeInfo* pCodeItem = static_cast<FCodeInfo*>(cursorItem.Item);
 				pCodeItem->OperandType = EOperandType::Unknown;
-				pCodeItem->Text.clear();
+				pCodeItem->bNeedsRewrite = true;
 			}
 		}
 		else if (ImGui::IsKeyPressed((ImGuiKey)state.KeyConfig[(int)EKey::AddLabel]))
@@ -774,10 +776,11 @@ void UpdatePopups(FCodeAnalysisState& state, FCodeAnalysisViewState& viewState)
 		ImGui::SetNextItemWidth(50 * ImGui::GetFontSize());
 
 		ImGui::SetKeyboardFocusHere();
-		if (ImGui::InputText("##comment", &cursorItem.Item->Comment, ImGuiInputTextFlags_EnterReturnsTrue))
-		{
+		const bool bEnterPressed = ImGui::InputText("##comment", &cursorItem.Item->Comment, ImGuiInputTextFlags_EnterReturnsTrue);
+		if (ImGui::IsItemEdited())	// the text is edited in place so it's changed even if the popup is dismissed
+			state.SetCodeAnalysisDirty(cursorItem.AddressRef);
+		if (bEnterPressed)
 			ImGui::CloseCurrentPopup();
-		}
 
 		MarkupHelpPopup();
 
@@ -790,11 +793,11 @@ void UpdatePopups(FCodeAnalysisState& state, FCodeAnalysisViewState& viewState)
 		ImGui::SetNextItemWidth(50 * ImGui::GetFontSize());
 
 		ImGui::SetKeyboardFocusHere();
-		if(ImGui::InputTextMultiline("##comment", &cursorItem.Item->Comment,ImVec2(), ImGuiInputTextFlags_EnterReturnsTrue | ImGuiInputTextFlags_CtrlEnterForNewLine))
-		{
+		const bool bEnterPressed = ImGui::InputTextMultiline("##comment", &cursorItem.Item->Comment,ImVec2(), ImGuiInputTextFlags_EnterReturnsTrue | ImGuiInputTextFlags_CtrlEnterForNewLine);
+		if (ImGui::IsItemEdited())
 			state.SetCodeAnalysisDirty(cursorItem.AddressRef);
+		if (bEnterPressed)
 			ImGui::CloseCurrentPopup();
-		}
 
 		MarkupHelpPopup();
 
@@ -810,7 +813,7 @@ void UpdatePopups(FCodeAnalysisState& state, FCodeAnalysisViewState& viewState)
 		std::string LabelText = pLabel->GetName();
 		if (ImGui::InputText("##comment", &LabelText, ImGuiInputTextFlags_EnterReturnsTrue))
 		{
-			pLabel->ChangeName(LabelText.c_str());
+			DoCommand(state, new FRenameLabelCommand(cursorItem.AddressRef, LabelText.c_str()));
 			ImGui::CloseCurrentPopup();
 		}
 		ImGui::SetItemDefaultFocus();
@@ -2022,98 +2025,163 @@ void DrawFormatTab(FCodeAnalysisState& state, FCodeAnalysisViewState& viewState)
 	}
 }
 
-void GenerateFilteredLabelList(FCodeAnalysisState& state, const FLabelListFilter&filter,const std::vector<FCodeAnalysisItem>& sourceLabelList, std::vector<FCodeAnalysisItem>& filteredList)
+static std::string GetFilterTextLower(const FLabelListFilter& filter)
 {
-	filteredList.clear();
-
 	std::string filterTextLower = filter.FilterText;
 	std::transform(filterTextLower.begin(), filterTextLower.end(), filterTextLower.begin(), [](unsigned char c){ return std::tolower(c); });
+	return filterTextLower;
+}
 
-	for (const FCodeAnalysisItem& labelItem : sourceLabelList)
-	{
-		if (labelItem.AddressRef.Address < filter.MinAddress || labelItem.AddressRef.Address > filter.MaxAddress)	// skip min address
-			continue;
+static bool LabelPassesFilter(FCodeAnalysisState& state, const FLabelListFilter& filter, const std::string& filterTextLower, const FCodeAnalysisItem& labelItem)
+{
+	if (labelItem.AddressRef.Address < filter.MinAddress || labelItem.AddressRef.Address > filter.MaxAddress)	// skip min address
+		return false;
 
-		const FCodeAnalysisBank* pBank = state.GetBank(labelItem.AddressRef.BankId);
-		if (pBank)
-		{
-			if (filter.bNoMachineRoms && pBank->bMachineROM)
-				continue;
-		}
-		
-		if (filter.DataType != EDataTypeFilter::All)
+	const FCodeAnalysisBank* pBank = state.GetBank(labelItem.AddressRef.BankId);
+	if (pBank)
+	{
+		if (filter.bNoMachineRoms && pBank->bMachineROM)
+			return false;
+	}
+	
+	if (filter.DataType != EDataTypeFilter::All)
+	{
+		if (const FDataInfo* pDataInfo = state.GetDataInfoForAddress(labelItem.AddressRef))
 		{
-			if (const FDataInfo* pDataInfo = state.GetDataInfoForAddress(labelItem.AddressRef))
+			switch (filter.DataType)
 			{
-				switch (filter.DataType)
-				{
-				case EDataTypeFilter::Pointer:
-					if (pDataInfo->DisplayType != EDataItemDisplayType::Pointer)
-						continue;
-						break;
-				case EDataTypeFilter::Text:
-					if (pDataInfo->DataType != EDataType::Text)
-						continue;
+			case EDataTypeFilter::Pointer:
+				if (pDataInfo->DisplayType != EDataItemDisplayType::Pointer)
+					return false;
 					break;
-				case EDataTypeFilter::Bitmap:
-					if (pDataInfo->DataType != EDataType::Bitmap)
-						continue;
-					break;
-				case EDataTypeFilter::CharacterMap:
-					if (pDataInfo->DataType != EDataType::CharacterMap)
-						continue;
-					break;
-				case EDataTypeFilter::ColAttr:
-					if (pDataInfo->DataType != EDataType::ColAttr)
-						continue;
-					break;
-                default:
-                    break;
-				}
+			case EDataTypeFilter::Text:
+				if (pDataInfo->DataType != EDataType::Text)
+					return false;
+				break;
+			case EDataTypeFilter::Bitmap:
+				if (pDataInfo->DataType != EDataType::Bitmap)
+					return false;
+				break;
+			case EDataTypeFilter::CharacterMap:
+				if (pDataInfo->DataType != EDataType::CharacterMap)
+					return false;
+				break;
+			case EDataTypeFilter::ColAttr:
+				if (pDataInfo->DataType != EDataType::ColAttr)
+					return false;
+				break;
+            default:
+                break;
 			}
 		}
+	}
 
-		const FLabelInfo* pLabelInfo = static_cast<const FLabelInfo*>(labelItem.Item);
-		std::string labelTextLower = pLabelInfo->GetName();
-		std::transform(labelTextLower.begin(), labelTextLower.end(), labelTextLower.begin(), [](unsigned char c){ return std::tolower(c); });
+	const FLabelInfo* pLabelInfo = static_cast<const FLabelInfo*>(labelItem.Item);
+	if (filter.FilterText.empty())
+		return true;
+
+	std::string labelTextLower = pLabelInfo->GetName();
+	std::transform(labelTextLower.begin(), labelTextLower.end(), labelTextLower.begin(), [](unsigned char c){ return std::tolower(c); });
+	return labelTextLower.find(filterTextLower) != std::string::npos;
+}
 
-		if (filter.FilterText.empty() || labelTextLower.find(filterTextLower) != std::string::npos)
+void GenerateFilteredLabelList(FCodeAnalysisState& state, const FLabelListFilter&filter,const std::vector<FCodeAnalysisItem>& sourceLabelList, std::vector<FCodeAnalysisItem>& filteredList)
+{
+	filteredList.clear();
+
+	const std::string filterTextLower = GetFilterTextLower(filter);
+
+	for (const FCodeAnalysisItem& labelItem : sourceLabelList)
+	{
+		if (LabelPassesFilter(state, filter, filterTextLower, labelItem))
 			filteredList.push_back(labelItem);
 	}
 }
 
+// apply the labels that have changed since the filtered list was built, rather than rebuilding it
+// source list is in address order, returns if the filtered list has changed
+bool UpdateFilteredLabelList(FCodeAnalysisState& state, const FLabelListFilter& filter, const std::vector<FCodeAnalysisItem>& sourceLabelList, const std::vector<FAddressRef>& changedLabels, size_t firstChange, std::vector<FCodeAnalysisItem>& filteredList, bool bAddressOrder)
+{
+	const std::string filterTextLower = GetFilterTextLower(filter);
+	bool bChanged = false;
+
+	for (size_t changeIndex = firstChange; changeIndex < changedLabels.size(); changeIndex++)
+	{
+		const FAddressRef addr = changedLabels[changeIndex];
+		auto filteredIt = std::find_if(filteredList.begin(), filteredList.end(), [addr](const FCodeAnalysisItem& item) { return item.AddressRef == addr; });
+		if (filteredIt != filteredList.end())
+		{
+			filteredList.erase(filteredIt);
+			bChanged = true;
+		}
+
+		auto sourceIt = std::lower_bound(sourceLabelList.begin(), sourceLabelList.end(), addr, [](const FCodeAnalysisItem& item, FAddressRef addr) { return item.AddressRef < addr; });
+		if (sourceIt == sourceLabelList.end() || sourceIt->AddressRef != addr)
+			continue;	// no longer in the source list
+		if (LabelPassesFilter(state, filter, filterTextLower, *sourceIt) == false)
+			continue;
+
+		if (bAddressOrder)
+			filteredList.insert(std::lower_bound(filteredList.begin(), filteredList.end(), addr, [](const FCodeAnalysisItem& item, FAddressRef addr) { return item.AddressRef < addr; }), *sourceIt);
+		else
+			filteredList.push_back(*sourceIt);
+		bChanged = true;
+	}
+
+	return bChanged;
+}
+
 void DrawGlobals(FCodeAnalysisState &state, FCodeAnalysisViewState& viewState)
 {
 	if (ImGui::InputText("Filter", &viewState.FilterText))
 	{
 		viewState.GlobalFunctionsFilter.FilterText = viewState.FilterText;
 		viewState.GlobalDataItemsFilter.FilterText = viewState.FilterText;
-		state.bRebuildFilteredGlobalFunctions = true;
-		state.bRebuildFilteredGlobalDataItems = true;
+		viewState.bRebuildFilteredGlobalFunctions = true;
+		viewState.bRebuildFilteredGlobalDataItems = true;
 	}
 	ImGui::SameLine();
 	if (ImGui::Checkbox("ROM", &viewState.ShowROMLabels))
 	{
 		viewState.GlobalFunctionsFilter.bNoMachineRoms = !viewState.ShowROMLabels;
 		viewState.GlobalDataItemsFilter.bNoMachineRoms = !viewState.ShowROMLabels;
-		state.bRebuildFilteredGlobalFunctions = true;
-		state.bRebuildFilteredGlobalDataItems = true;
+		viewState.bRebuildFilteredGlobalFunctions = true;
+		viewState.bRebuildFilteredGlobalDataItems = true;
+	}
+
+	// apply label changes to the filtered lists - they only need a full rebuild when the filters change
+	// or when this view has fallen behind the changes the state keeps
+	bool bGlobalFunctionsChanged = false;
+	const uint32_t lastChangeNo = state.FirstChangedGlobalLabelNo + (uint32_t)state.ChangedGlobalLabels.size();
+	if (viewState.GlobalLabelChangeNo < state.FirstChangedGlobalLabelNo)
+	{
+		viewState.bRebuildFilteredGlobalFunctions = true;
+		viewState.bRebuildFilteredGlobalDataItems = true;
+	}
+	else if (viewState.GlobalLabelChangeNo != lastChangeNo)
+	{
+		const size_t firstChange = viewState.GlobalLabelChangeNo - state.FirstChangedGlobalLabelNo;
+		if (viewState.bRebuildFilteredGlobalFunctions == false)
+			bGlobalFunctionsChanged = UpdateFilteredLabelList(state, viewState.GlobalFunctionsFilter, state.GlobalFunctions, state.ChangedGlobalLabels, firstChange, viewState.FilteredGlobalFunctions, false);
+		if (viewState.bRebuildFilteredGlobalDataItems == false)
+			UpdateFilteredLabelList(state, viewState.GlobalDataItemsFilter, state.GlobalDataItems, state.ChangedGlobalLabels, firstChange, viewState.FilteredGlobalDataItems, true);
 	}
+	viewState.GlobalLabelChangeNo = lastChangeNo;
 
 	if(ImGui::BeginTabBar("GlobalsTabBar"))
 	{
 		if(ImGui::BeginTabItem("Functions"))
 		{	
 			// only constantly sort call frequency
-			bool bSort = viewState.FunctionSortMode == EFunctionSortMode::CallFrequency;	
+			bool bSort = viewState.FunctionSortMode == EFunctionSortMode::CallFrequency || bGlobalFunctionsChanged;	
 			if (ImGui::Combo("Sort Mode", (int*)&viewState.FunctionSortMode, "Location\0Alphabetical\0Call Frequency\0Num References"))
 				bSort = true;
 
-			if (state.bRebuildFilteredGlobalFunctions)
+			if (viewState.bRebuildFilteredGlobalFunctions)
 			{
 				GenerateFilteredLabelList(state, viewState.GlobalFunctionsFilter, state.GlobalFunctions, viewState.FilteredGlobalFunctions);
 				bSort = true;
-				state.bRebuildFilteredGlobalFunctions = false;
+				viewState.bRebuildFilteredGlobalFunctions = false;
 			}
 
 			// sort by execution count
@@ -2132,7 +2200,7 @@ void DrawGlobals(FCodeAnalysisState &state, FCodeAnalysisViewState& viewState)
 						{
 							const FLabelInfo* pLabelA = state.GetLabelForAddress(a.AddressRef);
 							const FLabelInfo* pLabelB = state.GetLabelForAddress(b.AddressRef);
-							return std::string(pLabelA->GetName()) < std::string(pLabelB->GetName());	// dodgy!
+							return pLabelA->GetNameSortKey() < pLabelB->GetNameSortKey();
 						});
 					break;
 				case EFunctionSortMode::CallFrequency:	
@@ -2169,13 +2237,13 @@ void DrawGlobals(FCodeAnalysisState &state, FCodeAnalysisViewState& viewState)
 			if (DrawDataTypeFilterCombo("Data Type", viewState.DataTypeFilter))
 			{
 				viewState.GlobalDataItemsFilter.DataType = viewState.DataTypeFilter;
-				state.bRebuildFilteredGlobalDataItems = true;
+				viewState.bRebuildFilteredGlobalDataItems = true;
 			}
 
-			if (state.bRebuildFilteredGlobalDataItems)
+			if (viewState.bRebuildFilteredGlobalDataItems)
 			{
 				GenerateFilteredLabelList(state, viewState.GlobalDataItemsFilter, state.GlobalDataItems, viewState.FilteredGlobalDataItems);
-				state.bRebuildFilteredGlobalDataItems = false;
+				viewState.bRebuildFilteredGlobalDataItems = false;
 			}
 
 			DrawLabelList(state, viewState, viewState.FilteredGlobalDataItems);
@@ -2210,7 +2278,8 @@ void DrawCaptureTab(FCodeAnalysisState& state, FCodeAnalysisViewState& viewState
 
 void DrawFindTab(FCodeAnalysisState& state, FCodeAnalysisViewState& viewState)
 {
-	bool bActivateFind = ImGui::InputText("##findText", &viewState.FindText, ImGuiInputTextFlags_EnterReturnsTrue);
+	// search as you type - the search index makes this cheap
+	bool bActivateFind = ImGui::InputText("##findText", &viewState.FindText);
 	ImGui::SameLine();
 	bActivateFind |= ImGui::Button("Find");
 	if(bActivateFind)
@@ -135,7 +135,7 @@ bool EditHexDataItem(FCodeAnalysisState& state, uint16_t address)
 	if (ImGui::InputScalar("##hexbyteinput", ImGuiDataType_U8, &val, NULL, NULL, "%02X", ImGuiInputTextFlags_EnterReturnsTrue | ImGuiInputTextFlags_EnterReturnsTrue))
 	{
 		// Write value
-		state.CPUInterface->WriteByte(address, val);
+		state.PokeByte(address, val);
 		bChanged = true;
 	}
 	ImGui::PopStyleVar();
@@ -229,7 +229,7 @@ void DrawCodeInfo(FCodeAnalysisState& state, FCodeAnalysisViewState& viewState,
 	}
 
 	// regenerate code text if it hasn't been generated or SMC
-	if (pCodeInfo->bSelfModifyingCode == true || pCodeInfo->Text.empty())
+	if (pCodeInfo->bSelfModifyingCode == true || pCodeInfo->bNeedsRewrite)
 	{
 		//UpdateCodeInfoForAddress(state, pCodeInfo->Address);
 		WriteCodeInfoForAddress(state, physAddress);
@@ -275,7 +275,7 @@ void DrawCodeInfo(FCodeAnalysisState& state, FCodeAnalysisViewState& viewState,
 			{
 				if (EditHexDataItem(state, physAddress + i))
 				{
-					pCodeInfo->Text.clear();
+					pCodeInfo->bNeedsRewrite = true;
 				}
 			}
 			else
@@ -293,7 +293,7 @@ void DrawCodeInfo(FCodeAnalysisState& state, FCodeAnalysisViewState& viewState,
 	Markup::SetCodeInfo(pCodeInfo);
     const bool bNOPed = state.bAllowEditing && pCodeInfo->bNOPped;
 	ImGui::PushStyleColor(ImGuiCol_Text, bNOPed ? Colours::noppedMnemonic : Colours::mnemonic);
-	const bool bShownTooltip = Markup::DrawText(state,viewState,pCodeInfo->Text.c_str()); // draw the disassembly output for this instruction
+	const bool bShownTooltip = Markup::DrawText(state,viewState,state.DisassemblyCache.GetText(state, item.AddressRef, pCodeInfo).c_str()); // draw the disassembly output for this instruction
 	ImGui::PopStyleColor();
 	Markup::SetCodeInfo(nullptr);
 
@@ -328,7 +328,7 @@ void DrawCodeDetails(FCodeAnalysisState& state, FCodeAnalysisViewState& viewStat
 	const uint16_t physAddress = item.AddressRef.Address;
 
 	if (DrawOperandTypeCombo("Operand Type", pCodeInfo))
-		pCodeInfo->Text.clear();	// clear for a rewrite
+		pCodeInfo->bNeedsRewrite = true;
 
 	//if (pCodeInfo->OperandType == EOperandType::Struct)
 	if(GetInstructionByteOffset(state, item.AddressRef) != -1)
@@ -354,16 +354,16 @@ void DrawCodeDetails(FCodeAnalysisState& state, FCodeAnalysisViewState& viewStat
 				// NOP it out
 				// Note: This is not going to work with ROM
 				if (state.CPUInterface->CPUType == ECPUType::Z80)
-					state.WriteByte(physAddress + i, 0);
+					state.PokeByte(physAddress + i, 0);
 				else if (state.CPUInterface->CPUType == ECPUType::M6502)
-					state.WriteByte(physAddress + i, 0xEA);
+					state.PokeByte(physAddress + i, 0xEA);
 			}
 		}
 		else
 		{
 			// Restore
 			for (int i = 0; i < pCodeInfo->ByteSize; i++)
-				state.WriteByte(physAddress + i, pCodeInfo->OpcodeBkp[i]);
+				state.PokeByte(physAddress + i, pCodeInfo->OpcodeBkp[i]);
 
 		}
 	}
@@ -234,7 +234,7 @@ float DrawDataBitmapLine(FCodeAnalysisState& state, uint16_t addr, const FDataIn
 
 				uint8_t val = state.ReadByte(addr + byteNo);
 				val = val ^ (1 << (7 - bitNo));
-				state.WriteByte(addr + byteNo, val);
+				state.PokeByte(addr + byteNo, val);
 			}
 		}
 	}
@@ -343,7 +343,7 @@ void EditByteDataItem(FCodeAnalysisState& state, uint16_t address)
 	if (ImGui::InputScalar("##dbinput", ImGuiDataType_U8, &val, NULL, NULL, format, flags))
 	{
 		// Write value
-		state.CPUInterface->WriteByte(address, val);
+		state.PokeByte(address, val);
 	}
 	if (numMode == ENumberDisplayMode::HexAitch)
 	{
@@ -390,8 +390,8 @@ void EditWordDataItem(FCodeAnalysisState& state, uint16_t address)
 	if (ImGui::InputScalar("##dwinput", ImGuiDataType_U16, &val, NULL, NULL, format, flags))
 	{
 		// Write value
-		state.CPUInterface->WriteByte(address, val & 255);
-		state.CPUInterface->WriteByte(address + 1, val >> 8);
+		state.PokeByte(address, val & 255);
+		state.PokeByte(address + 1, val >> 8);
 	}
 	if (numMode == ENumberDisplayMode::HexAitch)
 	{
@@ -798,7 +798,9 @@ void DrawDataAccesses(FCodeAnalysisState& state, FCodeAnalysisViewState& viewSta
 				if (pCodeInfo)
 				{
 					if (pCodeInfo->Comment.empty() || bOverride)
-						pCodeInfo->Comment = commentTxt;
+					{
+						state.SetItemComment(reader, pCodeInfo, commentTxt);
+					}
 				}
 			}
 		}
@@ -836,7 +838,9 @@ void DrawDataAccesses(FCodeAnalysisState& state, FCodeAnalysisViewState& viewSta
 				if (pCodeInfo)
 				{
 					if (pCodeInfo->Comment.empty() || bOverride)
-						pCodeInfo->Comment = commentTxt;
+					{
+						state.SetItemComment(writer, pCodeInfo, commentTxt);
+					}
 				}
 			}
 		}
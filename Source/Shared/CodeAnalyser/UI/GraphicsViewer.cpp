@@ -171,7 +171,7 @@ uint32_t GetHeatmapColourForMemoryAddress(const FCodeAnalysisPage& page, uint16_
 	return 0xFFFFFFFF;
 }
 
-void FGraphicsViewer::DrawPhysicalMemoryAsGraphicsColumn(uint16_t memAddr, int xPos, int columnWidth)
+uint16_t FGraphicsViewer::DrawPhysicalMemoryAsGraphicsColumn(uint16_t memAddr, int xPos, int columnWidth)
 {
 	const FCodeAnalysisState& state = GetCodeAnalysis();
 
@@ -237,9 +237,11 @@ void FGraphicsViewer::DrawPhysicalMemoryAsGraphicsColumn(uint16_t memAddr, int x
 			}
 		}
 	}
+
+	return memAddr;
 }
 
-void FGraphicsViewer::DrawPhysicalMemoryAsGraphicsColumnChars(uint16_t memAddr, int xPos, int columnWidth)
+uint16_t FGraphicsViewer::DrawPhysicalMemoryAsGraphicsColumnChars(uint16_t memAddr, int xPos, int columnWidth)
 {
 	const FCodeAnalysisState& state = GetCodeAnalysis();
 
@@ -293,9 +295,11 @@ void FGraphicsViewer::DrawPhysicalMemoryAsGraphicsColumnChars(uint16_t memAddr,
 			}
 		}
 	}
+
+	return memAddr;
 }
 
-void FGraphicsViewer::DrawMemoryBankAsGraphicsColumn(int16_t bankId, uint16_t memAddr, int xPos, int columnWidth)
+uint16_t FGraphicsViewer::DrawMemoryBankAsGraphicsColumn(int16_t bankId, uint16_t memAddr, int xPos, int columnWidth)
 {
 	const FCodeAnalysisState& state = GetCodeAnalysis();
 	const FCodeAnalysisBank* pBank = state.GetBank(bankId);
@@ -351,10 +355,12 @@ void FGraphicsViewer::DrawMemoryBankAsGraphicsColumn(int16_t bankId, uint16_t me
 			}
 		}
 	}
+
+	return memAddr;
 }
 
 // draw columns using 8x8 chars
-void FGraphicsViewer::DrawMemoryBankAsGraphicsColumnChars(int16_t bankId, uint16_t memAddr, int xPos, int columnWidth)
+uint16_t FGraphicsViewer::DrawMemoryBankAsGraphicsColumnChars(int16_t bankId, uint16_t memAddr, int xPos, int columnWidth)
 {
 	const FCodeAnalysisState& state = GetCodeAnalysis();
 	const FCodeAnalysisBank* pBank = state.GetBank(bankId);
@@ -410,6 +416,147 @@ void FGraphicsViewer::DrawMemoryBankAsGraphicsColumnChars(int16_t bankId, uint16
 			}
 		}
 	}
+
+	return memAddr;
+}
+
+// Column cache
+
+static const int kMaxColumnTileAge = 30;	// UI frames - picks up writes the analyser doesn't see e.g. memory editing
+
+static bool IsPageHeatmapLive(const FCodeAnalysisPage* pPage, int currentFrameNo, int frameThreshold)
+{
+	return pPage->LastFrameAccessed != -1 && currentFrameNo - pPage->LastFrameAccessed < frameThreshold;
+}
+
+void FGraphicsViewer::GetColumnPages(const FGraphicsColumnKey& key, int byteCount, std::vector<const FCodeAnalysisPage*>& outPages) const
+{
+	const FCodeAnalysisState& state = GetCodeAnalysis();
+	const FCodeAnalysisBank* pBank = key.BankId == -1 ? nullptr : state.GetBank(key.BankId);
+
+	outPages.clear();
+	for (int addr = key.Address & ~FCodeAnalysisPage::kPageMask; addr < key.Address + byteCount; addr += FCodeAnalysisPage::kPageSize)
+	{
+		if (pBank != nullptr)
+			outPages.push_back(&pBank->Pages[(addr & pBank->SizeMask) >> FCodeAnalysisPage::kPageShift]);
+		else
+			outPages.push_back(state.GetReadPage((uint16_t)addr));	// current mapping
+	}
+}
+
+bool FGraphicsViewer::IsColumnTileValid(const FGraphicsColumnTile& tile)
+{
+	const FCodeAnalysisState& state = GetCodeAnalysis();
+
+	// without access tracking we won't know about writes
+	if (tile.Pixels.empty() || tile.bHeatmapLive || state.bRegisterDataAccesses == false)
+		return false;
+	if (ImGui::GetFrameCount() - tile.RenderUIFrame > kMaxColumnTileAge)
+		return false;
+
+	std::vector<const FCodeAnalysisPage*>& pages = ColumnPagesScratch;
+	GetColumnPages(tile.Key, tile.ByteCount, pages);
+	if (pages != tile.Pages)	// mapping has changed
+		return false;
+
+	const bool bHeatmap = tile.Key.BitmapFormat == EBitmapFormat::Bitmap_1Bpp;
+	for (size_t i = 0; i < pages.size(); i++)
+	{
+		if (pages[i]->WriteGeneration != tile.PageWriteGenerations[i])
+			return false;
+		if (bHeatmap && IsPageHeatmapLive(pages[i], state.CurrentFrameNo, HeatmapThreshold))
+			return false;
+	}
+
+	return true;
+}
+
+FGraphicsColumnTile& FGraphicsViewer::GetColumnTile(const FGraphicsColumnKey& key)
+{
+	FGraphicsColumnTile* pTile = nullptr;
+	for (FGraphicsColumnTile& tile : ColumnTiles)
+	{
+		if (tile.Key == key)
+		{
+			pTile = &tile;
+			break;
+		}
+	}
+
+	if (pTile == nullptr)
+	{
+		if (ColumnTiles.size() < kMaxColumnTiles)
+		{
+			pTile = &ColumnTiles.emplace_back();
+		}
+		else	// reuse least recently used
+		{
+			pTile = &ColumnTiles[0];
+			for (FGraphicsColumnTile& tile : ColumnTiles)
+			{
+				if (tile.LastUsed < pTile->LastUsed)
+					pTile = &tile;
+			}
+		}
+		pTile->Key = key;
+		pTile->Pixels.clear();
+	}
+
+	pTile->LastUsed = ++ColumnTileUseCount;
+	return *pTile;
+}
+
+// draw a column of the memory view, using the cached pixels if the memory hasn't changed
+void FGraphicsViewer::DrawCachedGraphicsColumn(const FGraphicsColumnKey& key, int columnNo, int xPos, int columnWidth, int columnWidthPixels)
+{
+	const FCodeAnalysisState& state = GetCodeAnalysis();
+	FGraphicsColumnTile& tile = GetColumnTile(key);
+	const int viewWidth = pGraphicsView->GetWidth();
+	const int viewHeight = pGraphicsView->GetHeight();
+	uint32_t* pViewPixels = pGraphicsView->GetPixelBuffer() + xPos;
+
+	if (IsColumnTileValid(tile))
+	{
+		if (DisplayedColumns[columnNo] != key)
+		{
+			for (int y = 0; y < viewHeight; y++)
+				memcpy(pViewPixels + (y * viewWidth), &tile.Pixels[y * columnWidthPixels], columnWidthPixels * sizeof(uint32_t));
+			DisplayedColumns[columnNo] = key;
+			bGraphicsViewDirty = true;
+		}
+		return;
+	}
+
+	for (int y = 0; y < viewHeight; y++)
+		std::fill(pViewPixels + (y * viewWidth), pViewPixels + (y * viewWidth) + columnWidthPixels, 0xff000000);
+
+	const bool bChars = key.ViewMode == EGraphicsViewMode::BitmapChars;
+	uint16_t endAddress = 0;
+	if (key.BankId == -1)
+		endAddress = bChars ? DrawPhysicalMemoryAsGraphicsColumnChars(key.Address, xPos, columnWidth) : DrawPhysicalMemoryAsGraphicsColumn(key.Address, xPos, columnWidth);
+	else
+		endAddress = bChars ? DrawMemoryBankAsGraphicsColumnChars(key.BankId, key.Address, xPos, columnWidth) : DrawMemoryBankAsGraphicsColumn(key.BankId, key.Address, xPos, columnWidth);
+
+	tile.RenderUIFrame = ImGui::GetFrameCount();
+	tile.ByteCount = (uint16_t)(endAddress - key.Address);
+	if (tile.ByteCount == 0)	// wrapped all the way round
+		tile.ByteCount = 0x10000;
+	tile.Pixels.resize(columnWidthPixels * viewHeight);
+	for (int y = 0; y < viewHeight; y++)
+		memcpy(&tile.Pixels[y * columnWidthPixels], pViewPixels + (y * viewWidth), columnWidthPixels * sizeof(uint32_t));
+
+	GetColumnPages(key, tile.ByteCount, tile.Pages);
+	tile.PageWriteGenerations.clear();
+	tile.bHeatmapLive = false;
+	for (const FCodeAnalysisPage* pPage : tile.Pages)
+	{
+		tile.PageWriteGenerations.push_back(pPage->WriteGeneration);
+		if (key.BitmapFormat == EBitmapFormat::Bitmap_1Bpp)
+			tile.bHeatmapLive |= IsPageHeatmapLive(pPage, state.CurrentFrameNo, HeatmapThreshold);
+	}
+
+	DisplayedColumns[columnNo] = key;
+	bGraphicsViewDirty = true;
 }
 
 // WIP
@@ -487,43 +634,54 @@ void FGraphicsViewer::UpdateCharacterGraphicsViewerImage(void)
 	GraphicColumnSizeBytes = xSizeChars * ycount * YSizePixels * bpp;
 	const int columnWidthPixels = XSizePixels * widthFactor;
 
-	if (ViewMode == EGraphicsViewMode::Bitmap)
+	if (ViewMode == EGraphicsViewMode::Bitmap || ViewMode == EGraphicsViewMode::BitmapChars ||
+		ViewMode == EGraphicsViewMode::MaskedInterleaved || ViewMode == EGraphicsViewMode::MaskedInterleavedZigZag)
 	{
-		for (int x = 0; x < xcount; x++)
+		FGraphicsColumnKey key;
+		key.BankId = bShowPhysicalMemory ? -1 : Bank;
+		key.ViewMode = ViewMode;
+		key.BitmapFormat = BitmapFormat;
+		key.XSizePixels = XSizePixels;
+		key.YSizePixels = YSizePixels;
+		key.ViewScale = ViewScale;
+		key.HeatmapThreshold = HeatmapThreshold;
+		if (BitmapFormatHasPalette(BitmapFormat))
 		{
-			if (bShowPhysicalMemory)
-				DrawPhysicalMemoryAsGraphicsColumn(address, x * columnWidthPixels, xSizeChars);
-			else
-				DrawMemoryBankAsGraphicsColumn(Bank, address & 0x3fff, x * columnWidthPixels, xSizeChars);
-			
-			address += GraphicColumnSizeBytes / widthFactor;
+			const uint32_t* pPaletteColours = GetPaletteFromPaletteNo(PaletteNo);
+			if (pPaletteColours == nullptr)
+				pPaletteColours = GetCurrentPalette();
+			key.PaletteHash = 2166136261u;
+			for (int i = 0; pPaletteColours != nullptr && i < GetNumColoursForBitmapFormat(BitmapFormat); i++)
+				key.PaletteHash = (key.PaletteHash ^ pPaletteColours[i]) * 16777619u;
 		}
-	}
-	else if (ViewMode == EGraphicsViewMode::MaskedInterleaved || ViewMode == EGraphicsViewMode::MaskedInterleavedZigZag)
-	{
-		for (int x = 0; x < xcount; x++)
-		{
-			if (bShowPhysicalMemory)
-				DrawPhysicalMemoryAsGraphicsColumn(address, x * columnWidthPixels, xSizeChars);
-			else
-				DrawMemoryBankAsGraphicsColumn(Bank, address & 0x3fff, x * columnWidthPixels, xSizeChars);
 
-			address += (GraphicColumnSizeBytes * 2) / widthFactor;
+		// start again if the layout has changed
+		if (key != DisplayedLayout || (int)DisplayedColumns.size() != xcount)
+		{
+			pGraphicsView->Clear(0xff000000);
+			DisplayedLayout = key;
+			DisplayedColumns.assign(xcount, FGraphicsColumnKey());
+			bGraphicsViewDirty = true;
 		}
-	}
-	else if (ViewMode == EGraphicsViewMode::BitmapChars)
-	{
+
+		const bool bMasked = ViewMode == EGraphicsViewMode::MaskedInterleaved || ViewMode == EGraphicsViewMode::MaskedInterleavedZigZag;
 		for (int x = 0; x < xcount; x++)
 		{
-			if (bShowPhysicalMemory)
-				DrawPhysicalMemoryAsGraphicsColumnChars(address, x * columnWidthPixels, xSizeChars);
-			else
-				DrawMemoryBankAsGraphicsColumnChars(Bank, address & 0x3fff, x * columnWidthPixels, xSizeChars);
+			key.Address = bShowPhysicalMemory ? address : address & 0x3fff;
+			DrawCachedGraphicsColumn(key, x, x * columnWidthPixels, xSizeChars, columnWidthPixels);
 
-			address += GraphicColumnSizeBytes / widthFactor;
+			address += ((bMasked ? 2 : 1) * GraphicColumnSizeBytes) / widthFactor;
 		}
 	}
-	else if (ViewMode == EGraphicsViewMode::BitmapWinding)
+	else	// other modes are redrawn every frame
+	{
+		pGraphicsView->Clear(0xff000000);
+		DisplayedColumns.clear();
+		DisplayedLayout = FGraphicsColumnKey();
+		bGraphicsViewDirty = true;
+	}
+
+	if (ViewMode == EGraphicsViewMode::BitmapWinding)
 	{
 		const int graphicsUnitSize = (XSizePixels >> 3) * YSizePixels;
 		int offsetX = 0;
@@ -642,7 +800,11 @@ void FGraphicsViewer::DrawCharacterGraphicsViewer(void)
 	const ImVec2 uv0(0, 0);
 	const ImVec2 uv1(1.0f / (float)ViewScale, 1.0f / (float)ViewScale);
 	const ImVec2 size((float)kGraphicsViewerWidth * scale, (float)kGraphicsViewerHeight * scale);
-	pGraphicsView->UpdateTexture();
+	if (bGraphicsViewDirty)	// only upload when columns have been redrawn
+	{
+		pGraphicsView->UpdateTexture();
+		bGraphicsViewDirty = false;
+	}
 	ImGui::Image((void*)pGraphicsView->GetTexture(), size, uv0, uv1);
 
 	if (ImGui::IsItemHovered())
@@ -738,7 +900,6 @@ void FGraphicsViewer::DrawCharacterGraphicsViewer(void)
 
 	// put in config? 
 	//ImGui::SliderInt("Heatmap frame threshold", &viewerState.HeatmapThreshold, 0, 60);
-	pGraphicsView->Clear(0xff000000);
 
 	FCodeAnalysisBank* pClickedBank = state.GetBank(ClickedAddress.BankId);
 	if (pClickedBank != nullptr && state.Config.bShowBanks)
@@ -1068,7 +1229,7 @@ void FGraphicsViewer::DrawGraphicToView(const FGraphicsSet& set, FGraphicsView*
 				{
 					const uint16_t charLine = state.ReadWord(itemAddress);
 					const uint32_t* pPaletteColours = GetPaletteFromPaletteNo(PaletteNo);
-					pGraphicsView->Draw2BppImageAt((uint8_t*)&charLine, x + (xp * 8), y + yp, 8, 1, pPaletteColours ? pPaletteColours : GetCurrentPalette());
+					pView->Draw2BppImageAt((uint8_t*)&charLine, x + (xp * 8), y + yp, 8, 1, pPaletteColours ? pPaletteColours : GetCurrentPalette());
 					state.AdvanceAddressRef(itemAddress, 2);
 					break;
 				}
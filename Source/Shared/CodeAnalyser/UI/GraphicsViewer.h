@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <map>
 #include <string>
+#include <vector>
 #include <CodeAnalyser/CodeAnalyserTypes.h>
 #include <Misc/EmuBase.h>
 
@@ -33,6 +34,41 @@ struct FGraphicsSet
 	int			Count;	// number of images
 };
 
+// what a column of the memory view was drawn with
+struct FGraphicsColumnKey
+{
+	bool operator==(const FGraphicsColumnKey& other) const
+	{
+		return BankId == other.BankId && Address == other.Address && ViewMode == other.ViewMode && BitmapFormat == other.BitmapFormat &&
+			PaletteHash == other.PaletteHash && XSizePixels == other.XSizePixels && YSizePixels == other.YSizePixels &&
+			ViewScale == other.ViewScale && HeatmapThreshold == other.HeatmapThreshold;
+	}
+	bool operator!=(const FGraphicsColumnKey& other) const { return !(*this == other); }
+
+	int16_t				BankId = -1;	// -1 for physical memory
+	uint16_t			Address = 0;
+	EGraphicsViewMode	ViewMode = EGraphicsViewMode::Bitmap;
+	EBitmapFormat		BitmapFormat = EBitmapFormat::None;
+	uint32_t			PaletteHash = 0;	// hash of the palette colours
+	int					XSizePixels = 0;
+	int					YSizePixels = 0;
+	int					ViewScale = 0;
+	int					HeatmapThreshold = 0;
+};
+
+// rendered column of the memory view - reused until a page it covers gets written to
+struct FGraphicsColumnTile
+{
+	FGraphicsColumnKey	Key;
+	uint32_t			LastUsed = 0;
+	int					RenderUIFrame = 0;	// ImGui frame it was drawn on
+	int					ByteCount = 0;	// memory the column covers
+	bool				bHeatmapLive = false;	// recently accessed memory so the heatmap will change
+	std::vector<const FCodeAnalysisPage*>	Pages;	// pages covered & their write generation when drawn
+	std::vector<uint32_t>	PageWriteGenerations;
+	std::vector<uint32_t>	Pixels;
+};
+
 // Graphics Viewer
 class FGraphicsViewer : public FViewerBase
 {
@@ -64,10 +100,15 @@ protected:
 
 	uint16_t		GetAddressOffsetFromPositionInView(int x, int y) const;
 
-	void			DrawPhysicalMemoryAsGraphicsColumn(uint16_t memAddr, int xPos, int columnWidth);
-	void			DrawPhysicalMemoryAsGraphicsColumnChars(uint16_t memAddr, int xPos, int columnWidth);
-	void			DrawMemoryBankAsGraphicsColumn(int16_t bankId, uint16_t memAddr, int xPos, int columnWidth);
-	void			DrawMemoryBankAsGraphicsColumnChars(int16_t bankId, uint16_t memAddr, int xPos, int columnWidth);
+	// these return the address after the column
+	uint16_t		DrawPhysicalMemoryAsGraphicsColumn(uint16_t memAddr, int xPos, int columnWidth);
+	uint16_t		DrawPhysicalMemoryAsGraphicsColumnChars(uint16_t memAddr, int xPos, int columnWidth);
+	uint16_t		DrawMemoryBankAsGraphicsColumn(int16_t bankId, uint16_t memAddr, int xPos, int columnWidth);
+	uint16_t		DrawMemoryBankAsGraphicsColumnChars(int16_t bankId, uint16_t memAddr, int xPos, int columnWidth);
+	void			DrawCachedGraphicsColumn(const FGraphicsColumnKey& key, int columnNo, int xPos, int columnWidth, int columnWidthPixels);
+	bool			IsColumnTileValid(const FGraphicsColumnTile& tile);
+	void			GetColumnPages(const FGraphicsColumnKey& key, int byteCount, std::vector<const FCodeAnalysisPage*>& outPages) const;
+	FGraphicsColumnTile&	GetColumnTile(const FGraphicsColumnKey& key);
 	void			UpdateCharacterGraphicsViewerImage(void); // make virtual for other platforms?
 
 	virtual			const uint32_t* GetCurrentPalette() const { return nullptr; }
@@ -110,6 +151,15 @@ protected:
 	int				ItemNo = 0;
 	FAddressRef		ImageGraphicSet;
 	FGraphicsView* pItemView = nullptr;
+
+	// column cache
+	static const int kMaxColumnTiles = 256;
+	std::vector<FGraphicsColumnTile>	ColumnTiles;
+	std::vector<FGraphicsColumnKey>		DisplayedColumns;	// what's in the graphics view now, per column
+	FGraphicsColumnKey					DisplayedLayout;	// settings the view was laid out with
+	uint32_t		ColumnTileUseCount = 0;
+	std::vector<const FCodeAnalysisPage*>	ColumnPagesScratch;	// reused when checking tiles
+	bool			bGraphicsViewDirty = true;	// texture needs uploading
 };
 
 uint32_t GetHeatmapColourForMemoryAddress(const FCodeAnalysisPage& page, uint16_t addr, int currentFrameNo, int frameThreshold);
\ No newline at end of file
@@ -1311,6 +1311,46 @@ void GetToolTipInfoFromOpcodeZ80(uint16_t pc, const FCodeAnalysisState& state, F
 	inst.Title = g_TTZ80TitleBuf;
 }
 
+// show the range of values the registers used by the instruction have had
+static void DrawRegisterProfileZ80(FCodeAnalysisState& state, uint16_t addr, uint32_t regFlags)
+{
+	const FRegisterProfile* pProfile = state.RegisterProfiler.GetProfile(state.GetCodeInfoForPhysicalAddress(addr));
+	if (pProfile == nullptr || regFlags == 0)
+		return;
+
+	struct FProfileReg
+	{
+		uint32_t	Flags;
+		int			ProfileReg;
+		const char*	Name;
+	};
+	static const FProfileReg profileRegs[] =
+	{
+		{ Z80Reg::A, EZ80ProfileReg::A, "A" },
+		{ Z80Reg::B | Z80Reg::C | Z80Reg::BC | Z80Reg::BC_Indirect, EZ80ProfileReg::BC, "BC" },
+		{ Z80Reg::D | Z80Reg::E | Z80Reg::DE | Z80Reg::DE_Indirect, EZ80ProfileReg::DE, "DE" },
+		{ Z80Reg::H | Z80Reg::L | Z80Reg::HL | Z80Reg::HL_Indirect, EZ80ProfileReg::HL, "HL" },
+		{ Z80Reg::IXL | Z80Reg::IXH | Z80Reg::IX | Z80Reg::IX_Indirect | Z80Reg::IX_Indirect_D, EZ80ProfileReg::IX, "IX" },
+		{ Z80Reg::IYL | Z80Reg::IYH | Z80Reg::IY | Z80Reg::IY_Indirect | Z80Reg::IY_Indirect_D, EZ80ProfileReg::IY, "IY" },
+		{ Z80Reg::SP | Z80Reg::SP_Indirect, EZ80ProfileReg::SP, "SP" },
+	};
+
+	bool bHeaderShown = false;
+	for (const FProfileReg& reg : profileRegs)
+	{
+		if ((regFlags & reg.Flags) == 0)
+			continue;
+		if (bHeaderShown == false)
+		{
+			ImGui::Separator();
+			ImGui::Text("Values over %u executions", pProfile->SampleCount);
+			bHeaderShown = true;
+		}
+		const std::string profileStr = GetRegisterProfileString(pProfile->Registers[reg.ProfileReg], reg.Name, reg.ProfileReg == EZ80ProfileReg::A);
+		ImGui::TextUnformatted(profileStr.c_str());
+	}
+}
+
 void ShowCodeToolTipZ80(FCodeAnalysisState& state, uint16_t addr)
 {
 	// Get flags for register usage and try to auto generate a description for the instruction.
@@ -1364,6 +1404,8 @@ void ShowCodeToolTipZ80(FCodeAnalysisState& state, uint16_t addr)
 		
 		ImGui::PopTextWrapPos();
 	}
+
+	DrawRegisterProfileZ80(state, addr, instrInfo.RegFlags);
 	ImGui::EndTooltip();
 }
 
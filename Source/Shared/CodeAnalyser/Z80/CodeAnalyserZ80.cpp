@@ -231,6 +231,20 @@ bool CheckStopInstructionZ80(const FCodeAnalysisState& state, uint16_t pc)
 	}
 }
 
+// registers as they are on entry to the instruction
+void CaptureRegisterProfileSampleZ80(FCodeAnalysisState& state, FCodeInfo* pCodeInfo)
+{
+	const z80_t* pCPU = static_cast<z80_t*>(state.CPUInterface->GetCPUEmulator());
+	uint16_t* pValues = state.RegisterProfiler.AddSample(pCodeInfo);
+	pValues[EZ80ProfileReg::A] = pCPU->a;
+	pValues[EZ80ProfileReg::BC] = pCPU->bc;
+	pValues[EZ80ProfileReg::DE] = pCPU->de;
+	pValues[EZ80ProfileReg::HL] = pCPU->hl;
+	pValues[EZ80ProfileReg::IX] = pCPU->ix;
+	pValues[EZ80ProfileReg::IY] = pCPU->iy;
+	pValues[EZ80ProfileReg::SP] = pCPU->sp;
+}
+
 bool RegisterCodeExecutedZ80(FCodeAnalysisState& state, uint16_t pc, uint16_t oldpc)
 {
 	const ICPUInterface* pCPUInterface = state.CPUInterface;
@@ -377,10 +391,12 @@ bool RegisterCodeExecutedZ80(FCodeAnalysisState& state, uint16_t pc, uint16_t ol
 			FDataInfo* pStackItem = state.GetWriteDataInfoForAddress(stackPointer);	// -2 because SP was recorded before instruction was 	
 			const FCodeInfo* pCodeItem = state.GetCodeInfoForPhysicalAddress(pc);
 
-			if (pCodeItem != nullptr)// && pCodeItem->Comment.empty() == false)
-				pStackItem->Comment = pCodeItem->Comment;
-			else
-				pStackItem->Comment = "";
+			static const std::string kNoComment;
+			const std::string& pushComment = pCodeItem != nullptr ? pCodeItem->Comment : kNoComment;
+
+			// only set when it changes - pushes happen a lot & each set gets re-indexed for search
+			if (pStackItem->Comment != pushComment)
+				state.SetItemComment(state.AddressRefFromPhysicalWriteAddress(stackPointer), pStackItem, pushComment);
 
 			// Format stack data item
 			if (pStackItem->DataType != EDataType::Word)
@@ -481,7 +481,7 @@ uint16_t z80dasm_op(uint16_t pc, dasm_input_t in_cb, dasm_output_t out_cb, void*
 // These functions were added to support the 8bit Analysers
 
 // Helper function to generate the disassembly for a code info item
-uint16_t Z80DisassembleCodeInfoItem(uint16_t pc, FCodeAnalysisState& state, FCodeInfo* pCodeInfo)
+uint16_t Z80DisassembleCodeInfoItem(uint16_t pc, FCodeAnalysisState& state, const FCodeInfo* pCodeInfo, std::string& outText)
 {
 	FAnalysisDasmState dasmState;
 	dasmState.pCodeInfoItem = pCodeInfo;
@@ -489,7 +489,7 @@ uint16_t Z80DisassembleCodeInfoItem(uint16_t pc, FCodeAnalysisState& state, FCod
 	dasmState.CurrentAddress = pc;
 	SetNumberOutput(&dasmState);
 	const uint16_t newPC = z80dasm_op(pc, AnalysisDasmInputCB, AnalysisOutputCB, &dasmState);
-	pCodeInfo->Text = dasmState.Text;
+	outText = std::move(dasmState.Text);
 	SetNumberOutput(nullptr);
 	return newPC;
 }
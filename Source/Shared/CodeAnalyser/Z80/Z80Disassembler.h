@@ -9,7 +9,7 @@ class FCodeAnalysisState;
 class FExportDasmState;
 struct FCodeInfo;
 
-uint16_t Z80DisassembleCodeInfoItem(uint16_t pc, FCodeAnalysisState& state, FCodeInfo* pCodeInfo);
+uint16_t Z80DisassembleCodeInfoItem(uint16_t pc, FCodeAnalysisState& state, const FCodeInfo* pCodeInfo, std::string& outText);
 uint16_t Z80DisassembleGetNextPC(uint16_t pc, FCodeAnalysisState& state, std::vector<uint8_t>& opcodes);
 //std::string Z80GenerateDasmStringForAddress(FCodeAnalysisState& state, uint16_t pc, ENumberDisplayMode hexMode);	// TODO: remove!
 bool Z80GenerateDasmExportString(FExportDasmState& exportState);
@@ -1,9 +1,14 @@
 #include "SkoolFile.h"
 
 #include "Util/Misc.h"
+#include "Util/BufferedFileWriter.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
-#include <sstream>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 FSkoolEntry::~FSkoolEntry()
 {
@@ -20,6 +25,8 @@ FSkoolInstruction* FSkoolEntry::AddInstruction(uint16_t address, const std::stri
 }
 
 
+FSkoolFile::FSkoolFile() = default;
+
 FSkoolFile::~FSkoolFile()
 {
 	for (FSkoolEntry* pEntry : Entries)
@@ -33,90 +40,234 @@ void FSkoolFile::Parse()
 	// todo
 }
 
-int FSkoolFile::WriteLinesToFile(FILE* fp, const std::string& str)
+void FSkoolFile::AppendCommentLines(std::string& outText, const std::string& str)
 {
-	std::stringstream stringStream(str);
-	std::string line;
-	int linesWritten = 0;
-	while (std::getline(stringStream, line, '\n'))
+	std::vector<std::string> lines;
+	Tokenize(str, '\n', lines);
+	for (const std::string& line : lines)
 	{
 		if (!line.empty() && line[0] == '@')
-			fprintf(fp, "%s\n", line.c_str());
+			outText += line;
 		else
-			fprintf(fp, "; %s\n", line.c_str());
-		linesWritten++;
+			outText.append("; ").append(line);
+		outText += '\n';
 	}
-	return linesWritten;
 }
 
-bool FSkoolFile::Export(const char* pFilename, Base base)
+// formatting only reads the entries & labels so it's safe to do from worker threads
+void FSkoolFile::FormatEntry(const FSkoolEntry* pEntry, Base base, std::string& outText) const
 {
-	FILE* fp = fopen(pFilename, "wt");
+	assert(!pEntry->Instructions.empty());
 
-	if (fp == nullptr)
-		return false;
+	std::vector<std::string> commentLines;
+	char addrText[16];
 
-	// go through all the entries and write to disk
-	for (FSkoolEntry* pEntry : Entries)
+	for (const FSkoolInstruction* pInst : pEntry->Instructions)
 	{
-		assert(!pEntry->Instructions.empty());
+		if (!pInst->CommentLines.empty())
+		{
+			AppendCommentLines(outText, pInst->CommentLines);
+		}
+
+		if (const char* pLabel = GetLabel(pInst->Address))
+		{
+			outText.append("@label=").append(pLabel).append("\n");
+		}
 
-		for (FSkoolInstruction* pInst : pEntry->Instructions)
+		if (!pInst->Comment.empty() || !pInst->Operation.empty())
 		{
-			if (!pInst->CommentLines.empty())
+			Tokenize(pInst->Comment, '\n', commentLines);
+
+			// code lines always have a semicolon, even if the comment is empty.
+			// other types only have a semicolon if we have a comment or we're in a brace comment segment.
+			bool bDisplaySemicolon = true;
+			if (pEntry->Type != SkoolDirective::Code && pInst->Comment.empty())
+				bDisplaySemicolon = false;
+
+			for (int i=0; i<commentLines.size(); i++)
 			{
-				WriteLinesToFile(fp, pInst->CommentLines);
+				if (i == 0)
+				{
+					snprintf(addrText, sizeof(addrText), base == Base::Decimal ? "%c%05d " : "%c$%04X ", pInst->CharPrefix, pInst->Address);
+					outText += addrText;
+					outText += pInst->Operation;
+					if (pInst->Operation.length() < 14)
+						outText.append(14 - pInst->Operation.length(), ' ');
+					else if (pInst->Operation.length() > 14)
+						outText += ' ';
+					if (bDisplaySemicolon)
+					{	
+						if (commentLines[i].empty()) 
+							outText += ';';
+						else
+							outText += "; ";
+					}
+					outText.append(commentLines[i]).append("\n");
+				}
+				else
+				{
+					outText.append(20, ' ').append(" ; ").append(commentLines[i]).append("\n");
+				}
 			}
+		}
+	}
+}
+
+// Entries are formatted in parallel into per chunk buffers which are written out in order
+// The threads are started once per export & wait for each batch of chunks
+class FSkoolFormatWorkerPool
+{
+public:
+	FSkoolFormatWorkerPool(const FSkoolFile& skoolFile, int noThreads) : SkoolFile(skoolFile)
+	{
+		for (int i = 0; i < noThreads; i++)
+			Threads.emplace_back(&FSkoolFormatWorkerPool::WorkerMain, this);
+	}
+
+	~FSkoolFormatWorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			bQuit = true;
+		}
+		WorkReady.notify_all();
+		for (std::thread& thread : Threads)
+			thread.join();
+	}
+
+	int GetNoWorkers() const { return (int)Threads.size() + 1; }	// including the calling thread
+
+	// returns when all the chunks have been formatted - the calling thread helps out
+	void FormatChunks(int batchStart, int batchEnd, FSkoolFile::Base base, std::vector<std::string>& chunkText)
+	{
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			BatchStart = batchStart;
+			BatchEnd = batchEnd;
+			NoChunks = (batchEnd - batchStart + FSkoolFile::kEntriesPerChunk - 1) / FSkoolFile::kEntriesPerChunk;
+			Base = base;
+			pChunkText = &chunkText;
+			NextChunk = 0;
+			NoWorkersBusy = (int)Threads.size();
+			JobNo++;
+		}
+		WorkReady.notify_all();
+
+		FormatNextChunks();
+
+		std::unique_lock<std::mutex> lock(Mutex);
+		WorkDone.wait(lock, [this] { return NoWorkersBusy == 0; });
+		pChunkText = nullptr;
+	}
 
-			if (const char* pLabel = GetLabel(pInst->Address))
+private:
+	void FormatNextChunks()
+	{
+		const int noEntries = (int)SkoolFile.Entries.size();
+		for (int chunkNo = NextChunk++; chunkNo < NoChunks; chunkNo = NextChunk++)
+		{
+			std::string& text = (*pChunkText)[chunkNo];
+			text.clear();
+			const int chunkStart = BatchStart + (chunkNo * FSkoolFile::kEntriesPerChunk);
+			const int chunkEnd = std::min(BatchEnd, chunkStart + FSkoolFile::kEntriesPerChunk);
+			for (int entryNo = chunkStart; entryNo < chunkEnd; entryNo++)
 			{
-				fprintf(fp, "@label=%s\n", pLabel);
+				SkoolFile.FormatEntry(SkoolFile.Entries[entryNo], Base, text);
+				if (entryNo != noEntries - 1)
+					text += '\n';
 			}
+		}
+	}
 
-			if (!pInst->Comment.empty() || !pInst->Operation.empty())
+	void WorkerMain()
+	{
+		uint32_t lastJobNo = 0;
+		while (true)
+		{
 			{
-				std::vector<std::string> commentLines;
-				Tokenize(pInst->Comment, '\n', commentLines);
+				std::unique_lock<std::mutex> lock(Mutex);
+				WorkReady.wait(lock, [this, lastJobNo] { return bQuit || JobNo != lastJobNo; });
+				if (bQuit)
+					break;
+				lastJobNo = JobNo;
+			}
 
-				// code lines always have a semicolon, even if the comment is empty.
-				// other types only have a semicolon if we have a comment or we're in a brace comment segment.
-				bool bDisplaySemicolon = true;
-				if (pEntry->Type != SkoolDirective::Code && pInst->Comment.empty())
-					bDisplaySemicolon = false;
+			FormatNextChunks();
 
-				for (int i=0; i<commentLines.size(); i++)
-				{
-					if (i == 0)
-					{
-						fprintf(fp, base == Base::Decimal ? "%c%05d " : "%c$%04X ", pInst->CharPrefix, pInst->Address);
-						fprintf(fp, "%-14s", pInst->Operation.c_str());
-						if (pInst->Operation.length() > 14)
-							fprintf(fp, " ");
-						if (bDisplaySemicolon)
-						{	
-							if (commentLines[i].empty()) 
-								fprintf(fp, ";");
-							else
-								fprintf(fp, "; ");
-						}
-						fprintf(fp, "%s\n", commentLines[i].c_str());
-					}
-					else
-					{
-						fprintf(fp, "%-20s ; %s\n", "", commentLines[i].c_str());
-					}
-				}
-			}
+			std::lock_guard<std::mutex> lock(Mutex);
+			if (--NoWorkersBusy == 0)
+				WorkDone.notify_one();
 		}
+	}
+
+	const FSkoolFile&		SkoolFile;
+	std::vector<std::thread>	Threads;
 
-		if (pEntry != Entries.back())
-			fprintf(fp, "\n");
+	std::mutex				Mutex;
+	std::condition_variable	WorkReady;
+	std::condition_variable	WorkDone;
+	int						BatchStart = 0;
+	int						BatchEnd = 0;
+	int						NoChunks = 0;
+	FSkoolFile::Base		Base = FSkoolFile::Base::Hexadecimal;
+	std::vector<std::string>*	pChunkText = nullptr;
+	std::atomic<int>		NextChunk = { 0 };
+	uint32_t				JobNo = 0;
+	int						NoWorkersBusy = 0;
+	bool					bQuit = false;
+};
+
+bool FSkoolFile::Export(const char* pFilename, Base base)
+{
+	if (BeginExport(pFilename, base) == false)
+		return false;
+
+	while (ExportNextBatch())
+	{
 	}
-	fclose(fp);
 
+	return EndExport();
+}
+
+bool FSkoolFile::BeginExport(const char* pFilename, Base base)
+{
+	if (ExportWriter.Open(pFilename) == false)
+		return false;
+
+	ExportBase = base;
+	NextExportEntry = 0;
+	const int noThreads = std::max(1, (int)std::thread::hardware_concurrency() - 1) - 1;	// the exporting thread is one of them
+	pFormatWorkerPool = std::make_unique<FSkoolFormatWorkerPool>(*this, noThreads);
+	ChunkText.resize(pFormatWorkerPool->GetNoWorkers() * kChunksPerWorker);
 	return true;
 }
 
+// a batch of chunks at a time so we never hold the text for the whole file
+bool FSkoolFile::ExportNextBatch()
+{
+	const int noEntries = (int)Entries.size();
+	if (pFormatWorkerPool == nullptr || NextExportEntry >= noEntries)
+		return false;
+
+	const int batchStart = NextExportEntry;
+	const int batchEnd = std::min(noEntries, batchStart + ((int)ChunkText.size() * kEntriesPerChunk));
+	const int noChunks = (batchEnd - batchStart + kEntriesPerChunk - 1) / kEntriesPerChunk;
+	pFormatWorkerPool->FormatChunks(batchStart, batchEnd, ExportBase, ChunkText);
+
+	for (int chunkNo = 0; chunkNo < noChunks; chunkNo++)
+		ExportWriter.Write(ChunkText[chunkNo]);
+
+	NextExportEntry = batchEnd;
+	return NextExportEntry < noEntries;
+}
+
+bool FSkoolFile::EndExport()
+{
+	pFormatWorkerPool.reset();
+	ChunkText.clear();
+	return ExportWriter.Close();
+}
+
 void FSkoolFile::Dump()
 {
 }
@@ -2,9 +2,14 @@
 
 #include <cstdint>
 #include <map>
+#include <memory>
 #include <vector>
 #include <string>
 
+#include "Util/BufferedFileWriter.h"
+
+class FSkoolFormatWorkerPool;
+
 // Note: Entries in a skoolfile cannot start with ' ' or '*'.
 enum SkoolDirective : unsigned char
 {
@@ -55,6 +60,7 @@ struct FSkoolInstruction
 
 class FSkoolFile
 {
+	friend class FSkoolFormatWorkerPool;
 public:
 	enum class Base
 	{
@@ -62,18 +68,36 @@ public:
 		Hexadecimal,
 	};
 
+	FSkoolFile();
 	~FSkoolFile();
 	void Parse();
 	bool Export(const char* pFilename, Base base);
 
+	// Export a batch of entries at a time - for spreading an export over several frames
+	bool BeginExport(const char* pFilename, Base base);
+	bool ExportNextBatch();	// returns false when all the entries have been written
+	bool EndExport();		// returns false if the file couldn't be written
+	float GetExportProgress() const { return Entries.empty() ? 1.0f : (float)NextExportEntry / (float)Entries.size(); }
+
 	FSkoolEntry* GetEntry(uint16_t address) const;
 	FSkoolEntry* AddEntry(SkoolDirective type, uint16_t address);
 	void AddLabel(uint16_t address, const std::string& label);
 	const char* GetLabel(uint16_t address) const;
 
 private:
-	int WriteLinesToFile(FILE* fp, const std::string& str);
+	static void AppendCommentLines(std::string& outText, const std::string& str);
+	void FormatEntry(const FSkoolEntry* pEntry, Base base, std::string& outText) const;
 	void Dump();
+
+	static const int kEntriesPerChunk = 64;	// entries formatted by a worker at a time
+	static const int kChunksPerWorker = 4;	// chunks in a batch for each worker
+
+	// export in progress
+	FBufferedFileWriter		ExportWriter;
+	Base					ExportBase = Base::Hexadecimal;
+	int						NextExportEntry = 0;
+	std::vector<std::string>	ChunkText;
+	std::unique_ptr<FSkoolFormatWorkerPool>	pFormatWorkerPool;
 	
 	typedef std::map<uint16_t, std::string> TLabelMap;
 	TLabelMap Labels;
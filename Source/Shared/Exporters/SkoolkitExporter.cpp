@@ -1,13 +1,17 @@
 #include "SkoolkitExporter.h"
 #include "CodeAnalyser/CodeAnalyser.h"
+#include "CodeAnalyser/Disassembler.h"
 #include "Debug/DebugLog.h"
 #include "Util/Misc.h"
 
 #include "SkoolFile.h"
 #include "SkoolFileInfo.h"
+#include "Misc/ExportJob.h"
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <cstdio>
 #include <CodeAnalyser/UI/CodeAnalyserUI.h>
 
 bool IsSpectrumChar(char value)
@@ -23,12 +27,30 @@ public:
 		, pSkoolInfo(pSkoolInfo)
 	{
 	}
-	void BuildSkoolFile(uint16_t startAddr, uint16_t endAddr)
+	void BeginSkoolFile(uint16_t startAddr, uint16_t endAddr, FSkoolFile::Base base)
 	{
-		FSkoolEntry* pCurEntry = nullptr;
+		Base = base;
 
-		for (int addr = startAddr; addr <= endAddr;)
+		if (pSkoolInfo)
 		{
+			startAddr = pSkoolInfo->StartAddr;
+			endAddr = pSkoolInfo->EndAddr;
+		}
+
+		StartAddr = startAddr;
+		EndAddr = endAddr;
+		CurAddr = startAddr;
+		pCurEntry = nullptr;
+	}
+
+	// returns false when all the addresses have been added
+	bool BuildNextAddresses(int noAddresses)
+	{
+		const int segmentEnd = std::min(EndAddr, CurAddr + noAddresses - 1);
+
+		while (CurAddr <= segmentEnd)
+		{
+			const int addr = CurAddr;
 			pCodeInfo = State.GetCodeInfoForPhysicalAddress(addr);
 			if (!pCodeInfo || pCodeInfo->bDisabled == true)
 				pDataInfo = State.GetReadDataInfoForAddress(addr);
@@ -48,10 +70,24 @@ public:
 
 			CurSubBlockDirective = addrSubBlockDirective;
 	
-			addr += GetAddrByteSize();
+			CurAddr += GetAddrByteSize();
 		}
+
+		return CurAddr <= EndAddr;
+	}
+
+	float GetProgress() const
+	{
+		return (float)(CurAddr - StartAddr) / (float)(EndAddr - StartAddr + 1);
 	}
 
+	bool WriteSkoolFile(const char* pFilename)
+	{
+		return SkoolFile.Export(pFilename, Base);
+	}
+
+	FSkoolFile& GetSkoolFile() { return SkoolFile; }
+
 	uint16_t GetAddrByteSize() const
 	{
 		if (pCodeInfo != nullptr)
@@ -199,7 +235,7 @@ public:
 			{
 				WriteCodeInfoForAddress(State, addr.Address); // what does this do again?
 				Markup::SetCodeInfo(pCodeInfo);
-				operationText = Markup::ExpandString(State,pCodeInfo->Text.c_str());
+				operationText = Markup::ExpandString(State,GenerateDasmStringForAddress(State, addr.Address, pCodeInfo).c_str());
 				pItem = pCodeInfo;
 			}
 			else if (pDataInfo != nullptr)
@@ -252,19 +288,14 @@ public:
 	
 	bool Export(const char* pFilename, uint16_t startAddr, uint16_t endAddr, FSkoolFile::Base base = FSkoolFile::Base::Hexadecimal)
 	{
-		Base = base;
-		
-		if (pSkoolInfo)
+		BeginSkoolFile(startAddr, endAddr, base);
+		while (BuildNextAddresses(0x10000))
 		{
-			startAddr = pSkoolInfo->StartAddr;
-			endAddr = pSkoolInfo->EndAddr;
 		}
 
-		BuildSkoolFile(startAddr, endAddr);
-
 		//SkoolFile.Dump();
 		
-		return SkoolFile.Export(pFilename, base);
+		return WriteSkoolFile(pFilename);
 	}
 
 	std::string MakeDataAsmText(const FCodeAnalysisItem& item)
@@ -404,6 +435,10 @@ public:
 private:
 
 	// temporary variables used when iterating through all memory locations to build the skoolfile
+	int StartAddr = 0;
+	int EndAddr = 0;
+	int CurAddr = 0;
+	FSkoolEntry* pCurEntry = nullptr;
 	bool bIsBranchDestination = false;						// the current instruction is a "mid-routine entry point" ie * prefix
 	FDataInfo* pDataInfo = nullptr;								// this will be set if the current address is data
 	FCodeInfo* pCodeInfo = nullptr;								// this will be set if the current address is code
@@ -446,4 +481,102 @@ bool ExportSkoolFile(FCodeAnalysisState& state, const char* pTextFileName, FSkoo
 	std::chrono::duration<double, std::milli> ms_double = std::chrono::high_resolution_clock::now() - t1;
 	LOGDEBUG("Exporting %s took %.2f ms", pTextFileName, ms_double);
 	return true;
-}
\ No newline at end of file
+}
+
+// the skool file is built a slice of addresses at a time, then the text is formatted & written a batch of entries at a time
+class FSkoolFileExportJob : public FExportJob
+{
+public:
+	FSkoolFileExportJob(FCodeAnalysisState& state, const char* pTextFileName, FSkoolFile::Base base, const FSkoolFileInfo* pSkoolInfo, uint16_t startAddr, uint16_t endAddr)
+		: State(state)
+		, SkoolInfo(pSkoolInfo ? *pSkoolInfo : FSkoolFileInfo())
+		, Exporter(state, pSkoolInfo ? &SkoolInfo : nullptr)
+		, Filename(pTextFileName)
+		, Base(base)
+	{
+		Description = std::string("Exporting ") + pTextFileName;
+		NumberMode = base == FSkoolFile::Base::Hexadecimal ? ENumberDisplayMode::HexDollar : ENumberDisplayMode::Decimal;
+		Exporter.BeginSkoolFile(startAddr, endAddr, base);
+	}
+
+	bool Step(double timeBudgetMs) override
+	{
+		const auto startTime = std::chrono::high_resolution_clock::now();
+		auto hasTimeLeft = [startTime, timeBudgetMs]() 
+		{ 
+			return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count() < timeBudgetMs; 
+		};
+
+		if (bWriting == false)
+		{
+			const ENumberDisplayMode previousDisplayMode = GetNumberDisplayMode();
+			SetNumberDisplayMode(NumberMode);
+
+			bool bMoreAddresses = true;
+			do
+			{
+				bMoreAddresses = Exporter.BuildNextAddresses(kAddressesPerStep);
+			} 
+			while (bMoreAddresses && hasTimeLeft());
+
+			SetNumberDisplayMode(previousDisplayMode);
+			Progress = Exporter.GetProgress() * 0.5f;
+			if (bMoreAddresses)
+				return true;
+
+			if (Exporter.GetSkoolFile().BeginExport(Filename.c_str(), Base) == false)
+				return Finish(false);
+			bWriting = true;
+		}
+
+		FSkoolFile& skoolFile = Exporter.GetSkoolFile();
+		bool bMoreEntries = true;
+		do
+		{
+			bMoreEntries = skoolFile.ExportNextBatch();
+		} 
+		while (bMoreEntries && hasTimeLeft());
+
+		Progress = 0.5f + (skoolFile.GetExportProgress() * 0.5f);
+		if (bMoreEntries)
+			return true;
+
+		return Finish(skoolFile.EndExport());
+	}
+
+	void Cancel() override
+	{
+		if (bWriting)
+		{
+			Exporter.GetSkoolFile().EndExport();
+			std::remove(Filename.c_str());
+		}
+	}
+
+private:
+	bool Finish(bool bExportedOk)
+	{
+		bSuccess = bExportedOk;
+		if (bSuccess)
+			LOGINFO("Successfully exported '%s'", Filename.c_str());
+		else
+			LOGINFO("Failed to export '%s'", Filename.c_str());
+		State.SetAddressRangeDirty();
+		return false;
+	}
+
+	static const int	kAddressesPerStep = 0x400;
+
+	FCodeAnalysisState&	State;
+	FSkoolFileInfo		SkoolInfo;	// copy as the job outlives the caller's info
+	FSkoolKitExporter	Exporter;
+	std::string			Filename;
+	FSkoolFile::Base	Base = FSkoolFile::Base::Hexadecimal;
+	ENumberDisplayMode	NumberMode = ENumberDisplayMode::HexDollar;
+	bool				bWriting = false;
+};
+
+FExportJob* CreateSkoolFileExportJob(FCodeAnalysisState& state, const char* pTextFileName, FSkoolFile::Base base, const FSkoolFileInfo* pSkoolInfo, uint16_t startAddr, uint16_t endAddr)
+{
+	return new FSkoolFileExportJob(state, pTextFileName, base, pSkoolInfo, startAddr, endAddr);
+}
@@ -4,6 +4,10 @@
 #include "SkoolFile.h"
 
 class FCodeAnalysisState;
+class FExportJob;
 struct FSkoolFileInfo;
 // the start and end address defaults will need to change
 bool ExportSkoolFile(FCodeAnalysisState& state, const char* pTextFileName, FSkoolFile::Base base = FSkoolFile::Base::Hexadecimal, const FSkoolFileInfo* pSkoolInfo = nullptr, uint16_t startAddr=0x4000, uint16_t endAddr=0xffff);
+
+// export run in slices from the emulator tick - see FEmuBase::StartExportJob
+FExportJob* CreateSkoolFileExportJob(FCodeAnalysisState& state, const char* pTextFileName, FSkoolFile::Base base, const FSkoolFileInfo* pSkoolInfo, uint16_t startAddr, uint16_t endAddr);
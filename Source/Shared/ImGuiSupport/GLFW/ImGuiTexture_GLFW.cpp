@@ -91,3 +91,18 @@ void ImGui_UpdateTextureRGBA(ImTextureID texture,const void* pixels, int srcWidt
 
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, srcWidth, srcHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
 }
+
+void ImGui_UpdateTextureRGBARows(ImTextureID texture, const void* pixels, int firstRow, int noRows)
+{
+	GLint lastTexture;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &lastTexture);
+
+	glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)texture);
+	int width;
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, firstRow, width, noRows, GL_RGBA, GL_UNSIGNED_BYTE, (const uint32_t*)pixels + (firstRow * width));
+
+	// Restore state
+	glBindTexture(GL_TEXTURE_2D, lastTexture);
+}
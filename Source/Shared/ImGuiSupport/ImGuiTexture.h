@@ -6,3 +6,5 @@ ImTextureID ImGui_CreateTextureRGBA(const void* pixels, int width, int height);
 void ImGui_FreeTexture(ImTextureID);
 void ImGui_UpdateTextureRGBA(ImTextureID texture, const void* pixels);
 void ImGui_UpdateTextureRGBA(ImTextureID texture, const void* pixels, int srcWidth, int srcHeight);
+// only upload a range of rows - pixels is the whole image
+void ImGui_UpdateTextureRGBARows(ImTextureID texture, const void* pixels, int firstRow, int noRows);
@@ -112,3 +112,9 @@ void ImGui_UpdateTextureRGBA(ImTextureID texture, unsigned char* pixels, int src
 		pDeviceCtx->Unmap(pTexture, 0);
 	}
 }
+
+// dynamic textures get discarded when mapped so the whole texture has to be written
+void ImGui_UpdateTextureRGBARows(ImTextureID texture, const void* pixels, int firstRow, int noRows)
+{
+	ImGui_UpdateTextureRGBA(texture, (unsigned char*)pixels);
+}
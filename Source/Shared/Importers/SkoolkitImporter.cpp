@@ -2,51 +2,81 @@
 #include "SkoolkitImporter.h"
 #include "../Exporters/SkoolFileInfo.h"
 #include "CodeAnalyser/CodeAnalyser.h"
+#include "CodeAnalyser/Disassembler.h"
 #include "Debug/DebugLog.h"
+#include "Util/FileUtil.h"
 #include "Util/Misc.h"
 
 #include <algorithm> // for std::count
+#include <chrono>
+#include <string_view>
 
-const std::string kWhiteSpace = " \n\r\t\f\v";
-const char kSkoolkitDirectiveNone = '-';
+// The file is loaded in one go & tokenized in place - lines, operations & labels are views into the file data
+// Parsed instructions are collected a page at a time & applied to the analysis together
+
+const std::string_view kWhiteSpace = " \n\r\t\f\v";
 
-struct FSkoolkitInstruction
-{
-	char BlockDirective = kSkoolkitDirectiveNone;
-	char SubBlockDirective = kSkoolkitDirectiveNone;
-	bool bBranchDestination = false; // is this address a branch destination (i.e. a line starting with an asterisk '*')
-	uint16_t Address = 0;
-	std::string Comment;
-	std::string Operation; // the disassembly text
-};
 
-std::string TrimLeadingChars(const std::string& str, const std::string& charsToTrim)
+std::string_view TrimLeadingChars(std::string_view str, std::string_view charsToTrim)
 {
-	size_t start = str.find_first_not_of(charsToTrim);
-	return (start == std::string::npos) ? "" : str.substr(start);
+	const size_t start = str.find_first_not_of(charsToTrim);
+	return (start == std::string_view::npos) ? std::string_view() : str.substr(start);
 }
 
-std::string TrimLeadingWhitespace(const std::string& str)
+std::string_view TrimLeadingWhitespace(std::string_view str)
 {
 	return TrimLeadingChars(str, kWhiteSpace);
 }
 
-void RemoveCarriageReturn(std::string& str)
+bool StringStartsWith(std::string_view str, std::string_view substring)
 {
-	if (str.empty())
-		return;
-	if (str.back() == '\n' || str.back() == '\r')
-		str.pop_back();
+	return str.substr(0, substring.size()) == substring;
 }
 
-bool StringStartsWith(const std::string& str, const std::string& substring)
+// get the next line from the file data without the line ending
+bool GetNextLine(std::string_view& fileText, std::string_view& outLine)
 {
-	return (str.rfind(substring, 0) == 0);
+	if (fileText.empty())
+		return false;
+
+	const size_t lineEnd = fileText.find('\n');
+	outLine = fileText.substr(0, lineEnd);
+	fileText = lineEnd == std::string_view::npos ? std::string_view() : fileText.substr(lineEnd + 1);
+
+	if (!outLine.empty() && outLine.back() == '\r')
+		outLine.remove_suffix(1);
+	return true;
 }
 
-char GetDirectiveFromAsm(const std::string& str)
+// parse an address field - fails if it's not a number, unless it's all zeros
+bool ParseAddressField(std::string_view numStr, int base, uint16_t& outAddress)
 {
-	if (StringStartsWith(str, "DEF") || StringStartsWith(str, "def"))
+	int value = 0;
+	size_t digitNo = 0;
+	for (; digitNo < numStr.size(); digitNo++)
+	{
+		const char c = numStr[digitNo];
+		int digit = 0;
+		if (c >= '0' && c <= '9')
+			digit = c - '0';
+		else if (base == 16 && c >= 'a' && c <= 'f')
+			digit = c - 'a' + 10;
+		else if (base == 16 && c >= 'A' && c <= 'F')
+			digit = c - 'A' + 10;
+		else
+			break;
+		value = (value * base) + digit;
+	}
+
+	outAddress = static_cast<uint16_t>(value);
+	if (outAddress == 0 && numStr.find_first_not_of('0') != std::string_view::npos)
+		return false;
+	return digitNo > 0;
+}
+
+char GetDirectiveFromAsm(std::string_view str)
+{
+	if (str.size() > 3 && (StringStartsWith(str, "DEF") || StringStartsWith(str, "def")))
 	{
 		if (str[3] == 'B' || str[3] == 'b')
 			return 'b';
@@ -61,119 +91,80 @@ char GetDirectiveFromAsm(const std::string& str)
 	return 'c';
 }
 
-bool ParseInstruction(std::string strLine, FSkoolkitInstruction& instruction)
+bool ParseInstruction(std::string_view strLine, FSkoolkitInstruction& instruction)
 {
-	if (strLine.length() < 6)
+	// line endings have been removed so this is one less than the line length check used to be
+	if (strLine.length() < 5)
 		return false;
 
 	if (strLine[0] == '*')
 		instruction.bBranchDestination = true;
 	else if (strLine[0] != ' ')
 		instruction.BlockDirective = strLine[0];
-	
+
 	if (strLine[1] == '$')
 	{
 		// hexadecimal address
-		std::string numStr = strLine.substr(2, 4);
-		instruction.Address = static_cast<uint16_t>(strtol(numStr.c_str(), nullptr, 16));
-		if (instruction.Address == 0)
-		{
-			if (numStr == "0000")
-			{
-				// Deal with the special case of the address being 0.
-				// We do this because strtol will return 0 if it fails.
-				// We want to differentiate between a valid address of 0 and a failure.
-			}
-			else
-			{
-				return false;
-			}
-		}
+		if (!ParseAddressField(strLine.substr(2, 4), 16, instruction.Address))
+			return false;
 	}
 	else
 	{
 		// decimal address
-		std::string numStr = strLine.substr(1, 5);
-		instruction.Address = static_cast<uint16_t>(strtol(numStr.c_str(), nullptr, 10));
-		if (instruction.Address == 0)
-		{
-			if (numStr == "00000")
-			{
-				// do nothing
-			}
-			else
-			{
-				return false;
-			}
-		}
+		if (!ParseAddressField(strLine.substr(1, 5), 10, instruction.Address))
+			return false;
 	}
 
 	const size_t opStart = 7;
-	size_t opLen = std::string::npos;
+	size_t opLen = std::string_view::npos;
 
 	// get the comment string
 	// todo deal with semicolons in strings
-	const size_t semicolonPos = strLine.find_first_of(';');
-	if (semicolonPos != std::string::npos)
+	const size_t semicolonPos = strLine.find(';');
+	if (semicolonPos != std::string_view::npos)
 	{
 		// calculate where the operation text begins
 		opLen = semicolonPos - opStart;
 
-		size_t strLen = strLine.length();
-
 		// skip ';' and leading space of comment
-		size_t commentStart = semicolonPos + 2;
+		const size_t commentStart = semicolonPos + 2;
 
-		if (commentStart == strLen)
+		if (commentStart > strLine.length())
 		{
 			// Special case. We have an empty comment.
-			// Empty comments occur in the skool file on data lines when we're between lines that contain 
+			// Empty comments occur in the skool file on data lines when we're between lines that contain
 			// a comment with an open and close brace. i.e. { and }
-			// To preserve these we set the comment to be a carriage return. This forces an empty comment 
+			// To preserve these we set the comment to be a carriage return. This forces an empty comment
 			// to be written out when exporting.
 			instruction.Comment = "\n";
 		}
-		else if (commentStart < strLen)
+		else
 		{
 			instruction.Comment = strLine.substr(commentStart);
-
-			RemoveCarriageReturn(instruction.Comment); // do I need to do this?
 		}
-	}
-	
-	// skip trailing spaces of disassembly text
-	if (semicolonPos != std::string::npos)
-	{
-		size_t opEnd = strLine.find_last_not_of(' ', semicolonPos-1);
-		if (opEnd != std::string::npos)
-			opLen = opEnd+1 - opStart;
+
+		// skip trailing spaces of disassembly text
+		const size_t opEnd = strLine.find_last_not_of(' ', semicolonPos - 1);
+		if (opEnd != std::string_view::npos)
+			opLen = opEnd + 1 - opStart;
 	}
 
 	// get the disassembly text inbetween the address and the comment
-	instruction.Operation = strLine.substr(opStart, opLen);
-
-	RemoveCarriageReturn(instruction.Operation);
+	instruction.Operation = strLine.length() > opStart ? strLine.substr(opStart, opLen) : std::string_view();
 
 	instruction.SubBlockDirective = GetDirectiveFromAsm(instruction.Operation);
 
 	return true;
 }
 
-bool ParseAsmDirective(FCodeAnalysisState& state, const std::string& strLine, std::string& label)
+bool ParseAsmDirective(std::string_view strLine, std::string_view& label, ISkoolkitTokenHandler& handler)
 {
 	if (StringStartsWith(strLine, "@label="))
 	{
 		// @label directive
 		// Create label at current instruction's address.
 		// eg @label=START
-
-		size_t eqLoc = strLine.find('=');
-		if (eqLoc != std::string::npos)
-		{
-			label = strLine.substr(eqLoc + 1);
-			if (label.back() == '\n' || label.back() == '\r')
-				label.pop_back();
-		}
+		label = strLine.substr(7);
 		return true;
 	}
 	else if (StringStartsWith(strLine, "@equ="))
@@ -182,32 +173,20 @@ bool ParseAsmDirective(FCodeAnalysisState& state, const std::string& strLine, st
 		// Create label at given address.
 		// eg @equ=KSTATE=$5C00
 
-		size_t eqLoc = strLine.find('=');
-		if (eqLoc != std::string::npos)
-		{
-			std::string str = strLine.substr(eqLoc + 1);
+		const std::string_view str = strLine.substr(5);
 
-			// split into label and address
-			eqLoc = str.find('=');
-			if (eqLoc != std::string::npos)
+		// split into label and address
+		const size_t eqLoc = str.find('=');
+		if (eqLoc != std::string_view::npos)
+		{
+			const std::string_view addressStr = str.substr(eqLoc + 1);
+			if (!addressStr.empty() && addressStr[0] == '$')
 			{
-				std::string labelStr = str.substr(0, eqLoc);
-				std::string addressStr = str.substr(eqLoc + 1);
-				if (addressStr[0] == '$')
-				{
-					addressStr = addressStr.substr(1, 4);
-					uint16_t address = static_cast<uint16_t>(std::stoul(addressStr, nullptr, 16));
-
-					AddLabelAtAddress(state, state.AddressRefFromPhysicalAddress(address));
-					if (FLabelInfo* pLabelInfo = state.GetLabelForPhysicalAddress(address))
-					{
-						pLabelInfo->ChangeName(labelStr.c_str());
-					}
-				}
-				// todo: decimal and 0x notation
-
-				return false;
+				uint16_t address = 0;
+				ParseAddressField(addressStr.substr(1, 4), 16, address);
+				handler.OnEquate(str.substr(0, eqLoc), address);
 			}
+			// todo: decimal and 0x notation
 		}
 	}
 
@@ -216,10 +195,10 @@ bool ParseAsmDirective(FCodeAnalysisState& state, const std::string& strLine, st
 
 // Split a string containing comma delimited items into individual strings.
 // Items can be text in quotes or numeric values.
-void SplitCommaDelimitedItems(const std::string& str, std::vector<std::string>& items)
+void SplitCommaDelimitedItems(std::string_view str, std::vector<std::string_view>& items)
 {
 	items.clear();
-	
+
 	if (str.empty())
 		return;
 
@@ -230,7 +209,7 @@ void SplitCommaDelimitedItems(const std::string& str, std::vector<std::string>&
 	for (size_t i=0; i<str.size(); i++)
 	{
 		c = str[i];
-		
+
 		if (c == '"')
 		{
 			if (!bEscapeChar)
@@ -246,13 +225,12 @@ void SplitCommaDelimitedItems(const std::string& str, std::vector<std::string>&
 		{
 			if (c == ',')
 			{
-				std::string subStr = str.substr(start, i-start);
-				items.push_back(subStr);
-				start = i+1; 
+				items.push_back(str.substr(start, i-start));
+				start = i+1;
 			}
 		}
 	}
-	// add the remainder of the string 
+	// add the remainder of the string
 	items.push_back(str.substr(start));
 }
 
@@ -261,12 +239,12 @@ void SplitCommaDelimitedItems(const std::string& str, std::vector<std::string>&
 // eg "RND" = 3 bytes
 //    255 = 1 byte
 //    "\"" = 1 byte
-uint16_t CountDataBytes(std::string str)
+uint16_t CountDataBytes(std::string_view str)
 {
 	uint16_t size = 0;
 	size_t first = str.find('"');
 	size_t last = str.find_last_of('"');
-	if (first != std::string::npos && last != std::string::npos)
+	if (first != std::string_view::npos && last != std::string_view::npos)
 	{
 		for (size_t i=first+1; i<last; i++)
 		{
@@ -279,27 +257,200 @@ uint16_t CountDataBytes(std::string str)
 	{
 		// if we didn't find a string we presume it's a byte value
 		// todo word values
-		size += 1; 
+		size += 1;
 	}
 	return size;
 }
 
-bool ImportSkoolKitFile(FCodeAnalysisState& state, const char* pTextFileName, FSkoolFileInfo* pSkoolInfo /*=nullptr*/)
+// follow on comment lines get added to the end of the item's comment
+// text is what comes after the ';'
+void AppendCommentContinuation(std::string& comment, std::string_view text)
 {
-	FILE* fp = fopen(pTextFileName, "rt");
-	char pchLine[65536];
-	// note: "rt" = text mode, which means Windows line endings \r\n will be converted into \n
-	
+	if (!comment.empty() && comment.back() != '\n')
+		comment += "\n";
 
-	if (fp == nullptr)
-		return false;
+	if (text.empty())
+	{
+		// a bare ';' doesn't add a line
+		if (!comment.empty())
+			comment.pop_back();
+		return;
+	}
+
+	comment += text.substr(1);	// skip the space after the ';'
+}
+
+// apply a page worth of instructions to the analysis
+void ApplyInstructions(FCodeAnalysisState& state, std::vector<FSkoolkitInstruction>& instructions)
+{
+	if (instructions.empty())
+		return;
+
+	FCodeAnalysisPage& page = *state.GetReadPage(instructions.front().Address);
+	const int16_t bankId = state.GetBankFromAddress(instructions.front().Address);
+
+	for (FSkoolkitInstruction& instruction : instructions)
+	{
+		const uint16_t pageAddr = instruction.Address & FCodeAnalysisPage::kPageMask;
+		const FAddressRef addrRef(bankId, instruction.Address);
+		FItem* pItem = nullptr;
+
+		switch (instruction.SubBlockDirective)
+		{
+		case 'c':
+		{
+			// Address is code
+
+			FCodeInfo* pCodeInfo = page.CodeInfo[pageAddr];
+			if (!pCodeInfo)
+			{
+				WriteCodeInfoForAddress(state, instruction.Address);
+				pCodeInfo = page.CodeInfo[pageAddr];
+			}
+			pItem = pCodeInfo;
+
+			if (pCodeInfo && instruction.CurBlockDirective == 'u')
+				pCodeInfo->bUnused = true;
+		}
+		break;
+		case 'b':
+		case 'w':
+		{
+			// Address is data
+
+			FDataInfo* pDataInfo = &page.DataInfo[pageAddr];
+			if (FCodeInfo* pCodeInfo = page.CodeInfo[pageAddr])
+			{
+				LOGWARNING("Item at $%02X was set to code: %s",instruction.Address, GenerateDasmStringForAddress(state, instruction.Address, pCodeInfo).c_str());
+				LOGWARNING("Code item removed and replace as data");
+				// remove the code item
+				state.SetCodeInfoForAddress(instruction.Address, nullptr);	// memory will get cleared up
+			}
+			pItem = pDataInfo;
+
+			// count how many entries we have
+			const uint16_t numItems = static_cast<uint16_t>(std::count(instruction.Operation.begin(), instruction.Operation.end(), ',') + 1);
+			const std::string_view defStatement = instruction.Operation.substr(0, 4);
+
+			if (defStatement == "DEFB" || defStatement == "defb")
+			{
+				if (numItems == 1)
+					pDataInfo->DataType = EDataType::Byte;
+				else
+					pDataInfo->DataType = EDataType::ByteArray;
+				pDataInfo->ByteSize = numItems;
+			}
+			else if (defStatement == "DEFW" || defStatement == "defw")
+			{
+				if (numItems == 1)
+					pDataInfo->DataType = EDataType::Word;
+				else
+					pDataInfo->DataType = EDataType::WordArray;
+				pDataInfo->ByteSize = numItems * 2;
+			}
+
+			if (instruction.CurBlockDirective == 'g')
+				pDataInfo->bGameState = true;
+			else if (instruction.CurBlockDirective == 'u')
+				pDataInfo->bUnused2 = true;	// What is this?
+		}
+		break;
+		case 't':
+		{
+			// Address is text
+			FDataInfo* pDataInfo = &page.DataInfo[pageAddr];
+
+			// If this is set to true it will parse the DEFM statement and calculate
+			// how many bytes the text needs to be. This DEFM statement could contain
+			// non-ascii byte values mixed in with the text.
+			// This means when the DEFM statement is exported it will match exactly
+			// the DEFM statement that was imported.
+			// This will bypass SetItemText() so may not display correctly in the tool.
+			const bool bSkoolKitCompatibleText = false;
+
+			if (bSkoolKitCompatibleText)
+			{
+				std::vector<std::string_view> elements;
+				SplitCommaDelimitedItems(instruction.Operation.substr(std::min<size_t>(5, instruction.Operation.size())), elements);
+
+				// This loop counts the number of bytes declared in the DEFM instruction.
+				// It can deal with byte values in addition to text strings.
+				// eg DEFM "One",2,"Three"
+				uint16_t byteSize = 0;
+				for (std::string_view str : elements)
+				{
+					byteSize += CountDataBytes(str);
+				}
+
+				if (byteSize > 0)
+				{
+					pDataInfo->DataType = EDataType::Text;
+
+					// SetItemText doesnt set the number of bytes correctly (compared to how skoolkit does it),
+					// so we set the byte size manually based on how many bytes we counted in the statement.
+					pDataInfo->ByteSize = byteSize;
+
+					// todo set bBit7Terminator flag on the FDataItem
+					// todo check we're not overlapping items.
+				}
+			}
+			else
+			{
+				// force to byte type otherwise SetItemText() does nothing
+				pDataInfo->DataType = EDataType::Byte;
+
+				SetItemText(state, FCodeAnalysisItem(pDataInfo, addrRef));
+			}
+			pItem = pDataInfo;
+		}
+		break;
+		}
+
+		if (pItem && (!instruction.Comment.empty() || !instruction.CommentContinuations.empty()))
+		{
+			std::string comment = instruction.Comment.empty() ? pItem->Comment : std::move(instruction.Comment);
+			for (std::string_view continuation : instruction.CommentContinuations)
+				AppendCommentContinuation(comment, continuation);
+			state.SetItemComment(addrRef, pItem, std::move(comment));
+		}
+
+		if (!instruction.CommentBlock.empty())
+		{
+			FCommentBlock* pBlock = page.CommentBlocks[pageAddr];
+
+			if (pBlock == nullptr)
+				pBlock = AddCommentBlock(state, addrRef);
+			else
+			{
+				std::string commentExcerpt = pBlock->Comment.substr(0, 1024);
+				if (!commentExcerpt.empty() && commentExcerpt.back() == '\n')
+					commentExcerpt.pop_back();
+				LOGWARNING("SkoolkitImporter: Replacing existing comment block: '%s'", commentExcerpt.c_str());
+			}
 
+			state.SetItemComment(addrRef, pBlock, std::move(instruction.CommentBlock));
+		}
+
+		if (!instruction.Label.empty())
+		{
+			AddLabelAtAddress(state, addrRef);
+			if (FLabelInfo* pLabelInfo = page.Labels[pageAddr])
+			{
+				state.SetLabelName(addrRef, pLabelInfo, std::string(instruction.Label).c_str());
+			}
+		}
+	}
+}
+
+bool TokenizeSkoolKitText(std::string_view fileText, ISkoolkitTokenHandler& handler, FSkoolFileInfo* pSkoolInfo /*=nullptr*/)
+{
 	char blockDirective = kSkoolkitDirectiveNone;
 	char subBlockDirective = kSkoolkitDirectiveNone;
 
 	std::string comments;
-	std::string label;
-	FCodeAnalysisItem LastItem;
+	std::string_view label;
+	std::vector<FSkoolkitInstruction> pageInstructions;
+	int lastAddress = -1;
 
 	uint16_t minAddr=0xffff;
 	uint16_t maxAddr=0;
@@ -308,11 +459,12 @@ bool ImportSkoolKitFile(FCodeAnalysisState& state, const char* pTextFileName, FS
 	FSkoolFileLocation skoolLocation;
 	const FSkoolFileLocation kSkoolLocationDefault;
 	bool bInRsubSection = false;
+	bool bSuccess = true;
 
 	unsigned int lineNum = 0;
-	while (fgets(pchLine, 65536, fp))
+	std::string_view strLine;
+	while (GetNextLine(fileText, strLine))
 	{
-		std::string strLine = pchLine;
 		lineNum++;
 
 		if (bInRsubSection)
@@ -320,69 +472,60 @@ bool ImportSkoolKitFile(FCodeAnalysisState& state, const char* pTextFileName, FS
 			if (StringStartsWith(strLine, "@rsub+end"))
 				bInRsubSection = false;
 			else
-				LOGINFO("Skipping @rsub text '%s' on line %d", pchLine, lineNum);
+				LOGINFO("Skipping @rsub text '%s' on line %d", std::string(strLine).c_str(), lineNum);
 			continue;
 		}
 
-		if (strLine[0] == '@')
+		if (!strLine.empty() && strLine[0] == '@')
 		{
-			if (!ParseAsmDirective(state, strLine, label))
-				comments += strLine;
+			if (!ParseAsmDirective(strLine, label, handler))
+				comments.append(strLine).append("\n");
 
 			if (StringStartsWith(strLine, "@rsub+begin"))
 			{
 				bInRsubSection = true;
 			}
-			
+
 			continue;
 		}
 
-		if (strLine[0] == ';')
+		if (!strLine.empty() && strLine[0] == ';')
 		{
-			comments += TrimLeadingChars(strLine, "; ");
+			comments.append(TrimLeadingChars(strLine, "; ")).append("\n");
 			continue;
 		}
 
-		std::string trimmed = TrimLeadingWhitespace(strLine);
-		if (trimmed[0] == ';')
+		const std::string_view trimmed = TrimLeadingWhitespace(strLine);
+		if (trimmed.empty())
 		{
-			// instruction comment continuation
-			if (LastItem.IsValid())
-			{
-				if (!LastItem.Item->Comment.empty() && LastItem.Item->Comment.back() != '\n')
-				{
-					LastItem.Item->Comment += "\n";
-				}
-				LastItem.Item->Comment += trimmed.substr(2);
-				RemoveCarriageReturn(LastItem.Item->Comment);
-			}
+			// skip blank lines
 			continue;
 		}
 
-		if (trimmed.empty())
+		if (trimmed[0] == ';')
 		{
-			// skip blank lines
+			// instruction comment continuation
+			if (!pageInstructions.empty())
+				pageInstructions.back().CommentContinuations.push_back(trimmed.substr(1));
 			continue;
 		}
-		
+
 		// we've got an instruction.
-		// get directive, address and comment 
-		FItem* pItem = nullptr;
+		// get directive, address and comment
 		FSkoolkitInstruction instruction;
 		if (!ParseInstruction(strLine, instruction))
 		{
-			RemoveCarriageReturn(strLine);
-			LOGWARNING("Parse error on line %d. Could not parse instruction: '%s'", lineNum, strLine.c_str());
-			fclose(fp);
-			return false;
+			LOGWARNING("Parse error on line %d. Could not parse instruction: '%s'", lineNum, std::string(strLine).c_str());
+			bSuccess = false;
+			break;
 		}
 
-		if (LastItem.IsValid() && instruction.Address < LastItem.AddressRef.Address)
+		if (instruction.Address < lastAddress)
 		{
 			// if this address is lower than the last one we saw then something has gone wrong, so abort
-			LOGWARNING("Parse error on line %d. Address $%x (%d) is lower than previous read address: $%x (%d)", lineNum, instruction.Address, instruction.Address, LastItem.AddressRef.Address, LastItem.AddressRef.Address);
-			fclose(fp);
-			return false;
+			LOGWARNING("Parse error on line %d. Address $%x (%d) is lower than previous read address: $%x (%d)", lineNum, instruction.Address, instruction.Address, lastAddress, lastAddress);
+			bSuccess = false;
+			break;
 		}
 
 		if (pSkoolInfo)
@@ -396,7 +539,7 @@ bool ImportSkoolKitFile(FCodeAnalysisState& state, const char* pTextFileName, FS
 		{
 			// we've encountered a new block
 			blockDirective = instruction.BlockDirective;
-			subBlockDirective = instruction.SubBlockDirective; 
+			subBlockDirective = instruction.SubBlockDirective;
 			if (pSkoolInfo)
 				skoolLocation.BlockDirective = GetDirectiveFromChar(blockDirective);// is this needed? we're doing it above
 		}
@@ -410,165 +553,6 @@ bool ImportSkoolKitFile(FCodeAnalysisState& state, const char* pTextFileName, FS
 				skoolLocation.SubBlockDirective = GetDirectiveFromChar(subBlockDirective);
 		}
 
-		switch (instruction.SubBlockDirective)
-		{
-		case 'c':
-		{
-			// Address is code
-
-			FCodeInfo* pCodeInfo = state.GetCodeInfoForPhysicalAddress(instruction.Address);
-			if (!pCodeInfo)
-			{
-				WriteCodeInfoForAddress(state, instruction.Address);
-				pCodeInfo = state.GetCodeInfoForPhysicalAddress(instruction.Address);
-
-			}
-			pItem = pCodeInfo;
-
-			
-			if (blockDirective == 'u')
-				pCodeInfo->bUnused = true;
-		}
-		break;
-		case 'b':
-		case 'w':
-		{
-			// Address is data
-			
-			FDataInfo* pDataInfo = state.GetReadDataInfoForAddress(instruction.Address);
-			FCodeInfo* pCodeInfo = state.GetCodeInfoForPhysicalAddress(instruction.Address);
-			if (pCodeInfo)
-			{
-				LOGWARNING("Item at $%02X was set to code: %s",instruction.Address, pCodeInfo->Text.c_str());
-				LOGWARNING("Code item removed and replace as data");
-				// remove the code item
-				state.SetCodeInfoForAddress(instruction.Address, nullptr);	// memory will get cleared up 
-			}
-			if (pDataInfo)
-			{
-				pItem = pDataInfo;
-
-				// count how many entries we have
-				const uint16_t numItems = static_cast<uint16_t>(std::count(instruction.Operation.begin(), instruction.Operation.end(), ',') + 1);
-				std::string defStatement = instruction.Operation.substr(0, 4);
-				
-				if (defStatement == "DEFB" || defStatement == "defb")
-				{
-					if (numItems == 1)
-						pDataInfo->DataType = EDataType::Byte;
-					else
-						pDataInfo->DataType = EDataType::ByteArray;
-					pDataInfo->ByteSize = numItems;
-				}
-				else if (defStatement == "DEFW" || defStatement == "defw")
-				{
-					if (numItems == 1)
-						pDataInfo->DataType = EDataType::Word;
-					else
-						pDataInfo->DataType = EDataType::WordArray;
-					pDataInfo->ByteSize = numItems * 2;
-				}
-
-				if (blockDirective == 'g')
-					pDataInfo->bGameState = true;
-				else if (blockDirective == 'u')
-					pDataInfo->bUnused2 = true;	// What is this?
-			}
-		}
-		break;
-		case 't':
-		{
-			// Address is text
-			FDataInfo* pDataInfo = state.GetReadDataInfoForAddress(instruction.Address);
-			if (pDataInfo)
-			{
-				// If this is set to true it will parse the DEFM statement and calculate
-				// how many bytes the text needs to be. This DEFM statement could contain
-				// non-ascii byte values mixed in with the text.
-				// This means when the DEFM statement is exported it will match exactly 
-				// the DEFM statement that was imported.
-				// This will bypass SetItemText() so may not display correctly in the tool.
-				const bool bSkoolKitCompatibleText = false;
-
-				if (bSkoolKitCompatibleText)
-				{
-					std::string defStatement = instruction.Operation.substr(0, 4);
-
-					std::vector<std::string> elements;
-					SplitCommaDelimitedItems(instruction.Operation.substr(5), elements);
-
-					// This loop counts the number of bytes declared in the DEFM instruction.
-					// It can deal with byte values in addition to text strings.
-					// eg DEFM "One",2,"Three"
-					uint16_t byteSize = 0;
-					for (std::string& str : elements)
-					{
-						byteSize += CountDataBytes(str);
-					}
-
-					if (byteSize > 0)
-					{
-						pDataInfo->DataType = EDataType::Text;
-
-						// SetItemText doesnt set the number of bytes correctly (compared to how skoolkit does it),
-						// so we set the byte size manually based on how many bytes we counted in the statement.
-						pDataInfo->ByteSize = byteSize;
-
-						// todo set bBit7Terminator flag on the FDataItem
-						// todo check we're not overlapping items.
-					}
-				}
-				else
-				{
-					// force to byte type otherwise SetItemText() does nothing
-					pDataInfo->DataType = EDataType::Byte;
-
-					SetItemText(state, FCodeAnalysisItem(pDataInfo,state.GetBankFromAddress(instruction.Address), instruction.Address));
-				}
-				pItem = pDataInfo;
-			}
-		}
-		break;
-		}
-
-		if (!instruction.Comment.empty())
-		{
-			if (pItem)
-			{
-				pItem->Comment = instruction.Comment;
-			}
-		}
-
-		if (!comments.empty())
-		{
-			FCommentBlock* pBlock = state.GetCommentBlockForAddress(state.AddressRefFromPhysicalAddress(instruction.Address));
-			
-			if (pBlock == nullptr)
-				pBlock = AddCommentBlock(state, state.AddressRefFromPhysicalAddress(instruction.Address));
-			else
-			{
-				std::string commentExcerpt = pBlock->Comment.substr(0, 1024);
-				RemoveCarriageReturn(commentExcerpt);
-				LOGWARNING("SkoolkitImporter: Replacing existing comment block: '%s'", commentExcerpt.c_str());
-			}
-
-			pBlock->Comment = comments;
-			comments.clear();
-		}
-
-		if (!label.empty())
-		{
-			ELabelType labelType = ELabelType::Data;
-			
-			AddLabelAtAddress(state, state.AddressRefFromPhysicalAddress(instruction.Address));
-			if (FLabelInfo* pLabelInfo = state.GetLabelForPhysicalAddress(instruction.Address))
-			{
-				pLabelInfo->ChangeName(label.c_str());
-			}
-			
-			label.clear();
-		}
-
 		if (pSkoolInfo)
 		{
 			if (instruction.BlockDirective != 's') // todo: repeated data
@@ -578,19 +562,87 @@ bool ImportSkoolKitFile(FCodeAnalysisState& state, const char* pTextFileName, FS
 			}
 		}
 
+		// new page - hand over what we've got so far
+		if (!pageInstructions.empty() && (pageInstructions.front().Address >> FCodeAnalysisPage::kPageShift) != (instruction.Address >> FCodeAnalysisPage::kPageShift))
+		{
+			handler.OnInstructions(pageInstructions);
+			pageInstructions.clear();
+		}
+
+		instruction.CurBlockDirective = blockDirective;
+		instruction.CommentBlock.swap(comments);
+		instruction.Label = label;
+		label = std::string_view();
+
 		minAddr = std::min(instruction.Address, minAddr);
 		maxAddr = std::max(instruction.Address, maxAddr);
+		lastAddress = instruction.Address;
 
-		LastItem = FCodeAnalysisItem(pItem, state.GetBankFromAddress(instruction.Address), instruction.Address);
+		pageInstructions.push_back(std::move(instruction));
 	}
 
+	// instructions before an error still get handed over
+	if (!pageInstructions.empty())
+		handler.OnInstructions(pageInstructions);
+
+	if (bSuccess == false)
+		return false;
+
 	if (pSkoolInfo)
 	{
 		pSkoolInfo->StartAddr = minAddr;
 		pSkoolInfo->EndAddr = maxAddr;
 	}
 
-	state.SetAddressRangeDirty();	
-	fclose(fp);
+	return true;
+}
+
+// applies what the tokenizer finds to the analysis
+class FSkoolkitAnalysisImporter : public ISkoolkitTokenHandler
+{
+public:
+	FSkoolkitAnalysisImporter(FCodeAnalysisState& state) : State(state) {}
+
+	void OnEquate(std::string_view label, uint16_t address) override
+	{
+		const FAddressRef addrRef = State.AddressRefFromPhysicalAddress(address);
+		AddLabelAtAddress(State, addrRef);
+		if (FLabelInfo* pLabelInfo = State.GetLabelForPhysicalAddress(address))
+		{
+			State.SetLabelName(addrRef, pLabelInfo, std::string(label).c_str());
+		}
+	}
+
+	void OnInstructions(std::vector<FSkoolkitInstruction>& instructions) override
+	{
+		ApplyInstructions(State, instructions);
+	}
+
+private:
+	FCodeAnalysisState&	State;
+};
+
+bool ImportSkoolKitFile(FCodeAnalysisState& state, const char* pTextFileName, FSkoolFileInfo* pSkoolInfo /*=nullptr*/)
+{
+	const auto startTime = std::chrono::high_resolution_clock::now();
+
+	// an empty file is fine - it just has nothing in it
+	size_t fileSize = 0;
+	char* pFileData = (char*)LoadBinaryFile(pTextFileName, fileSize);
+	if (pFileData == nullptr)
+		return false;
+
+	// line endings are dealt with by GetNextLine - windows line endings \r\n are treated as \n
+	FSkoolkitAnalysisImporter importer(state);
+	const bool bSuccess = TokenizeSkoolKitText(std::string_view(pFileData, fileSize), importer, pSkoolInfo);
+	free(pFileData);
+
+	if (bSuccess == false)
+		return false;
+
+	state.SetAddressRangeDirty();
+
+	std::chrono::duration<double, std::milli> ms_double = std::chrono::high_resolution_clock::now() - startTime;
+	LOGINFO("Imported %zu bytes from '%s' in %.2f ms", fileSize, pTextFileName, ms_double.count());
 	return true;
 }
@@ -1,6 +1,42 @@
 #pragma once
 
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
 class FCodeAnalysisState;
 struct FSkoolFileInfo;
 
+const char kSkoolkitDirectiveNone = '-';
+
+// an instruction line from a skool file with the comments & directives that came before it
+// the views point into the file text
+struct FSkoolkitInstruction
+{
+	char BlockDirective = kSkoolkitDirectiveNone;
+	char SubBlockDirective = kSkoolkitDirectiveNone;
+	char CurBlockDirective = kSkoolkitDirectiveNone;	// block the instruction is in
+	bool bBranchDestination = false; // is this address a branch destination (i.e. a line starting with an asterisk '*')
+	uint16_t Address = 0;
+	std::string Comment;
+	std::string_view Operation; // the disassembly text
+	std::string_view Label;		// from a preceding @label directive
+	std::string CommentBlock;	// comment lines & unhandled directives before the instruction
+	std::vector<std::string_view> CommentContinuations;	// comment lines after the instruction, from the ';'
+};
+
+// receives what the tokenizer finds - instructions are handed over a page at a time
+class ISkoolkitTokenHandler
+{
+public:
+	virtual ~ISkoolkitTokenHandler() = default;
+
+	virtual void	OnEquate(std::string_view label, uint16_t address) = 0;
+	virtual void	OnInstructions(std::vector<FSkoolkitInstruction>& instructions) = 0;
+};
+
+bool TokenizeSkoolKitText(std::string_view fileText, ISkoolkitTokenHandler& handler, FSkoolFileInfo* pSkoolInfo = nullptr);
+void AppendCommentContinuation(std::string& comment, std::string_view text);
+
 bool ImportSkoolKitFile(FCodeAnalysisState& state, const char* pTextFileName, FSkoolFileInfo* pSkoolInfo =nullptr);
@@ -18,6 +18,8 @@ extern "C"
 #include <ImGuiSupport/ImGuiScaling.h>
 #include "CodeAnalyser/UI/CodeAnalyserUI.h"
 
+#include <algorithm>
+
 
 static int print(lua_State* pState)
 {
@@ -121,6 +123,186 @@ static int GetMemPtr(lua_State* pState)
 	return 0;
 }
 
+// Bulk memory access
+// These work a page at a time so scripts scanning tables or sprites don't have to make a call per byte
+
+static int ReadBytes(lua_State* pState)
+{
+	FEmuBase* pEmu = LuaSys::GetEmulator();
+
+	if (pEmu == nullptr || lua_isinteger(pState, 1) == false || lua_isinteger(pState, 2) == false)
+		return 0;
+
+	const uint16_t address = (uint16_t)lua_tointeger(pState, 1);
+	const int noBytes = std::min((int)lua_tointeger(pState, 2), FCodeAnalysisState::kAddressSize);
+	if (noBytes <= 0)
+		return 0;
+
+	luaL_Buffer buffer;
+	char* pDest = luaL_buffinitsize(pState, &buffer, noBytes);
+	int bytesRead = 0;
+	while (bytesRead < noBytes)
+	{
+		// copy up to the end of the current page
+		const uint16_t readAddr = (uint16_t)(address + bytesRead);
+		const int pageBytesLeft = FCodeAnalysisPage::kPageSize - (readAddr & FCodeAnalysisPage::kPageMask);
+		const int chunkSize = std::min(pageBytesLeft, noBytes - bytesRead);
+		memcpy(pDest + bytesRead, pEmu->GetMemPtr(readAddr), chunkSize);
+		bytesRead += chunkSize;
+	}
+	luaL_pushresultsize(&buffer, noBytes);
+	return 1;
+}
+
+static int WriteBytes(lua_State* pState)
+{
+	FEmuBase* pEmu = LuaSys::GetEmulator();
+
+	if (pEmu != nullptr && lua_isinteger(pState, 1) && lua_isstring(pState, 2))
+	{
+		FCodeAnalysisState& state = pEmu->GetCodeAnalysis();
+
+		if (state.bAllowEditing)
+		{
+			size_t length = 0;
+			const uint16_t address = (uint16_t)lua_tointeger(pState, 1);
+			const uint8_t* pData = (const uint8_t*)lua_tolstring(pState, 2, &length);
+			for (size_t i = 0; i < length && i < FCodeAnalysisState::kAddressSize; i++)
+				pEmu->WriteByte((uint16_t)(address + i), pData[i]);
+		}
+	}
+
+	return 0;
+}
+
+// Memory views are userdata objects that index bank memory directly
+// Because they reference the bank rather than the physical address they stay valid when the bank is paged out
+struct FLuaMemView
+{
+	FAddressRef		Address;
+	int				Size = 0;
+};
+
+static const uint8_t* GetMemViewBytes(const FLuaMemView* pView)
+{
+	const FCodeAnalysisBank* pBank = LuaSys::GetEmulator()->GetCodeAnalysis().GetBank(pView->Address.BankId);
+	if (pBank == nullptr)
+		return nullptr;
+	return pBank->Memory + (pView->Address.Address - pBank->GetMappedAddress());
+}
+
+static int CreateMemView(lua_State* pState)
+{
+	FEmuBase* pEmu = LuaSys::GetEmulator();
+	if (pEmu == nullptr || lua_isinteger(pState, 1) == false)
+		return 0;
+
+	FCodeAnalysisState& state = pEmu->GetCodeAnalysis();
+	const FAddressRef addrRef = GetAddressRefFromLua(pState, 1);
+	const FCodeAnalysisBank* pBank = state.GetBank(addrRef.BankId);
+	if (pBank == nullptr)
+		return 0;
+
+	// clamp view to end of bank
+	const int bankBytesLeft = pBank->GetMappedAddress() + pBank->GetSizeBytes() - addrRef.Address;
+	const int size = std::min((int)luaL_optinteger(pState, 2, 1), bankBytesLeft);
+
+	void* mem = lua_newuserdata(pState, sizeof(FLuaMemView));
+	luaL_setmetatable(pState, "MemViewMT");
+	FLuaMemView* pView = new(mem) FLuaMemView;
+	pView->Address = addrRef;
+	pView->Size = std::max(size, 0);
+	return 1;
+}
+
+// view[offset] - offset is 0 based from the start address of the view
+static int MemViewIndex(lua_State* pState)
+{
+	const FLuaMemView* pView = (const FLuaMemView*)luaL_checkudata(pState, 1, "MemViewMT");
+	const lua_Integer offset = luaL_checkinteger(pState, 2);
+	const uint8_t* pBytes = GetMemViewBytes(pView);
+	if (pBytes == nullptr || offset < 0 || offset >= pView->Size)
+		return 0;
+
+	lua_pushinteger(pState, pBytes[offset]);
+	return 1;
+}
+
+// writes go through the emulator like WriteByte, so only a view of a RAM bank that's paged in can be written to
+static int MemViewNewIndex(lua_State* pState)
+{
+	const FLuaMemView* pView = (const FLuaMemView*)luaL_checkudata(pState, 1, "MemViewMT");
+	const lua_Integer offset = luaL_checkinteger(pState, 2);
+	const lua_Integer value = luaL_checkinteger(pState, 3);
+	FEmuBase* pEmu = LuaSys::GetEmulator();
+	FCodeAnalysisState& state = pEmu->GetCodeAnalysis();
+	const FCodeAnalysisBank* pBank = state.GetBank(pView->Address.BankId);
+	if (state.bAllowEditing == false || pBank == nullptr || offset < 0 || offset >= pView->Size)
+		return 0;
+
+	const uint16_t address = (uint16_t)(pView->Address.Address + offset);
+	if (pBank->bMachineROM || state.GetWriteBankFromAddress(address) != pBank->Id)
+		return 0;
+
+	pEmu->WriteByte(address, (uint8_t)value);
+	return 0;
+}
+
+static int MemViewLength(lua_State* pState)
+{
+	const FLuaMemView* pView = (const FLuaMemView*)luaL_checkudata(pState, 1, "MemViewMT");
+	lua_pushinteger(pState, pView->Size);
+	return 1;
+}
+
+// return the view contents as a string in one call
+static int MemViewToString(lua_State* pState)
+{
+	const FLuaMemView* pView = (const FLuaMemView*)luaL_checkudata(pState, 1, "MemViewMT");
+	const uint8_t* pBytes = GetMemViewBytes(pView);
+	if (pBytes == nullptr)
+		return 0;
+
+	lua_pushlstring(pState, (const char*)pBytes, pView->Size);
+	return 1;
+}
+
+// get a raw pointer to the start of the view - for passing to the drawing functions
+static int GetMemViewPtr(lua_State* pState)
+{
+	const FLuaMemView* pView = (const FLuaMemView*)luaL_checkudata(pState, 1, "MemViewMT");
+	const uint8_t* pBytes = GetMemViewBytes(pView);
+	if (pBytes == nullptr)
+		return 0;
+
+	lua_pushlightuserdata(pState, (void*)pBytes);
+	return 1;
+}
+
+static int FindMemoryPattern(lua_State* pState)
+{
+	FEmuBase* pEmu = LuaSys::GetEmulator();
+	if (pEmu == nullptr || lua_isstring(pState, 1) == false)
+		return 0;
+
+	FCodeAnalysisState& state = pEmu->GetCodeAnalysis();
+	size_t length = 0;
+	const uint8_t* pPattern = (const uint8_t*)lua_tolstring(pState, 1, &length);
+	const bool bSearchROM = lua_toboolean(pState, 2);
+	const bool bPhysicalOnly = lua_isboolean(pState, 3) ? lua_toboolean(pState, 3) : true;
+	if (length == 0)
+		return 0;
+
+	const std::vector<FAddressRef> results = state.FindAllMemoryPatterns(pPattern, length, bSearchROM, bPhysicalOnly);
+	lua_createtable(pState, (int)results.size(), 0);
+	for (int i = 0; i < (int)results.size(); i++)
+	{
+		PushAddressRefToLua(pState, results[i]);
+		lua_rawseti(pState, -2, i + 1);
+	}
+	return 1;
+}
+
 static int GetRegValue(lua_State* pState)
 {
 	FEmuBase* pEmu = LuaSys::GetEmulator();
@@ -212,7 +394,7 @@ static int SetDataItemComment(lua_State* pState)
 			const char* pText = luaL_tolstring(pState, 2, &length);
 
 			FDataInfo* pDataInfo = state.GetDataInfoForAddress(addrRef);
-			pDataInfo->Comment = pText;
+			state.SetItemComment(addrRef, pDataInfo, pText);
 		}
 	}
 
@@ -235,7 +417,7 @@ static int SetCodeItemComment(lua_State* pState)
 
 			FCodeInfo* pCodeInfo = state.GetCodeInfoForAddress(addrRef);
 			if (pCodeInfo)
-				pCodeInfo->Comment = pText;
+				state.SetItemComment(addrRef, pCodeInfo, pText);
 		}
 	}
 
@@ -257,7 +439,7 @@ static int AddCommentBlock(lua_State* pState)
 			const char* pText = luaL_tolstring(pState, 2, &length);
 
 			FCommentBlock* pCommentBlock = AddCommentBlock(state, addrRef);
-			pCommentBlock->Comment = pText;
+			state.SetItemComment(addrRef, pCommentBlock, pText);
 		}
 	}
 
@@ -314,6 +496,98 @@ static int AddDataLabel(lua_State* pState)
 	return 0;
 }
 
+// Add a label to each item in an array e.g. sprite_0, sprite_1...
+static int AddDataLabels(lua_State* pState)
+{
+	FEmuBase* pEmu = LuaSys::GetEmulator();
+	if (pEmu == nullptr || lua_isinteger(pState, 1) == false || lua_isstring(pState, 2) == false)
+		return 0;
+
+	FCodeAnalysisState& state = pEmu->GetCodeAnalysis();
+	const FAddressRef startAddr = GetAddressRefFromLua(pState, 1);
+	const char* pPrefix = lua_tostring(pState, 2);
+	const int itemSize = std::max((int)luaL_optinteger(pState, 3, 1), 1);
+	const int noItems = (int)luaL_optinteger(pState, 4, 1);
+	if (startAddr.IsValid() == false)
+		return 0;
+
+	char labelName[64];
+	FAddressRef itemAddr = startAddr;
+	for (int itemNo = 0; itemNo < noItems; itemNo++)
+	{
+		snprintf(labelName, sizeof(labelName), "%s_%d", pPrefix, itemNo);
+		FLabelInfo* pLabel = state.GetLabelForAddress(itemAddr);
+		if (pLabel == nullptr)
+			AddLabel(state, itemAddr, labelName, ELabelType::Data, (uint16_t)itemSize)->Global = true;
+		else
+			state.SetLabelName(itemAddr, pLabel, labelName);
+		UpdateGlobalInfoForAddress(state, itemAddr);
+
+		if (state.AdvanceAddressRef(itemAddr, itemSize) == false)
+			break;
+	}
+	state.SetCodeAnalysisDirty(startAddr);
+	return 0;
+}
+
+// Get the code & data items in an address range
+// Returns a flat array of (address, item type, byte size) triples
+static int GetItemsInRange(lua_State* pState)
+{
+	FEmuBase* pEmu = LuaSys::GetEmulator();
+	if (pEmu == nullptr || lua_isinteger(pState, 1) == false || lua_isinteger(pState, 2) == false)
+		return 0;
+
+	FCodeAnalysisState& state = pEmu->GetCodeAnalysis();
+	const int startAddr = (int)lua_tointeger(pState, 1) & 0xffff;
+	const int endAddr = std::min((int)lua_tointeger(pState, 2), 0xffff);
+	const bool bCallback = lua_isfunction(pState, 3);
+
+	if (bCallback == false)
+		lua_newtable(pState);
+
+	int entryNo = 1;
+	int addr = startAddr;
+	while (addr <= endAddr)
+	{
+		const FAddressRef addrRef = state.AddressRefFromPhysicalAddress((uint16_t)addr);
+		const FCodeInfo* pCodeInfo = state.GetCodeInfoForAddress(addrRef);
+		const FItem* pItem = pCodeInfo != nullptr ? (const FItem*)pCodeInfo : (const FItem*)state.GetDataInfoForAddress(addrRef);
+		const int byteSize = std::max((int)pItem->ByteSize, 1);
+
+		if (bCallback)
+		{
+			// callback(address, itemType, byteSize) - return true to stop iterating
+			lua_pushvalue(pState, 3);
+			lua_pushinteger(pState, addr);
+			lua_pushinteger(pState, (int)pItem->Type);
+			lua_pushinteger(pState, byteSize);
+			if (lua_pcall(pState, 3, 1, 0) != LUA_OK)
+			{
+				LuaSys::OutputDebugString("GetItemsInRange callback error: %s", lua_tostring(pState, -1));
+				lua_pop(pState, 1);
+				break;
+			}
+			const bool bStop = lua_toboolean(pState, -1);
+			lua_pop(pState, 1);
+			if (bStop)
+				break;
+		}
+		else
+		{
+			lua_pushinteger(pState, addr);
+			lua_rawseti(pState, -2, entryNo++);
+			lua_pushinteger(pState, (int)pItem->Type);
+			lua_rawseti(pState, -2, entryNo++);
+			lua_pushinteger(pState, byteSize);
+			lua_rawseti(pState, -2, entryNo++);
+		}
+
+		addr += byteSize;
+	}
+
+	return bCallback ? 0 : 1;
+}
 
 // Formatting
 
@@ -521,6 +795,11 @@ static const luaL_Reg corelib[] =
 	{"WriteByte", WriteByte},
 	{"WriteWord", WriteWord},
 	{"GetMemPtr", GetMemPtr},
+	{"ReadBytes", ReadBytes},
+	{"WriteBytes", WriteBytes},
+	{"CreateMemView", CreateMemView},
+	{"GetMemViewPtr", GetMemViewPtr},
+	{"FindMemoryPattern", FindMemoryPattern},
 	{"GetRegValue", GetRegValue},
 	{"RegisterExecutionHandler", RegisterExecutionHandler},
 	{"RemoveExecutionHandler", RemoveExecutionHandler},
@@ -531,6 +810,8 @@ static const luaL_Reg corelib[] =
 	{"AddCommentBlock", AddCommentBlock},
 	{"SetDataItemDisplayType", SetDataItemDisplayType},
 	{"AddDataLabel", AddDataLabel},
+	{"AddDataLabels", AddDataLabels},
+	{"GetItemsInRange", GetItemsInRange},
 	// Formatting
 	{"FormatMemory", FormatMemory},
 	{"FormatMemoryAsBitmap", FormatMemoryAsBitmap},
@@ -549,6 +830,17 @@ static const luaL_Reg corelib[] =
 	{NULL, NULL}    // terminator
 };
 
+// meta table for memory views
+static const luaL_Reg memViewMT[] =
+{
+	{"__index",		MemViewIndex},
+	{"__newindex",	MemViewNewIndex},
+	{"__len",		MemViewLength},
+	{"__tostring",	MemViewToString},
+
+	{NULL, NULL}    // terminator
+};
+
 void AddCoreLibLuaDoc(void)
 {
 	FLuaDocLib& coreLuaDocLib = AddLuaDocLib("Core API");
@@ -561,6 +853,10 @@ int luaopen_corelib(lua_State *pState)
 	lua_getglobal(pState, "_G");
 	luaL_setfuncs(pState, corelib, 0);  // for Lua versions 5.2 or greater
 	lua_pop(pState, 1);
+
+	luaL_newmetatable(pState, "MemViewMT");
+	luaL_setfuncs(pState, memViewMT, 0);
+	lua_pop(pState, 1);
 	return 1;
 }
 
@@ -25,10 +25,34 @@ FAddressRef GetAddressRefFromLua(lua_State* pState, int stackPos)
 	{
 		return state.AddressRefFromPhysicalAddress((uint16_t)lua_tointeger(pState, stackPos));
 	}
+	else if (lua_istable(pState, stackPos))	// { Bank = bankId, Address = address }
+	{
+		lua_getfield(pState, stackPos, "Bank");
+		const bool bValidBank = lua_isinteger(pState, -1);
+		const int16_t bankId = (int16_t)lua_tointeger(pState, -1);
+		lua_pop(pState, 1);
+		lua_getfield(pState, stackPos, "Address");
+		const bool bValidAddress = lua_isinteger(pState, -1);
+		const uint16_t address = (uint16_t)lua_tointeger(pState, -1);
+		lua_pop(pState, 1);
+
+		if (bValidBank && bValidAddress && state.GetBank(bankId) != nullptr)
+			return FAddressRef(bankId, address);
+	}
 
 	return FAddressRef();	// return invalid
 }
 
+// push an address ref as a { Bank = bankId, Address = address } table
+void PushAddressRefToLua(lua_State* pState, FAddressRef addrRef)
+{
+	lua_createtable(pState, 0, 2);
+	lua_pushinteger(pState, addrRef.BankId);
+	lua_setfield(pState, -2, "Bank");
+	lua_pushinteger(pState, addrRef.Address);
+	lua_setfield(pState, -2, "Address");
+}
+
 // table getting functions
 // assumes the table is at the top of the stack
 bool GetLuaTableField(lua_State* pState, const char* fieldName, FAddressRef& value)
@@ -6,6 +6,7 @@ struct lua_State;
 struct FAddressRef;
 
 FAddressRef GetAddressRefFromLua(lua_State* pState, int stackPos = -1);
+void PushAddressRefToLua(lua_State* pState, FAddressRef addrRef);
 bool GetLuaTableField(lua_State* pState, const char* fieldName, FAddressRef& value);
 bool GetLuaTableField(lua_State* pState, const char* fieldName, int& value);
 bool GetLuaTableField(lua_State* pState, const char* fieldName, bool& value);
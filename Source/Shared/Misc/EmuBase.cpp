@@ -8,6 +8,8 @@
 #include <CodeAnalyser/UI/CharacterMapViewer.h>
 #include <CodeAnalyser/DataTypes.h>
 #include "GameConfig.h"
+#include "ExportJob.h"
+#include "EmuThread.h"
 
 #include "Debug/DebugLog.h"
 #include "Debug/ImGuiLog.h"
@@ -77,6 +79,12 @@ bool	FEmuBase::Init(const FEmulatorLaunchConfig& launchConfig)
 
 void FEmuBase::Shutdown()
 {
+	if (pExportJob != nullptr)
+	{
+		pExportJob->Cancel();
+		delete pExportJob;
+		pExportJob = nullptr;
+	}
 	LuaSys::Shutdown();
 }
 
@@ -84,6 +92,88 @@ void FEmuBase::Tick()
 {
 	Colours::Tick();
 	UpdateCharacterSets(CodeAnalysis);
+	TickExportJob();
+}
+
+bool FEmuBase::StartExportJob(FExportJob* pJob)
+{
+	if (pJob == nullptr)
+		return false;
+
+	if (pExportJob != nullptr)
+	{
+		LOGWARNING("Can't start '%s' - an export is already running", pJob->GetDescription());
+		delete pJob;
+		return false;
+	}
+
+	LOGINFO("%s", pJob->GetDescription());
+	pExportJob = pJob;
+	pExportJobProject = pCurrentProjectConfig;
+
+	// the job runs over several frames so stop the machine changing under it
+	bExportJobPausedEmulation = CodeAnalysis.Debugger.IsStopped() == false;
+	if (bExportJobPausedEmulation)
+		CodeAnalysis.Debugger.Break();
+	return true;
+}
+
+void FEmuBase::TickExportJob()
+{
+	if (pExportJob == nullptr)
+		return;
+
+	// the analysis the job is working on has gone
+	if (pCurrentProjectConfig != pExportJobProject)
+	{
+		LOGWARNING("Export cancelled - project changed");
+		pExportJob->Cancel();
+		EndExportJob(false);
+		return;
+	}
+
+	// wait for the break to reach the emulator, or for the user to break again if they continued
+	if (CodeAnalysis.Debugger.IsStopped() == false)
+		return;
+
+	if (pExportJob->Step(kExportJobSliceMs))
+		return;
+
+	if (pExportJob->Succeeded() == false)
+		DisplayErrorMessage("%s failed", pExportJob->GetDescription());
+	EndExportJob(true);
+}
+
+void FEmuBase::EndExportJob(bool bResumeEmulation)
+{
+	delete pExportJob;
+	pExportJob = nullptr;
+
+	if (bResumeEmulation && bExportJobPausedEmulation)
+		CodeAnalysis.Debugger.Continue();
+	bExportJobPausedEmulation = false;
+}
+
+void FEmuBase::DrawExportJobUI()
+{
+	if (pExportJob == nullptr)
+		return;
+
+	ImGui::SetNextWindowSize(ImVec2(400, 0), ImGuiCond_Appearing);
+	if (ImGui::Begin("Export Progress", nullptr, ImGuiWindowFlags_NoCollapse))
+	{
+		ImGui::Text("%s", pExportJob->GetDescription());
+		if (CodeAnalysis.Debugger.IsStopped() == false)
+			ImGui::Text("Waiting for the emulator to pause");
+		ImGui::ProgressBar(pExportJob->GetProgress());
+		if (ImGui::Button("Cancel"))
+		{
+			LOGINFO("Export cancelled");
+			pExportJob->Cancel();
+			EndExportJob(true);
+		}
+	}
+	ImGui::End();
 }
 
 void FEmuBase::Reset()
@@ -144,7 +234,10 @@ bool FEmuBase::DrawDockingView()
 
 		//bQuit = MainMenu();
 		//DrawDebugWindows(uiState);
-		DrawMainMenu();
+		{
+			FEmuThread::FUILock lock(GetEmuThread());
+			DrawMainMenu();
+		}
 		DrawUI();
 		ImGui::End();
 	}
@@ -157,29 +250,36 @@ bool FEmuBase::DrawDockingView()
 	return bQuit;
 }
 
+// With an emulation thread running the state lock is taken per window, so the emulation can carry on in between
 void FEmuBase::DrawUI()
 {
+	FEmuThread* pEmuThread = GetEmuThread();
+
 	// TODO: Make these viewers
 	if (ImGui::Begin("Debugger"))
 	{
+		FEmuThread::FUILock lock(pEmuThread);
 		CodeAnalysis.Debugger.DrawUI();
 	}
 	ImGui::End();
 
 	if (ImGui::Begin("Memory Analyser"))
 	{
+		FEmuThread::FUILock lock(pEmuThread);
 		CodeAnalysis.MemoryAnalyser.DrawUI();
 	}
 	ImGui::End();
 
 	if (ImGui::Begin("IO Analyser"))
 	{
+		FEmuThread::FUILock lock(pEmuThread);
 		CodeAnalysis.IOAnalyser.DrawUI();
 	}
 	ImGui::End();
 
 	if (ImGui::Begin("Static Analysis"))
 	{
+		FEmuThread::FUILock lock(pEmuThread);
 		CodeAnalysis.StaticAnalysis.DrawUI();
 	}
 	ImGui::End();
@@ -190,7 +290,10 @@ void FEmuBase::DrawUI()
 		if (Viewer->bOpen)
 		{
 			if (ImGui::Begin(Viewer->GetName(), &Viewer->bOpen))
+			{
+				FEmuThread::FUILock lock(pEmuThread);
 				Viewer->DrawUI();
+			}
 			ImGui::End();
 		}
 	}
@@ -204,6 +307,7 @@ void FEmuBase::DrawUI()
 		{
 			if (ImGui::Begin(name, &CodeAnalysis.ViewState[codeAnalysisNo].Enabled))
 			{
+				FEmuThread::FUILock lock(pEmuThread);
 				DrawCodeAnalysisData(CodeAnalysis, codeAnalysisNo);
 			}
 			ImGui::End();
@@ -220,7 +324,9 @@ void FEmuBase::DrawUI()
     if (bShowImPlotDemo)
         ImPlot::ShowDemoWindow(&bShowImPlotDemo);
 
+	FEmuThread::FUILock lock(pEmuThread);
 	DrawEmulatorUI();
+	DrawExportJobUI();
     
     LuaSys::DrawUI();
 }
@@ -329,39 +435,23 @@ void FEmuBase::OptionsMenu()
 {
 	if (ImGui::BeginMenu("Number Mode"))
 	{
-		bool bClearCode = false;
+		// code text is keyed on the number mode by the disassembly cache so doesn't need clearing
 		if (ImGui::MenuItem("Decimal", 0, GetNumberDisplayMode() == ENumberDisplayMode::Decimal))
 		{
 			SetNumberDisplayMode(ENumberDisplayMode::Decimal);
 			CodeAnalysis.SetAllBanksDirty();
-			bClearCode = true;
 		}
 		if (ImGui::MenuItem("Hex - FEh", 0, GetNumberDisplayMode() == ENumberDisplayMode::HexAitch))
 		{
 			SetNumberDisplayMode(ENumberDisplayMode::HexAitch);
 			SetHexNumberDisplayMode(ENumberDisplayMode::HexAitch);
 			CodeAnalysis.SetAllBanksDirty();
-			bClearCode = true;
 		}
 		if (ImGui::MenuItem("Hex - $FE", 0, GetNumberDisplayMode() == ENumberDisplayMode::HexDollar))
 		{
 			SetNumberDisplayMode(ENumberDisplayMode::HexDollar);
 			SetHexNumberDisplayMode(ENumberDisplayMode::HexDollar);
 			CodeAnalysis.SetAllBanksDirty();
-			bClearCode = true;
-		}
-
-		// clear code text so it can be written again
-		// TODO: this needs to work for banks
-		if (bClearCode)
-		{
-			for (int i = 0; i < 1 << 16; i++)
-			{
-				FCodeInfo* pCodeInfo = CodeAnalysis.GetCodeInfoForPhysicalAddress(i);
-				if (pCodeInfo && pCodeInfo->Text.empty() == false)
-					pCodeInfo->Text.clear();
-
-			}
 		}
 
 		ImGui::EndMenu();
@@ -444,6 +534,20 @@ void FEmuBase::OptionsMenu()
 		ImGui::EndMenu();
 	}
 
+	// turning these off speeds up emulation
+	if (ImGui::BeginMenu("Analysis Features"))
+	{
+		ImGui::MenuItem("Memory Access Tracking", 0, &CodeAnalysis.bRegisterDataAccesses);
+		ImGui::MenuItem("IO Analysis", 0, &CodeAnalysis.bRegisterIOAccesses);
+		bool bEventTrace = CodeAnalysis.Debugger.IsEventTraceEnabled();
+		if (ImGui::MenuItem("Event Trace", 0, &bEventTrace))
+			CodeAnalysis.Debugger.SetEventTraceEnabled(bEventTrace);
+		bool bRegisterProfiling = CodeAnalysis.RegisterProfiler.IsEnabled();
+		if (ImGui::MenuItem("Register Value Profiling", 0, &bRegisterProfiling))
+			CodeAnalysis.RegisterProfiler.SetEnabled(bRegisterProfiling);
+		ImGui::EndMenu();
+	}
+
 	if (ImGui::BeginMenu("Assembler Exporter"))
 	{
 		const std::map<std::string, FASMExporter*>& exporters = GetAssemblerExporters();
@@ -629,7 +733,11 @@ void FEmuBase::DrawExportAsmModalPopup()
 					if(bExportAsm)
 					{
 						outputFname += ".asm";
-						ExportAssembler(this, outputFname.c_str(), ExportStartAddress, ExportEndAddress);
+						// the exporters are shared so don't start a new one while one is running
+						if (IsExportJobRunning())
+							LOGWARNING("Can't export '%s' - an export is already running", outputFname.c_str());
+						else
+							StartExportJob(CreateAssemblerExportJob(this, outputFname.c_str(), ExportStartAddress, ExportEndAddress));
 					}
 					else if (bExportBinary)
 					{
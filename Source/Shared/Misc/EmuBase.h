@@ -4,6 +4,8 @@
 #include "GamesList.h"
 
 class FEmuBase;
+class FExportJob;
+class FEmuThread;
 class FGraphicsViewer;
 class FCharacterMapViewer;
 
@@ -53,6 +55,9 @@ public:
 	virtual bool	LoadProject(FProjectConfig* pConfig, bool bLoadGame) = 0;
 	virtual bool	SaveProject(void) = 0;
 
+	// emulators which run on a worker thread return it so the UI can take the state lock
+	virtual FEmuThread*	GetEmuThread() { return nullptr; }
+
 	virtual void	OnEnterEditMode(void) {}
 	virtual void	OnExitEditMode(void) {}
 
@@ -68,6 +73,10 @@ public:
 
 	void			AddViewer(FViewerBase* pViewr);
 
+	// Export jobs - takes ownership of the job, only one can run at a time
+	bool			StartExportJob(FExportJob* pJob);
+	bool			IsExportJobRunning() const { return pExportJob != nullptr; }
+
 	void			SetXHighlight(int x) { HighlightXPos = x; }
 	void			SetYHighlight(int y) { HighlightYPos = y; }
 	void			SetScanlineHighlight(int scanline, uint32_t colour = 0x50ffffff) 
@@ -114,6 +123,9 @@ protected:
 
 
 	void			DrawExportAsmModalPopup(void);
+	void			TickExportJob(void);
+	void			EndExportJob(bool bResumeEmulation);
+	void			DrawExportJobUI(void);
 	void			DrawReplaceGameModalPopup(void);
 	void			DrawErrorMessageModalPopup(void);
 
@@ -135,6 +147,11 @@ protected:
 	// Assembler Export
 	uint16_t			ExportStartAddress = 0x0000;
 	uint16_t			ExportEndAddress = 0xffff;
+
+	FExportJob*			pExportJob = nullptr;
+	const FProjectConfig*	pExportJobProject = nullptr;	// job gets cancelled if the project changes
+	bool				bExportJobPausedEmulation = false;	// the emulator is paused while the job runs so it sees one machine state
+	static const int	kExportJobSliceMs = 10;	// time given to the export job each frame
 	
 public:
 	bool		bShowImGuiDemo = false;
@@ -0,0 +1,103 @@
+#include "EmuThread.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "Debug/DebugLog.h"
+
+// don't try to catch up more than this many slices after a stall (e.g. loading a project)
+static const int kMaxCatchUpSlices = 4;
+
+bool FEmuThread::Start(IEmuThreadClient* pEmuClient, uint32_t sliceMicroSeconds)
+{
+	if (bRunning)
+		return false;
+
+	pClient = pEmuClient;
+	SliceMicroSeconds = sliceMicroSeconds;
+	bRunning = true;
+	Thread = std::thread(&FEmuThread::ThreadMain, this);
+	LOGINFO("Emulation thread started");
+	return true;
+}
+
+void FEmuThread::Stop()
+{
+	if (bRunning == false)
+		return;
+
+	bRunning = false;
+	if (Thread.joinable())
+		Thread.join();
+
+	// flush any commands that didn't get processed
+	{
+		std::lock_guard<std::mutex> lock(StateLock);
+
+		FEmuThreadCommand command;
+		while (CommandQueue.Pop(command))
+			pClient->ExecuteEmuThreadCommand(command);
+	}
+	LOGINFO("Emulation thread stopped");
+}
+
+void FEmuThread::ThreadMain()
+{
+	using FClock = std::chrono::steady_clock;
+
+	FClock::time_point lastTime = FClock::now();
+	FClock::time_point fpsTime = lastTime;
+	double timeBudget = 0.0;	// emulated micro seconds we are allowed to run
+	int slicesExecuted = 0;
+
+	while (bRunning)
+	{
+		const FClock::time_point now = FClock::now();
+		const double elapsed = (double)std::chrono::duration_cast<std::chrono::microseconds>(now - lastTime).count();
+		lastTime = now;
+
+		if (bTurboMode)
+		{
+			timeBudget = SliceMicroSeconds;	// unthrottled
+		}
+		else
+		{
+			timeBudget += elapsed * SpeedScale;
+			timeBudget = std::min(timeBudget, (double)SliceMicroSeconds * kMaxCatchUpSlices);
+		}
+
+		if (timeBudget < SliceMicroSeconds)
+		{
+			const int sleepTime = (int)((SliceMicroSeconds - timeBudget) / std::max((float)SpeedScale, 0.01f));
+			std::this_thread::sleep_for(std::chrono::microseconds(std::min(sleepTime, 1000)));
+			continue;
+		}
+
+		// let the UI thread in first if it's waiting
+		while (UIWaiting > 0)
+			std::this_thread::yield();
+
+		{
+			// analysis always runs on the real machine so wait for the UI to finish with it
+			std::lock_guard<std::mutex> lock(StateLock);
+
+			FEmuThreadCommand command;
+			while (CommandQueue.Pop(command))
+				pClient->ExecuteEmuThreadCommand(command);
+
+			pClient->ExecuteEmuThreadSlice(SliceMicroSeconds);
+		}
+
+		timeBudget -= SliceMicroSeconds;
+		slicesExecuted++;
+
+		// update stats once a second
+		const double statsElapsed = (double)std::chrono::duration_cast<std::chrono::microseconds>(FClock::now() - fpsTime).count();
+		if (statsElapsed >= 1000000.0)
+		{
+			EmulatedFPS = (float)(slicesExecuted * 1000000.0 / statsElapsed);
+			slicesExecuted = 0;
+			fpsTime = FClock::now();
+		}
+	}
+}
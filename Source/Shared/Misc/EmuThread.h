@@ -0,0 +1,174 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Commands sent from the UI thread to the emulation thread
+enum class EEmuThreadCommand
+{
+	KeyDown,
+	KeyUp,
+	Joystick,
+	Poke,
+	Debugger,	// Param is an EDebuggerCommand
+};
+
+struct FEmuThreadCommand
+{
+	EEmuThreadCommand	Type = EEmuThreadCommand::Debugger;
+	int					Param = 0;
+	uint16_t			Address = 0;
+	uint8_t				Value = 0;
+};
+
+// Single producer/single consumer queue - UI thread pushes, emulation thread pops
+template <typename T, int kSize>
+class FSPSCQueue
+{
+public:
+	bool Push(const T& item)
+	{
+		const uint32_t head = Head.load(std::memory_order_relaxed);
+		const uint32_t next = (head + 1) % kSize;
+		if (next == Tail.load(std::memory_order_acquire))
+			return false;	// full
+
+		Items[head] = item;
+		Head.store(next, std::memory_order_release);
+		return true;
+	}
+
+	bool Pop(T& item)
+	{
+		const uint32_t tail = Tail.load(std::memory_order_relaxed);
+		if (tail == Head.load(std::memory_order_acquire))
+			return false;	// empty
+
+		item = Items[tail];
+		Tail.store((tail + 1) % kSize, std::memory_order_release);
+		return true;
+	}
+
+private:
+	std::atomic<uint32_t>	Head = { 0 };
+	std::atomic<uint32_t>	Tail = { 0 };
+	T						Items[kSize];
+};
+
+// Triple buffered display - emulation thread writes the back buffer & publishes, UI latches the newest published buffer
+// The buffers are swapped with an atomic index exchange so neither side ever touches a buffer the other is using
+class FEmuDisplayBuffer
+{
+public:
+	void		Init(int width, int height)
+	{
+		Width = width;
+		Height = height;
+		for (int i = 0; i < 3; i++)
+			Buffers[i].assign(width * height, 0);
+	}
+
+	// emulation thread
+	uint32_t*		GetBackBuffer() { return Buffers[BackIndex].data(); }
+	void			Publish()
+	{
+		BackIndex = ReadyIndex.exchange(BackIndex | kFreshBit, std::memory_order_acq_rel) & kIndexMask;
+		FrameNo++;
+	}
+
+	// UI thread - swaps in the newest published buffer if there is one
+	const uint32_t* LatchFrontBuffer()
+	{
+		if (ReadyIndex.load(std::memory_order_acquire) & kFreshBit)
+			FrontIndex = ReadyIndex.exchange(FrontIndex, std::memory_order_acq_rel) & kIndexMask;
+		return Buffers[FrontIndex].data();
+	}
+
+	int				GetFrameNo() const { return FrameNo.load(); }
+	int				GetWidth() const { return Width; }
+	int				GetHeight() const { return Height; }
+private:
+	static const int		kIndexMask = 3;
+	static const int		kFreshBit = 4;	// set when the ready buffer hasn't been latched yet
+
+	std::vector<uint32_t>	Buffers[3];
+	int						BackIndex = 0;		// owned by the emulation thread
+	int						FrontIndex = 1;		// owned by the UI thread
+	std::atomic<int>		ReadyIndex = { 2 };	// last published buffer
+	std::atomic<int>		FrameNo = { 0 };
+	int						Width = 0;
+	int						Height = 0;
+};
+
+// interface the emulator implements to be driven by the emulation thread
+class IEmuThreadClient
+{
+public:
+	// execute a slice of emulated time - called with the state lock held
+	virtual void	ExecuteEmuThreadSlice(uint32_t microSeconds) = 0;
+	// execute a command from the UI thread - called with the state lock held
+	virtual void	ExecuteEmuThreadCommand(const FEmuThreadCommand& command) = 0;
+};
+
+// Runs the emulator on a worker thread, paced against emulated time rather than the UI frame rate
+// The UI thread must hold the state lock (using FEmuThread::FUILock) while it accesses emulator or analysis state
+// The emulation thread blocks on the lock, so the UI should only hold it for short periods - e.g. per window
+class FEmuThread
+{
+public:
+	~FEmuThread() { Stop(); }
+
+	bool	Start(IEmuThreadClient* pClient, uint32_t sliceMicroSeconds);
+	void	Stop();
+	bool	IsRunning() const { return bRunning; }
+	bool	IsEmuThread() const { return std::this_thread::get_id() == Thread.get_id(); }
+
+	bool	PushCommand(const FEmuThreadCommand& command) { return CommandQueue.Push(command); }
+
+	void	SetSpeedScale(float scale) { SpeedScale = scale; }
+	void	SetTurbo(bool bTurbo) { bTurboMode = bTurbo; }
+	bool	IsTurbo() const { return bTurboMode; }
+
+	// stats
+	float	GetEmulatedFPS() const { return EmulatedFPS; }
+
+	// RAII lock for the UI thread - takes priority over the emulation thread
+	// does nothing if there's no emulation thread running
+	class FUILock
+	{
+	public:
+		FUILock(FEmuThread* pThread) : pEmuThread(pThread != nullptr && pThread->IsRunning() ? pThread : nullptr)
+		{
+			if (pEmuThread == nullptr)
+				return;
+			pEmuThread->UIWaiting++;
+			pEmuThread->StateLock.lock();
+			pEmuThread->UIWaiting--;
+		}
+		~FUILock()
+		{
+			if (pEmuThread != nullptr)
+				pEmuThread->StateLock.unlock();
+		}
+	private:
+		FEmuThread*	pEmuThread = nullptr;
+	};
+
+private:
+	void	ThreadMain();
+
+	IEmuThreadClient*		pClient = nullptr;
+	std::thread				Thread;
+	std::mutex				StateLock;
+	std::atomic<int>		UIWaiting = { 0 };
+	std::atomic<bool>		bRunning = { false };
+	std::atomic<bool>		bTurboMode = { false };
+	std::atomic<float>		SpeedScale = { 1.0f };
+	std::atomic<float>		EmulatedFPS = { 0.0f };
+	uint32_t				SliceMicroSeconds = 20000;
+
+	FSPSCQueue<FEmuThreadCommand, 256>	CommandQueue;
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+
+// An export which is run a slice at a time from the emulator tick so big exports don't freeze the UI
+// Steps are run with the emulator state locked so they can use the analysis like the rest of the UI
+// The emulator is paused while a job runs so every step sees the same machine state
+class FExportJob
+{
+public:
+	virtual ~FExportJob() {}
+
+	virtual bool	Step(double timeBudgetMs) = 0;	// returns false when the job has finished
+	virtual void	Cancel() {}	// clean up any partial output
+
+	const char*		GetDescription() const { return Description.c_str(); }
+	float			GetProgress() const { return Progress; }
+	bool			Succeeded() const { return bSuccess; }
+
+protected:
+	std::string		Description;
+	float			Progress = 0.0f;
+	bool			bSuccess = false;
+};
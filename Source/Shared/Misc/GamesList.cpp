@@ -12,6 +12,8 @@ std::unordered_map<std::string, EEmuFileType> g_ExtensionEmuFileType =
 	{"rzx", EEmuFileType::RZX},
 	{"prg", EEmuFileType::PRG},
 	{"crt", EEmuFileType::CRT},
+	{"d64", EEmuFileType::D64},
+	{"t64", EEmuFileType::T64},
 };
 
 EEmuFileType GetEmuFileTypeFromFileName(const std::string& filename)
@@ -73,7 +73,6 @@ bool ExportSkoolFile(FEmuBase* pEmu, bool bHexadecimal, uint16_t startAddr, uint
 	bool bLoadedSkoolFileInfo = LoadSkoolFileInfo(skoolInfo, skoolInfoFname.c_str());
 	
 	const std::string outFname = outDir + filename + ".skool";
-	ExportSkoolFile(pEmu->GetCodeAnalysis(), outFname.c_str(), bHexadecimal ? FSkoolFile::Base::Hexadecimal : FSkoolFile::Base::Decimal, bLoadedSkoolFileInfo ? &skoolInfo : nullptr, startAddr, endAddr);
-
-	return true;
+	FExportJob* pJob = CreateSkoolFileExportJob(pEmu->GetCodeAnalysis(), outFname.c_str(), bHexadecimal ? FSkoolFile::Base::Hexadecimal : FSkoolFile::Base::Decimal, bLoadedSkoolFileInfo ? &skoolInfo : nullptr, startAddr, endAddr);
+	return pEmu->StartExportJob(pJob);
 }
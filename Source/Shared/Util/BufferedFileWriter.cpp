@@ -0,0 +1,104 @@
+#include "BufferedFileWriter.h"
+
+#include <cstring>
+#include <stdarg.h>
+
+bool FBufferedFileWriter::Open(const char* pFilename)
+{
+	Close();
+	FilePtr = fopen(pFilename, "wt");
+	if (FilePtr == nullptr)
+		return false;
+
+	Buffer.resize(kBufferSize);
+	BufferUsed = 0;
+	BytesWritten = 0;
+	bWriteFailed = false;
+	return true;
+}
+
+bool FBufferedFileWriter::Close()
+{
+	if (FilePtr == nullptr)
+		return false;
+
+	Flush();
+	fclose(FilePtr);
+	FilePtr = nullptr;
+	return bWriteFailed == false;
+}
+
+void FBufferedFileWriter::Flush()
+{
+	if (FilePtr == nullptr || BufferUsed == 0)
+		return;
+
+	if (fwrite(Buffer.data(), 1, BufferUsed, FilePtr) != BufferUsed)
+		bWriteFailed = true;
+	BufferUsed = 0;
+}
+
+void FBufferedFileWriter::Write(const char* pData, size_t noBytes)
+{
+	if (FilePtr == nullptr)
+		return;
+
+	BytesWritten += noBytes;
+
+	// big blocks go straight out
+	if (noBytes >= kBufferSize)
+	{
+		Flush();
+		if (fwrite(pData, 1, noBytes, FilePtr) != noBytes)
+			bWriteFailed = true;
+		return;
+	}
+
+	if (BufferUsed + noBytes > kBufferSize)
+		Flush();
+	memcpy(Buffer.data() + BufferUsed, pData, noBytes);
+	BufferUsed += noBytes;
+}
+
+void FBufferedFileWriter::Printf(const char* pFormat, ...)
+{
+	char stringBuffer[256];
+	va_list ap;
+	va_start(ap, pFormat);
+	const int len = vsnprintf(stringBuffer, sizeof(stringBuffer), pFormat, ap);
+	va_end(ap);
+	if (len < 0)
+		return;
+
+	if (len < (int)sizeof(stringBuffer))
+	{
+		Write(stringBuffer, len);
+	}
+	else
+	{
+		// too long for the stack buffer
+		std::string longString(len + 1, '\0');
+		va_start(ap, pFormat);
+		vsnprintf(&longString[0], longString.size(), pFormat, ap);
+		va_end(ap);
+		Write(longString.c_str(), len);
+	}
+}
+
+bool FBufferedFileWriter::AppendFile(const char* pFilename)
+{
+	FILE* fp = fopen(pFilename, "rt");	// text mode so line endings don't get converted twice
+	if (fp == nullptr)
+		return false;
+
+	Flush();
+	size_t bytesRead = 0;
+	while ((bytesRead = fread(Buffer.data(), 1, kBufferSize, fp)) > 0)
+	{
+		BufferUsed = bytesRead;
+		BytesWritten += bytesRead;
+		Flush();
+	}
+	fclose(fp);
+	return true;
+}
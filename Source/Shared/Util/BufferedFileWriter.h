@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Text file writer which collects output in a fixed size buffer and writes it out in large blocks
+// so exporters can stream their output without building the whole file in memory
+class FBufferedFileWriter
+{
+public:
+	~FBufferedFileWriter() { Close(); }
+
+	bool	Open(const char* pFilename);
+	bool	Close();	// flushes - returns false if any write failed
+	bool	IsOpen() const { return FilePtr != nullptr; }
+
+	void	Write(const char* pData, size_t noBytes);
+	void	Write(const std::string& str) { Write(str.c_str(), str.size()); }
+	void	Printf(const char* pFormat, ...);
+	bool	AppendFile(const char* pFilename);	// copy the contents of another file to the output
+	void	Flush();
+
+	size_t	GetBytesWritten() const { return BytesWritten; }
+
+	static const size_t	kBufferSize = 64 * 1024;
+private:
+	FILE*				FilePtr = nullptr;
+	std::vector<char>	Buffer;
+	size_t				BufferUsed = 0;
+	size_t				BytesWritten = 0;
+	bool				bWriteFailed = false;
+};
@@ -116,9 +116,12 @@ void *LoadBinaryFile(const char *pFilename, size_t &byteCount)
 	fseek(fp, 0, SEEK_END);
 	byteCount = ftell(fp);
 	fseek(fp, 0, SEEK_SET);
-	void *pFileData = malloc(byteCount);
+	void *pFileData = malloc(byteCount > 0 ? byteCount : 1);	// empty files still get a buffer
 	if (pFileData == nullptr)
+	{
+		fclose(fp);
 		return nullptr;
+	}
 	fread(pFileData, byteCount, 1, fp);
 	fclose(fp);
 
@@ -3,6 +3,7 @@
 #include <imgui.h>
 #include <ImGuiSupport/ImGuiTexture.h>
 #include <ImGuiSupport/ImGuiScaling.h>
+#include "PixelExpand.h"
 #include <cstdint>
 #include <vector>
 
@@ -65,14 +66,7 @@ void FGraphicsView::Draw(bool bMagnifier)
 void FGraphicsView::DrawCharLine(uint8_t charLine, int xp, int yp, uint32_t inkCol, uint32_t paperCol)
 {
 	uint32_t* pBase = PixelBuffer + (xp + (yp * Width));
-
-	for (int xpix = 0; xpix < 8; xpix++)
-	{
-		const bool bSet = (charLine & (1 << (7 - xpix))) != 0;
-		const uint32_t col = bSet ? inkCol : paperCol;
-		if (col != 0xFF000000)
-			*(pBase + xpix) = col;
-	}
+	Expand1BppSpan(pBase, charLine, Get1BppWriteMask(charLine, paperCol != 0xFF000000, inkCol != 0xFF000000), paperCol, inkCol);
 }
 
 void FGraphicsView::DrawMaskedCharLine(uint8_t charLine, uint8_t maskLine, int xp, int yp, uint32_t inkCol, uint32_t paperCol)
@@ -95,6 +89,8 @@ void FGraphicsView::Draw1BppImageAt(const uint8_t* pSrc, int xp, int yp, int wid
 	uint32_t* pBase = PixelBuffer + (xp + (yp * Width));
 	int widthChars = widthPixels / 8;
 	assert((widthPixels & 7) == 0);	// we don't currently support sub character widths - maybe you should implement it?
+	const bool bDrawPaper = cols[0] != 0xFF000000;
+	const bool bDrawInk = cols[1] != 0xFF000000;
 
 	for (int y = 0; y < heightPixels; y++)
 	{
@@ -103,13 +99,7 @@ void FGraphicsView::Draw1BppImageAt(const uint8_t* pSrc, int xp, int yp, int wid
 			const uint8_t charLine = *pSrc;
 			pSrc+=stride;
 
-			for (int xpix = 0; xpix < 8; xpix++)
-			{
-				const bool bSet = (charLine & (1 << (7 - xpix))) != 0;
-				const uint32_t col = bSet ? cols[1] : cols[0];
-				if (col != 0xFF000000)
-					*(pBase + xpix + (x * 8)) = col;
-			}
+			Expand1BppSpan(pBase + (x * 8), charLine, Get1BppWriteMask(charLine, bDrawPaper, bDrawInk), cols[0], cols[1]);
 		}
 
 		pBase += Width;
@@ -130,14 +120,7 @@ void FGraphicsView::Draw1BppImageAtMask(const uint8_t* pSrc, int xp, int yp, int
 			const uint8_t pixels = *pSrc;
 			pSrc += stride;
 
-			for (int xpix = 0; xpix < 8; xpix++)
-			{
-				const bool bMasked = (mask & (1 << (7 - xpix))) != 0;
-				const bool bSet = (pixels & (1 << (7 - xpix))) != 0;
-				const uint32_t col = bSet ? cols[1] : cols[0];
-				if (bMasked == false)
-					*(pBase + xpix + (x * 8)) = col;
-			}
+			Expand1BppSpan(pBase + (x * 8), pixels, (uint8_t)~mask, cols[0], cols[1]);
 		}
 
 		pBase += Width;
@@ -149,36 +132,11 @@ void FGraphicsView::Draw2BppImageAt(const uint8_t* pSrc, int xp, int yp, int wid
 	uint32_t* pBase = PixelBuffer + (xp + (yp * Width));
 	const int bytesPerLine = widthPixels / 4;
 	assert((widthPixels & 7) == 0);	// we don't currently support sub character widths - maybe you should implement it?
-	
+
 	for (int y = 0; y < heightPixels; y++)
 	{
-		for (int x = 0; x < bytesPerLine; x++)
-		{
-			const uint8_t val = *pSrc++;
-
-			for (int xpix = 0; xpix < 4; xpix++)
-			{
-				uint8_t colNo = 0;
-
-				switch (xpix)
-				{
-				case 0:
-					colNo = (val & 0x8 ? 2 : 0) | (val & 0x80 ? 1 : 0);
-					break;
-				case 1:
-					colNo = (val & 0x4 ? 2 : 0) | (val & 0x40 ? 1 : 0);
-					break;
-				case 2:
-					colNo = (val & 0x2 ? 2 : 0) | (val & 0x20 ? 1 : 0);
-					break;
-				case 3:
-					colNo = (val & 0x1 ? 2 : 0) | (val & 0x10 ? 1 : 0);
-					break;
-				}
-				const uint32_t pixelCol = cols ? cols[colNo] : colNo == 0 ? 0 : 0xffffffff;
-				*(pBase + xpix + (x * 4)) = pixelCol;
-			}
-		}
+		Expand2BppSpan(pBase, pSrc, bytesPerLine, cols);
+		pSrc += bytesPerLine;
 		pBase += Width;
 	}
 }
@@ -189,23 +147,10 @@ void FGraphicsView::Draw2BppWideImageAt(const uint8_t* pSrc, int xp, int yp, int
 	int widthChars = widthPixels / 8;
 	assert((widthPixels & 7) == 0);	// we don't currently support sub character widths - maybe you should implement it?
 
-	//*pBase = 0;
 	for (int y = 0; y < heightPixels; y++)
 	{
-		for (int x = 0; x < widthChars; x++)
-		{
-			const uint8_t charLine = *pSrc++;
-
-			for (int xpix = 0; xpix < 4; xpix++)
-			{
-				const uint8_t colNo = (charLine >> (6 - (xpix * 2))) & 3;
-
-				// 0 check for sprites?
-				*(pBase + (xpix * 2) + (x * 8)) = cols[colNo];
-				*(pBase + (xpix * 2) + 1 + (x * 8)) = cols[colNo];
-			}
-		}
-
+		Expand2BppWideSpan(pBase, pSrc, widthChars, cols);	// 0 check for sprites?
+		pSrc += widthChars;
 		pBase += Width;
 	}
 }
@@ -222,23 +167,8 @@ void FGraphicsView::Draw4BppWideImageAt(const uint8_t* pSrc, int xp, int yp, int
 
 	for (int y = 0; y < heightPixels; y++)
 	{
-		for (int x = 0; x < bytesPerLine; x++)
-		{
-			const uint8_t val = *pSrc++;
-
-			for (int xpix = 0; xpix < 2; xpix++)
-			{
-				uint8_t colNo = 0;
-
-				if (xpix == 0)
-					colNo = (val & 0x80 ? 1 : 0) | (val & 0x8 ? 2 : 0) | (val & 0x20 ? 4 : 0) | (val & 0x2 ? 8 : 0);
-				else 
-					colNo = (val & 0x40 ? 1 : 0) | (val & 0x4 ? 2 : 0) | (val & 0x10 ? 4 : 0) | (val & 0x1 ? 8 : 0);
-
-				*(pBase + (xpix*2) + (x * 4)) = cols[colNo];
-				*(pBase + (xpix*2) + 1 + (x * 4)) = cols[colNo];
-			}
-		}
+		Expand4BppWideSpan(pBase, pSrc, bytesPerLine, cols);
+		pSrc += bytesPerLine;
 		pBase += Width;
 	}
 }
@@ -387,6 +317,7 @@ static std::vector<FCharacterSet*>	g_CharacterSets;
 static std::vector<FCharacterMap*>	g_CharacterMaps;
 
 void UpdateCharacterSetImage(FCodeAnalysisState& state, FCharacterSet& characterSet);
+void RefreshCharacterSetImage(FCodeAnalysisState& state, FCharacterSet& characterSet);
 
 
 void InitCharacterSets()
@@ -409,7 +340,7 @@ void UpdateCharacterSets(FCodeAnalysisState& state)
 	for (auto& it : g_CharacterSets)
 	{
 		if(it->Params.bDynamic)
-			UpdateCharacterSetImage(state, *it);
+			RefreshCharacterSetImage(state, *it);
 	}
 }
 
@@ -442,35 +373,81 @@ FCharacterSet* GetCharacterSetFromAddress(FAddressRef address)
 	return nullptr;
 }
 
-void DrawCharacterSetImage2BppCPC(FCodeAnalysisState& state, FCharacterSet& characterSet, uint16_t addr)
+static const int kCharSetCompareInterval = 50;	// updates between byte compares - catches writes the analyser doesn't see
+
+// number of bytes each glyph is drawn from - the attribute goes on the end for MemoryLUT
+static int GetCharacterSetGlyphSize(const FCharSetCreateParams& params)
 {
-	for (int charNo = 0; charNo < 256; charNo++)
+	switch (params.BitmapFormat)
+	{
+	case EBitmapFormat::Bitmap_1Bpp:
+	{
+		int glyphSize = 8;
+		if (params.MaskInfo == EMaskInfo::InterleavedBytesPM || params.MaskInfo == EMaskInfo::InterleavedBytesMP)
+			glyphSize += 8;
+		if (params.ColourInfo != EColourInfo::None)
+			glyphSize++;
+		return glyphSize;
+	}
+	case EBitmapFormat::ColMap2Bpp_CPC:
+		return 16;	// 2bpp * 8
+	case EBitmapFormat::ColMapMulticolour_C64:
+		return 8;	// half res pixels
+	default:
+		return 0;
+	}
+}
+
+static void GetCharacterSetPages(FCodeAnalysisState& state, const FCharSetCreateParams& params, std::vector<const FCodeAnalysisPage*>& outPages)
+{
+	const bool bAttribLUT = params.ColourInfo == EColourInfo::MemoryLUT && params.BitmapFormat == EBitmapFormat::Bitmap_1Bpp;
+	const int dataSize = 256 * (GetCharacterSetGlyphSize(params) - (bAttribLUT ? 1 : 0));
+
+	outPages.clear();
+	for (int addr = params.Address.Address & ~FCodeAnalysisPage::kPageMask; addr < params.Address.Address + dataSize; addr += FCodeAnalysisPage::kPageSize)
+		outPages.push_back(state.GetReadPage((uint16_t)addr));
+	if (bAttribLUT)
 	{
-		const uint8_t* pCharData = state.CPUInterface->GetMemPtr(addr);
-		const int xp = (charNo & 15) * 8;
-		const int yp = (charNo >> 4) * 8;
+		for (int addr = params.AttribsAddress.Address & ~FCodeAnalysisPage::kPageMask; addr < params.AttribsAddress.Address + 256; addr += FCodeAnalysisPage::kPageSize)
+			outPages.push_back(state.GetReadPage((uint16_t)addr));
+	}
+}
 
-		const uint32_t* pPaletteColours = GetPaletteFromPaletteNo(characterSet.Params.PaletteNo);
-		characterSet.Image->Draw2BppImageAt(pCharData, xp, yp, 8, 8, pPaletteColours);
-		addr += 16; // 2bpp * 8
+// colours the glyphs get drawn with - the palette or LUT contents can change without the params changing
+static void GetCharacterSetColours(const FCharSetCreateParams& params, std::vector<uint32_t>& outColours)
+{
+	outColours.clear();
+	if (params.BitmapFormat == EBitmapFormat::Bitmap_1Bpp)
+	{
+		if (params.ColourInfo != EColourInfo::None && params.ColourLUT != nullptr)
+			outColours.assign(params.ColourLUT, params.ColourLUT + 8);
+	}
+	else if (const FPaletteEntry* pPaletteEntry = GetPaletteEntry(params.PaletteNo))
+	{
+		const uint32_t* pPalette = GetPaletteFromPaletteNo(params.PaletteNo);
+		outColours.assign(pPalette, pPalette + pPaletteEntry->NoColours);
 	}
 }
 
-void DrawCharacterSetImageMultiColourC64(FCodeAnalysisState& state, FCharacterSet& characterSet, uint16_t addr)
+static void ReadCharacterSetGlyphData(FCodeAnalysisState& state, const FCharSetCreateParams& params, std::vector<uint8_t>& outData)
 {
+	const bool bAttribLUT = params.ColourInfo == EColourInfo::MemoryLUT && params.BitmapFormat == EBitmapFormat::Bitmap_1Bpp;
+	const int glyphSize = GetCharacterSetGlyphSize(params);
+	const int bitmapSize = glyphSize - (bAttribLUT ? 1 : 0);
+	uint16_t addr = params.Address.Address;
+
+	outData.resize(256 * glyphSize);
 	for (int charNo = 0; charNo < 256; charNo++)
 	{
-		const uint8_t* pCharData = state.CPUInterface->GetMemPtr(addr);
-		const int xp = (charNo & 15) * 8;
-		const int yp = (charNo >> 4) * 8;
-
-		const uint32_t* pPaletteColours = GetPaletteFromPaletteNo(characterSet.Params.PaletteNo);
-		characterSet.Image->Draw2BppWideImageAt(pCharData, xp, yp, 8, 8, pPaletteColours);
-		addr += 8; // half res pixels
+		uint8_t* pGlyph = &outData[charNo * glyphSize];
+		for (int i = 0; i < bitmapSize; i++)
+			pGlyph[i] = state.ReadByte(addr++);
+		if (bAttribLUT)
+			pGlyph[bitmapSize] = state.ReadByte(params.AttribsAddress.Address + charNo);
 	}
 }
 
-void DrawCharacterSetImage1Bpp(FCodeAnalysisState& state, FCharacterSet& characterSet, uint16_t addr)
+void DrawCharacterSetGlyph1Bpp(FCharacterSet& characterSet, const uint8_t* pGlyph, int xp, int yp)
 {
 	// TODO: these are speccy specific, put in config
 	const uint8_t brightMask = 1 << 6;
@@ -479,75 +456,135 @@ void DrawCharacterSetImage1Bpp(FCodeAnalysisState& state, FCharacterSet& charact
 	const uint8_t paperMask = 7;
 	const uint8_t paperShift = 3;
 
-	for (int charNo = 0; charNo < 256; charNo++)
-	{
-		const uint8_t* pCharData = state.CPUInterface->GetMemPtr(addr);
-		const int xp = (charNo & 15) * 8;
-		const int yp = (charNo >> 4) * 8;
-		uint32_t cols[2] = { 0,0xffffffff };
-		uint8_t colAttr = 0xff;
-		uint8_t charPix[8];
-		uint8_t charMask[8];
-
-		if (characterSet.Params.ColourInfo == EColourInfo::InterleavedPre)
-			colAttr = state.ReadByte(addr++);
+	uint32_t cols[2] = { 0,0xffffffff };
+	uint8_t colAttr = 0xff;
+	uint8_t charPix[8];
+	uint8_t charMask[8];
 
-		for (int i = 0; i < 8; i++)
-		{
-			if (characterSet.Params.MaskInfo == EMaskInfo::InterleavedBytesMP)
-				charMask[i] = state.ReadByte(addr++);
-			charPix[i] = state.ReadByte(addr++);
-			if (characterSet.Params.MaskInfo == EMaskInfo::InterleavedBytesPM)
-				charMask[i] = state.ReadByte(addr++);
-		}
+	if (characterSet.Params.ColourInfo == EColourInfo::InterleavedPre)
+		colAttr = *pGlyph++;
 
-		// Get colour from colour info
-		switch (characterSet.Params.ColourInfo)
-		{
-            case EColourInfo::MemoryLUT:
-                colAttr = state.ReadByte(characterSet.Params.AttribsAddress.Address + charNo);
-                break;
-            case EColourInfo::InterleavedPost:
-                colAttr = state.ReadByte(addr++);
-                break;
-            default:
-                break;
-		}
+	for (int i = 0; i < 8; i++)
+	{
+		if (characterSet.Params.MaskInfo == EMaskInfo::InterleavedBytesMP)
+			charMask[i] = *pGlyph++;
+		charPix[i] = *pGlyph++;
+		if (characterSet.Params.MaskInfo == EMaskInfo::InterleavedBytesPM)
+			charMask[i] = *pGlyph++;
+	}
 
-		if (colAttr != 0xff)
-		{
-			// get ink & paper
-			const bool bBright = !!(colAttr & brightMask);
-			cols[0] = GetColFromAttr((colAttr >> paperShift) & paperMask, characterSet.Params.ColourLUT, bBright);
-			cols[1] = GetColFromAttr((colAttr >> inkShift) & inkMask, characterSet.Params.ColourLUT, bBright);
-		}
+	// Get colour from colour info
+	switch (characterSet.Params.ColourInfo)
+	{
+        case EColourInfo::MemoryLUT:
+        case EColourInfo::InterleavedPost:
+            colAttr = *pGlyph++;
+            break;
+        default:
+            break;
+	}
 
-		characterSet.Image->Draw1BppImageAt(charPix, xp, yp, 8, 8, cols);
+	if (colAttr != 0xff)
+	{
+		// get ink & paper
+		const bool bBright = !!(colAttr & brightMask);
+		cols[0] = GetColFromAttr((colAttr >> paperShift) & paperMask, characterSet.Params.ColourLUT, bBright);
+		cols[1] = GetColFromAttr((colAttr >> inkShift) & inkMask, characterSet.Params.ColourLUT, bBright);
 	}
+
+	characterSet.Image->Draw1BppImageAt(charPix, xp, yp, 8, 8, cols);
 }
 
-// This function assumes the data is mapped in memory
-void UpdateCharacterSetImage(FCodeAnalysisState& state, FCharacterSet& characterSet)
+void DrawCharacterSetGlyph(FCharacterSet& characterSet, int charNo, const uint8_t* pGlyph)
 {
-	const uint16_t addr = characterSet.Params.Address.Address;
+	const int xp = (charNo & 15) * 8;
+	const int yp = (charNo >> 4) * 8;
 
-	characterSet.Image->Clear(0);	// clear first
+	// clear the old glyph first
+	uint32_t* pPixels = characterSet.Image->GetPixelBuffer() + xp + (yp * characterSet.Image->GetWidth());
+	for (int y = 0; y < 8; y++)
+		memset(pPixels + (y * characterSet.Image->GetWidth()), 0, 8 * sizeof(uint32_t));
 
 	switch (characterSet.Params.BitmapFormat)
 	{
 	case EBitmapFormat::Bitmap_1Bpp:
-		DrawCharacterSetImage1Bpp(state, characterSet, addr);
+		DrawCharacterSetGlyph1Bpp(characterSet, pGlyph, xp, yp);
 		break;
 	case EBitmapFormat::ColMap2Bpp_CPC:
-		DrawCharacterSetImage2BppCPC(state, characterSet, addr);
+		characterSet.Image->Draw2BppImageAt(pGlyph, xp, yp, 8, 8, GetPaletteFromPaletteNo(characterSet.Params.PaletteNo));
 		break;
 	case EBitmapFormat::ColMapMulticolour_C64:
-		DrawCharacterSetImageMultiColourC64(state, characterSet, addr);
+		characterSet.Image->Draw2BppWideImageAt(pGlyph, xp, yp, 8, 8, GetPaletteFromPaletteNo(characterSet.Params.PaletteNo));
+		break;
+	default:
 		break;
-    default:
-        break;
 	}
+}
 
+// Redraw the glyphs that have changed since the last update
+// Memory is only looked at when a page the set comes from has been written to, or the mapping or colours have changed
+// This function assumes the data is mapped in memory
+void RefreshCharacterSetImage(FCodeAnalysisState& state, FCharacterSet& characterSet)
+{
+	static std::vector<const FCodeAnalysisPage*> pages;
+	GetCharacterSetPages(state, characterSet.Params, pages);
+	static std::vector<uint32_t> colours;
+	GetCharacterSetColours(characterSet.Params, colours);
+	const bool bColoursChanged = colours != characterSet.GlyphColours;
+
+	// without access tracking we won't know about writes so keep comparing
+	bool bCompare = state.bRegisterDataAccesses == false || characterSet.GlyphData.empty() || pages != characterSet.Pages || bColoursChanged;
+	if (++characterSet.UpdatesSinceCompare >= kCharSetCompareInterval)
+		bCompare = true;
+	for (size_t i = 0; i < pages.size() && bCompare == false; i++)
+	{
+		if (pages[i]->WriteGeneration != characterSet.PageWriteGenerations[i])
+			bCompare = true;
+	}
+	if (bCompare == false)
+		return;
+
+	characterSet.UpdatesSinceCompare = 0;
+	characterSet.Pages = pages;
+	characterSet.PageWriteGenerations.clear();
+	for (const FCodeAnalysisPage* pPage : pages)
+		characterSet.PageWriteGenerations.push_back(pPage->WriteGeneration);
+
+	static std::vector<uint8_t> glyphData;
+	ReadCharacterSetGlyphData(state, characterSet.Params, glyphData);
+	const int glyphSize = GetCharacterSetGlyphSize(characterSet.Params);
+	if (glyphSize == 0)
+		return;
+
+	const bool bRedrawAll = characterSet.GlyphData.size() != glyphData.size() || bColoursChanged;
+	characterSet.GlyphColours = colours;
+	bool bChanged = false;
+	for (int charNo = 0; charNo < 256; charNo++)
+	{
+		const uint8_t* pGlyph = &glyphData[charNo * glyphSize];
+		if (bRedrawAll == false && memcmp(pGlyph, &characterSet.GlyphData[charNo * glyphSize], glyphSize) == 0)
+			continue;
+
+		if (bChanged == false)
+			characterSet.ImageGeneration++;
+		bChanged = true;
+		DrawCharacterSetGlyph(characterSet, charNo, pGlyph);
+		characterSet.GlyphGenerations[charNo] = characterSet.ImageGeneration;
+	}
+
+	if (bChanged)
+	{
+		characterSet.GlyphData.swap(glyphData);
+		characterSet.Image->UpdateTexture();
+	}
+}
+
+// Redraw all the glyphs
+void UpdateCharacterSetImage(FCodeAnalysisState& state, FCharacterSet& characterSet)
+{
+	characterSet.Image->Clear(0);	// clear first
+	characterSet.GlyphData.clear();
+	RefreshCharacterSetImage(state, characterSet);
 	characterSet.Image->UpdateTexture();
 }
 
@@ -574,7 +611,7 @@ bool CreateCharacterSetAt(FCodeAnalysisState& state, const FCharSetCreateParams&
 		const int kLabelSize = 32;
 		char label[kLabelSize] = { 0 };
 		snprintf(label, kLabelSize, "charset_%04X", params.Address.Address);
-		pLabel->ChangeName(label);
+		state.SetLabelName(params.Address, pLabel, label);
 	}
 
 	g_CharacterSets.push_back(pNewCharSet);
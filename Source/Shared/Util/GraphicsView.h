@@ -2,10 +2,12 @@
 
 #include <cstdint>
 #include <cstring>
+#include <vector>
 #include <json_fwd.hpp>
 #include "CodeAnalyser/CodeAnalyserTypes.h"
 
 class FCodeAnalysisState;
+struct FCodeAnalysisPage;
 
 // this is a surface on which to draw game graphics
 class FGraphicsView
@@ -117,6 +119,15 @@ struct FCharacterSet
 	FCharSetCreateParams	Params;
 
 	FGraphicsView*	Image = nullptr;	
+
+	// glyphs are only redrawn when the pages they come from have been written to
+	std::vector<const FCodeAnalysisPage*>	Pages;
+	std::vector<uint32_t>	PageWriteGenerations;
+	std::vector<uint8_t>	GlyphData;	// bytes each glyph was last drawn from
+	std::vector<uint32_t>	GlyphColours;	// palette or colour LUT the glyphs were drawn with
+	int						UpdatesSinceCompare = 0;
+	uint32_t				ImageGeneration = 0;	// bumped whenever any glyph gets redrawn
+	uint32_t				GlyphGenerations[256] = { 0 };	// ImageGeneration when each glyph was last redrawn
 };
 
 // Character Maps
@@ -13,6 +13,14 @@ public:
 	void	ResetPosition() { ReadPosition = 0; }
 	void	WriteBytes(const void* pData, size_t noBytes);
 	bool	ReadBytes(void* Dest, size_t noBytes);
+	bool	Skip(size_t noBytes)
+	{
+		if (ReadPosition + noBytes > CurrentSize)
+			return false;
+		ReadPosition += noBytes;
+		return true;
+	}
+	size_t	BytesRemaining() const { return CurrentSize - ReadPosition; }
 
 	template <class T>
 	void	Write(T item) { WriteBytes(&item, sizeof(T)); }
@@ -0,0 +1,66 @@
+#include "PixelExpand.h"
+
+// colour index of each pixel for every byte value
+struct FPixelIndexTables
+{
+	FPixelIndexTables()
+	{
+		for (int val = 0; val < 256; val++)
+		{
+			for (int xpix = 0; xpix < 4; xpix++)
+			{
+				CPCMode1[val][xpix] = (((val >> (3 - xpix)) & 1) << 1) | ((val >> (7 - xpix)) & 1);
+				Multicolour[val][xpix] = (val >> (6 - (xpix * 2))) & 3;
+			}
+			CPCMode0[val][0] = (val & 0x80 ? 1 : 0) | (val & 0x8 ? 2 : 0) | (val & 0x20 ? 4 : 0) | (val & 0x2 ? 8 : 0);
+			CPCMode0[val][1] = (val & 0x40 ? 1 : 0) | (val & 0x4 ? 2 : 0) | (val & 0x10 ? 4 : 0) | (val & 0x1 ? 8 : 0);
+		}
+	}
+
+	uint8_t	CPCMode1[256][4];		// 2bpp, pixel bits interleaved across the nibbles
+	uint8_t	CPCMode0[256][2];		// 4bpp, pixel bits interleaved
+	uint8_t	Multicolour[256][4];	// 2bpp bit pairs, e.g. C64 multicolour
+};
+
+static const FPixelIndexTables g_PixelIndexTables;
+
+void Expand2BppSpan(uint32_t* pDest, const uint8_t* pSrc, int noBytes, const uint32_t* cols)
+{
+	static const uint32_t kDefaultCols[4] = { 0, 0xffffffff, 0xffffffff, 0xffffffff };
+	if (cols == nullptr)
+		cols = kDefaultCols;
+
+	for (int x = 0; x < noBytes; x++)
+	{
+		const uint8_t* pColNo = g_PixelIndexTables.CPCMode1[*pSrc++];
+		pDest[0] = cols[pColNo[0]];
+		pDest[1] = cols[pColNo[1]];
+		pDest[2] = cols[pColNo[2]];
+		pDest[3] = cols[pColNo[3]];
+		pDest += 4;
+	}
+}
+
+void Expand2BppWideSpan(uint32_t* pDest, const uint8_t* pSrc, int noBytes, const uint32_t* cols)
+{
+	for (int x = 0; x < noBytes; x++)
+	{
+		const uint8_t* pColNo = g_PixelIndexTables.Multicolour[*pSrc++];
+		pDest[0] = pDest[1] = cols[pColNo[0]];
+		pDest[2] = pDest[3] = cols[pColNo[1]];
+		pDest[4] = pDest[5] = cols[pColNo[2]];
+		pDest[6] = pDest[7] = cols[pColNo[3]];
+		pDest += 8;
+	}
+}
+
+void Expand4BppWideSpan(uint32_t* pDest, const uint8_t* pSrc, int noBytes, const uint32_t* cols)
+{
+	for (int x = 0; x < noBytes; x++)
+	{
+		const uint8_t* pColNo = g_PixelIndexTables.CPCMode0[*pSrc++];
+		pDest[0] = pDest[1] = cols[pColNo[0]];
+		pDest[2] = pDest[3] = cols[pColNo[1]];
+		pDest += 4;
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+
+// Pixel expansion for the graphics views
+// 1bpp spans are expanded with SIMD compares, the multi-colour formats go through byte->colour index tables
+// All the 1bpp variants the compiler supports are available so they can be tested against each other
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define PIXELEXPAND_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PIXELEXPAND_SSE2 1
+#endif
+
+// write 8 pixels from a 1bpp byte, only where writeMask bits are set
+inline void Expand1BppSpan_Scalar(uint32_t* pDest, uint8_t pixels, uint8_t writeMask, uint32_t paperCol, uint32_t inkCol)
+{
+	const uint32_t cols[2] = { paperCol, inkCol };
+	if (writeMask == 0xff)
+	{
+		pDest[0] = cols[(pixels >> 7) & 1];
+		pDest[1] = cols[(pixels >> 6) & 1];
+		pDest[2] = cols[(pixels >> 5) & 1];
+		pDest[3] = cols[(pixels >> 4) & 1];
+		pDest[4] = cols[(pixels >> 3) & 1];
+		pDest[5] = cols[(pixels >> 2) & 1];
+		pDest[6] = cols[(pixels >> 1) & 1];
+		pDest[7] = cols[pixels & 1];
+	}
+	else
+	{
+		for (int xpix = 0; xpix < 8; xpix++)
+		{
+			if (writeMask & (0x80 >> xpix))
+				pDest[xpix] = cols[(pixels >> (7 - xpix)) & 1];
+		}
+	}
+}
+
+#if PIXELEXPAND_SSE2
+inline void Expand1BppSpan_SSE2(uint32_t* pDest, uint8_t pixels, uint8_t writeMask, uint32_t paperCol, uint32_t inkCol)
+{
+	const __m128i laneBitsLo = _mm_setr_epi32(0x80, 0x40, 0x20, 0x10);
+	const __m128i laneBitsHi = _mm_setr_epi32(0x08, 0x04, 0x02, 0x01);
+	const __m128i pixelBits = _mm_set1_epi32(pixels);
+	const __m128i paper = _mm_set1_epi32((int)paperCol);
+	const __m128i ink = _mm_set1_epi32((int)inkCol);
+	const __m128i setLo = _mm_cmpeq_epi32(_mm_and_si128(pixelBits, laneBitsLo), laneBitsLo);
+	const __m128i setHi = _mm_cmpeq_epi32(_mm_and_si128(pixelBits, laneBitsHi), laneBitsHi);
+	__m128i colsLo = _mm_or_si128(_mm_and_si128(setLo, ink), _mm_andnot_si128(setLo, paper));
+	__m128i colsHi = _mm_or_si128(_mm_and_si128(setHi, ink), _mm_andnot_si128(setHi, paper));
+	if (writeMask != 0xff)	// keep the unwritten pixels
+	{
+		const __m128i writeBits = _mm_set1_epi32(writeMask);
+		const __m128i writeLo = _mm_cmpeq_epi32(_mm_and_si128(writeBits, laneBitsLo), laneBitsLo);
+		const __m128i writeHi = _mm_cmpeq_epi32(_mm_and_si128(writeBits, laneBitsHi), laneBitsHi);
+		colsLo = _mm_or_si128(_mm_and_si128(writeLo, colsLo), _mm_andnot_si128(writeLo, _mm_loadu_si128((const __m128i*)pDest)));
+		colsHi = _mm_or_si128(_mm_and_si128(writeHi, colsHi), _mm_andnot_si128(writeHi, _mm_loadu_si128((const __m128i*)(pDest + 4))));
+	}
+	_mm_storeu_si128((__m128i*)pDest, colsLo);
+	_mm_storeu_si128((__m128i*)(pDest + 4), colsHi);
+}
+#endif
+
+#if PIXELEXPAND_AVX2
+inline void Expand1BppSpan_AVX2(uint32_t* pDest, uint8_t pixels, uint8_t writeMask, uint32_t paperCol, uint32_t inkCol)
+{
+	const __m256i laneBits = _mm256_setr_epi32(0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01);
+	const __m256i setLanes = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(pixels), laneBits), laneBits);
+	const __m256i cols = _mm256_blendv_epi8(_mm256_set1_epi32((int)paperCol), _mm256_set1_epi32((int)inkCol), setLanes);
+	if (writeMask == 0xff)
+	{
+		_mm256_storeu_si256((__m256i*)pDest, cols);
+	}
+	else
+	{
+		const __m256i writeLanes = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(writeMask), laneBits), laneBits);
+		_mm256_maskstore_epi32((int*)pDest, writeLanes, cols);
+	}
+}
+#endif
+
+// best variant available
+inline void Expand1BppSpan(uint32_t* pDest, uint8_t pixels, uint8_t writeMask, uint32_t paperCol, uint32_t inkCol)
+{
+	if (writeMask == 0)
+		return;
+#if PIXELEXPAND_AVX2
+	Expand1BppSpan_AVX2(pDest, pixels, writeMask, paperCol, inkCol);
+#elif PIXELEXPAND_SSE2
+	Expand1BppSpan_SSE2(pDest, pixels, writeMask, paperCol, inkCol);
+#else
+	Expand1BppSpan_Scalar(pDest, pixels, writeMask, paperCol, inkCol);
+#endif
+}
+
+// 0xFF000000 (opaque black) isn't drawn by the unmasked 1bpp functions
+inline uint8_t Get1BppWriteMask(uint8_t pixels, bool bDrawPaper, bool bDrawInk)
+{
+	return (bDrawPaper ? (uint8_t)~pixels : 0) | (bDrawInk ? pixels : 0);
+}
+
+// Multi-colour spans - cols can be null for 2bpp
+void Expand2BppSpan(uint32_t* pDest, const uint8_t* pSrc, int noBytes, const uint32_t* cols);		// CPC mode 1, 4 pixels per byte
+void Expand2BppWideSpan(uint32_t* pDest, const uint8_t* pSrc, int noBytes, const uint32_t* cols);	// bit pairs e.g. C64 multicolour, 4 double width pixels per byte
+void Expand4BppWideSpan(uint32_t* pDest, const uint8_t* pSrc, int noBytes, const uint32_t* cols);	// CPC mode 0, 2 double width pixels per byte
@@ -842,8 +842,7 @@ bool LoadMachineState(FSpectrumEmu* pSpectrumEmu, FILE* fp)
 	if (bSuccess && sys->type == ZX_TYPE_128)
 	{
 		const uint8_t memConfig = pSpectrumEmu->ZXEmuState.last_mem_config;
-		pSpectrumEmu->SetROMBank(memConfig & (1 << 4) ? 1 : 0);
-		pSpectrumEmu->SetRAMBank(3, memConfig & 0x7);
+		pSpectrumEmu->Set128KMemoryConfig(memConfig);
 		pSpectrumEmu->GetCodeAnalysis().SetAllBanksDirty();
 	}
 	return bSuccess;
@@ -7,6 +7,7 @@
 #include <systems/zx.h>
 #include "Util/MemoryBuffer.h"
 #include <Debug/DebugLog.h>
+#include "TapePlayer.h"
 
 // https://sinclair.wiki.zxnet.co.uk/wiki/TAP_format
 
@@ -16,84 +17,42 @@ bool LoadTAPFile(FSpectrumEmu* pEmu, const char* fName)
 	uint8_t* pData = (uint8_t*)LoadBinaryFile(fName, byteCount);
 	if (!pData)
 		return false;
-	const bool bSuccess = LoadTAPFromMemory(pEmu, pData, byteCount);
+	const bool bSuccess = LoadTAPFromMemory(pEmu, pData, byteCount, fName);
 	free(pData);
 
 	return bSuccess;
 }
 
-bool LoadTAPFromMemory(FSpectrumEmu* pEmu, const uint8_t* pData, size_t dataSize)
+bool LoadTAPFromMemory(FSpectrumEmu* pEmu, const uint8_t* pData, size_t dataSize, const char* pTapeName)
 {
 	FMemoryBuffer tapBuffer;
 	tapBuffer.Init(pData, dataSize);
 
-	LOGINFO("TAP started:");
+	FZXTape tape;
 
-	// TODO: This is a basic POC reader, we could store it a much nicer way
-	while (tapBuffer.Finished() == false)
+	// each block is a 16 bit length followed by the flag, data & checksum bytes
+	while (tapBuffer.BytesRemaining() >= 2)
 	{
 		const uint16_t blockLength = tapBuffer.Read<uint16_t>();
-		const uint8_t flags = tapBuffer.Read<uint8_t>();
-		
-		LOGINFO("");	// line space
-		if (flags == 0)	// 0 Indicates Header
+		if (blockLength > tapBuffer.BytesRemaining())
 		{
-			LOGINFO("TAP Header");
-			// Block Types
-			// 0 : Program
-			// 1 : Number Array
-			// 2 : Character Array
-			// 3 : Code
-			const uint8_t blockType = tapBuffer.Read<uint8_t>();
-			char fileName[11];
-			memset(fileName,0,11);
-			tapBuffer.ReadBytes(fileName, 10);
-			const uint16_t dataBlockLength = tapBuffer.Read<uint16_t>();
-			
-
-			if(blockType == 0)
-			{
-				// For Programs:
-				// Param 1 : Autostart line number (or >32768 if no line number was given)
-				// Param 2 : Start of variable area relative to start of program
-				LOGINFO("Program: %s", fileName);
-				const uint16_t autoLineNumber = tapBuffer.Read<uint16_t>();
-				const uint16_t startOfVariableArea = tapBuffer.Read<uint16_t>();
-				LOGINFO("Autostart line number: %d", autoLineNumber);
-				LOGINFO("Start of variable area: %d", startOfVariableArea);
-			}
-			else if(blockType == 3)
-			{
-				// For Code:
-				// Param 1 : Start address of code block
-				// Param 2 : 32768
-				LOGINFO("Code: %s", fileName);
-				const uint16_t startAddress = tapBuffer.Read<uint16_t>();
-				const uint16_t param2 = tapBuffer.Read<uint16_t>();
-				LOGINFO("Start address: 0x%04X", startAddress);
-				LOGINFO("Param2: %d",param2);
-			}
-
-			const uint8_t checksum = tapBuffer.Read<uint8_t>();
-			LOGINFO("checksum = %d",checksum);
+			LOGWARNING("TAP Loader: truncated block %d", (int)tape.Blocks.size());
+			break;
 		}
-		else if (flags == 0xff)	// 0xff indicates data
-		{
-			uint16_t dataLength = blockLength - 2;
-			uint8_t* pData = new uint8_t[dataLength];
-			tapBuffer.ReadBytes(pData, dataLength);
-			const uint8_t checksum = tapBuffer.Read<uint8_t>();
-			delete[] pData;
 
-			LOGINFO("TAP Data");
-			LOGINFO("Loaded %d bytes",dataLength);
-		}
-		else
-		{
-			// TODO: error
-		}
+		std::vector<uint8_t> blockData(blockLength);
+		tapBuffer.ReadBytes(blockData.data(), blockLength);
+
+		FZXTapeBlock block;
+		InitStandardTapeBlock(block, blockData.data(), blockData.size(), 1000);
+		tape.Blocks.push_back(block);
 	}
 
-	LOGINFO("TAP: Done");
-	return false;
-}
\ No newline at end of file
+	if (tape.Blocks.empty())
+		return false;
+
+	tape.Name = pTapeName;
+	LOGINFO("TAP Loader: %d blocks", (int)tape.Blocks.size());
+	pEmu->TapePlayer.InsertTape(tape, true);
+	return true;
+}
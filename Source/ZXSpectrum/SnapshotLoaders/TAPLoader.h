@@ -6,5 +6,5 @@
 class FSpectrumEmu;
 
 bool LoadTAPFile(FSpectrumEmu* pEmu, const char* fName);
-bool LoadTAPFromMemory(FSpectrumEmu* pEmu, const uint8_t* pData, size_t dataSize);
+bool LoadTAPFromMemory(FSpectrumEmu* pEmu, const uint8_t* pData, size_t dataSize, const char* pTapeName = "TAP");
 
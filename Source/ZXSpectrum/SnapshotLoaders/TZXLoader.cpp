@@ -3,12 +3,15 @@
 
 #include "../SpectrumEmu.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <Util/FileUtil.h>
 #include <cassert>
 #include <systems/zx.h>
 #include "Util/MemoryBuffer.h"
 #include "Debug/DebugLog.h"
+#include "TapePlayer.h"
 
 // http://k1.spdns.de/Develop/Projects/zasm/Info/TZX%20format.html
 
@@ -16,13 +19,29 @@ enum class ETZXBlockId
 {
 	StandardSpeed	= 0x10,
 	TurboSpeed		= 0x11,
-
+	PureTone		= 0x12,
+	PulseSequence	= 0x13,
+	PureData		= 0x14,
+	DirectRecording	= 0x15,
+	CSWRecording	= 0x18,
+	GeneralisedData	= 0x19,
+	Pause			= 0x20,
+	GroupStart		= 0x21,
+	GroupEnd		= 0x22,
+	JumpToBlock		= 0x23,
+	LoopStart		= 0x24,
+	LoopEnd			= 0x25,
+	CallSequence	= 0x26,
+	ReturnFromSequence	= 0x27,
+	SelectBlock		= 0x28,
+	StopTape48K		= 0x2A,
+	SetSignalLevel	= 0x2B,
+	TextDescription	= 0x30,
+	Message			= 0x31,
 	ArchiveInfo		= 0x32,
-};
-
-struct FTZXBlockBase
-{
-	ETZXBlockId	Type;
+	HardwareType	= 0x33,
+	CustomInfo		= 0x35,
+	Glue			= 0x5A,
 };
 
 struct FTZXArchiveBlockText
@@ -31,9 +50,9 @@ struct FTZXArchiveBlockText
 	std::string	String;
 };
 
-struct FTZXArchiveBlock : public FTZXBlockBase
+struct FTZXArchiveBlock
 {
-	void ReadFromMemoryBuffer(FMemoryBuffer& buffer)
+	bool ReadFromMemoryBuffer(FMemoryBuffer& buffer)
 	{
 		const uint16_t	blockLength = buffer.Read<uint16_t>();
 		const uint8_t noTextStrings = buffer.Read<uint8_t>();
@@ -43,19 +62,39 @@ struct FTZXArchiveBlock : public FTZXBlockBase
 			FTZXArchiveBlockText	textEntry;
 			textEntry.Type = buffer.Read<uint8_t>();
 			const int noChars = buffer.Read<uint8_t>();
+			if (noChars > (int)buffer.BytesRemaining())
+				return false;
 			textEntry.String = buffer.ReadString(noChars);
 			TextEntries.push_back(textEntry);
 		}
+		return true;
 	}
 
 	std::vector<FTZXArchiveBlockText>	TextEntries;
 };
 
-struct FTZXFile
+static uint32_t ReadTZX24(FMemoryBuffer& buffer)
 {
+	uint8_t bytes[3] = { 0 };
+	buffer.ReadBytes(bytes, 3);
+	return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16);
+}
 
-	std::vector<FTZXBlockBase*>	Blocks;
-};
+static bool ReadTZXData(FMemoryBuffer& buffer, FZXTapeBlock& block, uint32_t dataLength)
+{
+	if (dataLength > buffer.BytesRemaining())
+		return false;
+	block.Data.resize(dataLength);
+	return buffer.ReadBytes(block.Data.data(), dataLength);
+}
+
+static std::string ReadTZXText(FMemoryBuffer& buffer)
+{
+	const int noChars = buffer.Read<uint8_t>();
+	if (noChars > (int)buffer.BytesRemaining())
+		return std::string();
+	return buffer.ReadString(noChars);
+}
 
 bool LoadTZXFile(FSpectrumEmu* pEmu, const char* fName)
 {
@@ -63,54 +102,215 @@ bool LoadTZXFile(FSpectrumEmu* pEmu, const char* fName)
 	uint8_t* pData = (uint8_t*)LoadBinaryFile(fName, byteCount);
 	if (!pData)
 		return false;
-	const bool bSuccess = LoadTZXFromMemory(pEmu, pData, byteCount);
+	const bool bSuccess = LoadTZXFromMemory(pEmu, pData, byteCount, fName);
 	free(pData);
 
 	return bSuccess;
 }
 
-bool LoadTZXFromMemory(FSpectrumEmu* pEmu, const uint8_t* pData, size_t dataSize)
+bool LoadTZXFromMemory(FSpectrumEmu* pEmu, const uint8_t* pData, size_t dataSize, const char* pTapeName)
 {
 	FMemoryBuffer tzxBuffer;
 	tzxBuffer.Init(pData, dataSize);
 
-	FTZXFile	tzxFile;
-
-	char tzxSignature[7];
+	FZXTape	tape;
+	tape.Name = pTapeName;
 
-	tzxBuffer.ReadBytes(tzxSignature, 7);
+	char tzxSignature[8] = { 0 };
+	if (tzxBuffer.ReadBytes(tzxSignature, 7) == false || strcmp(tzxSignature, "ZXTape!") != 0)
+	{
+		LOGWARNING("TZX Loader: Not a TZX file");
+		return false;
+	}
 	const uint8_t endTextMarker = tzxBuffer.Read<uint8_t>();
 	const uint8_t majorVersion = tzxBuffer.Read<uint8_t>();
 	const uint8_t minorVersion = tzxBuffer.Read<uint8_t>();
 
-	while (tzxBuffer.Finished() == false)
+	int loopStartBlock = -1;
+	int loopRepetitions = 0;
+	std::string groupName;
+	bool bOK = true;
+
+	while (bOK && tzxBuffer.BytesRemaining() > 0)
 	{
 		const ETZXBlockId blockId = (ETZXBlockId)tzxBuffer.Read<uint8_t>();
+		FZXTapeBlock block;
 
 		switch (blockId)
 		{
 		case ETZXBlockId::StandardSpeed:
 			{
-				LOGINFO("TZX Loader: Standard Speed Block");
+				const uint16_t pauseMs = tzxBuffer.Read<uint16_t>();
+				const uint16_t dataLength = tzxBuffer.Read<uint16_t>();
+				if (dataLength > tzxBuffer.BytesRemaining())
+				{
+					bOK = false;
+					break;
+				}
+				std::vector<uint8_t> blockData(dataLength);
+				tzxBuffer.ReadBytes(blockData.data(), dataLength);
+				InitStandardTapeBlock(block, blockData.data(), dataLength, pauseMs);
+				tape.Blocks.push_back(block);
 			}
 			break;
 		case ETZXBlockId::TurboSpeed:
-			LOGINFO("TZX Loader: Turbo Speed Block");
+			block.PilotPulseLength = tzxBuffer.Read<uint16_t>();
+			block.Sync1Length = tzxBuffer.Read<uint16_t>();
+			block.Sync2Length = tzxBuffer.Read<uint16_t>();
+			block.ZeroLength = tzxBuffer.Read<uint16_t>();
+			block.OneLength = tzxBuffer.Read<uint16_t>();
+			block.PilotPulseCount = tzxBuffer.Read<uint16_t>();
+			block.UsedBitsInLastByte = tzxBuffer.Read<uint8_t>();
+			block.PauseMs = tzxBuffer.Read<uint16_t>();
+			bOK = ReadTZXData(tzxBuffer, block, ReadTZX24(tzxBuffer));
+			block.Description = groupName.empty() ? "Turbo Data" : groupName;
+			tape.Blocks.push_back(block);
+			break;
+		case ETZXBlockId::PureTone:
+			block.Type = EZXTapeBlockType::PureTone;
+			block.PilotPulseLength = tzxBuffer.Read<uint16_t>();
+			block.PilotPulseCount = tzxBuffer.Read<uint16_t>();
+			tape.Blocks.push_back(block);
+			break;
+		case ETZXBlockId::PulseSequence:
+			{
+				block.Type = EZXTapeBlockType::PulseSequence;
+				const int noPulses = tzxBuffer.Read<uint8_t>();
+				for (int i = 0; i < noPulses; i++)
+					block.Pulses.push_back(tzxBuffer.Read<uint16_t>());
+				tape.Blocks.push_back(block);
+			}
+			break;
+		case ETZXBlockId::PureData:
+			block.PilotPulseCount = 0;
+			block.ZeroLength = tzxBuffer.Read<uint16_t>();
+			block.OneLength = tzxBuffer.Read<uint16_t>();
+			block.UsedBitsInLastByte = tzxBuffer.Read<uint8_t>();
+			block.PauseMs = tzxBuffer.Read<uint16_t>();
+			bOK = ReadTZXData(tzxBuffer, block, ReadTZX24(tzxBuffer));
+			block.Description = "Pure Data";
+			tape.Blocks.push_back(block);
 			break;
+		case ETZXBlockId::DirectRecording:
+			{
+				// the samples are played as they are - each bit sets the EAR level
+				const uint16_t ticksPerSample = tzxBuffer.Read<uint16_t>();
+				const uint16_t pauseMs = tzxBuffer.Read<uint16_t>();
+				block.UsedBitsInLastByte = tzxBuffer.Read<uint8_t>();
+				bOK = ReadTZXData(tzxBuffer, block, ReadTZX24(tzxBuffer));
+
+				block.Type = EZXTapeBlockType::DirectRecording;
+				block.SampleLength = std::max<uint16_t>(ticksPerSample, 1);
+				block.PauseMs = pauseMs;
+				block.Description = "Direct Recording";
+				tape.Blocks.push_back(block);
 
+				if (pauseMs > 0)
+				{
+					FZXTapeBlock pauseBlock;
+					pauseBlock.Type = EZXTapeBlockType::Pause;
+					pauseBlock.PauseMs = pauseMs;
+					tape.Blocks.push_back(pauseBlock);
+				}
+			}
+			break;
+		case ETZXBlockId::Pause:
+			block.Type = EZXTapeBlockType::Pause;
+			block.PauseMs = tzxBuffer.Read<uint16_t>();
+			block.Description = block.PauseMs == 0 ? "Stop the tape" : "Pause";
+			tape.Blocks.push_back(block);
+			break;
+		case ETZXBlockId::StopTape48K:
+			tzxBuffer.Skip(tzxBuffer.Read<uint32_t>());
+			if (pEmu->GetCurrentSpectrumModel() == ESpectrumModel::Spectrum48K)
+			{
+				block.Type = EZXTapeBlockType::StopTape;
+				block.Description = "Stop the tape (48K)";
+				tape.Blocks.push_back(block);
+			}
+			break;
+		case ETZXBlockId::GroupStart:
+			groupName = ReadTZXText(tzxBuffer);
+			break;
+		case ETZXBlockId::GroupEnd:
+			groupName.clear();
+			break;
+		case ETZXBlockId::LoopStart:
+			loopStartBlock = (int)tape.Blocks.size();
+			loopRepetitions = tzxBuffer.Read<uint16_t>();
+			break;
+		case ETZXBlockId::LoopEnd:
+			if (loopStartBlock != -1)
+			{
+				// unroll the loop
+				const int loopEndBlock = (int)tape.Blocks.size();
+				for (int rep = 1; rep < loopRepetitions; rep++)
+				{
+					for (int blockNo = loopStartBlock; blockNo < loopEndBlock; blockNo++)
+						tape.Blocks.push_back(tape.Blocks[blockNo]);
+				}
+				loopStartBlock = -1;
+			}
+			break;
+		case ETZXBlockId::JumpToBlock:
+			LOGWARNING("TZX Loader: Jump blocks not supported");
+			tzxBuffer.Skip(2);
+			break;
+		case ETZXBlockId::CallSequence:
+			LOGWARNING("TZX Loader: Call sequence blocks not supported");
+			tzxBuffer.Skip(tzxBuffer.Read<uint16_t>() * 2);
+			break;
+		case ETZXBlockId::ReturnFromSequence:
+			break;
+		case ETZXBlockId::SelectBlock:
+			tzxBuffer.Skip(tzxBuffer.Read<uint16_t>());
+			break;
+		case ETZXBlockId::TextDescription:
+			LOGINFO("TZX Loader: %s", ReadTZXText(tzxBuffer).c_str());
+			break;
+		case ETZXBlockId::Message:
+			tzxBuffer.Skip(1);	// display time
+			LOGINFO("TZX Loader: %s", ReadTZXText(tzxBuffer).c_str());
+			break;
 		case ETZXBlockId::ArchiveInfo:
 			{
-				LOGINFO("TZX Loader: Archive Info");
-				FTZXArchiveBlock* pArchiveBlock = new FTZXArchiveBlock;
-				pArchiveBlock->ReadFromMemoryBuffer(tzxBuffer);
-				tzxFile.Blocks.push_back(pArchiveBlock);
+				FTZXArchiveBlock archiveBlock;
+				bOK = archiveBlock.ReadFromMemoryBuffer(tzxBuffer);
+				for (const FTZXArchiveBlockText& text : archiveBlock.TextEntries)
+				{
+					if (text.Type == 0)	// full title
+						tape.Name = text.String;
+				}
 			}
 			break;
+		case ETZXBlockId::HardwareType:
+			tzxBuffer.Skip(tzxBuffer.Read<uint8_t>() * 3);
+			break;
+		case ETZXBlockId::CustomInfo:
+			tzxBuffer.Skip(16);
+			tzxBuffer.Skip(tzxBuffer.Read<uint32_t>());
+			break;
+		case ETZXBlockId::Glue:
+			tzxBuffer.Skip(9);
+			break;
+		case ETZXBlockId::CSWRecording:
+		case ETZXBlockId::GeneralisedData:
+		case ETZXBlockId::SetSignalLevel:
 		default:
-			LOGWARNING("TZX Loader: Unrecognised block Id: 0x%0X", (uint8_t)blockId);
+			// blocks from v1.10 onwards start with a 32 bit length so we can skip them
+			LOGWARNING("TZX Loader: Unsupported block Id: 0x%0X", (uint8_t)blockId);
+			bOK = tzxBuffer.Skip(tzxBuffer.Read<uint32_t>());
+			break;
 		}
-
 	}
 
-	return false;
+	if (bOK == false)
+		LOGWARNING("TZX Loader: file is truncated");
+
+	if (tape.Blocks.empty())
+		return false;
+
+	LOGINFO("TZX Loader: v%d.%d %d blocks", majorVersion, minorVersion, (int)tape.Blocks.size());
+	pEmu->TapePlayer.InsertTape(tape, true);
+	return true;
 }
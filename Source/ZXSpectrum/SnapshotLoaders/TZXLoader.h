@@ -6,5 +6,5 @@
 class FSpectrumEmu;
 
 bool LoadTZXFile(FSpectrumEmu* pEmu, const char* fName);
-bool LoadTZXFromMemory(FSpectrumEmu* pEmu, const uint8_t* pData, size_t dataSize);
+bool LoadTZXFromMemory(FSpectrumEmu* pEmu, const uint8_t* pData, size_t dataSize, const char* pTapeName = "TZX");
 
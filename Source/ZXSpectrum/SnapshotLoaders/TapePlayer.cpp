@@ -0,0 +1,499 @@
+#include "TapePlayer.h"
+
+#include <algorithm>
+#include <imgui.h>
+#include "Debug/DebugLog.h"
+#include "../SpectrumEmu.h"
+
+// time to wait for the ROM to boot before typing LOAD ""
+static const uint32_t kAutoTypeStartMicroSeconds = 2500000;
+static const uint32_t kAutoTypeStepMicroSeconds = 80000;
+
+// Edge timing loops (like LD-EDGE-1 in the ROM) read the port every few hundred T-states & step a counter
+// in B by one between reads. Keyboard polling doesn't do that, however often it reads the port.
+static const uint64_t kLoaderLoopMaxTicks = 500;
+static const int kLoaderLoopReads = 10;
+
+// stop the tape if nothing has read the EAR bit for this long (~2 seconds)
+static const uint64_t kTapeIdleStopTicks = 7000000;
+
+void InitStandardTapeBlock(FZXTapeBlock& block, const uint8_t* pData, size_t dataSize, int pauseMs)
+{
+	block.Type = EZXTapeBlockType::Data;
+	block.Data.assign(pData, pData + dataSize);
+	block.PauseMs = pauseMs;
+	block.PilotPulseCount = (dataSize > 0 && pData[0] < 128) ? kTapeHeaderPilotCount : kTapeDataPilotCount;
+
+	// describe ROM headers
+	if (dataSize == 19 && pData[0] == 0)
+	{
+		static const char* kHeaderTypes[] = { "Program", "Number Array", "Character Array", "Bytes" };
+		const uint8_t headerType = pData[1];
+		const std::string fileName((const char*)pData + 2, 10);
+		block.Description = std::string(headerType < 4 ? kHeaderTypes[headerType] : "Unknown") + ": " + fileName;
+	}
+	else
+	{
+		block.Description = dataSize > 0 && pData[0] == 0xff ? "Data" : "Custom";
+	}
+}
+
+// C hooks called from the emulation tick
+static bool TapeGetEarLevel(zx_t* sys, uint64_t tick_count, void* user_data)
+{
+	return ((FZXTapePlayer*)user_data)->GetEarLevel(sys, tick_count);
+}
+
+static uint64_t TapeLDBytesTrap(zx_t* sys, uint64_t pins, void* user_data)
+{
+	return ((FZXTapePlayer*)user_data)->LDBytesTrap(sys, pins);
+}
+
+void FZXTapePlayer::Init(FSpectrumEmu* pEmu)
+{
+	pSpectrumEmu = pEmu;
+
+	ZXTapeHooks hooks;
+	hooks.get_ear_level = TapeGetEarLevel;
+	hooks.ld_bytes_trap = TapeLDBytesTrap;
+	hooks.user_data = this;
+	ZXSetTapeHooks(&hooks);
+}
+
+void FZXTapePlayer::Shutdown()
+{
+	ZXSetTapeHooks(nullptr);
+	EjectTape();
+}
+
+void FZXTapePlayer::InsertTape(FZXTape& tape, bool bAutoLoad)
+{
+	Tape = std::move(tape);
+	BlocksFastLoaded = 0;
+	bPlaying = false;
+	EarLevel = false;
+	StartBlock(0, ZXGetTickCount());
+
+	LOGINFO("Tape '%s' inserted: %d blocks", Tape.Name.c_str(), (int)Tape.Blocks.size());
+
+	if (bAutoLoad)
+	{
+		// reset & type LOAD "" (48K) or select Tape Loader (128K)
+		pSpectrumEmu->ResetMachine();
+		AutoTypeStep = 0;
+		AutoTypeTimer = 0;
+	}
+}
+
+void FZXTapePlayer::EjectTape()
+{
+	Tape.Name.clear();
+	Tape.Blocks.clear();
+	bPlaying = false;
+	AutoTypeStep = -1;
+	CurrentBlock = 0;
+}
+
+void FZXTapePlayer::Play()
+{
+	if (CurrentBlock >= (int)Tape.Blocks.size())
+		return;
+
+	TStatesPerMs = (uint32_t)(pSpectrumEmu->ZXEmuState.freq_hz / 1000);
+	NextEdgeTick = ZXGetTickCount();
+	LastEarReadTick = NextEdgeTick;
+	bPlaying = true;
+}
+
+void FZXTapePlayer::Stop()
+{
+	bPlaying = false;
+}
+
+void FZXTapePlayer::Rewind()
+{
+	StartBlock(0, ZXGetTickCount());
+	BlocksFastLoaded = 0;
+}
+
+void FZXTapePlayer::StartBlock(int blockNo, uint64_t tickCount)
+{
+	CurrentBlock = blockNo;
+	Phase = EPhase::BlockStart;
+	NextEdgeTick = tickCount;
+}
+
+void FZXTapePlayer::Update(uint32_t microSeconds)
+{
+	zx_t& zx = pSpectrumEmu->ZXEmuState;
+
+	// type one key event per update so the emulator gets to see it
+	if (AutoTypeStep >= 0)
+	{
+		AutoTypeTimer += microSeconds;
+		if (AutoTypeTimer >= kAutoTypeStartMicroSeconds + AutoTypeStep * kAutoTypeStepMicroSeconds)
+		{
+			const char* pKeys = zx.type == ZX_TYPE_128 ? "\r" : "j\"\"\r";
+			const char key = pKeys[AutoTypeStep / 2];
+			if (key == 0)
+				AutoTypeStep = -1;
+			else if (AutoTypeStep++ & 1)
+				zx_key_up(&zx, key);
+			else
+				zx_key_down(&zx, key);
+		}
+	}
+
+	if (bPlaying)
+	{
+		const uint64_t tickCount = ZXGetTickCount();
+
+		// game has finished loading
+		if (tickCount - LastEarReadTick > kTapeIdleStopTicks)
+		{
+			LOGINFO("Tape stopped - no longer being read");
+			Stop();
+		}
+		else
+		{
+			AdvanceTape(tickCount);	// keep the tape moving when nothing is reading it
+		}
+	}
+}
+
+bool FZXTapePlayer::GetEarLevel(zx_t* pSys, uint64_t tickCount)
+{
+	if (bPlaying == false)
+	{
+		DetectCustomLoader(pSys, tickCount);
+		return EarLevel;
+	}
+
+	LastEarReadTick = tickCount;
+	AdvanceTape(tickCount);
+	return EarLevel;
+}
+
+// play the tape when something runs an edge timing loop on the EAR bit
+void FZXTapePlayer::DetectCustomLoader(zx_t* pSys, uint64_t tickCount)
+{
+	const uint8_t b = pSys->cpu.b;
+	const uint8_t bDiff = (uint8_t)(b - LastEarReadB);
+	const bool bLoaderLoop = tickCount - LastEarReadTick <= kLoaderLoopMaxTicks && (bDiff == 1 || bDiff == 0xff);
+	LastEarReadTick = tickCount;
+	LastEarReadB = b;
+
+	if (bAutoPlay == false || CurrentBlock >= (int)Tape.Blocks.size())
+		return;
+
+	if (bLoaderLoop == false)
+	{
+		LoaderLoopReads = 0;
+	}
+	else if (++LoaderLoopReads >= kLoaderLoopReads)
+	{
+		LOGINFO("Tape loader detected at 0x%04X - playing tape", pSys->cpu.pc);
+		LoaderLoopReads = 0;
+		Play();
+	}
+}
+
+// move the tape on to the given time, without counting as a read
+void FZXTapePlayer::AdvanceTape(uint64_t tickCount)
+{
+	while (bPlaying && tickCount >= NextEdgeTick)
+	{
+		EPulseLevel level = EPulseLevel::Toggle;
+		const uint32_t pulseLength = GetNextPulse(level);
+		if (pulseLength == 0)	// end of tape or stop block
+		{
+			bPlaying = false;
+			break;
+		}
+
+		if (level == EPulseLevel::Toggle)
+			EarLevel = !EarLevel;
+		else
+			EarLevel = level == EPulseLevel::High;
+		NextEdgeTick += pulseLength;
+	}
+}
+
+// Get the length of the next pulse in T-states, 0 stops the tape
+uint32_t FZXTapePlayer::GetNextPulse(EPulseLevel& level)
+{
+	while (CurrentBlock < (int)Tape.Blocks.size())
+	{
+		const FZXTapeBlock& block = Tape.Blocks[CurrentBlock];
+
+		switch (Phase)
+		{
+		case EPhase::BlockStart:
+			PulseCounter = 0;
+			ByteNo = 0;
+			BitNo = 0;
+			bSecondHalf = false;
+			switch (block.Type)
+			{
+			case EZXTapeBlockType::Data:
+				Phase = block.PilotPulseCount > 0 ? EPhase::Pilot : EPhase::Data;
+				break;
+			case EZXTapeBlockType::PureTone:
+				Phase = EPhase::Tone;
+				break;
+			case EZXTapeBlockType::PulseSequence:
+				Phase = EPhase::Sequence;
+				break;
+			case EZXTapeBlockType::DirectRecording:
+				Phase = EPhase::Samples;
+				break;
+			case EZXTapeBlockType::Pause:
+				Phase = EPhase::Pause;
+				break;
+			case EZXTapeBlockType::StopTape:
+				StartBlock(CurrentBlock + 1, NextEdgeTick);
+				return 0;
+			}
+			break;
+		case EPhase::Pilot:
+			if (PulseCounter++ < block.PilotPulseCount)
+				return block.PilotPulseLength;
+			Phase = EPhase::Sync1;
+			break;
+		case EPhase::Sync1:
+			Phase = EPhase::Sync2;
+			return block.Sync1Length;
+		case EPhase::Sync2:
+			Phase = EPhase::Data;
+			return block.Sync2Length;
+		case EPhase::Data:
+			if (ByteNo < (int)block.Data.size())
+			{
+				// each bit is 2 pulses of the same length
+				const int noBits = ByteNo == (int)block.Data.size() - 1 ? block.UsedBitsInLastByte : 8;
+				const bool bOne = (block.Data[ByteNo] & (0x80 >> BitNo)) != 0;
+				if (bSecondHalf && ++BitNo >= noBits)
+				{
+					BitNo = 0;
+					ByteNo++;
+				}
+				bSecondHalf = !bSecondHalf;
+				return bOne ? block.OneLength : block.ZeroLength;
+			}
+			Phase = EPhase::Pause;
+			break;
+		case EPhase::Tone:
+			if (PulseCounter++ < block.PilotPulseCount)
+				return block.PilotPulseLength;
+			Phase = EPhase::BlockEnd;
+			break;
+		case EPhase::Sequence:
+			if (PulseCounter < (int)block.Pulses.size())
+				return block.Pulses[PulseCounter++];
+			Phase = EPhase::BlockEnd;
+			break;
+		case EPhase::Samples:
+			if (ByteNo < (int)block.Data.size())
+			{
+				// one pulse per run of samples at the same level
+				const bool bHigh = (block.Data[ByteNo] & (0x80 >> BitNo)) != 0;
+				uint32_t pulseLength = 0;
+				while (ByteNo < (int)block.Data.size() && ((block.Data[ByteNo] & (0x80 >> BitNo)) != 0) == bHigh)
+				{
+					pulseLength += block.SampleLength;
+					const int noBits = ByteNo == (int)block.Data.size() - 1 ? block.UsedBitsInLastByte : 8;
+					if (++BitNo >= noBits)
+					{
+						BitNo = 0;
+						ByteNo++;
+					}
+				}
+				level = bHigh ? EPulseLevel::High : EPulseLevel::Low;
+				return pulseLength;
+			}
+			Phase = EPhase::BlockEnd;	// the pause follows as its own block
+			break;
+		case EPhase::Pause:
+			Phase = EPhase::BlockEnd;
+			if (block.PauseMs > 0)
+			{
+				level = EPulseLevel::Low;
+				return block.PauseMs * TStatesPerMs;
+			}
+			if (block.Type == EZXTapeBlockType::Pause)	// pause of 0 means stop the tape
+			{
+				StartBlock(CurrentBlock + 1, NextEdgeTick);
+				return 0;
+			}
+			break;
+		case EPhase::BlockEnd:
+			CurrentBlock++;
+			Phase = EPhase::BlockStart;
+			break;
+		}
+	}
+
+	return 0;
+}
+
+// Called when the CPU is about to execute LD-BYTES (0x0556)
+// Entry: A = flag byte, IX = dest address, DE = length, carry set = LOAD, reset = VERIFY
+// We copy the next block straight into memory & return to the caller with carry set on success
+uint64_t FZXTapePlayer::LDBytesTrap(zx_t* pSys, uint64_t pins)
+{
+	if (bFastLoad == false || HasTape() == false)
+		return pins;
+
+	// LD-BYTES lives in the 48K ROM - ROM 1 on the 128K
+	if (pSys->type == ZX_TYPE_128 && (pSys->last_mem_config & (1 << 4)) == 0)
+		return pins;
+
+	// don't trap if we're part way through playing a block
+	if (bPlaying && Phase != EPhase::BlockStart && Phase != EPhase::Pilot)
+		return pins;
+
+	// skip any pauses
+	int blockNo = CurrentBlock;
+	while (blockNo < (int)Tape.Blocks.size() && Tape.Blocks[blockNo].Type == EZXTapeBlockType::Pause)
+		blockNo++;
+	if (blockNo >= (int)Tape.Blocks.size())
+		return pins;
+
+	const FZXTapeBlock& block = Tape.Blocks[blockNo];
+	if (block.IsStandard() == false)
+	{
+		// needs to be played in real time
+		if (bAutoPlay && bPlaying == false)
+			Play();
+		return pins;
+	}
+
+	z80_t& cpu = pSys->cpu;
+	const bool bLoad = (cpu.f & Z80_CF) != 0;
+	const uint8_t flag = block.Data[0];
+	bool bSuccess = false;
+
+	if (flag == cpu.a)
+	{
+		const int noBytes = (int)block.Data.size() - 2;	// without flag & checksum
+		const int noToLoad = std::min((int)cpu.de, noBytes);
+		uint8_t parity = flag;
+		bool bVerified = true;
+
+		for (int i = 0; i < noToLoad; i++)
+		{
+			const uint8_t val = block.Data[1 + i];
+			const uint16_t addr = (uint16_t)(cpu.ix + i);
+			if (bLoad)
+				mem_wr(&pSys->mem, addr, val);
+			else if (mem_rd(&pSys->mem, addr) != val)
+				bVerified = false;
+			parity ^= val;
+		}
+
+		// the ROM reads the byte after the ones requested as the parity byte
+		if (cpu.de <= noBytes)
+		{
+			parity ^= block.Data[1 + cpu.de];
+			bSuccess = parity == 0 && bVerified;
+		}
+
+		cpu.ix += noToLoad;
+		cpu.de -= noToLoad;
+	}
+
+	if (bSuccess)
+		cpu.f |= Z80_CF;
+	else
+		cpu.f &= ~Z80_CF;
+
+	// the ROM enables interrupts on exit (SA/LD-RET)
+	cpu.iff1 = cpu.iff2 = true;
+
+	// tape moves on to the next block
+	StartBlock(blockNo + 1, ZXGetTickCount());
+	BlocksFastLoaded++;
+
+	// return to the caller
+	const uint16_t retAddr = mem_rd(&pSys->mem, cpu.sp) | (mem_rd(&pSys->mem, cpu.sp + 1) << 8);
+	cpu.sp += 2;
+	return z80_prefetch(&cpu, retAddr);
+}
+
+static const char* GetBlockTypeName(const FZXTapeBlock& block)
+{
+	switch (block.Type)
+	{
+	case EZXTapeBlockType::Data:
+		return block.IsStandard() ? "Standard" : "Turbo";
+	case EZXTapeBlockType::PureTone:
+		return "Tone";
+	case EZXTapeBlockType::PulseSequence:
+		return "Pulses";
+	case EZXTapeBlockType::DirectRecording:
+		return "Samples";
+	case EZXTapeBlockType::Pause:
+		return "Pause";
+	case EZXTapeBlockType::StopTape:
+		return "Stop";
+	}
+	return "?";
+}
+
+void FZXTapePlayer::DrawUI()
+{
+	if (HasTape() == false)
+	{
+		ImGui::Text("No tape inserted");
+		return;
+	}
+
+	ImGui::Text("Tape: %s", Tape.Name.c_str());
+	if (bPlaying)
+	{
+		if (ImGui::Button("Stop"))
+			Stop();
+	}
+	else
+	{
+		if (ImGui::Button("Play"))
+			Play();
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Rewind"))
+		Rewind();
+	ImGui::SameLine();
+	if (ImGui::Button("Eject"))
+		EjectTape();
+
+	ImGui::Checkbox("Fast Load", &bFastLoad);
+	ImGui::SameLine();
+	ImGui::Checkbox("Auto Play", &bAutoPlay);
+	ImGui::Text("Blocks fast loaded: %d", BlocksFastLoaded);
+
+	if (ImGui::BeginTable("TapeBlocks", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY))
+	{
+		ImGui::TableSetupColumn("No", ImGuiTableColumnFlags_WidthFixed, 30);
+		ImGui::TableSetupColumn("Type", ImGuiTableColumnFlags_WidthFixed, 70);
+		ImGui::TableSetupColumn("Size", ImGuiTableColumnFlags_WidthFixed, 60);
+		ImGui::TableSetupColumn("Description");
+		ImGui::TableHeadersRow();
+
+		for (int blockNo = 0; blockNo < (int)Tape.Blocks.size(); blockNo++)
+		{
+			const FZXTapeBlock& block = Tape.Blocks[blockNo];
+			ImGui::TableNextRow();
+			if (blockNo == CurrentBlock)
+				ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg0, bPlaying ? 0xff008000 : 0xff404040);
+			ImGui::TableNextColumn();
+			ImGui::Text("%d", blockNo);
+			ImGui::TableNextColumn();
+			ImGui::Text("%s", GetBlockTypeName(block));
+			ImGui::TableNextColumn();
+			ImGui::Text("%d", (int)block.Data.size());
+			ImGui::TableNextColumn();
+			ImGui::Text("%s", block.Description.c_str());
+		}
+		ImGui::EndTable();
+	}
+}
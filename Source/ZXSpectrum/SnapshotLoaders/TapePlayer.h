@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../ZXChipsImpl.h"
+
+class FSpectrumEmu;
+
+// standard ROM timings in T-states
+static const uint16_t kTapePilotPulseLength = 2168;
+static const uint16_t kTapeSync1Length = 667;
+static const uint16_t kTapeSync2Length = 735;
+static const uint16_t kTapeZeroLength = 855;
+static const uint16_t kTapeOneLength = 1710;
+static const int kTapeHeaderPilotCount = 8063;
+static const int kTapeDataPilotCount = 3223;
+
+enum class EZXTapeBlockType
+{
+	Data,			// pilot, sync & data - standard, turbo & pure data blocks
+	PureTone,		// PilotPulseCount pulses of PilotPulseLength
+	PulseSequence,	// pulses of the lengths in Pulses
+	DirectRecording,	// one bit per sample of SampleLength in Data, the bit is the EAR level
+	Pause,			// pause of PauseMs, 0 stops the tape
+	StopTape,
+};
+
+struct FZXTapeBlock
+{
+	EZXTapeBlockType	Type = EZXTapeBlockType::Data;
+
+	uint16_t	PilotPulseLength = kTapePilotPulseLength;
+	uint16_t	Sync1Length = kTapeSync1Length;
+	uint16_t	Sync2Length = kTapeSync2Length;
+	uint16_t	ZeroLength = kTapeZeroLength;
+	uint16_t	OneLength = kTapeOneLength;
+	uint16_t	SampleLength = 0;
+	int			PilotPulseCount = 0;
+	int			UsedBitsInLastByte = 8;
+	int			PauseMs = 1000;
+
+	std::vector<uint32_t>	Pulses;
+	std::vector<uint8_t>	Data;	// including flag & checksum bytes
+	std::string				Description;
+
+	// can this block be loaded by trapping the ROM loader
+	bool	IsStandard() const
+	{
+		return Type == EZXTapeBlockType::Data && Data.size() >= 2 &&
+			ZeroLength == kTapeZeroLength && OneLength == kTapeOneLength && UsedBitsInLastByte == 8;
+	}
+};
+
+// set up a standard ROM timing block - used for TAP & TZX standard speed blocks
+void InitStandardTapeBlock(FZXTapeBlock& block, const uint8_t* pData, size_t dataSize, int pauseMs);
+
+struct FZXTape
+{
+	std::string					Name;
+	std::vector<FZXTapeBlock>	Blocks;
+};
+
+// Plays a tape into the EAR input & fast loads standard blocks by trapping LD-BYTES in the ROM
+class FZXTapePlayer
+{
+public:
+	void	Init(FSpectrumEmu* pEmu);
+	void	Shutdown();
+
+	void	InsertTape(FZXTape& tape, bool bAutoLoad);
+	void	EjectTape();
+	bool	HasTape() const { return Tape.Blocks.empty() == false; }
+
+	void	Play();
+	void	Stop();
+	void	Rewind();
+	bool	IsPlaying() const { return bPlaying; }
+
+	// run the emulator as fast as possible while the tape is playing or we are typing LOAD ""
+	bool	WantsMaxSpeed() const { return bPlaying || AutoTypeStep >= 0; }
+
+	void	Update(uint32_t microSeconds);	// call before executing a slice of emulation
+	void	DrawUI();
+
+	// called from the emulation tick when the ULA port is read
+	bool		GetEarLevel(zx_t* pSys, uint64_t tickCount);
+	uint64_t	LDBytesTrap(zx_t* pSys, uint64_t pins);
+
+	bool	bFastLoad = true;
+	bool	bAutoPlay = true;	// start playing when a custom loader is detected
+private:
+	enum class EPulseLevel
+	{
+		Toggle,
+		Low,
+		High,
+	};
+
+	void		StartBlock(int blockNo, uint64_t tickCount);
+	void		AdvanceTape(uint64_t tickCount);
+	uint32_t	GetNextPulse(EPulseLevel& level);
+	void		DetectCustomLoader(zx_t* pSys, uint64_t tickCount);
+
+	enum class EPhase
+	{
+		BlockStart,
+		Pilot,
+		Sync1,
+		Sync2,
+		Data,
+		Tone,
+		Sequence,
+		Samples,
+		Pause,
+		BlockEnd,
+	};
+
+	FSpectrumEmu*	pSpectrumEmu = nullptr;
+	FZXTape			Tape;
+
+	// pulse generator
+	bool		bPlaying = false;
+	bool		EarLevel = false;
+	EPhase		Phase = EPhase::BlockStart;
+	int			CurrentBlock = 0;
+	int			PulseCounter = 0;
+	int			ByteNo = 0;
+	int			BitNo = 0;
+	bool		bSecondHalf = false;
+	uint64_t	NextEdgeTick = 0;
+
+	uint32_t	TStatesPerMs = 3500;
+
+	// custom loader detection
+	int			LoaderLoopReads = 0;
+	uint64_t	LastEarReadTick = 0;
+	uint8_t		LastEarReadB = 0;
+
+	// auto typing of LOAD ""
+	int			AutoTypeStep = -1;
+	uint32_t	AutoTypeTimer = 0;
+
+	// stats
+	int			BlocksFastLoaded = 0;
+};
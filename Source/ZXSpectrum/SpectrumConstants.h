@@ -20,3 +20,7 @@ const uint16_t	kScreenPixMemEnd = kScreenPixMemStart + kScreenPixMemSize - 1;
 const uint16_t	kScreenAttrMemStart = 0x5800;
 const uint16_t	kScreenAttrMemSize = 32 * 24;
 const uint16_t	kScreenAttrMemEnd = kScreenAttrMemStart + kScreenAttrMemSize - 1;
+
+// position of the screen in the 320x256 display
+const int	kBorderOffsetX = (320 - 256) / 2;
+const int	kBorderOffsetY = (256 - 192) / 2;
@@ -23,6 +23,10 @@
 
 #include "zx-roms.h"
 #include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <utility>
 #include <sokol_audio.h>
 #include "Misc/SkoolkitSupport.h"
 #include "Debug/DebugLog.h"
@@ -36,6 +40,7 @@
 #include "App.h"
 #include <CodeAnalyser/CodeAnalysisState.h>
 #include "CodeAnalyser/CodeAnalysisJson.h"
+#include "CodeAnalyser/RomAnalysisImage.h"
 #include "ZXSpectrumGameConfig.h"
 
 #include "LuaScripting/LuaDocs.h"
@@ -114,6 +119,7 @@ const uint8_t* FSpectrumEmu::GetMemPtr(uint16_t address) const
 void FSpectrumEmu::WriteByte(uint16_t address, uint8_t value)
 {
 	mem_wr(&ZXEmuState.mem, address, value);
+	CodeAnalysis.OnMemoryPoked(address);
 }
 
 
@@ -218,27 +224,35 @@ int UIEvalBreakpoint(ui_dbg_t* dbg_win, uint16_t pc, int ticks, uint64_t pins, v
 	return 0;
 }*/
 
-uint64_t FSpectrumEmu::Z80Tick(int num, uint64_t pins)
+// Tick handler for a set of analysis features - see ETickFeature
+template<uint32_t kTickFeatures>
+uint64_t FSpectrumEmu::Z80TickWithFeatures(int num, uint64_t pins)
 {
+	constexpr bool bAccessTracking = (kTickFeatures & ETickFeature::AccessTracking) != 0;
+	constexpr bool bEventTrace = (kTickFeatures & ETickFeature::EventTrace) != 0;
+	constexpr bool bIOAnalysis = (kTickFeatures & ETickFeature::IOAnalysis) != 0;
+
 	FCodeAnalysisState &state = CodeAnalysis;
 	FDebugger& debugger = CodeAnalysis.Debugger;
 	z80_t& cpu = ZXEmuState.cpu;
 	const uint16_t pc = GetPC().Address;
-	static uint64_t lastTickPins = 0;
-	const uint64_t risingPins = pins & (pins ^ lastTickPins);
-	lastTickPins = pins;
-	static uint16_t lastScanlinePos = 0;
+	const uint64_t risingPins = pins & (pins ^ LastTickPins);
+	LastTickPins = pins;
 	const uint16_t scanlinePos = (uint16_t)ZXEmuState.scanline_y;
 
 	// trigger frame events on scanline pos
-	if(scanlinePos != lastScanlinePos)
+	if(scanlinePos != LastScanlinePos)
 	{
-		if (scanlinePos == 0)	// first scanline
+		if (scanlinePos == 0)	// first scanline - start the frame before the scanline so it lands in the new frame
+		{
 			CodeAnalysis.OnMachineFrameStart();
+			ScreenDecoder.OnMachineFrameStart();
+		}
+		debugger.OnScanlineStart(scanlinePos);
 		if (scanlinePos == ZXEmuState.frame_scan_lines)	// last scanline
 			CodeAnalysis.OnMachineFrameEnd();
 	}
-	lastScanlinePos = scanlinePos;
+	LastScanlinePos = scanlinePos;
 
 	/* memory and IO requests */
 	if (pins & Z80_MREQ) 
@@ -268,25 +282,34 @@ uint64_t FSpectrumEmu::Z80Tick(int num, uint64_t pins)
 			}
 			else
 			{
-				if (state.bRegisterDataAccesses)
+				if constexpr (bAccessTracking)
 					RegisterDataRead(state, pc, addr);
 			}
 		}
 		else if (pins & Z80_WR) 
 		{
-			if (state.bRegisterDataAccesses)
-				RegisterDataWrite(state, pc, addr, value);
-			const FAddressRef addrRef = state.AddressRefFromPhysicalAddress(addr);
 			const FAddressRef pcAddrRef = state.AddressRefFromPhysicalAddress(pc);
-			state.SetLastWriterForAddress(addr, pcAddrRef);
-			
-			if (addr >= kScreenPixMemStart && addr <= kScreenPixMemEnd)
+			if constexpr (bAccessTracking)
 			{
-				debugger.RegisterEvent((uint8_t)EEventType::ScreenPixWrite, pcAddrRef, addr, value, scanlinePos);
+				RegisterDataWrite(state, pc, addr, value);
+				state.SetLastWriterForAddress(addr, pcAddrRef);
 			}
-			else if (addr >= kScreenAttrMemStart && addr < kScreenAttrMemEnd)
+			
+			// the displayed screen bank can be paged in at 0x4000 or 0xC000
+			const uint16_t screenOffset = addr & 0x3fff;
+			if (screenOffset <= kScreenAttrMemEnd - kScreenPixMemStart && CurRAMBank[addr >> 14] == RAMBanks[ZXEmuState.display_ram_bank])
+				ScreenDecoder.OnScreenWrite(screenOffset);
+
+			if constexpr (bEventTrace)
 			{
-				debugger.RegisterEvent((uint8_t)EEventType::ScreenAttrWrite, pcAddrRef, addr, value, scanlinePos);
+				if (addr >= kScreenPixMemStart && addr <= kScreenPixMemEnd)
+				{
+					debugger.RegisterEvent((uint8_t)EEventType::ScreenPixWrite, pcAddrRef, addr, value, scanlinePos);
+				}
+				else if (addr >= kScreenAttrMemStart && addr < kScreenAttrMemEnd)
+				{
+					debugger.RegisterEvent((uint8_t)EEventType::ScreenAttrWrite, pcAddrRef, addr, value, scanlinePos);
+				}
 			}
 		}
 	}
@@ -300,51 +323,65 @@ uint64_t FSpectrumEmu::Z80Tick(int num, uint64_t pins)
 
 		//IOAnalysis.IOHandler(pc, pins);
 
-		if (pins & Z80_RD)
+		// reads are only classified for analysis
+		if constexpr (bEventTrace || bIOAnalysis)
 		{
-			if ((pins & Z80_A0) == 0)
-			{
-				debugger.RegisterEvent((uint8_t)EEventType::KeyboardRead, pcAddrRef, addr , data, scanlinePos);
-				Keyboard.RegisterKeyboardRead(pcAddrRef,addr,data);
-			}
-			else if ((pins & (Z80_A7 | Z80_A6 | Z80_A5)) == 0) // Kempston Joystick (........000.....)
-			{
-				debugger.RegisterEvent((uint8_t)EEventType::KempstonJoystickRead, pcAddrRef, addr, data, scanlinePos);
-			}
-			else if (pins & 0xff)
+			if (pins & Z80_RD)
 			{
-				debugger.RegisterEvent((uint8_t)EEventType::FloatingBusRead, pcAddrRef, addr, data, scanlinePos);
-			}
-			// 128K specific
-			else if (ZXEmuState.type == ZX_TYPE_128)
-			{
-				if ((pins & (Z80_A15 | Z80_A14 | Z80_A1)) == (Z80_A15 | Z80_A14))
-					debugger.RegisterEvent((uint8_t)EEventType::SoundChipRead, pcAddrRef, addr, data, scanlinePos);
+				if ((pins & Z80_A0) == 0)
+				{
+					if constexpr (bEventTrace)
+						debugger.RegisterEvent((uint8_t)EEventType::KeyboardRead, pcAddrRef, addr , data, scanlinePos);
+					if constexpr (bIOAnalysis)
+						Keyboard.RegisterKeyboardRead(pcAddrRef,addr,data);
+				}
+				else if constexpr (bEventTrace)
+				{
+					if ((pins & (Z80_A7 | Z80_A6 | Z80_A5)) == 0) // Kempston Joystick (........000.....)
+					{
+						debugger.RegisterEvent((uint8_t)EEventType::KempstonJoystickRead, pcAddrRef, addr, data, scanlinePos);
+					}
+					else if (pins & 0xff)
+					{
+						debugger.RegisterEvent((uint8_t)EEventType::FloatingBusRead, pcAddrRef, addr, data, scanlinePos);
+					}
+					// 128K specific
+					else if (ZXEmuState.type == ZX_TYPE_128)
+					{
+						if ((pins & (Z80_A15 | Z80_A14 | Z80_A1)) == (Z80_A15 | Z80_A14))
+							debugger.RegisterEvent((uint8_t)EEventType::SoundChipRead, pcAddrRef, addr, data, scanlinePos);
+					}
+				}
 			}
 		}
-		else if (pins & Z80_WR)
+		
+		if (pins & Z80_WR)
 		{
 			// handle bank switching on speccy 128
 			if ((pins & Z80_A0) == 0)
 			{
-				static uint8_t LastFE = 0;
 				// Spectrum ULA (...............0)
 
-				// has border colour changed?
-				if ((data & 7) != (LastFE & 7))
-					debugger.RegisterEvent((uint8_t)EEventType::SetBorderColour, pcAddrRef, Z80_GET_ADDR(pins), data, scanlinePos);
+				if constexpr (bEventTrace)
+				{
+					// has border colour changed?
+					if ((data & 7) != (LastFE & 7))
+						debugger.RegisterEvent((uint8_t)EEventType::SetBorderColour, pcAddrRef, Z80_GET_ADDR(pins), data, scanlinePos);
+
+					// has mic output changed
+					if ((data & (1 << 3)) != (LastFE & (1 << 3)))
+						debugger.RegisterEvent((uint8_t)EEventType::OutputMic, pcAddrRef, Z80_GET_ADDR(pins), data, scanlinePos);
+				}
 
 				// has beeper changed
 				if ((data & (1 << 4)) != (LastFE & (1 << 4)))
 				{
-					debugger.RegisterEvent((uint8_t)EEventType::OutputBeeper, pcAddrRef, Z80_GET_ADDR(pins), data, scanlinePos);
-					Beeper.RegisterBeeperWrite(pcAddrRef,data);
+					if constexpr (bEventTrace)
+						debugger.RegisterEvent((uint8_t)EEventType::OutputBeeper, pcAddrRef, Z80_GET_ADDR(pins), data, scanlinePos);
+					if constexpr (bIOAnalysis)
+						Beeper.RegisterBeeperWrite(pcAddrRef,data);
 				}
 
-				// has mic output changed
-				if ((data & (1 << 3)) != (LastFE & (1 << 3)))
-					debugger.RegisterEvent((uint8_t)EEventType::OutputMic, pcAddrRef, Z80_GET_ADDR(pins), data, scanlinePos);
-
 				LastFE = data;
 			}
 			else if (ZXEmuState.type == ZX_TYPE_128)
@@ -353,27 +390,27 @@ uint64_t FSpectrumEmu::Z80Tick(int num, uint64_t pins)
 				{
 					if (!ZXEmuState.memory_paging_disabled)
 					{
-						debugger.RegisterEvent((uint8_t)EEventType::SwitchMemoryBanks, pcAddrRef, Z80_GET_ADDR(pins), data, scanlinePos);
-
-						const int ramBank = data & 0x7;
-						const int romBank = (data & (1 << 4)) ? 1 : 0;
-						const int displayRamBank = (data & (1 << 3)) ? 7 : 5;
+						if constexpr (bEventTrace)
+							debugger.RegisterEvent((uint8_t)EEventType::SwitchMemoryBanks, pcAddrRef, Z80_GET_ADDR(pins), data, scanlinePos);
 
-						SetROMBank(romBank);
-						SetRAMBank(3, ramBank);
+						Set128KMemoryConfig(data);
 
-						MemoryControl.RegisterMemoryConfigWrite(pcAddrRef, data);
+						if constexpr (bIOAnalysis)
+							MemoryControl.RegisterMemoryConfigWrite(pcAddrRef, data);
 					}
 				}
 				else if ((pins & (Z80_A15 | Z80_A14 | Z80_A1)) == (Z80_A15 | Z80_A14))	// select AY-3-8912 register (11............0.)
 				{
-					debugger.RegisterEvent((uint8_t)EEventType::SoundChipRegisterSelect, pcAddrRef, addr, data, scanlinePos);
-					AYSoundChip.SelectAYRegister(pcAddrRef, data);
+					if constexpr (bEventTrace)
+						debugger.RegisterEvent((uint8_t)EEventType::SoundChipRegisterSelect, pcAddrRef, addr, data, scanlinePos);
+					AYSoundChip.SelectAYRegister(pcAddrRef, data);	// always track so the selected register is right if analysis is turned on
 				}
 				else if ((pins & (Z80_A15 | Z80_A14 | Z80_A1)) == Z80_A15)	// write to AY-3-8912 (10............0.) 
 				{
-					debugger.RegisterEvent((uint8_t)EEventType::SoundChipRegisterWrite, pcAddrRef, addr, data, scanlinePos);
-					AYSoundChip.WriteAYRegister(pcAddrRef, data);
+					if constexpr (bEventTrace)
+						debugger.RegisterEvent((uint8_t)EEventType::SoundChipRegisterWrite, pcAddrRef, addr, data, scanlinePos);
+					if constexpr (bIOAnalysis)
+						AYSoundChip.WriteAYRegister(pcAddrRef, data, ZXGetTickCount());
 				}
 			}
 		}
@@ -389,11 +426,27 @@ uint64_t FSpectrumEmu::Z80Tick(int num, uint64_t pins)
 		InstructionsTicks = 0;
 	}
 
-	CodeAnalysis.OnCPUTick(pins);
+	CodeAnalysis.OnCPUTick<kTickFeatures>(pins);
 	//debugger.CPUTick(pins);
 	return pins;
 }
 
+// one tick handler for each feature combination
+typedef uint64_t (FSpectrumEmu::*FZ80TickHandler)(int num, uint64_t pins);
+
+template<uint32_t... kFeatureSets>
+static constexpr std::array<FZ80TickHandler, sizeof...(kFeatureSets)> MakeZ80TickHandlers(std::integer_sequence<uint32_t, kFeatureSets...>)
+{
+	return { &FSpectrumEmu::Z80TickWithFeatures<kFeatureSets>... };
+}
+
+static constexpr auto g_Z80TickHandlers = MakeZ80TickHandlers(std::make_integer_sequence<uint32_t, ETickFeature::NoCombinations>());
+
+uint64_t FSpectrumEmu::Z80Tick(int num, uint64_t pins)
+{
+	return (this->*g_Z80TickHandlers[CodeAnalysis.GetTickFeatures()])(num, pins);
+}
+
 static uint64_t Z80TickThunk(int num, uint64_t pins, void* user_data)
 {
 	FSpectrumEmu* pEmu = (FSpectrumEmu*)user_data;
@@ -429,6 +482,17 @@ void FSpectrumEmu::SetRAMBank(int slot, int bankNo)
 	CurRAMBank[slot] = bankId;
 }
 
+// Set ROM & top RAM slot from a 128K paging port value using the precomputed configs
+void FSpectrumEmu::Set128KMemoryConfig(uint8_t portValue)
+{
+	const int ramBank = portValue & 0x7;
+	const int romBank = (portValue & (1 << 4)) ? 1 : 0;
+
+	CodeAnalysis.ApplyMemoryConfig(MemoryConfigs128K[(romBank << 3) | ramBank]);
+	CurROMBank = ROMBanks[romBank];
+	CurRAMBank[3] = RAMBanks[ramBank];
+}
+
 // callback function to save snapshot to a numbered slot
 void UISnapshotSaveCB(size_t slot_index)
 {
@@ -635,6 +699,18 @@ bool FSpectrumEmu::InitForModel(ESpectrumModel model)
         SetRAMBank(2, 2);    // 0x8000 - 0xBfff
         SetRAMBank(3, 0);    // 0xc000 - 0xffff
 
+		// build memory configs for paging port values
+		for (int romBank = 0; romBank < kNoROMBanks; romBank++)
+		{
+			for (int ramBank = 0; ramBank < kNoRAMBanks; ramBank++)
+			{
+				FCodeAnalysisMemoryConfig& config = MemoryConfigs128K[(romBank << 3) | ramBank];
+				config.Reset();
+				config.MapBank(CodeAnalysis.GetBank(ROMBanks[romBank]), 0, EBankAccess::ReadWrite);
+				config.MapBank(CodeAnalysis.GetBank(RAMBanks[ramBank]), 3 * kNoBankPages, EBankAccess::ReadWrite);
+			}
+		}
+
         // Setup memory description handlers
         PixMemDescGenerator.SetRegionBankId(RAMBanks[5]);
         AttrMemDescGenerator.SetRegionBankId(RAMBanks[5]);
@@ -680,6 +756,7 @@ bool FSpectrumEmu::Init(const FEmulatorLaunchConfig& config)
 
 	//RZXManager.Init(this);
 	//RZXGamesList.SetLoader(&GameLoader);
+	TapePlayer.Init(this);
 #if ENABLE_RZX
 	AddGamesList("RZX File", GetZXSpectrumGlobalConfig()->RZXFolder.c_str());
 #endif
@@ -697,6 +774,10 @@ bool FSpectrumEmu::Init(const FEmulatorLaunchConfig& config)
 
 	SpectrumViewer.Init(this);
 	FrameTraceViewer.Init(this);
+	ScreenDecoder.Init(this);
+
+	const chips_display_info_t dispInfo = zx_display_info(&ZXEmuState);
+	DisplayBuffer.Init(dispInfo.frame.dim.width, dispInfo.frame.dim.height);
 
 	CodeAnalysis.ViewState[0].Enabled = true;	// always have first view enabled
 
@@ -750,7 +831,7 @@ bool FSpectrumEmu::Init(const FEmulatorLaunchConfig& config)
 		CodeAnalysis.Init(this);
 
 		if (FileExists(GetBundlePath(romJsonFName.c_str())))
-			ImportAnalysisJson(CodeAnalysis, GetBundlePath(romJsonFName.c_str()));
+			ImportRomAnalysis(CodeAnalysis, GetBundlePath(romJsonFName.c_str()));
 	}
 	else
 	{
@@ -804,6 +885,9 @@ bool FSpectrumEmu::Init(const FEmulatorLaunchConfig& config)
 
 void FSpectrumEmu::Shutdown()
 {
+	EmuThread.Stop();
+	CodeAnalysis.Debugger.SetCommandHandler(nullptr);
+	TapePlayer.Shutdown();
 	FEmuBase::Shutdown();
 	
 	if (RZXManager.GetReplayMode() == EReplayMode::Off)
@@ -914,7 +998,7 @@ bool FSpectrumEmu::LoadProject(FProjectConfig* pGameConfig, bool bLoadGameData /
 	const std::string romJsonFName = (ZXEmuState.type == ZX_TYPE_128) ? kRomInfo128JsonFile : kRomInfo48JsonFile;
 
 	if (FileExists(GetBundlePath(romJsonFName.c_str())))
-		ImportAnalysisJson(CodeAnalysis, GetBundlePath(romJsonFName.c_str()));
+		ImportRomAnalysis(CodeAnalysis, GetBundlePath(romJsonFName.c_str()));
 	
 	if (bLoadSnapshot)
 	{
@@ -941,6 +1025,7 @@ bool FSpectrumEmu::LoadProject(FProjectConfig* pGameConfig, bool bLoadGameData /
 	// 
 	// decode whole screen
 	ZXDecodeScreen(&ZXEmuState);
+	ScreenDecoder.Reset();
 	CodeAnalysis.Debugger.Break();
 
 	CodeAnalysis.Debugger.RegisterNewStackPointer(ZXEmuState.cpu.sp, FAddressRef());
@@ -1447,36 +1532,21 @@ void FSpectrumEmu::DrawMainMenu(double timeMS)
 		{
 			if (ImGui::BeginMenu("Number Mode"))
 			{
-				bool bClearCode = false;
+				// code text is keyed on the number mode by the disassembly cache so doesn't need clearing
 				if (ImGui::MenuItem("Decimal", 0, GetNumberDisplayMode() == ENumberDisplayMode::Decimal))
 				{
 					SetNumberDisplayMode(ENumberDisplayMode::Decimal);
 					CodeAnalysis.SetAllBanksDirty();
-					bClearCode = true;
 				}
 				if (ImGui::MenuItem("Hex - FEh", 0, GetNumberDisplayMode() == ENumberDisplayMode::HexAitch))
 				{
 					SetNumberDisplayMode(ENumberDisplayMode::HexAitch);
 					CodeAnalysis.SetAllBanksDirty();
-					bClearCode = true;
 				}
 				if (ImGui::MenuItem("Hex - $FE", 0, GetNumberDisplayMode() == ENumberDisplayMode::HexDollar))
 				{
 					SetNumberDisplayMode(ENumberDisplayMode::HexDollar);
 					CodeAnalysis.SetAllBanksDirty();
-					bClearCode = true;
-				}
-
-				// clear code text so it can be written again
-				if (bClearCode)
-				{
-					for (int i = 0; i < 1 << 16; i++)
-					{
-						FCodeInfo* pCodeInfo = CodeAnalysis.GetCodeInfoForAddress(i);
-						if (pCodeInfo && pCodeInfo->Text.empty() == false)
-							pCodeInfo->Text.clear();
-
-					}
 				}
 
 				ImGui::EndMenu();
@@ -1744,6 +1814,38 @@ bool GetIOInputFunc(uint16_t port, uint8_t* pInVal, void* pUserData)
 
 void FSpectrumEmu::Tick()
 {
+	// start/stop emulation thread - this needs to be done outside the state lock
+	if (bUseEmuThread != EmuThread.IsRunning())
+	{
+		if (bUseEmuThread)
+		{
+			CodeAnalysis.Debugger.SetCommandHandler(this);
+			EmuThread.Start(this, kEmuThreadSliceMicroSeconds);
+		}
+		else
+		{
+			EmuThread.Stop();
+			CodeAnalysis.Debugger.SetCommandHandler(nullptr);
+			ScreenDecoder.Reset();
+		}
+	}
+
+	if (EmuThread.IsRunning())
+	{
+		SpectrumViewer.Tick();	// input is sent to the emulation thread via commands
+		EmuThread.SetSpeedScale(ExecSpeedScale);
+
+		// the emulation thread waits while we hold the state lock, so only hold it around the analysis updates
+		{
+			FEmuThread::FUILock lock(&EmuThread);
+			FEmuBase::Tick();
+		}
+
+		// Draw UI - takes the state lock per window
+		DrawDockingView();
+		return;
+	}
+
 	FEmuBase::Tick();
 
 	FDebugger& debugger = CodeAnalysis.Debugger;
@@ -1756,67 +1858,152 @@ void FSpectrumEmu::Tick()
 		//const float frameTime = min(1000000.0f / 50, 32000.0f) * ExecSpeedScale;
 		const uint32_t microSeconds = std::max(static_cast<uint32_t>(frameTime), uint32_t(1));
 
-		CodeAnalysis.OnFrameStart();
-		StoreRegisters_Z80(CodeAnalysis);
+		ExecuteEmulation(microSeconds);
+		ExecuteTapeMaxSpeed();
+	}
+	else
+	{
+	}
+
+	//UpdateCharacterSets(CodeAnalysis);
+
+	// Draw UI
+	DrawDockingView();
+}
+
+// Run the emulator & analysis for a period of time
+void FSpectrumEmu::ExecuteEmulation(uint32_t microSeconds)
+{
+	TapePlayer.Update(microSeconds);
+	CodeAnalysis.OnFrameStart();
+	StoreRegisters_Z80(CodeAnalysis);
 #if ENABLE_CAPTURES
-		const uint32_t ticks_to_run = clk_ticks_to_run(&ZXEmuState.clk, microSeconds);
-		uint32_t ticks_executed = 0;
-		while (UIZX.dbg.dbg.z80->trap_id != kCaptureTrapId && ticks_executed < ticks_to_run)
-		{
-			ticks_executed += z80_exec(&ZXEmuState.cpu, ticks_to_run - ticks_executed);
+	const uint32_t ticks_to_run = clk_ticks_to_run(&ZXEmuState.clk, microSeconds);
+	uint32_t ticks_executed = 0;
+	while (UIZX.dbg.dbg.z80->trap_id != kCaptureTrapId && ticks_executed < ticks_to_run)
+	{
+		ticks_executed += z80_exec(&ZXEmuState.cpu, ticks_to_run - ticks_executed);
 
-			if (UIZX.dbg.dbg.z80->trap_id == kCaptureTrapId)
+		if (UIZX.dbg.dbg.z80->trap_id == kCaptureTrapId)
+		{
+			const uint16_t PC = GetPC();
+			FMachineState* pMachineState = CodeAnalysis.GetMachineState(PC);
+			if (pMachineState == nullptr)
 			{
-				const uint16_t PC = GetPC();
-				FMachineState* pMachineState = CodeAnalysis.GetMachineState(PC);
-				if (pMachineState == nullptr)
-				{
-					pMachineState = AllocateMachineState(CodeAnalysis);
-					CodeAnalysis.SetMachineStateForAddress(PC, pMachineState);
-				}
-
-				CaptureMachineState(pMachineState, this);
-				UIZX.dbg.dbg.z80->trap_id = 0;
-				_ui_dbg_continue(&UIZX.dbg);
+				pMachineState = AllocateMachineState(CodeAnalysis);
+				CodeAnalysis.SetMachineStateForAddress(PC, pMachineState);
 			}
+
+			CaptureMachineState(pMachineState, this);
+			UIZX.dbg.dbg.z80->trap_id = 0;
+			_ui_dbg_continue(&UIZX.dbg);
 		}
-		clk_ticks_executed(&ZXEmuState.clk, ticks_executed);
-		kbd_update(&ZXEmuState.kbd);
+	}
+	clk_ticks_executed(&ZXEmuState.clk, ticks_executed);
+	kbd_update(&ZXEmuState.kbd);
 #else
-		if (RZXManager.GetReplayMode() == EReplayMode::Playback)
-		{
-			if (RZXFetchesRemaining <= 0)
-				RZXFetchesRemaining += RZXManager.Update();
-			const uint32_t fetchesProcessed = ZXExeEmu_UseFetchCount(&ZXEmuState, RZXFetchesRemaining, GetIOInputFunc, this);
-			RZXFetchesRemaining -= fetchesProcessed;
-		}
-		else
-		{
-			//ImGui::Begin("Execution View");
-			ZXExeEmu(&ZXEmuState, microSeconds);
-			//ImGui::End();
-		}
-#endif
-		
-		FrameTraceViewer.CaptureFrame();
-		//FrameScreenPixWrites.clear();
-		//FrameScreenAttrWrites.clear();
-		CodeAnalysis.OnFrameEnd();
+	if (RZXManager.GetReplayMode() == EReplayMode::Playback)
+	{
+		if (RZXFetchesRemaining <= 0)
+			RZXFetchesRemaining += RZXManager.Update();
+		const uint32_t fetchesProcessed = ZXExeEmu_UseFetchCount(&ZXEmuState, RZXFetchesRemaining, GetIOInputFunc, this);
+		RZXFetchesRemaining -= fetchesProcessed;
 	}
 	else
 	{
+		//ImGui::Begin("Execution View");
+		ZXExeEmu(&ZXEmuState, microSeconds);
+		//ImGui::End();
 	}
+#endif
 
-	//UpdateCharacterSets(CodeAnalysis);
+	FrameTraceViewer.CaptureFrame();
+	//FrameScreenPixWrites.clear();
+	//FrameScreenAttrWrites.clear();
+	CodeAnalysis.OnFrameEnd();
+}
 
-	// Draw UI
-	DrawDockingView();
+// Run extra frames while the tape is loading, for a limited amount of real time so the UI stays responsive
+void FSpectrumEmu::ExecuteTapeMaxSpeed()
+{
+	const auto startTime = std::chrono::steady_clock::now();
+	while (TapePlayer.WantsMaxSpeed() && CodeAnalysis.Debugger.IsStopped() == false)
+	{
+		if (std::chrono::steady_clock::now() - startTime > std::chrono::milliseconds(kTapeMaxSpeedMilliSeconds))
+			break;
+		ExecuteEmulation(kEmuThreadSliceMicroSeconds);
+	}
+}
+
+// Emulation thread interface - these are called with the state lock held
+void FSpectrumEmu::ExecuteEmuThreadSlice(uint32_t microSeconds)
+{
+	if (CodeAnalysis.Debugger.IsStopped())
+		return;
+
+	ExecuteEmulation(microSeconds);
+	ExecuteTapeMaxSpeed();
+	PublishDisplay();
+}
+
+void FSpectrumEmu::ExecuteEmuThreadCommand(const FEmuThreadCommand& command)
+{
+	switch (command.Type)
+	{
+	case EEmuThreadCommand::KeyDown:
+		zx_key_down(&ZXEmuState, command.Param);
+		break;
+	case EEmuThreadCommand::KeyUp:
+		zx_key_up(&ZXEmuState, command.Param);
+		break;
+	case EEmuThreadCommand::Joystick:
+		zx_joystick(&ZXEmuState, command.Param);
+		break;
+	case EEmuThreadCommand::Poke:
+		WriteByte(command.Address, command.Value);
+		break;
+	case EEmuThreadCommand::Debugger:
+		CodeAnalysis.Debugger.ExecuteCommand((EDebuggerCommand)command.Param);
+		break;
+	}
+}
+
+// convert to RGBA for the UI thread
+void FSpectrumEmu::PublishDisplay()
+{
+	chips_display_info_t disp = zx_display_info(&ZXEmuState);
+	const uint8_t* pix = (const uint8_t*)disp.frame.buffer.ptr;
+	const uint32_t* pal = (const uint32_t*)disp.palette.ptr;
+	uint32_t* pDest = DisplayBuffer.GetBackBuffer();
+	for (int i = 0; i < disp.frame.buffer.size; i++)
+		pDest[i] = pal[pix[i]];
+	DisplayBuffer.Publish();
+}
+
+// UI requests get sent to the emulation thread when it's running
+bool FSpectrumEmu::QueueDebuggerCommand(EDebuggerCommand command)
+{
+	if (EmuThread.IsRunning() == false || EmuThread.IsEmuThread())
+		return false;
+
+	return EmuThread.PushCommand({ EEmuThreadCommand::Debugger, (int)command });
+}
+
+bool FSpectrumEmu::QueuePoke(uint16_t address, uint8_t value)
+{
+	if (EmuThread.IsRunning() == false || EmuThread.IsEmuThread())
+		return false;
+
+	FEmuThreadCommand command;
+	command.Type = EEmuThreadCommand::Poke;
+	command.Address = address;
+	command.Value = value;
+	return EmuThread.PushCommand(command);
 }
 
 void FSpectrumEmu::Reset()
 {
-	// Reset speccy
-	zx_reset(&ZXEmuState);
+	ResetMachine();
 	//ui_dbg_reset(&pZXUI->dbg);
 
 	FZXSpectrumGameConfig* pBasicConfig = (FZXSpectrumGameConfig * )GetGameConfigForName("ZXBasic");
@@ -1827,6 +2014,21 @@ void FSpectrumEmu::Reset()
 	LoadProject(pBasicConfig,false);	// reset code analysis
 }
 
+// Reset speccy & the emulator state that tracks it, leaving the analysis alone
+void FSpectrumEmu::ResetMachine()
+{
+	zx_reset(&ZXEmuState);
+
+	if (ZXEmuState.type == ZX_TYPE_128)
+		Set128KMemoryConfig(ZXEmuState.last_mem_config);
+
+	PreviousPC = ZXEmuState.cpu.pc;
+	InstructionsTicks = 0;
+	LastTickPins = ZXEmuState.pins;
+	LastScanlinePos = (uint16_t)ZXEmuState.scanline_y;
+	ScreenDecoder.Reset();
+}
+
 void    FSpectrumEmu::OnEnterEditMode(void)
 {
     zx_save_snapshot(&ZXEmuState,&BackupState);
@@ -1946,6 +2148,15 @@ void FSpectrumEmu::DrawEmulatorUI()
 	}
 	ImGui::End();
 
+	if (TapePlayer.HasTape())
+	{
+		if (ImGui::Begin("Tape"))
+		{
+			TapePlayer.DrawUI();
+		}
+		ImGui::End();
+	}
+
 	if (RZXManager.GetReplayMode() == EReplayMode::Playback)
 	{
 		if (ImGui::Begin("RZX Info"))
@@ -2124,18 +2335,18 @@ void FSpectrumEmu::DrawCheatsUI()
 					// store old value
 					if (!bWasEnabled)
 						entry.OldValue = ReadByte( entry.Address);
-					WriteByte( entry.Address, static_cast<uint8_t>(entry.Value));
+					CodeAnalysis.PokeByte(entry.Address, static_cast<uint8_t>(entry.Value));
 					entry.bUserDefinedValueDirty = false;
 				}
 				else
 				{
-					WriteByte( entry.Address, entry.OldValue);
+					CodeAnalysis.PokeByte(entry.Address, entry.OldValue);
 				}
 
 				// if code has been modified then clear the code text so it gets regenerated
 				FCodeInfo* pCodeInfo = CodeAnalysis.GetCodeInfoForPhysicalAddress(entry.Address);
 				if (pCodeInfo)
-					pCodeInfo->Text.clear();
+					pCodeInfo->bNeedsRewrite = true;
 			
 				CodeAnalysis.SetCodeAnalysisDirty(entry.Address);
 			}
@@ -2193,6 +2404,7 @@ bool FSpectrumEmu::LoadMachineSnapshot(int snapshotNo)
 		if(snapshot.bValid == false)
 			return false;
 		zx_load_snapshot(&ZXEmuState, ZX_SNAPSHOT_VERSION, &snapshot.State);
+		ScreenDecoder.Reset();
 		return true;
 	}
 
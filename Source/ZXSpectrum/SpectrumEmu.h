@@ -43,9 +43,12 @@
 #include "Misc/GamesList.h"
 #include "IOAnalysis.h"
 #include "SnapshotLoaders/RZXLoader.h"
+#include "SnapshotLoaders/TapePlayer.h"
 #include "Util/Misc.h"
 #include "SpectrumDevices.h"
+#include "ZXScreenDecoder.h"
 #include "Misc/EmuBase.h"
+#include "Misc/EmuThread.h"
 
 struct FGame;
 struct FGameViewer;
@@ -83,7 +86,7 @@ struct FSnapshot
 };
 
 
-class FSpectrumEmu : public FEmuBase
+class FSpectrumEmu : public FEmuBase, public IEmuThreadClient, public IDebuggerCommandHandler
 {
 public:
 	FSpectrumEmu()
@@ -100,6 +103,7 @@ public:
 	void	Shutdown() override;
 	void	Tick() override;
 	void	Reset() override;
+	void	ResetMachine();
     void    OnEnterEditMode(void) override;
     void    OnExitEditMode(void) override;
 
@@ -129,6 +133,22 @@ public:
 
 	void	OnInstructionExecuted(int ticks, uint64_t pins);
 	uint64_t Z80Tick(int num, uint64_t pins);
+	template<uint32_t kTickFeatures> uint64_t Z80TickWithFeatures(int num, uint64_t pins);
+	void	ExecuteEmulation(uint32_t microSeconds);
+
+	// IEmuThreadClient Begin
+	void	ExecuteEmuThreadSlice(uint32_t microSeconds) override;
+	void	ExecuteEmuThreadCommand(const FEmuThreadCommand& command) override;
+	// IEmuThreadClient End
+
+	// IDebuggerCommandHandler Begin
+	bool	QueueDebuggerCommand(EDebuggerCommand command) override;
+	// IDebuggerCommandHandler End
+
+	void	PublishDisplay();
+	FEmuThread*	GetEmuThread() override { return &EmuThread; }
+
+	void	ExecuteTapeMaxSpeed();
 
 	void	DrawMemoryTools();
 	void	DrawEmulatorUI() override;
@@ -143,6 +163,7 @@ public:
 	uint16_t	ReadWord(uint16_t address) const override;
 	const uint8_t*	GetMemPtr(uint16_t address) const override;
 	void		WriteByte(uint16_t address, uint8_t value) override;
+	bool		QueuePoke(uint16_t address, uint8_t value) override;
 
 	FAddressRef	GetPC(void) override;
 	uint16_t	GetSP(void) override;
@@ -154,6 +175,7 @@ public:
     ESpectrumModel  GetCurrentSpectrumModel() const { return ZXEmuState.type == ZX_TYPE_128 ? ESpectrumModel::Spectrum128K : ESpectrumModel::Spectrum48K;}
 	void SetROMBank(int bankNo);
 	void SetRAMBank(int slot, int bankNo);
+	void Set128KMemoryConfig(uint8_t portValue);
 
 	void AddMemoryHandler(const FMemoryAccessHandler& handler)
 	{
@@ -182,6 +204,14 @@ public:
 
 	float			ExecSpeedScale = 1.0f;
 
+	// Emulation thread
+	static const uint32_t	kEmuThreadSliceMicroSeconds = 20000;	// one 50Hz frame
+	static const int		kTapeMaxSpeedMilliSeconds = 12;		// real time to spend on extra frames when loading
+	bool				bUseEmuThread = false;
+	FEmuThread			EmuThread;
+	FEmuDisplayBuffer	DisplayBuffer;
+	FZXScreenDecoder	ScreenDecoder;
+
 	// Chips UI
 	//ui_zx_t			UIZX;
 
@@ -215,6 +245,7 @@ public:
 	int16_t				RAMBanks[kNoRAMBanks];
 	int16_t				CurROMBank = -1;
 	int16_t				CurRAMBank[4] = { -1,-1,-1,-1 };
+	FCodeAnalysisMemoryConfig	MemoryConfigs128K[16];	// indexed by ROM bit & RAM bank of the paging port
 
 	// Memory handling
 	std::string							SelectedMemoryHandler;
@@ -228,10 +259,15 @@ public:
 	
 	uint16_t		PreviousPC = 0;		// store previous pc
 	int				InstructionsTicks = 0;
+	uint64_t		LastTickPins = 0;
+	uint16_t		LastScanlinePos = 0;
+	uint8_t			LastFE = 0;
 
 	FRZXManager		RZXManager;
 	int				RZXFetchesRemaining = 0;
 
+	FZXTapePlayer	TapePlayer;
+
 private:
 	//std::vector<FViewerBase*>	Viewers;
 
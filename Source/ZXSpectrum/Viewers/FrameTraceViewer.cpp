@@ -23,6 +23,9 @@ void FFrameTraceViewer::Init(FSpectrumEmu* pEmu)
 	}
 
 	ShowWritesView = new FZXGraphicsView(320, 256);
+
+	// keep the events for all the traced frames - the oldest can still be lost if the log fills up
+	pEmu->GetCodeAnalysis().Debugger.GetEventTrace().SetMinFramesToKeep(kNoFramesInTrace);
 }
 
 void FFrameTraceViewer::Reset()
@@ -31,7 +34,7 @@ void FFrameTraceViewer::Reset()
 	{
 		auto& frame = FrameTrace[i];
 		frame.InstructionTrace.clear();
-		frame.FrameEvents.clear();
+		frame.FirstEvent = frame.EndEvent = 0;
 		frame.FrameOverview.clear();
 		frame.MemoryDiffs.clear();
 	}
@@ -58,7 +61,9 @@ void FFrameTraceViewer::CaptureFrame()
 	FSpeccyFrameTrace& frame = FrameTrace[CurrentTraceFrame];
 	ImGui_UpdateTextureRGBA(frame.Texture, pSpectrumEmu->SpectrumViewer.GetFrameBuffer());
 	frame.InstructionTrace = codeAnalysis.Debugger.GetFrameTrace();	// copy frame trace - use method?
-	frame.FrameEvents = codeAnalysis.Debugger.GetEventTrace();
+	const FEventLog& eventLog = codeAnalysis.Debugger.GetEventTrace();
+	frame.FirstEvent = eventLog.GetFrameStartEvent(0);
+	frame.EndEvent = eventLog.GetEndEvent();
 	frame.FrameOverview.clear();
 
 	// copy memory
@@ -114,6 +119,8 @@ void FFrameTraceViewer::RestoreFrame(const FSpeccyFrameTrace& frame)
 		pSpectrumEmu->SetROMBank(frame.MemoryBankRegister & (1 << 4) ? 1 : 0);
 		pSpectrumEmu->SetRAMBank(3, frame.MemoryBankRegister & 0x7);
 	}
+
+	pSpectrumEmu->ScreenDecoder.Reset();
 }
 
 void FFrameTraceViewer::Draw()
@@ -239,14 +246,14 @@ void	FFrameTraceViewer::DrawInstructionTrace(const FSpeccyFrameTrace& frame)
 			{
 				//ImGui::Text("%s %s", NumStr(instAddr.Address), pCodeInfo->Text.c_str());
                 
-                if (pCodeInfo->bSelfModifyingCode == true || pCodeInfo->Text.empty())
+                if (pCodeInfo->bSelfModifyingCode == true || pCodeInfo->bNeedsRewrite)
                     WriteCodeInfoForAddress(state, instAddr.Address);
                 
                 Markup::SetCodeInfo(pCodeInfo);
                 ImGui::Text("%s ", NumStr(instAddr.Address));
                 ImGui::SameLine();
                 ImGui::PushStyleColor(ImGuiCol_Text, Colours::mnemonic);
-                Markup::DrawText(state,viewState,pCodeInfo->Text.c_str());
+                Markup::DrawText(state,viewState,state.DisassemblyCache.GetText(state, instAddr, pCodeInfo).c_str());
                 ImGui::PopStyleColor();
                 Markup::SetCodeInfo(nullptr);
 				//ImGui::SameLine();
@@ -50,7 +50,8 @@ struct FSpeccyFrameTrace
 	void*					CPUState = nullptr;
 	std::vector<FAddressRef>	InstructionTrace;
 	std::vector<FMemoryAccess>	ScreenPixWrites;
-	std::vector<FEvent>			FrameEvents;
+	uint64_t				FirstEvent = 0;	// range of the debugger's event log captured with the frame - clamp with IsEventValid
+	uint64_t				EndEvent = 0;
 
 	std::vector<FFrameOverviewItem>	FrameOverview;
 	std::vector<FMemoryDiff>	MemoryDiffs;
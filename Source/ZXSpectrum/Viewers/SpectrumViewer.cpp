@@ -15,9 +15,6 @@
 #include <CodeAnalyser/UI/UIColours.h>
 #include <LuaScripting/LuaSys.h>
 
-static const int kBorderOffsetX = (320 - 256) / 2;
-static const int kBorderOffsetY = (256 - 192) / 2;
-
 
 void FSpectrumViewer::Init(FSpectrumEmu* pEmu)
 {
@@ -43,14 +40,30 @@ void FSpectrumViewer::Draw()
 
 	chips_display_info_t disp = zx_display_info(&pSpectrumEmu->ZXEmuState);
 	
-	// convert texture to RGBA
-	const uint8_t* pix = (const uint8_t*)disp.frame.buffer.ptr;
-	const uint32_t* pal = (const uint32_t*)disp.palette.ptr;
-	for (int i = 0; i < disp.frame.buffer.size; i++)
-		FrameBuffer[i] = pal[pix[i]];
-
-	// update screen texture
-	ImGui_UpdateTextureRGBA(ScreenTexture, FrameBuffer);
+	if (pSpectrumEmu->EmuThread.IsRunning())
+	{
+		// use the last display published by the emulation thread
+		memcpy(FrameBuffer, pSpectrumEmu->DisplayBuffer.LatchFrontBuffer(), disp.frame.buffer.size * sizeof(uint32_t));
+		ImGui_UpdateTextureRGBA(ScreenTexture, FrameBuffer);
+	}
+	else if (bIncrementalScreenDecode)
+	{
+		// only the rows which have been drawn to get uploaded
+		int firstRow = 0, noRows = 0;
+		if (pSpectrumEmu->ScreenDecoder.Decode(FrameBuffer, firstRow, noRows))
+			ImGui_UpdateTextureRGBARows(ScreenTexture, FrameBuffer, firstRow, noRows);
+	}
+	else
+	{
+		// convert texture to RGBA
+		const uint8_t* pix = (const uint8_t*)disp.frame.buffer.ptr;
+		const uint32_t* pal = (const uint32_t*)disp.palette.ptr;
+		for (int i = 0; i < disp.frame.buffer.size; i++)
+			FrameBuffer[i] = pal[pix[i]];
+
+		// update screen texture
+		ImGui_UpdateTextureRGBA(ScreenTexture, FrameBuffer);
+	}
 
 	const ImVec2 pos = ImGui::GetCursorScreenPos();
 	const float scale = (float)config.ImageScale;//ImGui_GetScaling();
@@ -72,6 +85,7 @@ void FSpectrumViewer::Draw()
 			dl->AddLine(ImVec2(pos.x + (320 * scale), pos.y + (scanlineY * scale)), ImVec2(pos.x + (320 + 32) * scale, pos.y + (scanlineY * scale)), col);
 		}
 	}
+	debugger.GetScanlineTimeline().DrawBeamChart(ImVec2(pos.x + (320 + 36) * scale, pos.y), 96 * scale, scale, topScreenScanLine, 256);
 	// Draw an indicator to show which scanline is being drawn
 	if (config.bShowScanLineIndicator && codeAnalysis.Debugger.IsStopped())
 	{
@@ -98,6 +112,8 @@ void FSpectrumViewer::Draw()
 
 	if (bShowCoordinates)
 		DrawCoordinatePositions(codeAnalysis, pos);
+	if (bHighlightDrawnCells)
+		DrawDrawnCellHighlights(pos, scale);
 
 	
 	// draw hovered address
@@ -182,6 +198,22 @@ void FSpectrumViewer::Draw()
 	ImGui::SameLine();
 	if (ImGui::Button("Reset"))
 		pSpectrumEmu->ExecSpeedScale = 1.0f;
+	if (ImGui::Checkbox("Incremental Screen Decode", &bIncrementalScreenDecode))
+		pSpectrumEmu->ScreenDecoder.Reset();
+	if (ImGui::IsItemHovered())
+		ImGui::SetTooltip("Only redraw what has been written to the screen - mid frame effects won't be shown");
+	ImGui::SameLine();
+	ImGui::Checkbox("Highlight Drawn Cells", &bHighlightDrawnCells);
+	ImGui::Checkbox("Emulation Thread", &pSpectrumEmu->bUseEmuThread);
+	if (pSpectrumEmu->EmuThread.IsRunning())
+	{
+		bool bTurbo = pSpectrumEmu->EmuThread.IsTurbo();
+		ImGui::SameLine();
+		if (ImGui::Checkbox("Turbo", &bTurbo))
+			pSpectrumEmu->EmuThread.SetTurbo(bTurbo);
+		ImGui::SameLine();
+		ImGui::Text("Emulation %.1f FPS", pSpectrumEmu->EmuThread.GetEmulatedFPS());
+	}
 	ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
 
 	if (pSpectrumEmu->bHasInterruptHandler)
@@ -218,6 +250,29 @@ void FSpectrumViewer::Draw()
 	bWindowFocused = ImGui::IsWindowFocused();
 }
 
+// outline the character cells written to in the last frame
+void FSpectrumViewer::DrawDrawnCellHighlights(const ImVec2& pos, float scale)
+{
+	ImDrawList* dl = ImGui::GetWindowDrawList();
+	const uint32_t* pDrawnCells = pSpectrumEmu->ScreenDecoder.GetLastFrameDrawnCells();
+
+	for (int yChar = 0; yChar < FZXScreenDecoder::kNoCharRows; yChar++)
+	{
+		if (pDrawnCells[yChar] == 0)
+			continue;
+
+		for (int xChar = 0; xChar < 32; xChar++)
+		{
+			if ((pDrawnCells[yChar] & (1 << xChar)) == 0)
+				continue;
+
+			const float xp = pos.x + (kBorderOffsetX + (xChar * 8)) * scale;
+			const float yp = pos.y + (kBorderOffsetY + (yChar * 8)) * scale;
+			dl->AddRect(ImVec2(xp, yp), ImVec2(xp + (8 * scale), yp + (8 * scale)), 0xff00ffff);
+		}
+	}
+}
+
 void FSpectrumViewer::DrawCoordinatePositions(FCodeAnalysisState& codeAnalysis, const ImVec2& pos)
 {
 	const FZXSpectrumConfig& config = *pSpectrumEmu->GetZXSpectrumGlobalConfig();
@@ -488,6 +543,10 @@ int SpectrumKeyFromImGuiKey(ImGuiKey key)
 
 void FSpectrumViewer::Tick(void)
 {
+	// when the emulation thread is running we send input as commands rather than poking the emulator state
+	FEmuThread& emuThread = pSpectrumEmu->EmuThread;
+	const bool bThreaded = emuThread.IsRunning();
+
 	// Check keys - not event driven, hopefully perf isn't too bad
 	for (int key = ImGuiKey_NamedKey_BEGIN; key < ImGuiKey_COUNT; key++)
 	{
@@ -495,13 +554,23 @@ void FSpectrumViewer::Tick(void)
 		{ 
 			const int speccyKey = SpectrumKeyFromImGuiKey((ImGuiKey)key);
 			if (speccyKey != 0 && bWindowFocused)
-				zx_key_down(&pSpectrumEmu->ZXEmuState, speccyKey);
+			{
+				if (bThreaded)
+					emuThread.PushCommand({ EEmuThreadCommand::KeyDown, speccyKey });
+				else
+					zx_key_down(&pSpectrumEmu->ZXEmuState, speccyKey);
+			}
 		}
 		else if (ImGui::IsKeyReleased((ImGuiKey)key))
 		{
 			const int speccyKey = SpectrumKeyFromImGuiKey((ImGuiKey)key);
 			if (speccyKey != 0)
-				zx_key_up(&pSpectrumEmu->ZXEmuState, speccyKey);
+			{
+				if (bThreaded)
+					emuThread.PushCommand({ EEmuThreadCommand::KeyUp, speccyKey });
+				else
+					zx_key_up(&pSpectrumEmu->ZXEmuState, speccyKey);
+			}
 		}
 	}
 
@@ -520,6 +589,9 @@ void FSpectrumViewer::Tick(void)
 		if (ImGui::IsKeyDown(ImGuiKey_GamepadFaceDown))
 			mask |= 1 << 4;
 
-		zx_joystick(&pSpectrumEmu->ZXEmuState, mask);
+		if (bThreaded)
+			emuThread.PushCommand({ EEmuThreadCommand::Joystick, mask });
+		else
+			zx_joystick(&pSpectrumEmu->ZXEmuState, mask);
 	}
 }
@@ -25,6 +25,7 @@ public:
 private:
 	// private methods
 	void	DrawCoordinatePositions(FCodeAnalysisState& codeAnalysis, const ImVec2& pos);
+	void	DrawDrawnCellHighlights(const ImVec2& pos, float scale);
 	void	DrawSelectedCharUI(const ImVec2& pos);
 	bool	OnHovered(const ImVec2& pos, FCodeAnalysisState& codeAnalysis, FCodeAnalysisViewState& viewState);
 	ImU32	GetFlashColour() const;
@@ -34,6 +35,8 @@ private:
 
 	uint32_t*		FrameBuffer;	// pixel buffer to store emu output
 	ImTextureID		ScreenTexture;		// texture 
+	bool			bIncrementalScreenDecode = false;	// decode from screen writes rather than using the emulator's display
+	bool			bHighlightDrawnCells = false;
 
 	// screen inspector
 	bool		bScreenCharSelected = false;
@@ -1,3 +1,5 @@
+#include <string.h>
+
 #define CHIPS_IMPL
 #include "ZXChipsImpl.h"
 
@@ -17,6 +19,47 @@ void ZXDecodeScreen(zx_t* pZX)
 	pZX->scanline_y = oldScanlineVal;
 }
 
+// Tape hooks - set by the tape player
+static ZXTapeHooks g_TapeHooks = { 0 };
+static uint64_t g_TickCount = 0;
+
+void ZXSetTapeHooks(const ZXTapeHooks* pHooks)
+{
+	if (pHooks != NULL)
+		g_TapeHooks = *pHooks;
+	else
+		memset(&g_TapeHooks, 0, sizeof(ZXTapeHooks));
+}
+
+uint64_t ZXGetTickCount(void)
+{
+	return g_TickCount;
+}
+
+// feeds the tape EAR signal into ULA port reads & traps the ROM loader
+static uint64_t TapeTick(zx_t* sys, uint64_t pins)
+{
+	g_TickCount++;
+
+	if (g_TapeHooks.get_ear_level == NULL)
+		return pins;
+
+	if ((pins & (Z80_IORQ | Z80_RD)) == (Z80_IORQ | Z80_RD) && (pins & Z80_A0) == 0)	// ULA
+	{
+		// replace bit 6 (EAR), keep the keyboard bits
+		uint8_t data = Z80_GET_DATA(pins) & ~(1 << 6);
+		if (g_TapeHooks.get_ear_level(sys, g_TickCount, g_TapeHooks.user_data))
+			data |= (1 << 6);
+		Z80_SET_DATA(pins, (uint64_t)data);
+	}
+	else if (z80_opdone(&sys->cpu) && Z80_GET_ADDR(pins) == kZXROMLDBytes && g_TapeHooks.ld_bytes_trap != NULL)
+	{
+		pins = g_TapeHooks.ld_bytes_trap(sys, pins, g_TapeHooks.user_data);
+	}
+
+	return pins;
+}
+
 // Additional tick to support floating bus
 static uint64_t FloatingBusTick(zx_t* sys, uint64_t pins)
 {
@@ -24,8 +67,7 @@ static uint64_t FloatingBusTick(zx_t* sys, uint64_t pins)
 	{
 		if ((pins & Z80_A0) == 0)	// ULA
 		{
-			// TODOO: if we want to emulate tape then we could put something here
-			// be careful not to lose the keyboard bits
+			// tape EAR bit is handled in TapeTick
 		}
 		else if ((pins & (Z80_A7 | Z80_A6 | Z80_A5)) == 0)	// Kempston
 		{
@@ -85,6 +127,7 @@ uint32_t ZXExeEmu(zx_t* sys, uint32_t micro_seconds)
 			if (sys->cpu.step == 1490)	// this is a bit of a hack to fix IM2 on some games
 				sys->cpu.dlatch = 0xff;
 			pins = FloatingBusTick(sys, pins);
+			pins = TapeTick(sys, pins);
 		}
 	}
 	else 
@@ -96,6 +139,7 @@ uint32_t ZXExeEmu(zx_t* sys, uint32_t micro_seconds)
 			if (sys->cpu.step == 1490)	// this is a bit of a hack to fix IM2 on some games
 				sys->cpu.dlatch = 0xff;
 			pins = FloatingBusTick(sys, pins);
+			pins = TapeTick(sys, pins);
 			sys->debug.callback.func(sys->debug.callback.user_data, pins);
 		}
 	}
@@ -125,6 +169,7 @@ uint32_t ZXExeEmu_UseFetchCount(zx_t* sys, uint32_t noFetches, GetIOInput ioInpu
 		{
 			pins = _zx_tick(sys, pins);
 			pins = FloatingBusTick(sys, pins);
+			pins = TapeTick(sys, pins);
 			if (ioInputCB)
 				pins = ReadInputIOTick(pins, ioInputCB, pUserData);
 
@@ -166,6 +211,7 @@ uint32_t ZXExeEmu_UseFetchCount(zx_t* sys, uint32_t noFetches, GetIOInput ioInpu
 
 			pins = _zx_tick(sys, pins);
 			pins = FloatingBusTick(sys, pins);
+			pins = TapeTick(sys, pins);
 			if (ioInputCB)
 				pins = ReadInputIOTick(pins, ioInputCB, pUserData);
 			sys->debug.callback.func(sys->debug.callback.user_data, pins);
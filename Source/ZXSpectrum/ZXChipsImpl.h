@@ -17,6 +17,22 @@ extern "C" {
 	
 typedef bool(*GetIOInput)(uint16_t port, uint8_t* pInVal, void* pUserData);
 
+// address of LD-BYTES in the 48K ROM
+#define kZXROMLDBytes	0x0556
+
+// hooks for the tape player
+typedef struct
+{
+	// return EAR level at the given tick count - called on ULA port reads
+	bool		(*get_ear_level)(zx_t* sys, uint64_t tick_count, void* user_data);
+	// called when the CPU is about to execute LD-BYTES, returns new pins
+	uint64_t	(*ld_bytes_trap)(zx_t* sys, uint64_t pins, void* user_data);
+	void*		user_data;
+} ZXTapeHooks;
+
+void ZXSetTapeHooks(const ZXTapeHooks* pHooks);	// NULL to clear
+uint64_t ZXGetTickCount(void);
+
 void ZXDecodeScreen(zx_t* pZX);
 uint32_t ZXExeEmu(zx_t* sys, uint32_t micro_seconds);
 uint32_t ZXExeEmu_UseFetchCount(zx_t* sys, uint32_t noFetches, GetIOInput ioInputCB, void* pUserData);
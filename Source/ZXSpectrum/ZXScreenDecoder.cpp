@@ -0,0 +1,154 @@
+#include "ZXScreenDecoder.h"
+
+#include "SpectrumEmu.h"
+
+#include <algorithm>
+#include <cstring>
+
+void FZXScreenDecoder::Init(FSpectrumEmu* pEmu)
+{
+	pSpectrumEmu = pEmu;
+	memset(FrameDrawnCells, 0, sizeof(FrameDrawnCells));
+	memset(LastFrameDrawnCells, 0, sizeof(LastFrameDrawnCells));
+	Reset();
+}
+
+void FZXScreenDecoder::Reset()
+{
+	memset(DirtyLines, 0, sizeof(DirtyLines));
+	memset(DirtyCells, 0, sizeof(DirtyCells));
+	bFullRedraw = true;
+	DecodesSinceVerify = 0;
+}
+
+void FZXScreenDecoder::OnMachineFrameStart()
+{
+	memcpy(LastFrameDrawnCells, FrameDrawnCells, sizeof(FrameDrawnCells));
+	memset(FrameDrawnCells, 0, sizeof(FrameDrawnCells));
+}
+
+// writes which don't come from the CPU (snapshot loads, pokes etc.) get picked up here
+void FZXScreenDecoder::VerifyScreenMemory(const uint8_t* pScreenMem)
+{
+	for (int offset = 0; offset < kScreenPixMemSize + kScreenAttrMemSize; offset++)
+	{
+		if (pScreenMem[offset] != DecodedScreen[offset])
+			OnScreenWrite(offset);
+	}
+}
+
+bool FZXScreenDecoder::Decode(uint32_t* pFrameBuffer, int& outFirstRow, int& outNoRows)
+{
+	zx_t& zx = pSpectrumEmu->ZXEmuState;
+	const chips_display_info_t disp = zx_display_info(&zx);
+	const uint32_t* pPalette = (const uint32_t*)disp.palette.ptr;
+	const int stride = disp.frame.dim.width;
+	const uint8_t* pScreenMem = zx.ram[zx.display_ram_bank];
+	int firstRow = disp.screen.height;
+	int lastRow = -1;
+
+	if (zx.display_ram_bank != DisplayBank)
+	{
+		DisplayBank = zx.display_ram_bank;
+		bFullRedraw = true;
+	}
+
+	if (bFullRedraw)
+	{
+		std::fill(DirtyLines, DirtyLines + kNoLines, 0xffffffff);
+		BorderColour = -1;
+		bFullRedraw = false;
+	}
+	else if (++DecodesSinceVerify >= kVerifyInterval)
+	{
+		VerifyScreenMemory(pScreenMem);
+		DecodesSinceVerify = 0;
+	}
+
+	// mark flashing cells when the flash toggles - the machine counts the frames so it's in step with the chips decode
+	const bool bFlash = (zx.blink_counter & 0x10) != 0;
+	if (bFlash != bFlashOn)
+	{
+		bFlashOn = bFlash;
+		for (int cellNo = 0; cellNo < kScreenAttrMemSize; cellNo++)
+		{
+			if (pScreenMem[kScreenPixMemSize + cellNo] & 0x80)
+				DirtyCells[cellNo >> 5] |= 1 << (cellNo & 31);
+		}
+	}
+
+	// changed attributes redraw all the lines of the cell
+	for (int charRow = 0; charRow < kNoCharRows; charRow++)
+	{
+		if (DirtyCells[charRow] == 0)
+			continue;
+		for (int charLine = 0; charLine < 8; charLine++)
+			DirtyLines[(charRow * 8) + charLine] |= DirtyCells[charRow];
+		DirtyCells[charRow] = 0;
+	}
+
+	// border is a single colour
+	if (zx.border_color != BorderColour)
+	{
+		BorderColour = zx.border_color;
+		const uint32_t borderCol = pPalette[BorderColour & 7];
+		for (int y = 0; y < disp.screen.height; y++)
+		{
+			uint32_t* pDest = pFrameBuffer + (y * stride);
+			if (y < kBorderOffsetY || y >= kBorderOffsetY + kNoLines)
+			{
+				std::fill(pDest, pDest + disp.screen.width, borderCol);
+			}
+			else
+			{
+				std::fill(pDest, pDest + kBorderOffsetX, borderCol);
+				std::fill(pDest + kBorderOffsetX + 256, pDest + disp.screen.width, borderCol);
+			}
+		}
+		firstRow = 0;
+		lastRow = disp.screen.height - 1;
+	}
+
+	for (int line = 0; line < kNoLines; line++)
+	{
+		const uint32_t dirtyColumns = DirtyLines[line];
+		if (dirtyColumns == 0)
+			continue;
+		DirtyLines[line] = 0;
+
+		const int pixOffset = ((line & 0xC0) << 5) | ((line & 7) << 8) | ((line & 0x38) << 2);
+		const int attrOffset = kScreenPixMemSize + ((line >> 3) * 32);
+		uint32_t* pDest = pFrameBuffer + ((kBorderOffsetY + line) * stride) + kBorderOffsetX;
+
+		for (int column = 0; column < 32; column++)
+		{
+			if ((dirtyColumns & (1 << column)) == 0)
+				continue;
+
+			const uint8_t pixels = pScreenMem[pixOffset + column];
+			const uint8_t attr = pScreenMem[attrOffset + column];
+			DecodedScreen[pixOffset + column] = pixels;
+			DecodedScreen[attrOffset + column] = attr;
+
+			const uint8_t bright = (attr >> 3) & 8;
+			uint32_t inkCol = pPalette[(attr & 7) | bright];
+			uint32_t paperCol = pPalette[((attr >> 3) & 7) | bright];
+			if ((attr & 0x80) && bFlashOn)
+				std::swap(inkCol, paperCol);
+
+			uint32_t* pPixel = pDest + (column * 8);
+			for (int xpix = 0; xpix < 8; xpix++)
+				pPixel[xpix] = (pixels & (0x80 >> xpix)) ? inkCol : paperCol;
+		}
+
+		firstRow = std::min(firstRow, kBorderOffsetY + line);
+		lastRow = std::max(lastRow, kBorderOffsetY + line);
+	}
+
+	if (lastRow == -1)
+		return false;
+
+	outFirstRow = firstRow;
+	outNoRows = lastRow - firstRow + 1;
+	return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+
+#include "SpectrumConstants.h"
+
+class FSpectrumEmu;
+
+// Decodes the screen straight from screen memory, only redrawing what has changed since the last decode
+// CPU writes mark the pixel lines they touch, attribute writes mark whole cells & flash cells get marked when the flash toggles
+// Mid-frame effects such as multicolour & border stripes aren't reproduced - the chips scanline decode is needed for those
+class FZXScreenDecoder
+{
+public:
+	void	Init(FSpectrumEmu* pEmu);
+	void	Reset();	// redraw everything on the next decode
+
+	// offset is from the start of the displayed screen bank
+	void	OnScreenWrite(uint16_t screenOffset)
+	{
+		if (screenOffset < kScreenPixMemSize)
+		{
+			const int line = ((screenOffset >> 5) & 0xC0) | ((screenOffset >> 8) & 7) | ((screenOffset >> 2) & 0x38);
+			const uint32_t columnBit = 1 << (screenOffset & 31);
+			DirtyLines[line] |= columnBit;
+			FrameDrawnCells[line >> 3] |= columnBit;
+		}
+		else
+		{
+			const int cellNo = screenOffset - kScreenPixMemSize;
+			DirtyCells[cellNo >> 5] |= 1 << (cellNo & 31);
+			FrameDrawnCells[cellNo >> 5] |= 1 << (cellNo & 31);
+		}
+	}
+	void	OnMachineFrameStart();
+
+	// decode the dirty parts of the screen into the frame buffer
+	// returns false if nothing changed, otherwise the range of frame buffer rows which were touched
+	bool	Decode(uint32_t* pFrameBuffer, int& outFirstRow, int& outNoRows);
+
+	// one bit per column for each character row
+	const uint32_t*	GetLastFrameDrawnCells() const { return LastFrameDrawnCells; }
+
+	static const int	kNoCharRows = 24;
+	static const int	kNoLines = kNoCharRows * 8;
+private:
+	void	VerifyScreenMemory(const uint8_t* pScreenMem);
+
+	static const int	kVerifyInterval = 25;	// decodes between checking for writes we didn't see
+
+	FSpectrumEmu*	pSpectrumEmu = nullptr;
+
+	uint32_t	DirtyLines[kNoLines];	// pixel bytes to decode - one bit per column
+	uint32_t	DirtyCells[kNoCharRows];	// cells with changed attributes
+	uint32_t	FrameDrawnCells[kNoCharRows];	// cells written to this machine frame
+	uint32_t	LastFrameDrawnCells[kNoCharRows];
+
+	uint8_t		DecodedScreen[kScreenPixMemSize + kScreenAttrMemSize];	// memory as it was last decoded
+	bool		bFullRedraw = true;
+	int			DisplayBank = -1;
+	int			BorderColour = -1;
+	bool		bFlashOn = false;
+	int			DecodesSinceVerify = 0;
+};